@@ -0,0 +1,29 @@
+# - Try to find zstd
+# Once done this will define
+#  ZSTD_FOUND        - System has zstd
+#  ZSTD_INCLUDE_DIRS - The zstd include directories
+#  ZSTD_LIBRARIES    - The libraries needed to use zstd
+
+find_path(
+    ZSTD_INCLUDE_DIR
+    NAMES zstd.h
+)
+
+find_library(
+    ZSTD_LIBRARY
+    NAMES zstd
+)
+
+set(ZSTD_INCLUDE_DIRS ${ZSTD_INCLUDE_DIR})
+set(ZSTD_LIBRARIES ${ZSTD_LIBRARY})
+
+# Handle arguments such as QUIETLY and REQUIRED
+# Sets ZSTD_FOUND to TRUE if the other variables passed in here are set
+include(FindPackageHandleStandardArgs)
+find_package_handle_standard_args(
+    Zstd DEFAULT_MSG
+    ZSTD_LIBRARY
+    ZSTD_INCLUDE_DIR
+)
+
+mark_as_advanced(ZSTD_INCLUDE_DIR ZSTD_LIBRARY)
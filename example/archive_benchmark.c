@@ -0,0 +1,152 @@
+/* Archive Benchmark
+ *
+ * Decodes a synthetic 1 Hz track of RMC and GGA sentences, stores one TPV
+ * record per epoch in a compact binary archive, and then measures how fast
+ * the archive can be decoded again. The size of the archive is reported
+ * against the size of the NMEA it was built from.
+ */
+
+#include "gps.h"
+#include "gps_archive.h"
+
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define NUM_EPOCHS   (100000)
+#define NUM_PASSES   (20)
+#define BLOCK_SIZE   (4096)
+#define ARCHIVE_SIZE (NUM_EPOCHS * GPS_ARCHIVE_RECORD_MAX_SIZE)
+
+struct memory_sink
+{
+    uint8_t *data;
+    size_t size;
+};
+
+static int memory_write(void *context, const void *data, size_t size)
+{
+    struct memory_sink *sink = context;
+
+    if (size > ARCHIVE_SIZE - sink->size) return -1;
+    memcpy(sink->data + sink->size, data, size);
+    sink->size += size;
+    return 0;
+}
+
+static double elapsed(const struct timespec *start, const struct timespec *end)
+{
+    return (double)(end->tv_sec - start->tv_sec) + (end->tv_nsec - start->tv_nsec) / 1e9;
+}
+
+/* Formats a coordinate in micro-degrees as NMEA degrees and minutes */
+static void format_angle(char *str, size_t size, int32_t value, int degree_digits)
+{
+    int32_t magnitude = value < 0 ? -value : value;
+    int32_t degrees = magnitude / 1000000;
+    int32_t minutes = (int32_t)(((int64_t)(magnitude % 1000000) * 60000) / 1000000);
+
+    snprintf(str, size, "%0*d%02d.%03d", degree_digits, degrees, minutes / 1000, minutes % 1000);
+}
+
+int main(void)
+{
+    struct gps_archive_writer writer;
+    struct gps_archive_reader reader;
+    struct memory_sink sink;
+    struct gps_tpv tpv;
+    struct timespec start_ts, end_ts;
+    static uint8_t block[BLOCK_SIZE];
+    size_t nmea_size = 0;
+    unsigned long records = 0;
+    int32_t latitude = 48117300;
+    int32_t longitude = 11516667;
+    double seconds;
+    int i;
+
+    sink.data = malloc(ARCHIVE_SIZE);
+    sink.size = 0;
+    if (!sink.data)
+    {
+        perror("malloc");
+        return EXIT_FAILURE;
+    }
+
+    /* Build the archive from decoded NMEA */
+    gps_init_tpv(&tpv);
+    gps_archive_writer_init(&writer, block, sizeof(block), memory_write, &sink);
+    for (i = 0; i < NUM_EPOCHS; ++i)
+    {
+        char lat[16], lon[16], body[128], nmea[136];
+        int t = i % 86400;
+
+        latitude += 40 + (i % 7);
+        longitude += 55 - (i % 11);
+        format_angle(lat, sizeof(lat), latitude, 2);
+        format_angle(lon, sizeof(lon), longitude, 3);
+
+        snprintf(body, sizeof(body), "GPRMC,%02d%02d%02d,A,%s,N,%s,E,%03d.%d,084.%d,230394,003.1,W",
+                 t / 3600, (t / 60) % 60, t % 60, lat, lon, 22 + (i % 3), i % 10, i % 10);
+        nmea_size += (size_t)(gps_encode(nmea, body) - nmea);
+        gps_decode(&tpv, nmea);
+
+        snprintf(body, sizeof(body), "GPGGA,%02d%02d%02d,%s,N,%s,E,1,08,0.9,%d.%d,M,46.9,M,,",
+                 t / 3600, (t / 60) % 60, t % 60, lat, lon, 545 + (i % 4), i % 10);
+        nmea_size += (size_t)(gps_encode(nmea, body) - nmea);
+        gps_decode(&tpv, nmea);
+
+        if (gps_archive_write(&writer, &tpv) != GPS_OK)
+        {
+            fputs("Archive write failed\n", stderr);
+            return EXIT_FAILURE;
+        }
+    }
+    gps_archive_flush(&writer);
+
+    /* Time decoding the whole archive several times over */
+    if (clock_gettime(CLOCK_MONOTONIC, &start_ts) < 0)
+    {
+        perror("clock_gettime start");
+        return errno;
+    }
+
+    for (i = 0; i < NUM_PASSES; ++i)
+    {
+        gps_archive_reader_init(&reader, sink.data, sink.size);
+        while (gps_archive_next_block(&reader, NULL) == GPS_OK)
+        {
+            while (gps_archive_read(&reader, &tpv) == GPS_OK)
+            {
+                ++records;
+            }
+        }
+    }
+
+    if (clock_gettime(CLOCK_MONOTONIC, &end_ts) < 0)
+    {
+        perror("clock_gettime end");
+        return errno;
+    }
+
+    seconds = elapsed(&start_ts, &end_ts);
+    printf("Archived %d epochs:\n"
+           "  NMEA size:       %lu bytes\n"
+           "  Archive size:    %lu bytes (%.1f bytes/record)\n"
+           "  Compression:     %.1fx\n"
+           "  Decode rate:     %.1f Mrecords/s\n"
+           "  Decode rate:     %.1f MB/s of archive, %.1f MB/s of NMEA equivalent\n",
+           NUM_EPOCHS,
+           (unsigned long)nmea_size,
+           (unsigned long)sink.size, (double)sink.size / NUM_EPOCHS,
+           (double)nmea_size / sink.size,
+           records / seconds / 1e6,
+           (double)sink.size * NUM_PASSES / seconds / 1e6,
+           (double)nmea_size * NUM_PASSES / seconds / 1e6);
+
+    free(sink.data);
+
+    return EXIT_SUCCESS;
+}
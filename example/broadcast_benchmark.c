@@ -0,0 +1,260 @@
+/* Broadcast Load Test
+ *
+ * Pseudo-terminals stand in for four receivers, each sending GGA, RMC, GSA
+ * and VTG every epoch, as fast as they are decoded. A session decodes them
+ * and a broadcaster fans the TPVs out to many clients on a Unix socket, as
+ * broadcast-daemon does. Most clients read every message, some read one
+ * message every few epochs, and a few never read at all.
+ *
+ * Everything runs on one thread, so any time the broadcaster spent waiting
+ * for a client would show up in the epoch rate. The epochs decoded per
+ * second, the mean and worst time spent handing a TPV to the broadcaster,
+ * and what each kind of client received and skipped are reported.
+ */
+
+#define _XOPEN_SOURCE 600
+
+#include "gps.h"
+#include "gps_broadcast.h"
+#include "gps_session.h"
+
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+#define NUM_DEVICES  (4)
+#define NUM_FAST     (32)
+#define NUM_SLOW     (8)
+#define NUM_STALLED  (4)
+#define NUM_CLIENTS  (NUM_FAST + NUM_SLOW + NUM_STALLED)
+#define NUM_EPOCHS   (20000)
+#define SLOW_EVERY   (16)
+#define SENTENCES    (4)
+
+struct client
+{
+    int fd;
+    uint32_t received;
+    uint32_t gaps;
+    uint32_t next;
+};
+
+struct timing
+{
+    struct gps_broadcast *broadcast;
+    uint32_t calls;
+    int64_t total;
+    int64_t worst;
+};
+
+static int64_t monotonic_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static int open_pty(int *slave)
+{
+    struct termios attributes;
+    int master = posix_openpt(O_RDWR | O_NOCTTY);
+
+    if ((master < 0) || (grantpt(master) < 0) || (unlockpt(master) < 0)) return -1;
+    *slave = open(ptsname(master), O_RDWR | O_NOCTTY);
+    if (*slave < 0) return -1;
+
+    tcgetattr(*slave, &attributes);
+    attributes.c_iflag &= ~(tcflag_t)(IGNBRK | BRKINT | PARMRK | ISTRIP | INLCR | IGNCR | ICRNL | IXON);
+    attributes.c_oflag &= ~(tcflag_t)OPOST;
+    attributes.c_lflag &= ~(tcflag_t)(ECHO | ECHONL | ICANON | ISIG | IEXTEN);
+    attributes.c_cflag &= ~(tcflag_t)(CSIZE | PARENB);
+    attributes.c_cflag |= CS8;
+    tcsetattr(*slave, TCSANOW, &attributes);
+
+    return master;
+}
+
+static void on_tpv(void *context, size_t device, const struct gps_tpv *tpv)
+{
+    struct timing *timing = context;
+    int64_t start;
+    int64_t elapsed;
+
+    if (NULL == tpv) return;
+
+    start = monotonic_ns();
+    gps_broadcast_update(timing->broadcast, (uint16_t)device, tpv, start);
+    elapsed = monotonic_ns() - start;
+
+    timing->calls++;
+    timing->total += elapsed;
+    if (elapsed > timing->worst) timing->worst = elapsed;
+}
+
+/* Reads up to limit messages without waiting, noting gaps in the sequence */
+static void drain(struct client *client, int limit)
+{
+    uint8_t message[GPS_BROADCAST_MESSAGE_SIZE];
+    struct gps_broadcast_record records[GPS_BROADCAST_BATCH_SIZE];
+    uint32_t sequence;
+    size_t count;
+
+    while (limit-- > 0)
+    {
+        ssize_t size = recv(client->fd, message, sizeof(message), MSG_DONTWAIT);
+
+        if (size <= 0) return;
+        if (gps_broadcast_parse(message, (size_t)size, &sequence, records, &count) != GPS_OK) continue;
+
+        if ((client->received > 0) && (sequence != client->next)) client->gaps++;
+        client->next = sequence + 1;
+        client->received++;
+    }
+}
+
+static void report(const char *name, const struct client *clients, const struct gps_broadcast_client *slots,
+                   int first, int count)
+{
+    double received = 0;
+    double skipped = 0;
+    double gaps = 0;
+    int i;
+
+    for (i = first; i < first + count; ++i)
+    {
+        received += clients[i].received;
+        skipped += slots[i].skipped;
+        gaps += clients[i].gaps;
+    }
+
+    printf("  %-8s %8d %12.0f %12.0f %12.0f\n", name, count, received / count, skipped / count, gaps / count);
+}
+
+int main(void)
+{
+    static struct gps_broadcast_client slots[NUM_CLIENTS];
+    static struct gps_broadcast broadcast;
+    struct gps_session_device devices[NUM_DEVICES];
+    struct gps_session session;
+    struct client clients[NUM_CLIENTS];
+    struct timing timing;
+    int masters[NUM_DEVICES];
+    int slaves[NUM_DEVICES];
+    char path[64];
+    char epoch[NUM_DEVICES][SENTENCES * 96];
+    double seconds;
+    int64_t start;
+    uint32_t expected = 0;
+    int e;
+    int i;
+
+    snprintf(path, sizeof(path), "/tmp/gps-broadcast-%d.sock", (int)getpid());
+    if ((gps_broadcast_init(&broadcast, slots, NUM_CLIENTS, path, 100000000) != GPS_OK) ||
+        (gps_session_init(&session, devices, NUM_DEVICES) != GPS_OK))
+    {
+        perror("init");
+        return EXIT_FAILURE;
+    }
+
+    memset(&timing, 0, sizeof(timing));
+    timing.broadcast = &broadcast;
+    for (i = 0; i < NUM_DEVICES; ++i)
+    {
+        masters[i] = open_pty(&slaves[i]);
+        if ((masters[i] < 0) || (gps_session_add(&session, slaves[i], on_tpv, &timing, NULL) != GPS_OK))
+        {
+            perror("pty");
+            return EXIT_FAILURE;
+        }
+    }
+
+    memset(clients, 0, sizeof(clients));
+    for (i = 0; i < NUM_CLIENTS; ++i)
+    {
+        if (gps_broadcast_connect(path, &clients[i].fd) != GPS_OK)
+        {
+            perror("gps_broadcast_connect");
+            return EXIT_FAILURE;
+        }
+        gps_broadcast_service(&broadcast, 0);
+    }
+
+    start = monotonic_ns();
+    for (e = 0; e < NUM_EPOCHS; ++e)
+    {
+        int h = (e / 3600) % 24;
+        int m = (e / 60) % 60;
+        int s = e % 60;
+
+        for (i = 0; i < NUM_DEVICES; ++i)
+        {
+            char body[96];
+            char *p = epoch[i];
+
+            sprintf(body, "GPGGA,%02d%02d%02d.000,5321.%04d,N,00630.3371,W,1,8,1.03,61.7,M,55.3,M,,",
+                    h, m, s, (e + i) % 10000);
+            p = gps_encode(p, body);
+            sprintf(body, "GPRMC,%02d%02d%02d.000,A,5321.%04d,N,00630.3371,W,0.02,31.66,280511,,,A",
+                    h, m, s, (e + i) % 10000);
+            p = gps_encode(p, body);
+            p = gps_encode(p, "GPGSA,A,3,10,07,05,02,29,04,08,13,,,,,1.72,1.03,1.38");
+            p = gps_encode(p, "GPVTG,176.90,T,,M,3.68,N,6.81,K,A");
+            if (write(masters[i], epoch[i], (size_t)(p - epoch[i])) != p - epoch[i])
+            {
+                perror("write");
+                return EXIT_FAILURE;
+            }
+        }
+
+        /* Decode the whole epoch of every receiver */
+        expected += NUM_DEVICES * SENTENCES;
+        for (;;)
+        {
+            uint32_t decoded = 0;
+
+            for (i = 0; i < NUM_DEVICES; ++i) decoded += devices[i].sentences;
+            if (decoded >= expected) break;
+            gps_session_poll(&session, 100);
+        }
+        gps_broadcast_service(&broadcast, monotonic_ns());
+
+        for (i = 0; i < NUM_FAST; ++i) drain(&clients[i], NUM_EPOCHS);
+        if (0 == e % SLOW_EVERY)
+        {
+            for (i = NUM_FAST; i < NUM_FAST + NUM_SLOW; ++i) drain(&clients[i], 1);
+        }
+    }
+    gps_broadcast_flush(&broadcast);
+    seconds = (double)(monotonic_ns() - start) / 1e9;
+    for (i = 0; i < NUM_FAST + NUM_SLOW; ++i) drain(&clients[i], NUM_EPOCHS);
+
+    printf("%d receivers, %d epochs, %u batches to %d clients in %.2fs\n",
+           NUM_DEVICES, NUM_EPOCHS, broadcast.sequence, NUM_CLIENTS, seconds);
+    printf("  %.0f epochs/s, %.0f sentences/s\n", NUM_EPOCHS / seconds, expected / seconds);
+    printf("  update %.2fus mean, %.1fus worst, over %u TPVs\n",
+           (double)timing.total / timing.calls / 1e3, (double)timing.worst / 1e3, timing.calls);
+    printf("Per client:\n");
+    printf("  %-8s %8s %12s %12s %12s\n", "kind", "clients", "received", "skipped", "gaps");
+    report("fast", clients, slots, 0, NUM_FAST);
+    report("slow", clients, slots, NUM_FAST, NUM_SLOW);
+    report("stalled", clients, slots, NUM_FAST + NUM_SLOW, NUM_STALLED);
+
+    for (i = 0; i < NUM_CLIENTS; ++i) close(clients[i].fd);
+    for (i = 0; i < NUM_DEVICES; ++i)
+    {
+        close(masters[i]);
+        close(slaves[i]);
+    }
+    gps_broadcast_close(&broadcast);
+    gps_session_close(&session);
+    unlink(path);
+
+    return EXIT_SUCCESS;
+}
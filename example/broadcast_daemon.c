@@ -0,0 +1,168 @@
+/* TPV Broadcast Daemon
+ *
+ * Owns the receivers named on the command line, decodes them on a single
+ * thread with gps_session, and fans the TPVs out to local clients over the
+ * Unix socket given first:
+ *
+ *     broadcast-daemon /run/gps.sock /dev/ttyUSB0 /dev/ttyACM0
+ *
+ * Terminals are put in raw mode, other files are read as they are. Clients
+ * connect with gps_broadcast_connect() and decode messages with
+ * gps_broadcast_parse(). A batch is held for at most HOLD_MS waiting for the
+ * rest of an epoch. The daemon runs until interrupted, then reports what
+ * each client was sent and skipped.
+ *
+ * broadcast-benchmark runs the same loop against pseudo-terminals and many
+ * clients, without a daemon.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "gps.h"
+#include "gps_broadcast.h"
+#include "gps_session.h"
+
+#include <fcntl.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+#define MAX_DEVICES (16)
+#define MAX_CLIENTS (64)
+#define HOLD_MS     (100)
+
+/* Longest wait for input, which is also how late a new client is accepted */
+#define IDLE_MS     (250)
+
+static volatile sig_atomic_t stop;
+
+static void on_signal(int signal)
+{
+    (void)signal;
+    stop = 1;
+}
+
+static int64_t monotonic_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static void make_raw(int fd)
+{
+    struct termios attributes;
+
+    if (tcgetattr(fd, &attributes) < 0) return;
+
+    attributes.c_iflag &= ~(tcflag_t)(IGNBRK | BRKINT | PARMRK | ISTRIP | INLCR | IGNCR | ICRNL | IXON);
+    attributes.c_oflag &= ~(tcflag_t)OPOST;
+    attributes.c_lflag &= ~(tcflag_t)(ECHO | ECHONL | ICANON | ISIG | IEXTEN);
+    attributes.c_cflag &= ~(tcflag_t)(CSIZE | PARENB);
+    attributes.c_cflag |= CS8;
+    tcsetattr(fd, TCSANOW, &attributes);
+}
+
+static void on_tpv(void *context, size_t device, const struct gps_tpv *tpv)
+{
+    struct gps_broadcast *broadcast = context;
+
+    if (NULL == tpv)
+    {
+        fprintf(stderr, "Device %zu hung up\n", device);
+        return;
+    }
+
+    gps_broadcast_update(broadcast, (uint16_t)device, tpv, monotonic_ns());
+}
+
+int main(int argc, char *argv[])
+{
+    static struct gps_session_device devices[MAX_DEVICES];
+    static struct gps_broadcast_client clients[MAX_CLIENTS];
+    static struct gps_broadcast broadcast;
+    struct gps_session session;
+    struct sigaction action;
+    int fds[MAX_DEVICES];
+    int count;
+    int i;
+
+    if ((argc < 3) || (argc - 2 > MAX_DEVICES))
+    {
+        fprintf(stderr, "Usage: %s SOCKET DEVICE... (at most %d devices)\n", argv[0], MAX_DEVICES);
+        return EXIT_FAILURE;
+    }
+
+    if (gps_broadcast_init(&broadcast, clients, MAX_CLIENTS, argv[1], (int64_t)HOLD_MS * 1000000) != GPS_OK)
+    {
+        perror(argv[1]);
+        return EXIT_FAILURE;
+    }
+    if (gps_session_init(&session, devices, MAX_DEVICES) != GPS_OK)
+    {
+        perror("gps_session_init");
+        return EXIT_FAILURE;
+    }
+
+    count = argc - 2;
+    for (i = 0; i < count; ++i)
+    {
+        fds[i] = open(argv[i + 2], O_RDONLY | O_NOCTTY);
+        if (fds[i] < 0)
+        {
+            perror(argv[i + 2]);
+            return EXIT_FAILURE;
+        }
+        make_raw(fds[i]);
+        if (gps_session_add(&session, fds[i], on_tpv, &broadcast, NULL) != GPS_OK)
+        {
+            fprintf(stderr, "Cannot watch %s\n", argv[i + 2]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = on_signal;
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+
+    while (!stop)
+    {
+        int timeout = gps_broadcast_service(&broadcast, monotonic_ns());
+
+        if ((timeout < 0) || (timeout > IDLE_MS)) timeout = IDLE_MS;
+        if (gps_session_poll(&session, timeout) != GPS_OK)
+        {
+            perror("gps_session_poll");
+            break;
+        }
+    }
+
+    gps_broadcast_flush(&broadcast);
+    printf("%u batches, %u clients refused, %u disconnected\n",
+           broadcast.sequence, broadcast.refused, broadcast.disconnected);
+    for (i = 0; i < MAX_CLIENTS; ++i)
+    {
+        if (clients[i].fd >= 0)
+        {
+            printf("  client %d: %u sent, %u skipped\n", i, clients[i].sent, clients[i].skipped);
+        }
+    }
+    for (i = 0; i < count; ++i)
+    {
+        printf("  device %d: %u sentences, %u errors\n", i, devices[i].sentences, devices[i].errors);
+        close(fds[i]);
+    }
+
+    gps_broadcast_close(&broadcast);
+    gps_session_close(&session);
+    unlink(argv[1]);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,126 @@
+/* C++ Interface Benchmark
+ *
+ * Builds an hour of 1 Hz output from a receiver sending GGA, RMC, GSA, GSV
+ * and VTG, held in one buffer like a log file read into memory, and decodes
+ * all of it four ways: through gps_decode() after copying each sentence into
+ * a mutable buffer, which is what wrapping the C interface takes, through
+ * gps_decode_const(), through gps::all_decoder, and through a
+ * gps::decoder selecting only GGA and RMC. The average time per sentence in
+ * the buffer is reported.
+ */
+
+#include "gps.h"
+#include "gps.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <time.h>
+
+#define NUM_EPOCHS (3600)
+#define NUM_RUNS   (20)
+
+static double now()
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+static void append(std::string &log, const char *body)
+{
+    char nmea[128];
+
+    gps_encode(nmea, body);
+    log += nmea;
+}
+
+/* Runs decode over every line of the log, and reports the time per line
+ * along with how many of them decoded
+ */
+template <class Decode>
+static void measure(const char *name, const std::string &log, std::size_t lines, Decode decode)
+{
+    volatile int32_t sink = 0;
+    double start = now();
+    std::size_t decoded = 0;
+    int run;
+
+    for (run = 0; run < NUM_RUNS; ++run)
+    {
+        for (std::string_view nmea : gps::sentences(log))
+        {
+            decoded += (GPS_OK == decode(nmea));
+        }
+    }
+    sink = (int32_t)decoded;
+    (void)sink;
+
+    std::printf("  %-28s %6.1fns  %zu decoded\n", name, (now() - start) / NUM_RUNS / lines, decoded / NUM_RUNS);
+}
+
+int main()
+{
+    std::string log;
+    std::size_t lines = 0;
+    char body[96];
+    int e;
+
+    for (e = 0; e < NUM_EPOCHS; ++e)
+    {
+        int m = (e / 60) % 60;
+        int s = e % 60;
+
+        std::snprintf(body, sizeof(body), "GPGGA,12%02d%02d.000,5321.%04d,N,00630.3371,W,1,8,1.03,61.7,M,55.3,M,,",
+                      m, s, e);
+        append(log, body);
+        std::snprintf(body, sizeof(body), "GPRMC,12%02d%02d.000,A,5321.%04d,N,00630.3371,W,0.02,31.66,280511,,,A",
+                      m, s, e);
+        append(log, body);
+        append(log, "GPGSA,A,3,10,07,05,02,29,04,08,13,,,,,1.72,1.03,1.38");
+        append(log, "GPGSV,3,1,11,03,03,111,00,04,15,270,00,06,01,010,00,13,06,292,00");
+        append(log, "GPVTG,176.90,T,,M,3.68,N,6.81,K,A");
+        lines += 5;
+    }
+
+    std::printf("Average time per sentence, %zu sentences:\n", lines);
+
+    {
+        gps_tpv tpv;
+        char copy[128];
+
+        gps_init_tpv(&tpv);
+        measure("copy then gps_decode", log, lines, [&](std::string_view nmea) {
+            if (nmea.size() >= sizeof(copy)) return GPS_ERROR_OVERFLOW;
+            std::memcpy(copy, nmea.data(), nmea.size());
+            copy[nmea.size()] = '\0';
+            return gps_decode(&tpv, copy);
+        });
+    }
+
+    {
+        gps_tpv tpv;
+
+        gps_init_tpv(&tpv);
+        measure("gps_decode_const", log, lines, [&](std::string_view nmea) {
+            return gps_decode_const(&tpv, nmea.data(), nmea.size());
+        });
+    }
+
+    {
+        gps::all_decoder decoder;
+
+        measure("gps::all_decoder", log, lines, [&](std::string_view nmea) { return decoder.decode(nmea); });
+    }
+
+    {
+        gps::decoder<gps::gga, gps::rmc> decoder;
+
+        measure("gps::decoder<gga, rmc>", log, lines, [&](std::string_view nmea) { return decoder.decode(nmea); });
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,130 @@
+/* Duplicate Filter Benchmark
+ *
+ * Builds an hour of 1 Hz output from a receiver sending GGA, RMC, GSA and
+ * VTG, as delivered by a gateway which gets the feed over two links, so
+ * every sentence arrives twice a few sentences apart. The stream is decoded
+ * twice: every sentence, and only those gps_dedup_check() reports as new.
+ * The time per received sentence and the share of duplicates dropped are
+ * reported.
+ */
+
+#include "gps.h"
+#include "gps_dedup.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define NUM_EPOCHS     (3600)
+#define NUM_TYPES      (4)
+#define NUM_SENTENCES  (2 * NUM_EPOCHS * NUM_TYPES)
+#define SENTENCE_SIZE  (96)
+#define LINK_DELAY     (3)
+#define TABLE_SIZE     (256)
+#define WINDOW_MS      (500)
+#define NUM_RUNS       (20)
+
+struct sentence
+{
+    char text[SENTENCE_SIZE];
+    size_t size;
+    uint32_t received;
+};
+
+static double elapsed_ns(const struct timespec *start, const struct timespec *end)
+{
+    return (double)(end->tv_sec - start->tv_sec) * 1e9 + (double)(end->tv_nsec - start->tv_nsec);
+}
+
+static void build(struct sentence *stream, size_t *count, const char *body, uint32_t received)
+{
+    struct sentence *s = &stream[(*count)++];
+
+    gps_encode(s->text, body);
+    s->size = strlen(s->text);
+    s->received = received;
+}
+
+int main(void)
+{
+    static struct sentence stream[NUM_SENTENCES];
+    static struct sentence epoch[NUM_TYPES];
+    struct gps_dedup_entry entries[TABLE_SIZE];
+    struct gps_dedup dedup;
+    struct gps_tpv tpv;
+    struct timespec start_ts, end_ts;
+    double plain = 0;
+    double filtered = 0;
+    size_t count = 0;
+    char body[SENTENCE_SIZE];
+    int run;
+    int e;
+    int t;
+
+    /* The second link delivers each sentence LINK_DELAY sentences later */
+    for (e = 0; e < NUM_EPOCHS; ++e)
+    {
+        int h = 12 + e / 3600;
+        int m = (e / 60) % 60;
+        int s = e % 60;
+        uint32_t ms = (uint32_t)e * 1000;
+        size_t n = 0;
+
+        sprintf(body, "GPGGA,%02d%02d%02d.000,5321.%04d,N,00630.3371,W,1,8,1.03,61.7,M,55.3,M,,",
+                h, m, s, e % 10000);
+        build(epoch, &n, body, ms);
+        sprintf(body, "GPRMC,%02d%02d%02d.000,A,5321.%04d,N,00630.3371,W,0.02,31.66,280511,,,A",
+                h, m, s, e % 10000);
+        build(epoch, &n, body, ms + 5);
+        build(epoch, &n, "GPGSA,A,3,10,07,05,02,29,04,08,13,,,,,1.72,1.03,1.38", ms + 10);
+        sprintf(body, "GPVTG,%d.%02d,T,,M,0.02,N,0.04,K,A", e % 360, e % 100);
+        build(epoch, &n, body, ms + 15);
+
+        for (t = 0; t < NUM_TYPES + LINK_DELAY; ++t)
+        {
+            if (t < NUM_TYPES) stream[count++] = epoch[t];
+            if (t >= LINK_DELAY)
+            {
+                stream[count] = epoch[t - LINK_DELAY];
+                stream[count++].received += 2;
+            }
+        }
+    }
+
+    for (run = 0; run < NUM_RUNS; ++run)
+    {
+        size_t i;
+
+        gps_init_tpv(&tpv);
+        clock_gettime(CLOCK_MONOTONIC, &start_ts);
+        for (i = 0; i < count; ++i)
+        {
+            gps_decode_const(&tpv, stream[i].text, stream[i].size);
+        }
+        clock_gettime(CLOCK_MONOTONIC, &end_ts);
+        plain += elapsed_ns(&start_ts, &end_ts);
+
+        gps_init_tpv(&tpv);
+        gps_dedup_init(&dedup, entries, TABLE_SIZE, WINDOW_MS);
+        clock_gettime(CLOCK_MONOTONIC, &start_ts);
+        for (i = 0; i < count; ++i)
+        {
+            if (!gps_dedup_check(&dedup, stream[i].text, stream[i].size, stream[i].received))
+            {
+                gps_decode_const(&tpv, stream[i].text, stream[i].size);
+            }
+        }
+        clock_gettime(CLOCK_MONOTONIC, &end_ts);
+        filtered += elapsed_ns(&start_ts, &end_ts);
+    }
+
+    printf("%zu sentences received, %u dropped as duplicates (%.1f%%)\n",
+           count, dedup.hits, 100.0 * dedup.hits / count);
+    printf("Average time per received sentence:\n");
+    printf("  decode all        %6.1fns\n", plain / NUM_RUNS / count);
+    printf("  dedup then decode %6.1fns\n", filtered / NUM_RUNS / count);
+
+    return EXIT_SUCCESS;
+}
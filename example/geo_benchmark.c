@@ -0,0 +1,132 @@
+/* Geodesic Benchmark
+ *
+ * Compares the fixed-point distance functions against a double precision
+ * haversine over the same set of random coordinate pairs near Munich. The
+ * largest deviation from the double precision result is reported alongside
+ * the throughput of each variant.
+ */
+
+#include "gps.h"
+#include "gps_geo.h"
+
+#include <errno.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define NUM_PAIRS  (1000000)
+#define NUM_PASSES (10)
+
+#define EARTH_RADIUS_MM (6371008800.0)
+#define RADIANS_PER_MICRODEGREE (3.14159265358979323846 / 180e6)
+
+static int32_t lat1[NUM_PAIRS], lon1[NUM_PAIRS], lat2[NUM_PAIRS], lon2[NUM_PAIRS];
+static int32_t distance[NUM_PAIRS];
+static double reference[NUM_PAIRS];
+
+static double haversine(int32_t a_lat, int32_t a_lon, int32_t b_lat, int32_t b_lon)
+{
+    double phi1 = a_lat * RADIANS_PER_MICRODEGREE;
+    double phi2 = b_lat * RADIANS_PER_MICRODEGREE;
+    double dphi = (b_lat - a_lat) * RADIANS_PER_MICRODEGREE;
+    double dlambda = (b_lon - a_lon) * RADIANS_PER_MICRODEGREE;
+    double a = sin(dphi / 2) * sin(dphi / 2) + cos(phi1) * cos(phi2) * sin(dlambda / 2) * sin(dlambda / 2);
+
+    return 2 * EARTH_RADIUS_MM * asin(sqrt(a));
+}
+
+static double now(void)
+{
+    struct timespec ts;
+
+    if (clock_gettime(CLOCK_MONOTONIC, &ts) < 0)
+    {
+        perror("clock_gettime");
+        exit(errno);
+    }
+
+    return (double)ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void report(const char *name, double seconds, double worst)
+{
+    printf("  %-28s %8.1f Mpairs/s   max error %10.1f mm\n",
+           name, (double)NUM_PAIRS * NUM_PASSES / seconds / 1e6, worst);
+}
+
+int main(void)
+{
+    volatile int64_t sink = 0;
+    double start, worst;
+    int pass, i;
+
+    srand(1);
+    for (i = 0; i < NUM_PAIRS; ++i)
+    {
+        lat1[i] = 48137000 + rand() % 200000 - 100000;
+        lon1[i] = 11575000 + rand() % 200000 - 100000;
+        lat2[i] = lat1[i] + rand() % 20000 - 10000;
+        lon2[i] = lon1[i] + rand() % 20000 - 10000;
+        reference[i] = haversine(lat1[i], lon1[i], lat2[i], lon2[i]);
+    }
+
+    printf("Distance between %d coordinate pairs up to 1.5 km apart:\n", NUM_PAIRS);
+
+    start = now();
+    for (pass = 0; pass < NUM_PASSES; ++pass)
+    {
+        for (i = 0; i < NUM_PAIRS; ++i) sink += (int64_t)haversine(lat1[i], lon1[i], lat2[i], lon2[i]);
+    }
+    report("double haversine", now() - start, 0.0);
+
+    worst = 0.0;
+    start = now();
+    for (pass = 0; pass < NUM_PASSES; ++pass)
+    {
+        for (i = 0; i < NUM_PAIRS; ++i) sink += gps_geo_distance(lat1[i], lon1[i], lat2[i], lon2[i]);
+    }
+    start = now() - start;
+
+    /* Accuracy is measured outside of the timed loops */
+    for (i = 0; i < NUM_PAIRS; ++i)
+    {
+        double error = fabs(gps_geo_distance(lat1[i], lon1[i], lat2[i], lon2[i]) - reference[i]);
+        if (error > worst) worst = error;
+    }
+    report("gps_geo_distance", start, worst);
+
+    worst = 0.0;
+    start = now();
+    for (pass = 0; pass < NUM_PASSES; ++pass)
+    {
+        for (i = 0; i < NUM_PAIRS; ++i) sink += gps_geo_distance_fast(lat1[i], lon1[i], lat2[i], lon2[i]);
+    }
+    start = now() - start;
+    for (i = 0; i < NUM_PAIRS; ++i)
+    {
+        double error = fabs(gps_geo_distance_fast(lat1[i], lon1[i], lat2[i], lon2[i]) - reference[i]);
+        if (error > worst) worst = error;
+    }
+    report("gps_geo_distance_fast", start, worst);
+
+    worst = 0.0;
+    start = now();
+    for (pass = 0; pass < NUM_PASSES; ++pass)
+    {
+        gps_geo_distance_fast_batch(distance, lat1, lon1, lat2, lon2, NUM_PAIRS);
+        sink += distance[pass];
+    }
+    start = now() - start;
+    for (i = 0; i < NUM_PAIRS; ++i)
+    {
+        double error = fabs(distance[i] - reference[i]);
+        if (error > worst) worst = error;
+    }
+    report("gps_geo_distance_fast_batch", start, worst);
+
+    (void)sink;
+
+    return EXIT_SUCCESS;
+}
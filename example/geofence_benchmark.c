@@ -0,0 +1,128 @@
+/* Geofence Benchmark
+ *
+ * Measures point-in-geofence queries per second against the number of
+ * polygons, both with the grid index and with a brute force scan of every
+ * polygon. Polygons are random star shaped areas between roughly 100 m and
+ * 1 km across, scattered over a 2 x 2 degree region.
+ */
+
+#include "gps.h"
+#include "gps_geofence.h"
+
+#include <errno.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define MAX_POLYGONS (50000)
+#define NUM_VERTICES (12)
+#define NUM_QUERIES  (1000000)
+#define REGION_SIZE  (2000000)
+
+static int32_t vertex_lat[MAX_POLYGONS][NUM_VERTICES];
+static int32_t vertex_lon[MAX_POLYGONS][NUM_VERTICES];
+static int32_t query_lat[NUM_QUERIES];
+static int32_t query_lon[NUM_QUERIES];
+
+static double now(void)
+{
+    struct timespec ts;
+
+    if (clock_gettime(CLOCK_MONOTONIC, &ts) < 0)
+    {
+        perror("clock_gettime");
+        exit(errno);
+    }
+
+    return (double)ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static double run_queries(const struct gps_geofence *geofence, int queries, unsigned long *hits)
+{
+    uint32_t found[GPS_GEOFENCE_MAX_INSIDE];
+    double start = now();
+    int i;
+
+    *hits = 0;
+    for (i = 0; i < queries; ++i)
+    {
+        *hits += gps_geofence_query(geofence, query_lat[i], query_lon[i], found, GPS_GEOFENCE_MAX_INSIDE);
+    }
+
+    return queries / (now() - start);
+}
+
+int main(void)
+{
+    static const int counts[] = { 100, 1000, 10000, 50000 };
+    struct gps_geofence_polygon *polygons;
+    uint32_t *cell_start, *cell_items;
+    int i, j, k;
+
+    polygons = malloc(MAX_POLYGONS * sizeof(*polygons));
+    cell_start = malloc((2 * MAX_POLYGONS + 1) * sizeof(*cell_start));
+    cell_items = malloc(MAX_POLYGONS * 16 * sizeof(*cell_items));
+    if (!polygons || !cell_start || !cell_items)
+    {
+        perror("malloc");
+        return EXIT_FAILURE;
+    }
+
+    srand(1);
+    for (i = 0; i < MAX_POLYGONS; ++i)
+    {
+        int32_t center_lat = 47000000 + rand() % REGION_SIZE;
+        int32_t center_lon = 10000000 + rand() % REGION_SIZE;
+        int32_t radius = 500 + rand() % 4000;
+
+        for (j = 0; j < NUM_VERTICES; ++j)
+        {
+            double angle = j * 2 * 3.14159265358979 / NUM_VERTICES;
+            double r = radius * (0.5 + (rand() % 1000) / 2000.0);
+
+            vertex_lat[i][j] = center_lat + (int32_t)(r * sin(angle));
+            vertex_lon[i][j] = center_lon + (int32_t)(1.5 * r * cos(angle));
+        }
+    }
+
+    for (i = 0; i < NUM_QUERIES; ++i)
+    {
+        query_lat[i] = 47000000 + rand() % REGION_SIZE;
+        query_lon[i] = 10000000 + rand() % REGION_SIZE;
+    }
+
+    printf("%10s %8s %16s %16s\n", "polygons", "hits", "indexed q/s", "brute force q/s");
+    for (k = 0; k < (int)(sizeof(counts) / sizeof(counts[0])); ++k)
+    {
+        struct gps_geofence geofence;
+        uint32_t side = (uint32_t)ceil(sqrt(counts[k]));
+        unsigned long hits, brute_hits;
+        double indexed, brute;
+
+        gps_geofence_init(&geofence, polygons, counts[k]);
+        for (i = 0; i < counts[k]; ++i)
+        {
+            gps_geofence_add(&geofence, (uint32_t)i, vertex_lat[i], vertex_lon[i], NUM_VERTICES);
+        }
+
+        /* Without a call to gps_geofence_build() every polygon is scanned */
+        brute = run_queries(&geofence, NUM_QUERIES / counts[k] * 10, &brute_hits);
+
+        if (gps_geofence_build(&geofence, side, side, cell_start, cell_items, MAX_POLYGONS * 16) != GPS_OK)
+        {
+            fputs("Index build failed\n", stderr);
+            return EXIT_FAILURE;
+        }
+        indexed = run_queries(&geofence, NUM_QUERIES, &hits);
+
+        printf("%10d %8lu %16.0f %16.0f\n", counts[k], hits, indexed, brute);
+    }
+
+    free(polygons);
+    free(cell_start);
+    free(cell_items);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,218 @@
+/* Index Benchmark
+ *
+ * Archives an hour of 1 Hz fixes for a fleet of vehicles wandering around
+ * Munich, one archive per vehicle, and indexes them all. A bounding box and
+ * time range query is then answered twice: by decoding every archive, and
+ * by decoding only the blocks the index points at. The time taken and the
+ * share of the archive data read are reported for both.
+ */
+
+#include "gps.h"
+#include "gps_archive.h"
+#include "gps_index.h"
+
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define NUM_VEHICLES (1000)
+#define NUM_EPOCHS   (3600)
+#define NUM_ENTRIES  (NUM_VEHICLES * 256)
+#define NUM_POSTINGS (65536)
+#define BLOCK_SIZE   (4096)
+#define ARCHIVE_SIZE (NUM_EPOCHS * GPS_ARCHIVE_RECORD_MAX_SIZE)
+#define INDEX_SIZE   (NUM_ENTRIES * (GPS_INDEX_KEY_SIZE + GPS_INDEX_POSTING_SIZE))
+#define START_TIME   INT64_C(1700035200000)
+
+#define TILE_SIZE   (10000)  /* 0.01 degrees, about 1 km */
+#define BUCKET_SIZE (300000) /* 5 minutes */
+
+struct memory_sink
+{
+    uint8_t *data;
+    size_t size;
+    size_t capacity;
+};
+
+static int memory_write(void *context, const void *data, size_t size)
+{
+    struct memory_sink *sink = context;
+
+    if (size > sink->capacity - sink->size) return -1;
+    memcpy(sink->data + sink->size, data, size);
+    sink->size += size;
+    return 0;
+}
+
+static void count_match(void *context, const struct gps_tpv *tpv)
+{
+    (void)tpv;
+    ++*(unsigned long *)context;
+}
+
+static double now(void)
+{
+    struct timespec ts;
+
+    if (clock_gettime(CLOCK_MONOTONIC, &ts) < 0)
+    {
+        perror("clock_gettime");
+        exit(errno);
+    }
+
+    return (double)ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void *allocate(size_t size)
+{
+    void *p = malloc(size);
+
+    if (NULL == p)
+    {
+        perror("malloc");
+        exit(EXIT_FAILURE);
+    }
+
+    return p;
+}
+
+int main(void)
+{
+    static uint8_t block[BLOCK_SIZE];
+    struct memory_sink *archives = allocate(NUM_VEHICLES * sizeof(*archives));
+    struct gps_index_entry *entries = allocate(NUM_ENTRIES * sizeof(*entries));
+    struct gps_index_posting *postings = allocate(NUM_POSTINGS * sizeof(*postings));
+    struct memory_sink index_sink;
+    struct gps_archive_writer writer;
+    struct gps_archive_reader reader;
+    struct gps_archive_block summary;
+    struct gps_index_builder builder;
+    struct gps_index index;
+    struct gps_index_query query;
+    struct gps_tpv tpv;
+    size_t total_size = 0;
+    size_t read_size = 0;
+    size_t count = 0;
+    unsigned long records = 0;
+    unsigned long matches = 0;
+    double start, seconds;
+    int v, i;
+
+    srand(1);
+    gps_init_tpv(&tpv);
+    tpv.mode = GPS_MODE_3D_FIX;
+    tpv.altitude = 520000;
+    strcpy(tpv.talker_id, "GP");
+    for (v = 0; v < NUM_VEHICLES; ++v)
+    {
+        int32_t dlat = rand() % 41 - 20;
+        int32_t dlon = rand() % 61 - 30;
+
+        archives[v].data = allocate(ARCHIVE_SIZE);
+        archives[v].size = 0;
+        archives[v].capacity = ARCHIVE_SIZE;
+        tpv.latitude = 47900000 + rand() % 500000;
+        tpv.longitude = 11300000 + rand() % 500000;
+
+        gps_archive_writer_init(&writer, block, sizeof(block), memory_write, &archives[v]);
+        for (i = 0; i < NUM_EPOCHS; ++i)
+        {
+            /* Drive at up to 10 m/s, turning now and then */
+            if (0 == rand() % 60)
+            {
+                dlat = rand() % 91 - 45;
+                dlon = rand() % 135 - 67;
+            }
+            tpv.latitude += dlat;
+            tpv.longitude += dlon;
+            tpv.speed = 5000 + i % 100;
+            gps_ms_to_time(tpv.time, START_TIME + (int64_t)i * 1000, 1);
+            if (gps_archive_write(&writer, &tpv) != GPS_OK)
+            {
+                fputs("Archive write failed\n", stderr);
+                return EXIT_FAILURE;
+            }
+        }
+        gps_archive_flush(&writer);
+        total_size += archives[v].size;
+    }
+
+    /* Index the fleet */
+    start = now();
+    gps_index_builder_init(&builder, TILE_SIZE, BUCKET_SIZE, entries, NUM_ENTRIES);
+    for (v = 0; v < NUM_VEHICLES; ++v)
+    {
+        if (gps_index_builder_add(&builder, (uint32_t)v, archives[v].data, archives[v].size) != GPS_OK)
+        {
+            fputs("Index build failed\n", stderr);
+            return EXIT_FAILURE;
+        }
+    }
+    index_sink.data = allocate(INDEX_SIZE);
+    index_sink.size = 0;
+    index_sink.capacity = INDEX_SIZE;
+    if ((gps_index_builder_write(&builder, memory_write, &index_sink) != GPS_OK) ||
+        (gps_index_init(&index, index_sink.data, index_sink.size) != GPS_OK))
+    {
+        fputs("Index write failed\n", stderr);
+        return EXIT_FAILURE;
+    }
+    seconds = now() - start;
+
+    printf("%d vehicles, %lu records in %.1f MB of archives\n",
+           NUM_VEHICLES, (unsigned long)NUM_VEHICLES * NUM_EPOCHS, total_size / 1e6);
+    printf("  index built in %.0f ms, %u keys, %u postings, %.1f kB\n",
+           seconds * 1e3, index.key_count, index.posting_count, index_sink.size / 1e3);
+
+    /* A 2 km box in the middle of the area, for ten minutes */
+    query.latitude_min = 48140000;
+    query.latitude_max = 48160000;
+    query.longitude_min = 11540000;
+    query.longitude_max = 11570000;
+    query.time_min = START_TIME + 1200000;
+    query.time_max = START_TIME + 1800000;
+
+    start = now();
+    for (v = 0; v < NUM_VEHICLES; ++v)
+    {
+        gps_archive_reader_init(&reader, archives[v].data, archives[v].size);
+        while (gps_archive_next_block(&reader, NULL) == GPS_OK)
+        {
+            while (gps_archive_read(&reader, &tpv) == GPS_OK)
+            {
+                if (gps_index_match(&query, &tpv)) ++records;
+            }
+        }
+    }
+    seconds = now() - start;
+    printf("  full scan:  %6lu matches in %8.3f ms, read 100%% of the data\n", records, seconds * 1e3);
+
+    start = now();
+    if (gps_index_query(&index, &query, postings, NUM_POSTINGS, &count) != GPS_OK)
+    {
+        fputs("Index query failed\n", stderr);
+        return EXIT_FAILURE;
+    }
+    for (v = 0; v < NUM_VEHICLES; ++v)
+    {
+        gps_archive_reader_init(&reader, archives[v].data, archives[v].size);
+        gps_index_scan(&reader, (uint32_t)v, &query, postings, count, count_match, &matches);
+    }
+    seconds = now() - start;
+
+    /* Size of the blocks read, outside of the timed section */
+    for (i = 0; i < (int)count; ++i)
+    {
+        gps_archive_reader_init(&reader, archives[postings[i].archive].data, archives[postings[i].archive].size);
+        gps_archive_seek(&reader, (size_t)postings[i].offset);
+        gps_archive_next_block(&reader, &summary);
+        read_size += GPS_ARCHIVE_BLOCK_HEADER_SIZE + summary.size;
+    }
+    printf("  index scan: %6lu matches in %8.3f ms, read %.2f%% of the data in %lu blocks\n",
+           matches, seconds * 1e3, 100.0 * read_size / total_size, (unsigned long)count);
+
+    return (matches == records) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
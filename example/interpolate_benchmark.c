@@ -0,0 +1,150 @@
+/* Interpolation Benchmark
+ *
+ * Drives a vehicle at 20 m/s for ten minutes, once in a straight line and
+ * once around a circle of 200 m radius, and samples it at 1, 5 and 10 Hz
+ * as a receiver would. A 100 Hz control loop asks for the position at
+ * every tick, given only the fixes already received. The error of the
+ * newest fix held as is, and of gps_interpolate_at() dead reckoning from
+ * it, are reported against the true position, along with the time per
+ * estimate after the newest fix and within the ring.
+ */
+
+#include "gps.h"
+#include "gps_geo.h"
+#include "gps_interpolate.h"
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define DURATION_MS    (600000)
+#define LOOP_MS        (10)
+#define SPEED          (20.0)
+#define RING_SIZE      (16)
+#define NUM_QUERIES    (1000000)
+#define LATITUDE       (53.3613)
+#define LONGITUDE      (-6.5056)
+#define M_PER_DEGREE   (111195.08)
+
+static const int rates[] = { 1, 5, 10 };
+static const double radii[] = { 0, 200 };
+
+static double elapsed_ns(const struct timespec *start, const struct timespec *end)
+{
+    return (double)(end->tv_sec - start->tv_sec) * 1e9 + (double)(end->tv_nsec - start->tv_nsec);
+}
+
+/* The true fix at a time, heading north and turning right on a circle of
+ * the radius, or straight on when the radius is 0
+ */
+static void truth(struct gps_tpv *tpv, double radius, int64_t ms)
+{
+    double distance = SPEED * (double)ms / 1000.0;
+    double heading = (radius > 0) ? distance / radius : 0;
+    double north = (radius > 0) ? radius * sin(heading) : distance;
+    double east = (radius > 0) ? radius * (1 - cos(heading)) : 0;
+    double degrees = fmod(heading * 180.0 / M_PI, 360.0);
+
+    gps_init_tpv(tpv);
+    tpv->latitude = (int32_t)lround((LATITUDE + north / M_PER_DEGREE) * 1e6);
+    tpv->longitude = (int32_t)lround((LONGITUDE + east / (M_PER_DEGREE * cos(LATITUDE * M_PI / 180.0))) * 1e6);
+    tpv->speed = (int32_t)lround(SPEED * 1e3);
+    tpv->track = (int32_t)lround(degrees * 1e3);
+}
+
+int main(void)
+{
+    struct gps_interpolate_sample samples[RING_SIZE];
+    struct gps_interpolate interpolate;
+    struct gps_interpolate_sample fix;
+    struct timespec start_ts, end_ts;
+    size_t r;
+    size_t k;
+
+    printf("Position error of a 100 Hz loop over %d seconds at %.0f m/s:\n", DURATION_MS / 1000, SPEED);
+    printf("  %-8s %6s %12s %12s %12s %12s\n", "track", "rate", "hold mean", "hold max", "dr mean", "dr max");
+    for (k = 0; k < sizeof(radii) / sizeof(radii[0]); ++k)
+    {
+        for (r = 0; r < sizeof(rates) / sizeof(rates[0]); ++r)
+        {
+            int64_t interval = 1000 / rates[r];
+            int64_t next = 0;
+            int64_t newest = 0;
+            double hold_sum = 0;
+            double estimate_sum = 0;
+            int64_t hold_max = 0;
+            int64_t estimate_max = 0;
+            long ticks = 0;
+            int64_t t;
+
+            gps_interpolate_init(&interpolate, samples, RING_SIZE, 2 * interval);
+            for (t = 0; t < DURATION_MS; t += LOOP_MS)
+            {
+                struct gps_tpv actual;
+                struct gps_tpv received;
+                int64_t hold;
+                int64_t estimate;
+
+                for (; next <= t; next += interval)
+                {
+                    truth(&received, radii[k], next);
+                    gps_interpolate_add(&interpolate, &received, next);
+                    newest = next;
+                }
+
+                truth(&actual, radii[k], t);
+                truth(&received, radii[k], newest);
+                gps_interpolate_at(&interpolate, t, &fix);
+                hold = gps_geo_distance(received.latitude, received.longitude, actual.latitude, actual.longitude);
+                estimate = gps_geo_distance(fix.latitude, fix.longitude, actual.latitude, actual.longitude);
+
+                hold_sum += (double)hold;
+                estimate_sum += (double)estimate;
+                if (hold > hold_max) hold_max = hold;
+                if (estimate > estimate_max) estimate_max = estimate;
+                ++ticks;
+            }
+
+            printf("  %-8s %4dHz %10.3fm %10.3fm %10.3fm %10.3fm\n",
+                   (radii[k] > 0) ? "circle" : "straight", rates[r],
+                   hold_sum / ticks / 1e3, (double)hold_max / 1e3,
+                   estimate_sum / ticks / 1e3, (double)estimate_max / 1e3);
+        }
+    }
+
+    /* Time per estimate, with the ring full of 10 Hz fixes */
+    {
+        const int64_t newest = (int64_t)interpolate.samples[interpolate.newest].time;
+        const int64_t oldest = newest - (RING_SIZE - 1) * 100;
+        volatile int32_t sink = 0;
+        double ns;
+        long n;
+
+        printf("Time per estimate:\n");
+
+        clock_gettime(CLOCK_MONOTONIC, &start_ts);
+        for (n = 0; n < NUM_QUERIES; ++n)
+        {
+            gps_interpolate_at(&interpolate, newest + n % 200, &fix);
+            sink += fix.latitude;
+        }
+        clock_gettime(CLOCK_MONOTONIC, &end_ts);
+        ns = elapsed_ns(&start_ts, &end_ts) / NUM_QUERIES;
+        printf("  after the newest fix %6.1fns\n", ns);
+
+        clock_gettime(CLOCK_MONOTONIC, &start_ts);
+        for (n = 0; n < NUM_QUERIES; ++n)
+        {
+            gps_interpolate_at(&interpolate, oldest + (n * 7) % (newest - oldest), &fix);
+            sink += fix.latitude;
+        }
+        clock_gettime(CLOCK_MONOTONIC, &end_ts);
+        ns = elapsed_ns(&start_ts, &end_ts) / NUM_QUERIES;
+        printf("  within the ring      %6.1fns\n", ns);
+        (void)sink;
+    }
+
+    return EXIT_SUCCESS;
+}
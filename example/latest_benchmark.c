@@ -0,0 +1,165 @@
+/* Latest TPV Benchmark
+ *
+ * Reader threads on every core but one read the current position in a
+ * tight loop, while the remaining thread publishes a new TPV every 100
+ * microseconds, far more often than any receiver reports. The average read
+ * time is compared between the lock free publisher and a TPV shared behind
+ * a mutex.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "gps.h"
+#include "gps_latest.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#define MAX_READERS     (16)
+#define RUN_SECONDS     (0.5)
+#define PUBLISH_NANOS   (100000)
+
+struct shared
+{
+    struct gps_latest latest;
+    pthread_mutex_t mutex;
+    struct gps_tpv tpv;
+    int use_mutex;
+    atomic_int done;
+};
+
+struct reader
+{
+    pthread_t thread;
+    struct shared *shared;
+    unsigned long reads;
+    double seconds;
+};
+
+static double now(void)
+{
+    struct timespec ts;
+
+    if (clock_gettime(CLOCK_MONOTONIC, &ts) < 0)
+    {
+        perror("clock_gettime");
+        exit(errno);
+    }
+
+    return (double)ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void *read_loop(void *context)
+{
+    struct reader *reader = context;
+    struct shared *shared = reader->shared;
+    struct gps_tpv tpv;
+    int32_t sum = 0;
+    double start = now();
+
+    while (!atomic_load_explicit(&shared->done, memory_order_relaxed))
+    {
+        if (shared->use_mutex)
+        {
+            pthread_mutex_lock(&shared->mutex);
+            tpv = shared->tpv;
+            pthread_mutex_unlock(&shared->mutex);
+        }
+        else
+        {
+            gps_latest_read(&shared->latest, &tpv);
+        }
+        sum += tpv.latitude;
+        reader->reads++;
+    }
+
+    reader->seconds = now() - start;
+    if (0 == sum) putchar('\0');
+
+    return NULL;
+}
+
+static double run(struct shared *shared, int readers)
+{
+    struct reader r[MAX_READERS];
+    struct timespec pause = {0, PUBLISH_NANOS};
+    struct gps_tpv tpv;
+    double start;
+    double nanos = 0;
+    int i;
+
+    gps_init_tpv(&tpv);
+    atomic_store(&shared->done, 0);
+    for (i = 0; i < readers; ++i)
+    {
+        r[i].shared = shared;
+        r[i].reads = 0;
+        if (pthread_create(&r[i].thread, NULL, read_loop, &r[i]) != 0)
+        {
+            perror("pthread_create");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    start = now();
+    while (now() - start < RUN_SECONDS)
+    {
+        tpv.latitude++;
+        if (shared->use_mutex)
+        {
+            pthread_mutex_lock(&shared->mutex);
+            shared->tpv = tpv;
+            pthread_mutex_unlock(&shared->mutex);
+        }
+        else
+        {
+            gps_latest_publish(&shared->latest, &tpv);
+        }
+        nanosleep(&pause, NULL);
+    }
+
+    atomic_store(&shared->done, 1);
+    for (i = 0; i < readers; ++i)
+    {
+        pthread_join(r[i].thread, NULL);
+        nanos += r[i].seconds * 1e9 / r[i].reads;
+    }
+
+    return nanos / readers;
+}
+
+int main(void)
+{
+    static struct shared shared;
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    int readers;
+
+    gps_latest_init(&shared.latest);
+    pthread_mutex_init(&shared.mutex, NULL);
+    gps_init_tpv(&shared.tpv);
+
+    if (cores < 2) cores = 2;
+    if (cores > MAX_READERS + 1) cores = MAX_READERS + 1;
+
+    printf("Average time per read, one TPV published every %d us\n", PUBLISH_NANOS / 1000);
+    printf("  readers     mutex  gps_latest\n");
+    for (readers = 1; readers < cores; readers *= 2)
+    {
+        double locked;
+        double latest;
+
+        shared.use_mutex = 1;
+        locked = run(&shared, readers);
+        shared.use_mutex = 0;
+        latest = run(&shared, readers);
+        printf("  %7d  %6.1f ns  %7.1f ns\n", readers, locked, latest);
+    }
+
+    return EXIT_SUCCESS;
+}
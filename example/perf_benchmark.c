@@ -0,0 +1,292 @@
+/* Decoder Internals Benchmark
+ *
+ * Time each parser behind gps_decode() on its own, through the wrappers of
+ * gps_internal.h, and read the hardware counters around it with Linux
+ * perf_event_open. For every parser, each input is run many times over and
+ * then all of its inputs are run in turn, since a branch predictor learns a
+ * single repeated input and hides the misses a real stream of sentences
+ * causes. Cycles, instructions, branch misses, L1 data cache read misses and
+ * wall time are reported per call.
+ *
+ * Counters the kernel or the CPU does not provide are reported as "-". In
+ * that case check /proc/sys/kernel/perf_event_paranoid, which must be 2 or
+ * less for a user to count its own process.
+ *
+ * This program compiles gps.c itself with GPS_TEST_INTERNALS defined.
+ */
+
+#define _GNU_SOURCE
+
+#include "gps.h"
+#include "gps_internal.h"
+
+#include <linux/perf_event.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#define NUM_ITERATIONS (200000)
+#define MAX_FIELDS     (8)
+
+enum counter
+{
+    CYCLES,
+    INSTRUCTIONS,
+    BRANCH_MISSES,
+    L1D_MISSES,
+    NUM_COUNTERS
+};
+
+struct counters
+{
+    int fd[NUM_COUNTERS];
+    int leader;
+};
+
+struct field
+{
+    const char *label;
+    const char *text;
+    char arg;
+    size_t length;
+};
+
+typedef int32_t (*runner)(const struct field *field);
+
+struct suite
+{
+    const char *name;
+    runner run;
+    struct field fields[MAX_FIELDS];
+};
+
+static char time_buffer[GPS_TIME_STRING_SIZE] = "0000-00-00T00:00:00.000Z";
+
+static int32_t run_nothing(const struct field *field)
+{
+    return field->arg;
+}
+
+static int32_t run_tokenize(const struct field *field)
+{
+    const char *token[GPS_INTERNAL_MAX_FIELDS];
+    uint_fast8_t count;
+    uint8_t checksum = 0;
+
+    gps_internal_tokenize(field->text, field->text + field->length, token, &count, &checksum);
+    return (int32_t)count + checksum;
+}
+
+static int32_t run_find_parser(const struct field *field)
+{
+    return gps_internal_find_parser(field->text);
+}
+
+static int32_t run_number(const struct field *field)
+{
+    return gps_internal_parse_number(field->text);
+}
+
+static int32_t run_angular_distance(const struct field *field)
+{
+    return gps_internal_parse_angular_distance(field->text, field->arg);
+}
+
+static int32_t run_time(const struct field *field)
+{
+    gps_internal_parse_time(time_buffer, field->text);
+    return time_buffer[18];
+}
+
+static int32_t run_date(const struct field *field)
+{
+    gps_internal_parse_date(time_buffer, field->text);
+    return time_buffer[3];
+}
+
+static int32_t run_speed(const struct field *field)
+{
+    return gps_internal_parse_speed(field->text, field->arg);
+}
+
+/* Representative fields first, then the worst cases for each parser */
+static struct suite suites[] = {
+    { "loop overhead", run_nothing, {
+        { "nothing", "", 0, 0 } } },
+    { "tokenize", run_tokenize, {
+        { "GGA body", "GGA,123519,4807.038,N,01131.000,E,1,08,0.9,545.4,M,46.9,M,,*47", 0, 0 },
+        { "GSA body", "GSA,A,3,04,05,,09,12,,,24,,,,,2.5,1.3,2.1*39", 0, 0 },
+        { "31 commas", "GSA,A,3,,,,,,,,,,,,,,,,,,,,,,,,,,,,,*00", 0, 0 },
+        { "120 chars", "GGA,092751.999,5321.680212,N,00630.337199,W,1,12,1.03,-12345.678,M,55.3,M,"
+                       "1234567890123456789012345678901234567890*00", 0, 0 } } },
+    { "find_parser", run_find_parser, {
+        { "GGA", "GGA", 0, 0 },
+        { "ZDA", "ZDA", 0, 0 },
+        { "unsupported", "TXT", 0, 0 } } },
+    { "parse_number", run_number, {
+        { "altitude", "545.4", 0, 0 },
+        { "negative", "-12345.678", 0, 0 },
+        { "digit run", "0000000000000000000000000000001.5", 0, 0 },
+        { "empty", "", 0, 0 } } },
+    { "parse_angular_distance", run_angular_distance, {
+        { "latitude", "4807.038", 'N', 0 },
+        { "longitude", "01131.000", 'E', 0 },
+        { "6 decimals", "17959.999999", 'W', 0 },
+        { "empty", "", 'N', 0 } } },
+    { "parse_time", run_time, {
+        { "seconds", "123519", 0, 0 },
+        { "milliseconds", "092751.999", 0, 0 },
+        { "empty", "", 0, 0 } } },
+    { "parse_date", run_date, {
+        { "date", "230394", 0, 0 },
+        { "empty", "", 0, 0 } } },
+    { "parse_speed", run_speed, {
+        { "knots", "022.4", 'N', 0 },
+        { "km/h", "010.2", 'K', 0 },
+        { "empty", "", 'K', 0 } } }
+};
+
+static int open_counter(uint32_t type, uint64_t config, int leader)
+{
+    struct perf_event_attr attr;
+
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.disabled = (leader < 0);
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+
+    return (int)syscall(SYS_perf_event_open, &attr, 0, -1, leader, 0);
+}
+
+static void open_counters(struct counters *counters)
+{
+    counters->leader = open_counter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES, -1);
+    counters->fd[CYCLES] = counters->leader;
+    if (counters->leader < 0)
+    {
+        counters->fd[INSTRUCTIONS] = -1;
+        counters->fd[BRANCH_MISSES] = -1;
+        counters->fd[L1D_MISSES] = -1;
+        return;
+    }
+
+    counters->fd[INSTRUCTIONS] = open_counter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS,
+                                              counters->leader);
+    counters->fd[BRANCH_MISSES] = open_counter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES,
+                                               counters->leader);
+    counters->fd[L1D_MISSES] = open_counter(PERF_TYPE_HW_CACHE,
+                                            PERF_COUNT_HW_CACHE_L1D |
+                                            (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                                            (PERF_COUNT_HW_CACHE_RESULT_MISS << 16),
+                                            counters->leader);
+}
+
+static double now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+/* Runs the fields from first to first + count in turn, and reports the
+ * counters and the time per call
+ */
+static void measure(const struct counters *counters, const char *name, const char *label,
+                    runner run, const struct field *first, size_t count)
+{
+    volatile int32_t sink = 0;
+    uint64_t values[NUM_COUNTERS];
+    double start;
+    double ns;
+    size_t j = 0;
+    long n;
+    int c;
+
+    if (counters->leader >= 0)
+    {
+        ioctl(counters->leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+        ioctl(counters->leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    }
+    start = now();
+
+    for (n = 0; n < NUM_ITERATIONS; ++n)
+    {
+        sink += run(&first[j]);
+        if (++j == count) j = 0;
+    }
+
+    ns = (now() - start) / NUM_ITERATIONS;
+    if (counters->leader >= 0)
+    {
+        ioctl(counters->leader, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+    }
+
+    printf("  %-22s %-12s", name, label);
+    for (c = 0; c < NUM_COUNTERS; ++c)
+    {
+        if ((counters->fd[c] >= 0) &&
+            (read(counters->fd[c], &values[c], sizeof(values[c])) == (ssize_t)sizeof(values[c])))
+        {
+            printf(" %8.2f", (double)values[c] / NUM_ITERATIONS);
+        }
+        else
+        {
+            printf(" %8s", "-");
+        }
+    }
+    printf(" %8.2f\n", ns);
+    (void)sink;
+}
+
+int main(void)
+{
+    struct counters counters;
+    size_t s;
+    size_t f;
+    int c;
+
+    open_counters(&counters);
+    if (counters.leader < 0)
+    {
+        perror("perf_event_open");
+        fprintf(stderr, "Hardware counters unavailable, reporting wall time only\n");
+    }
+
+    printf("Per call:\n");
+    printf("  %-22s %-12s %8s %8s %8s %8s %8s\n", "parser", "input",
+           "cycles", "instr", "br-miss", "L1d-miss", "ns");
+
+    for (s = 0; s < sizeof(suites) / sizeof(suites[0]); ++s)
+    {
+        struct suite *suite = &suites[s];
+        size_t count = 0;
+
+        for (f = 0; (f < MAX_FIELDS) && (suite->fields[f].text != NULL); ++f)
+        {
+            suite->fields[f].length = strlen(suite->fields[f].text);
+            measure(&counters, suite->name, suite->fields[f].label, suite->run, &suite->fields[f], 1);
+            ++count;
+        }
+
+        if (count > 1)
+        {
+            measure(&counters, suite->name, "mixed", suite->run, suite->fields, count);
+        }
+    }
+
+    for (c = 0; c < NUM_COUNTERS; ++c)
+    {
+        if (counters.fd[c] >= 0) close(counters.fd[c]);
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,239 @@
+/* Projection Benchmark
+ *
+ * Compares the batch ENU and UTM projections against straightforward double
+ * precision implementations built on the C math library, over a set of
+ * random fixes within 50 km of Munich. The largest deviation from the
+ * double precision result is reported alongside the throughput of each
+ * variant.
+ */
+
+#include "gps.h"
+#include "gps_project.h"
+
+#include <errno.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define NUM_POINTS (1000000)
+#define NUM_PASSES (10)
+
+#define RADIANS_PER_MICRODEGREE (3.14159265358979323846 / 180e6)
+#define SEMI_MAJOR_AXIS (6378137.0)
+#define FLATTENING (1.0 / 298.257223563)
+
+#define ORIGIN_LATITUDE  (48137000)
+#define ORIGIN_LONGITUDE (11575000)
+#define ORIGIN_ALTITUDE  (519000)
+#define ZONE (32)
+
+static int32_t latitude[NUM_POINTS], longitude[NUM_POINTS], altitude[NUM_POINTS];
+static int32_t east[NUM_POINTS], north[NUM_POINTS], up[NUM_POINTS];
+static float east_float[NUM_POINTS], north_float[NUM_POINTS], up_float[NUM_POINTS];
+static int64_t easting[NUM_POINTS], northing[NUM_POINTS];
+static double easting_double[NUM_POINTS], northing_double[NUM_POINTS];
+static double reference[NUM_POINTS][3];
+
+static void geocentric(double xyz[3], int32_t lat, int32_t lon, int32_t alt)
+{
+    double e2 = FLATTENING * (2 - FLATTENING);
+    double phi = lat * RADIANS_PER_MICRODEGREE;
+    double lambda = lon * RADIANS_PER_MICRODEGREE;
+    double h = alt / 1000.0;
+    double n = SEMI_MAJOR_AXIS / sqrt(1 - e2 * sin(phi) * sin(phi));
+
+    xyz[0] = (n + h) * cos(phi) * cos(lambda);
+    xyz[1] = (n + h) * cos(phi) * sin(lambda);
+    xyz[2] = (n * (1 - e2) + h) * sin(phi);
+}
+
+/* The textbook conversion through geocentric coordinates */
+static void enu(double result[3], int32_t lat, int32_t lon, int32_t alt)
+{
+    double phi = ORIGIN_LATITUDE * RADIANS_PER_MICRODEGREE;
+    double lambda = ORIGIN_LONGITUDE * RADIANS_PER_MICRODEGREE;
+    double origin[3], point[3], d[3];
+    int i;
+
+    geocentric(origin, ORIGIN_LATITUDE, ORIGIN_LONGITUDE, ORIGIN_ALTITUDE);
+    geocentric(point, lat, lon, alt);
+    for (i = 0; i < 3; ++i) d[i] = point[i] - origin[i];
+
+    result[0] = -sin(lambda) * d[0] + cos(lambda) * d[1];
+    result[1] = -sin(phi) * cos(lambda) * d[0] - sin(phi) * sin(lambda) * d[1] + cos(phi) * d[2];
+    result[2] = cos(phi) * cos(lambda) * d[0] + cos(phi) * sin(lambda) * d[1] + sin(phi) * d[2];
+}
+
+/* Transverse Mercator with the Krueger series to the fourth order */
+static void utm(double *e, double *n, int32_t lat, int32_t lon)
+{
+    static const double k0 = 0.9996;
+    double f = FLATTENING;
+    double m = f / (2 - f);
+    double a = SEMI_MAJOR_AXIS / (1 + m) * (1 + m * m / 4 + m * m * m * m / 64);
+    double alpha[4];
+    double ecc = sqrt(f * (2 - f));
+    double phi = lat * RADIANS_PER_MICRODEGREE;
+    double lambda = (lon - (ZONE * 6 - 183) * 1000000) * RADIANS_PER_MICRODEGREE;
+    double t, xi, eta, x, y;
+    int j;
+
+    alpha[0] = m / 2 - 2 * m * m / 3 + 5 * m * m * m / 16 + 41 * m * m * m * m / 180;
+    alpha[1] = 13 * m * m / 48 - 3 * m * m * m / 5 + 557 * m * m * m * m / 1440;
+    alpha[2] = 61 * m * m * m / 240 - 103 * m * m * m * m / 140;
+    alpha[3] = 49561 * m * m * m * m / 161280;
+
+    t = sinh(atanh(sin(phi)) - ecc * atanh(ecc * sin(phi)));
+    xi = atan2(t, cos(lambda));
+    eta = atanh(sin(lambda) / sqrt(1 + t * t));
+    x = eta;
+    y = xi;
+    for (j = 0; j < 4; ++j)
+    {
+        x += alpha[j] * cos(2 * (j + 1) * xi) * sinh(2 * (j + 1) * eta);
+        y += alpha[j] * sin(2 * (j + 1) * xi) * cosh(2 * (j + 1) * eta);
+    }
+
+    *e = 500000 + k0 * a * x;
+    *n = k0 * a * y;
+}
+
+static double now(void)
+{
+    struct timespec ts;
+
+    if (clock_gettime(CLOCK_MONOTONIC, &ts) < 0)
+    {
+        perror("clock_gettime");
+        exit(errno);
+    }
+
+    return (double)ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void report(const char *name, double seconds, double worst)
+{
+    printf("  %-24s %8.1f Mpoints/s   max error %8.2f mm\n",
+           name, (double)NUM_POINTS * NUM_PASSES / seconds / 1e6, worst);
+}
+
+int main(void)
+{
+    struct gps_project_origin origin;
+    volatile double sink = 0;
+    double start, worst, result[3], e, n;
+    int pass, i;
+
+    srand(1);
+    for (i = 0; i < NUM_POINTS; ++i)
+    {
+        latitude[i] = ORIGIN_LATITUDE + rand() % 900000 - 450000;
+        longitude[i] = ORIGIN_LONGITUDE + rand() % 1300000 - 650000;
+        altitude[i] = ORIGIN_ALTITUDE + rand() % 1000000 - 500000;
+        enu(reference[i], latitude[i], longitude[i], altitude[i]);
+    }
+
+    gps_project_origin_init(&origin, ORIGIN_LATITUDE, ORIGIN_LONGITUDE, ORIGIN_ALTITUDE);
+
+    printf("Local ENU frame of %d points within 50 km:\n", NUM_POINTS);
+
+    start = now();
+    for (pass = 0; pass < NUM_PASSES; ++pass)
+    {
+        for (i = 0; i < NUM_POINTS; ++i)
+        {
+            enu(result, latitude[i], longitude[i], altitude[i]);
+            sink += result[0];
+        }
+    }
+    report("double geocentric", now() - start, 0.0);
+
+    start = now();
+    for (pass = 0; pass < NUM_PASSES; ++pass)
+    {
+        gps_project_enu(&origin, east, north, up, latitude, longitude, altitude, NUM_POINTS);
+        sink += east[pass];
+    }
+    start = now() - start;
+
+    /* Accuracy is measured outside of the timed loops */
+    worst = 0.0;
+    for (i = 0; i < NUM_POINTS; ++i)
+    {
+        worst = fmax(worst, fabs(east[i] - reference[i][0] * 1000));
+        worst = fmax(worst, fabs(north[i] - reference[i][1] * 1000));
+        worst = fmax(worst, fabs(up[i] - reference[i][2] * 1000));
+    }
+    report("gps_project_enu", start, worst);
+
+    start = now();
+    for (pass = 0; pass < NUM_PASSES; ++pass)
+    {
+        gps_project_enu_float(&origin, east_float, north_float, up_float,
+                              latitude, longitude, altitude, NUM_POINTS);
+        sink += east_float[pass];
+    }
+    start = now() - start;
+    worst = 0.0;
+    for (i = 0; i < NUM_POINTS; ++i)
+    {
+        worst = fmax(worst, fabs(east_float[i] - reference[i][0]) * 1000);
+        worst = fmax(worst, fabs(north_float[i] - reference[i][1]) * 1000);
+        worst = fmax(worst, fabs(up_float[i] - reference[i][2]) * 1000);
+    }
+    report("gps_project_enu_float", start, worst);
+
+    for (i = 0; i < NUM_POINTS; ++i)
+    {
+        utm(&reference[i][0], &reference[i][1], latitude[i], longitude[i]);
+    }
+
+    printf("UTM zone %d of the same points:\n", ZONE);
+
+    start = now();
+    for (pass = 0; pass < NUM_PASSES; ++pass)
+    {
+        for (i = 0; i < NUM_POINTS; ++i)
+        {
+            utm(&e, &n, latitude[i], longitude[i]);
+            sink += e;
+        }
+    }
+    report("double Krueger series", now() - start, 0.0);
+
+    start = now();
+    for (pass = 0; pass < NUM_PASSES; ++pass)
+    {
+        gps_project_utm(ZONE, easting, northing, latitude, longitude, NUM_POINTS);
+        sink += (double)easting[pass];
+    }
+    start = now() - start;
+    worst = 0.0;
+    for (i = 0; i < NUM_POINTS; ++i)
+    {
+        worst = fmax(worst, fabs(easting[i] - reference[i][0] * 1000));
+        worst = fmax(worst, fabs(northing[i] - reference[i][1] * 1000));
+    }
+    report("gps_project_utm", start, worst);
+
+    start = now();
+    for (pass = 0; pass < NUM_PASSES; ++pass)
+    {
+        gps_project_utm_double(ZONE, easting_double, northing_double, latitude, longitude, NUM_POINTS);
+        sink += easting_double[pass];
+    }
+    start = now() - start;
+    worst = 0.0;
+    for (i = 0; i < NUM_POINTS; ++i)
+    {
+        worst = fmax(worst, fabs(easting_double[i] - reference[i][0]) * 1000);
+        worst = fmax(worst, fabs(northing_double[i] - reference[i][1]) * 1000);
+    }
+    report("gps_project_utm_double", start, worst);
+
+    (void)sink;
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,83 @@
+/* Replay Benchmark
+ *
+ * Builds five minutes of 1 Hz receiver output, GGA, RMC, GSA and VTG every
+ * second, and replays it into /dev/null at increasing speed-up factors.
+ * For each factor the achieved speed-up, the lines written per second, and
+ * how late the deadlines were met on average and at worst are reported.
+ */
+
+#include "gps.h"
+#include "gps_replay.h"
+
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define NUM_EPOCHS (300)
+#define LOG_SIZE   (NUM_EPOCHS * 4 * 96)
+
+static const uint32_t speeds[] = { 100, 1000, 10000, 100000 };
+
+static size_t append(char *log, size_t size, const char *body)
+{
+    return (size_t)(gps_encode(log + size, body) - log);
+}
+
+int main(void)
+{
+    static char log[LOG_SIZE];
+    char body[96];
+    size_t size = 0;
+    size_t i;
+    int fd;
+    int e;
+
+    for (e = 0; e < NUM_EPOCHS; ++e)
+    {
+        int m = e / 60;
+        int s = e % 60;
+
+        sprintf(body, "GPGGA,12%02d%02d.000,5321.6802,N,00630.3371,W,1,8,1.03,61.7,M,55.3,M,,", m, s);
+        size = append(log, size, body);
+        sprintf(body, "GPRMC,12%02d%02d.000,A,5321.6802,N,00630.3371,W,0.02,31.66,280511,,,A", m, s);
+        size = append(log, size, body);
+        size = append(log, size, "GPGSA,A,3,10,07,05,02,29,04,08,13,,,,,1.72,1.03,1.38");
+        size = append(log, size, "GPVTG,176.90,T,,M,3.68,N,6.81,K,A");
+    }
+
+    fd = open("/dev/null", O_WRONLY);
+    if (fd < 0)
+    {
+        perror("open");
+        return EXIT_FAILURE;
+    }
+
+    printf("Replaying %d seconds of log, %d lines:\n", NUM_EPOCHS, 4 * NUM_EPOCHS);
+    printf("  %8s %10s %12s %12s %12s\n", "speed", "achieved", "lines/s", "mean late", "max late");
+    for (i = 0; i < sizeof(speeds) / sizeof(speeds[0]); ++i)
+    {
+        struct gps_replay_stats stats;
+        double achieved;
+        double rate;
+        double mean;
+
+        if (gps_replay(log, size, GPS_REPLAY_FIX_TIME, speeds[i], gps_replay_write_fd, &fd, &stats) != GPS_OK)
+        {
+            perror("gps_replay");
+            close(fd);
+            return EXIT_FAILURE;
+        }
+
+        achieved = (double)stats.span_ns / (double)stats.elapsed_ns;
+        rate = stats.lines / ((double)stats.elapsed_ns / 1e9);
+        mean = stats.deadlines ? (double)stats.late_total_ns / stats.deadlines : 0;
+        printf("  %7ux %9.1fx %12.0f %10.1fus %10.1fus\n", speeds[i], achieved, rate,
+               mean / 1e3, (double)stats.late_max_ns / 1e3);
+    }
+
+    close(fd);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,244 @@
+/* Shared Memory Ring Latency Benchmark
+ *
+ * A writer process publishes a TPV every 100 microseconds and a reader
+ * process receives it, first through a gps_shm ring the reader polls, then
+ * through a gps_broadcast Unix socket the reader blocks on. The writer
+ * stores the CLOCK_MONOTONIC time of each publish in the latitude and
+ * longitude of the TPV, and the reader records how long after that it got
+ * the TPV. Percentiles of the latency are reported for both.
+ *
+ * The polling reader spins on a core of its own. On a machine with a single
+ * core it yields between polls instead, and waits for the writer to sleep.
+ */
+
+#define _GNU_SOURCE
+
+#include "gps.h"
+#include "gps_broadcast.h"
+#include "gps_latency.h"
+#include "gps_shm.h"
+
+#include <sched.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#define NUM_SAMPLES    (20000)
+#define NUM_WARMUP     (1000)
+#define INTERVAL_NS    (100000)
+#define NUM_SLOTS      (1024)
+
+static const uint32_t percentiles[] = { 500000, 900000, 990000, 999000, 1000000 };
+
+static int64_t monotonic_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static void stamp(struct gps_tpv *tpv, int64_t time)
+{
+    tpv->latitude = (int32_t)(uint32_t)time;
+    tpv->longitude = (int32_t)(uint32_t)((uint64_t)time >> 32);
+}
+
+static int64_t stamped(int32_t latitude, int32_t longitude)
+{
+    return (int64_t)(((uint64_t)(uint32_t)longitude << 32) | (uint32_t)latitude);
+}
+
+static void record(struct gps_histogram *histogram, uint32_t number, int64_t sent)
+{
+    if (number >= NUM_WARMUP) gps_histogram_record(histogram, monotonic_ns() - sent);
+}
+
+static void read_ring(const char *name, struct gps_histogram *histogram, int ready, int yield)
+{
+    struct gps_shm_reader reader;
+    struct gps_tpv tpv;
+    uint32_t number = 0;
+
+    if (gps_shm_reader_open(&reader, name) != GPS_OK) _exit(EXIT_FAILURE);
+    if (write(ready, "", 1) != 1) _exit(EXIT_FAILURE);
+
+    while (number < NUM_SAMPLES - 1)
+    {
+        if (gps_shm_read(&reader, &tpv, &number) != GPS_OK)
+        {
+            if (yield) sched_yield();
+            continue;
+        }
+        record(histogram, number, stamped(tpv.latitude, tpv.longitude));
+    }
+
+    gps_shm_reader_close(&reader);
+}
+
+static void read_socket(const char *path, struct gps_histogram *histogram, int ready)
+{
+    uint8_t message[GPS_BROADCAST_MESSAGE_SIZE];
+    struct gps_broadcast_record records[GPS_BROADCAST_BATCH_SIZE];
+    uint32_t number = 0;
+    size_t count;
+    int fd;
+
+    if (gps_broadcast_connect(path, &fd) != GPS_OK) _exit(EXIT_FAILURE);
+    if (write(ready, "", 1) != 1) _exit(EXIT_FAILURE);
+
+    while (number < NUM_SAMPLES - 1)
+    {
+        ssize_t size = recv(fd, message, sizeof(message), 0);
+
+        if (size <= 0) break;
+        if (gps_broadcast_parse(message, (size_t)size, &number, records, &count) != GPS_OK) continue;
+        record(histogram, number, stamped(records[0].tpv.latitude, records[0].tpv.longitude));
+    }
+
+    close(fd);
+}
+
+/* Publishes on a fixed schedule, through the ring if broadcast is NULL */
+static void write_samples(struct gps_shm_writer *writer, struct gps_broadcast *broadcast)
+{
+    struct gps_tpv tpv;
+    struct timespec next;
+    uint32_t n;
+
+    gps_init_tpv(&tpv);
+    clock_gettime(CLOCK_MONOTONIC, &next);
+    for (n = 0; n < NUM_SAMPLES; ++n)
+    {
+        next.tv_nsec += INTERVAL_NS;
+        if (next.tv_nsec >= 1000000000)
+        {
+            next.tv_nsec -= 1000000000;
+            next.tv_sec++;
+        }
+        clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL);
+
+        stamp(&tpv, monotonic_ns());
+        if (NULL == broadcast)
+        {
+            gps_shm_publish(writer, &tpv);
+        }
+        else
+        {
+            gps_broadcast_update(broadcast, 0, &tpv, 0);
+            gps_broadcast_flush(broadcast);
+        }
+    }
+}
+
+static int run(const char *label, const char *name, int socket, struct gps_histogram *histogram)
+{
+    struct gps_broadcast_client clients[1];
+    struct gps_broadcast broadcast;
+    struct gps_shm_writer writer;
+    int yield = sysconf(_SC_NPROCESSORS_ONLN) < 2;
+    int fds[2];
+    char byte;
+    int status;
+    pid_t child;
+    size_t i;
+
+    if (socket)
+    {
+        if (gps_broadcast_init(&broadcast, clients, 1, name, 0) != GPS_OK) return -1;
+    }
+    else if (gps_shm_writer_open(&writer, name, NUM_SLOTS) != GPS_OK)
+    {
+        return -1;
+    }
+    if (pipe(fds) < 0) return -1;
+
+    child = fork();
+    if (child < 0) return -1;
+    if (0 == child)
+    {
+        close(fds[0]);
+        gps_histogram_init(histogram);
+        if (socket)
+        {
+            read_socket(name, histogram, fds[1]);
+        }
+        else
+        {
+            read_ring(name, histogram, fds[1], yield);
+        }
+        _exit(EXIT_SUCCESS);
+    }
+
+    close(fds[1]);
+    if (read(fds[0], &byte, 1) != 1) return -1;
+    close(fds[0]);
+    if (socket) gps_broadcast_service(&broadcast, 0);
+
+    write_samples(&writer, socket ? &broadcast : NULL);
+    if ((waitpid(child, &status, 0) != child) || !WIFEXITED(status) || (WEXITSTATUS(status) != EXIT_SUCCESS))
+    {
+        return -1;
+    }
+
+    if (socket)
+    {
+        gps_broadcast_close(&broadcast);
+        unlink(name);
+    }
+    else
+    {
+        gps_shm_writer_close(&writer);
+        shm_unlink(name);
+    }
+
+    printf("  %-20s", label);
+    for (i = 0; i < sizeof(percentiles) / sizeof(percentiles[0]); ++i)
+    {
+        printf(" %8.1f", (double)gps_histogram_quantile(histogram, percentiles[i]) / 1e3);
+    }
+    printf("\n");
+
+    return 0;
+}
+
+int main(void)
+{
+    struct gps_histogram *histogram;
+    char name[64];
+
+    /* The reader process fills in the histogram */
+    histogram = mmap(NULL, sizeof(*histogram), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (MAP_FAILED == histogram)
+    {
+        perror("mmap");
+        return EXIT_FAILURE;
+    }
+
+    printf("Latency from publish to reader in microseconds, %d samples every %dus:\n",
+           NUM_SAMPLES - NUM_WARMUP, INTERVAL_NS / 1000);
+    printf("  %-20s %8s %8s %8s %8s %8s\n", "transport", "p50", "p90", "p99", "p99.9", "max");
+
+    snprintf(name, sizeof(name), "/gps-shm-benchmark-%d", (int)getpid());
+    if (run("shared memory ring", name, 0, histogram) < 0)
+    {
+        perror("shared memory ring");
+        return EXIT_FAILURE;
+    }
+
+    snprintf(name, sizeof(name), "/tmp/gps-shm-benchmark-%d.sock", (int)getpid());
+    if (run("Unix socket", name, 1, histogram) < 0)
+    {
+        perror("Unix socket");
+        return EXIT_FAILURE;
+    }
+
+    munmap(histogram, sizeof(*histogram));
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,175 @@
+/* Track Simplification Benchmark
+ *
+ * Builds two tracks with a meter or so of receiver noise: four hours on
+ * highways sampled at 1 Hz, with long straights and gentle curves, and one
+ * hour across a city grid sampled at 10 Hz, with right angle turns and stops
+ * at junctions. Each is simplified at several tolerances by the streaming
+ * window and by Douglas-Peucker. The points processed per second and the
+ * compression ratio, points in per point kept, are reported.
+ */
+
+#include "gps.h"
+#include "gps_simplify.h"
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define MAX_POINTS (36000)
+#define NUM_RUNS   (10)
+#define M_PER_DEG  (111195.08)
+
+struct track
+{
+    const char *name;
+    int32_t latitude[MAX_POINTS];
+    int32_t longitude[MAX_POINTS];
+    size_t count;
+};
+
+static struct track tracks[2];
+static uint8_t keep[MAX_POINTS];
+static uint32_t seed = 1;
+
+static const int32_t tolerances[] = { 1000, 5000, 10000, 25000 };
+
+static double now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static double noise(void)
+{
+    seed = seed * 1103515245u + 12345u;
+    return ((double)(seed >> 8) / (1 << 24) - 0.5) * 2.0;
+}
+
+static void add_point(struct track *track, double lat, double lon)
+{
+    size_t i = track->count++;
+
+    track->latitude[i] = (int32_t)lround((lat + noise() / M_PER_DEG) * 1e6);
+    track->longitude[i] = (int32_t)lround((lon + noise() / (M_PER_DEG * cos(lat * M_PI / 180))) * 1e6);
+}
+
+/* 1 Hz at 30 m/s, the heading drifting slowly, with a bend every few km */
+static void build_highway(struct track *track)
+{
+    double lat = 52.0;
+    double lon = 5.0;
+    double heading = 0.5;
+    double turn = 0;
+    size_t i;
+
+    track->name = "highway";
+    for (i = 0; i < 4 * 3600; ++i)
+    {
+        if (0 == (i % 120)) turn = noise() * 0.004;
+        heading += turn;
+        lat += 30 * cos(heading) / M_PER_DEG;
+        lon += 30 * sin(heading) / (M_PER_DEG * cos(lat * M_PI / 180));
+        add_point(track, lat, lon);
+    }
+}
+
+/* 10 Hz at 10 m/s along 150 m blocks, turning at random junctions and
+ * stopping at some of them for a few seconds
+ */
+static void build_city(struct track *track)
+{
+    double lat = 40.75;
+    double lon = -73.98;
+    int heading = 0;
+    int step = 0;
+    size_t i;
+
+    track->name = "city";
+    for (i = 0; i < 3600 * 10; )
+    {
+        int wait;
+
+        lat += (0 == heading) ? 1.0 / M_PER_DEG : (2 == heading) ? -1.0 / M_PER_DEG : 0;
+        lon += (1 == heading) ? 1.0 / (M_PER_DEG * cos(lat * M_PI / 180)) :
+               (3 == heading) ? -1.0 / (M_PER_DEG * cos(lat * M_PI / 180)) : 0;
+        add_point(track, lat, lon);
+        ++i;
+
+        if (++step < 150) continue;
+        step = 0;
+        if (noise() > 0.3) heading = (heading + ((noise() > 0) ? 1 : 3)) % 4;
+        for (wait = (noise() > 0.5) ? 50 : 0; (wait > 0) && (i < 3600 * 10); --wait, ++i)
+        {
+            add_point(track, lat, lon);
+        }
+    }
+}
+
+static void on_point(void *context, const struct gps_simplify_point *point)
+{
+    (void)point;
+    ++*(size_t *)context;
+}
+
+int main(void)
+{
+    size_t t, k;
+
+    build_highway(&tracks[0]);
+    build_city(&tracks[1]);
+
+    printf("Points per second and points in per point kept:\n");
+    printf("  %-8s %9s %14s %8s %14s %8s\n", "track", "tolerance", "window pts/s", "ratio", "DP pts/s", "ratio");
+
+    for (t = 0; t < 2; ++t)
+    {
+        const struct track *track = &tracks[t];
+
+        for (k = 0; k < sizeof(tolerances) / sizeof(tolerances[0]); ++k)
+        {
+            struct gps_simplify simplify;
+            struct gps_tpv tpv;
+            size_t window_kept = 0;
+            size_t dp_kept = 0;
+            double window_time;
+            double dp_time;
+            double start;
+            int run;
+            size_t i;
+
+            gps_init_tpv(&tpv);
+            start = now();
+            for (run = 0; run < NUM_RUNS; ++run)
+            {
+                window_kept = 0;
+                gps_simplify_init(&simplify, tolerances[k], on_point, &window_kept);
+                for (i = 0; i < track->count; ++i)
+                {
+                    tpv.latitude = track->latitude[i];
+                    tpv.longitude = track->longitude[i];
+                    gps_simplify_add(&simplify, &tpv, (int64_t)i);
+                }
+                gps_simplify_flush(&simplify);
+            }
+            window_time = now() - start;
+
+            start = now();
+            for (run = 0; run < NUM_RUNS; ++run)
+            {
+                dp_kept = gps_simplify_track(track->latitude, track->longitude, track->count,
+                                             tolerances[k], keep);
+            }
+            dp_time = now() - start;
+
+            printf("  %-8s %8dm %14.3g %8.1f %14.3g %8.1f\n", track->name, tolerances[k] / GPS_VALUE_FACTOR,
+                   NUM_RUNS * track->count / window_time, (double)track->count / window_kept,
+                   NUM_RUNS * track->count / dp_time, (double)track->count / dp_kept);
+        }
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,215 @@
+/* Compressed Log Benchmark
+ *
+ * Builds eight hours of 1 Hz receiver output, GGA, RMC, GSA and VTG every
+ * second, and stores it uncompressed and in every compressed format of this
+ * build. Each file is decoded twice: by decompressing all of it into memory
+ * and then decoding it, and by gps_stream_decode(), which decodes while it
+ * decompresses. The compression ratio and the throughput in megabytes of
+ * NMEA per second are reported for every format.
+ */
+
+#include "gps.h"
+#include "gps_stream.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifdef GPS_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+#ifdef GPS_HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+#define NUM_EPOCHS (8 * 3600)
+#define LOG_SIZE   (NUM_EPOCHS * 4 * 96)
+#define NUM_RUNS   (5)
+
+static char log_text[LOG_SIZE];
+static char scratch[LOG_SIZE];
+static unsigned char packed[LOG_SIZE];
+static struct gps_stream stream;
+
+static double now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static void on_tpv(void *context, const struct gps_tpv *tpv)
+{
+    (void)tpv;
+    ++*(uint32_t *)context;
+}
+
+static size_t build_log(void)
+{
+    char body[96];
+    size_t size = 0;
+    int e;
+
+    for (e = 0; e < NUM_EPOCHS; ++e)
+    {
+        int h = e / 3600;
+        int m = (e / 60) % 60;
+        int s = e % 60;
+
+        sprintf(body, "GPGGA,%02d%02d%02d.000,5321.%04d,N,00630.%04d,W,1,8,1.03,61.7,M,55.3,M,,",
+                h, m, s, e % 10000, (e * 7) % 10000);
+        gps_encode(log_text + size, body);
+        size += strlen(log_text + size);
+        sprintf(body, "GPRMC,%02d%02d%02d.000,A,5321.%04d,N,00630.%04d,W,0.02,31.66,280511,,,A",
+                h, m, s, e % 10000, (e * 7) % 10000);
+        gps_encode(log_text + size, body);
+        size += strlen(log_text + size);
+        gps_encode(log_text + size, "GPGSA,A,3,10,07,05,02,29,04,08,13,,,,,1.72,1.03,1.38");
+        size += strlen(log_text + size);
+        sprintf(body, "GPVTG,%d.%02d,T,,M,0.02,N,0.04,K,A", e % 360, e % 100);
+        gps_encode(log_text + size, body);
+        size += strlen(log_text + size);
+    }
+
+    return size;
+}
+
+/* Decodes the log decompressed into scratch, line by line */
+static uint32_t decode_all(size_t size)
+{
+    struct gps_tpv tpv;
+    const char *line = scratch;
+    const char *end = scratch + size;
+    uint32_t count = 0;
+
+    gps_init_tpv(&tpv);
+    while (line < end)
+    {
+        const char *eol = memchr(line, '\n', (size_t)(end - line));
+        const char *next = (NULL == eol) ? end : eol + 1;
+
+        if (GPS_OK == gps_decode_const(&tpv, line, (size_t)(next - line))) ++count;
+        line = next;
+    }
+
+    return count;
+}
+
+static size_t unpack_plain(size_t size)
+{
+    memcpy(scratch, packed, size);
+    return size;
+}
+
+#ifdef GPS_HAVE_ZLIB
+static size_t pack_gzip(size_t size)
+{
+    z_stream z;
+    size_t n;
+
+    memset(&z, 0, sizeof(z));
+    deflateInit2(&z, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY);
+    z.next_in = (Bytef *)log_text;
+    z.avail_in = (uInt)size;
+    z.next_out = packed;
+    z.avail_out = sizeof(packed);
+    deflate(&z, Z_FINISH);
+    n = z.total_out;
+    deflateEnd(&z);
+
+    return n;
+}
+
+static size_t unpack_gzip(size_t size)
+{
+    z_stream z;
+    size_t n;
+
+    memset(&z, 0, sizeof(z));
+    inflateInit2(&z, 15 + 32);
+    z.next_in = packed;
+    z.avail_in = (uInt)size;
+    z.next_out = (Bytef *)scratch;
+    z.avail_out = sizeof(scratch);
+    inflate(&z, Z_FINISH);
+    n = z.total_out;
+    inflateEnd(&z);
+
+    return n;
+}
+#endif
+
+#ifdef GPS_HAVE_ZSTD
+static size_t pack_zstd(size_t size)
+{
+    return ZSTD_compress(packed, sizeof(packed), log_text, size, 3);
+}
+
+static size_t unpack_zstd(size_t size)
+{
+    return ZSTD_decompress(scratch, sizeof(scratch), packed, size);
+}
+#endif
+
+static void run(const char *name, size_t size, size_t packed_size, size_t (*unpack)(size_t))
+{
+    double sequential = 0;
+    double streamed = 0;
+    uint32_t count = 0;
+    int r;
+    FILE *file = tmpfile();
+
+    if (NULL == file)
+    {
+        perror("tmpfile");
+        exit(EXIT_FAILURE);
+    }
+    fwrite(packed, 1, packed_size, file);
+
+    for (r = 0; r < NUM_RUNS; ++r)
+    {
+        double start;
+
+        /* Reading the file is left out of the sequential time, and the file
+         * is in the page cache for the streamed one
+         */
+        rewind(file);
+        if (fread(packed, 1, packed_size, file) != packed_size) break;
+        start = now();
+        count = decode_all(unpack(packed_size));
+        sequential += now() - start;
+
+        rewind(file);
+        count = 0;
+        start = now();
+        gps_stream_decode(&stream, file, on_tpv, &count);
+        streamed += now() - start;
+    }
+    fclose(file);
+
+    printf("  %-6s %6.1f%% %10.1f %10.1f %10u\n", name, 100.0 * packed_size / size,
+           NUM_RUNS * size / sequential / 1e6, NUM_RUNS * size / streamed / 1e6, count);
+}
+
+int main(void)
+{
+    size_t size = build_log();
+
+    printf("Decoding %.1f MB of NMEA, in MB/s:\n", size / 1e6);
+    printf("  %-6s %7s %10s %10s %10s\n", "format", "size", "sequential", "streamed", "sentences");
+
+    memcpy(packed, log_text, size);
+    run("plain", size, size, unpack_plain);
+#ifdef GPS_HAVE_ZLIB
+    run("gzip", size, pack_gzip(size), unpack_gzip);
+#endif
+#ifdef GPS_HAVE_ZSTD
+    run("zstd", size, pack_zstd(size), unpack_zstd);
+#endif
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,241 @@
+/* Worst Case Execution Time Benchmark
+ *
+ * Drive every decoding entry point with adversarial sentences: the longest
+ * sentence the steppers accept, the most fields the decoder tokenizes, long
+ * runs of digits in the parsed fields, and a bad checksum. Each call is
+ * timed on its own with the cycle counter, many times over. For every entry
+ * point, the slowest input is reported by its fastest run, which is the cost
+ * of the code path itself, along with the slowest run seen at all, which
+ * adds cache misses and interrupts.
+ *
+ * read_cycles() is the only platform dependent part. On a microcontroller,
+ * replace it with the core cycle counter, such as DWT->CYCCNT on Cortex-M.
+ */
+
+#include "gps.h"
+#include "gps_ring.h"
+#include "gps_step.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+
+#define CYCLE_UNIT "TSC ticks"
+
+static uint64_t read_cycles(void)
+{
+    return __rdtsc();
+}
+#else
+#define CYCLE_UNIT "ns"
+
+static uint64_t read_cycles(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+#endif
+
+#define NUM_INPUTS     (6)
+#define NUM_RUNS       (20000)
+#define STEP_BUDGET    (16)
+#define RING_SIZE      (256)
+
+enum entry_point
+{
+    DECODE,
+    DECODE_CONST,
+    RING_DECODE,
+    STEP_FEED,
+    STEP_DECODE,
+    NUM_ENTRY_POINTS
+};
+
+static const char *entry_names[NUM_ENTRY_POINTS] = {
+    "gps_decode",
+    "gps_decode_const",
+    "gps_ring_decode",
+    "gps_step_feed",
+    "gps_step_decode"
+};
+
+static const char *input_names[NUM_INPUTS] = {
+    "typical GGA",
+    "longest GGA",
+    "31 commas",
+    "digit runs",
+    "bad checksum",
+    "unsupported"
+};
+
+struct worst
+{
+    uint64_t fastest; /* Fastest run of the slowest input */
+    uint64_t slowest; /* Slowest run seen */
+    int input;        /* The slowest input */
+};
+
+static uint64_t overhead;
+
+static void record(struct worst *worst, int input, uint64_t fastest, uint64_t slowest)
+{
+    fastest = (fastest > overhead) ? fastest - overhead : 0;
+    slowest = (slowest > overhead) ? slowest - overhead : 0;
+
+    if (fastest > worst->fastest)
+    {
+        worst->fastest = fastest;
+        worst->input = input;
+    }
+    if (slowest > worst->slowest) worst->slowest = slowest;
+}
+
+/* Places the sentence so that it wraps around the end of the ring, which is
+ * the slow path of gps_ring_decode()
+ */
+static size_t fill_ring(char *ring, const char *nmea, size_t length)
+{
+    size_t start = RING_SIZE - length / 2;
+    size_t i;
+
+    for (i = 0; i < length; ++i) ring[(start + i) % RING_SIZE] = nmea[i];
+    return start;
+}
+
+int main(void)
+{
+    static char nmea[NUM_INPUTS][GPS_STEP_SENTENCE_SIZE + 1];
+    struct worst worst[NUM_ENTRY_POINTS];
+    struct gps_tpv tpv;
+    struct gps_ring ring;
+    struct gps_step step;
+    char buffer[RING_SIZE];
+    char copy[GPS_STEP_SENTENCE_SIZE + 1];
+    char body[GPS_STEP_SENTENCE_SIZE];
+    size_t length;
+    int input;
+    int e;
+    long n;
+
+    /* Inputs. Every one of them fits in GPS_STEP_SENTENCE_SIZE characters. */
+    gps_encode(nmea[0], "GPGGA,092751.000,5321.6802,N,00630.3371,W,1,8,1.03,61.7,M,55.3,M,,");
+    gps_encode(nmea[1], "GPGGA,092751.999,5321.680212,N,00630.337199,W,1,12,1.03,-12345.678,M,55.3,M,"
+                        "12345678901234567,12345678");
+    strcpy(body, "GPGSA,A,3");
+    memset(body + strlen(body), ',', 29);
+    body[38] = '\0';
+    gps_encode(nmea[2], body);
+    gps_encode(nmea[3], "GPGGA,235959.999,8959.999999,S,17959.999999,E,1,8,1.03,"
+                        "0000000000000000000000000000000000000000000000001.999,M,55.3,M,,");
+    strcpy(nmea[4], nmea[1]);
+    nmea[4][strlen(nmea[4]) - 3] ^= 1;
+    gps_encode(nmea[5], "GPXXX,092751.999,5321.680212,N,00630.337199,W,1,12,1.03,-12345.678,M,55.3,M,"
+                        "12345678901234567,12345678");
+
+    for (input = 0; input < NUM_INPUTS; ++input)
+    {
+        if (strlen(nmea[input]) > GPS_STEP_SENTENCE_SIZE)
+        {
+            fprintf(stderr, "Input %s is too long\n", input_names[input]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    /* Cost of reading the counter itself */
+    overhead = UINT64_MAX;
+    for (n = 0; n < NUM_RUNS; ++n)
+    {
+        uint64_t start = read_cycles();
+        uint64_t cycles = read_cycles() - start;
+
+        if (cycles < overhead) overhead = cycles;
+    }
+
+    memset(worst, 0, sizeof(worst));
+    memset(buffer, 0, sizeof(buffer));
+    gps_init_tpv(&tpv);
+
+    for (input = 0; input < NUM_INPUTS; ++input)
+    {
+        uint64_t fastest[NUM_ENTRY_POINTS];
+        uint64_t slowest[NUM_ENTRY_POINTS];
+
+        length = strlen(nmea[input]);
+        for (e = 0; e < NUM_ENTRY_POINTS; ++e)
+        {
+            fastest[e] = UINT64_MAX;
+            slowest[e] = 0;
+        }
+
+        for (n = 0; n < NUM_RUNS; ++n)
+        {
+            uint64_t start;
+            uint64_t cycles[NUM_ENTRY_POINTS];
+            size_t read;
+            size_t offset;
+
+            memcpy(copy, nmea[input], length + 1);
+            start = read_cycles();
+            gps_decode(&tpv, copy);
+            cycles[DECODE] = read_cycles() - start;
+
+            start = read_cycles();
+            gps_decode_const(&tpv, nmea[input], length);
+            cycles[DECODE_CONST] = read_cycles() - start;
+
+            read = fill_ring(buffer, nmea[input], length);
+            gps_ring_init(&ring, buffer, RING_SIZE, read);
+            start = read_cycles();
+            gps_ring_decode(&ring, (read + length) % RING_SIZE, &tpv);
+            cycles[RING_DECODE] = read_cycles() - start;
+
+            /* The slowest of the feed calls making up the sentence */
+            gps_step_init(&step);
+            cycles[STEP_FEED] = 0;
+            for (offset = 0; offset < length;)
+            {
+                uint64_t feed;
+
+                start = read_cycles();
+                offset += gps_step_feed(&step, nmea[input] + offset, length - offset, STEP_BUDGET);
+                feed = read_cycles() - start;
+                if (feed > cycles[STEP_FEED]) cycles[STEP_FEED] = feed;
+            }
+
+            start = read_cycles();
+            gps_step_decode(&step, &tpv);
+            cycles[STEP_DECODE] = read_cycles() - start;
+
+            for (e = 0; e < NUM_ENTRY_POINTS; ++e)
+            {
+                if (cycles[e] < fastest[e]) fastest[e] = cycles[e];
+                if (cycles[e] > slowest[e]) slowest[e] = cycles[e];
+            }
+        }
+
+        for (e = 0; e < NUM_ENTRY_POINTS; ++e)
+        {
+            record(&worst[e], input, fastest[e], slowest[e]);
+        }
+    }
+
+    printf("Worst case per call, in %s, over %d runs of each input:\n", CYCLE_UNIT, NUM_RUNS);
+    printf("  %-18s %8s %8s  %s\n", "entry point", "path", "seen", "slowest input");
+    for (e = 0; e < NUM_ENTRY_POINTS; ++e)
+    {
+        printf("  %-18s %8llu %8llu  %s\n", entry_names[e],
+               (unsigned long long)worst[e].fastest,
+               (unsigned long long)worst[e].slowest,
+               input_names[worst[e].input]);
+    }
+    printf("gps_step_feed examines at most %d characters per call.\n", STEP_BUDGET);
+
+    return EXIT_SUCCESS;
+}
@@ -29,8 +29,10 @@ THE SOFTWARE.
 #include <stddef.h>
 #include <string.h>
 
-#define NMEA_MAX_FIELDS  (32)
-#define SENTENCE_ID_SIZE (3)
+#define NMEA_MAX_FIELDS    (32)
+#define NMEA_PARSED_FIELDS (10) /* One past the highest token read by a parse function */
+#define SENTENCE_ID_SIZE   (3)
+#define NUMBER_MAX         (INT32_MAX / GPS_VALUE_FACTOR - 1) /* Largest integer part parse_number() accepts */
 
 #define is_char_in_range(c, start, end) \
     (((uint_fast8_t)(c - start)) < ((uint_fast8_t)(end - start + 1)))
@@ -41,6 +43,19 @@ THE SOFTWARE.
 #define is_digit_0_to_5(c) is_char_in_range(c, '0', '5')
 #define is_digit_0_to_9(c) is_char_in_range(c, '0', '9')
 
+/* The sentence body is scanned 8 characters at a time, SIMD within a
+ * register, on targets with at least 32 bit pointers. Define GPS_SWAR as 0
+ * to scan one character at a time, which may be faster on 8 and 16 bit
+ * microcontrollers.
+ */
+#ifndef GPS_SWAR
+#if UINTPTR_MAX > 0xFFFFu
+#define GPS_SWAR (1)
+#else
+#define GPS_SWAR (0)
+#endif
+#endif
+
 typedef void (*parse_function)(struct gps_tpv *, const char **);
 
 static const char NULL_TIME[] = "0000-00-00T00:00:00.000Z";
@@ -81,6 +96,105 @@ static bool match_sentence_id(const char *str, const char *id)
     return strncmp(str, id, SENTENCE_ID_SIZE) == 0;
 }
 
+#if GPS_SWAR
+#define SWAR_ONES (UINT64_C(0x0101010101010101))
+#define SWAR_HIGH (UINT64_C(0x8080808080808080))
+
+/* Loads 8 characters with the first one in the lowest byte, whatever the
+ * byte order of the target
+ */
+static uint64_t swar_load(const char *str)
+{
+    const unsigned char *s = (const unsigned char *)str;
+
+    return  (uint64_t)s[0]        | ((uint64_t)s[1] << 8)  |
+           ((uint64_t)s[2] << 16) | ((uint64_t)s[3] << 24) |
+           ((uint64_t)s[4] << 32) | ((uint64_t)s[5] << 40) |
+           ((uint64_t)s[6] << 48) | ((uint64_t)s[7] << 56);
+}
+
+/* Sets the top bit of every byte of word which equals c, and no other bit.
+ * Unlike the usual zero byte test, the sum cannot carry between bytes, so
+ * every match is flagged and not just the first.
+ */
+static uint64_t swar_match(uint64_t word, char c)
+{
+    uint64_t x = word ^ (SWAR_ONES * (uint8_t)c);
+
+    return ~(((x & ~SWAR_HIGH) + ~SWAR_HIGH) | x) & SWAR_HIGH;
+}
+
+/* Returns the index of the lowest byte flagged by swar_match() */
+static uint_fast8_t swar_first(uint64_t matches)
+{
+#if defined(__GNUC__)
+    return (uint_fast8_t)(__builtin_ctzll(matches) >> 3);
+#else
+    uint64_t below = ((matches & (0 - matches)) >> 7) - 1;
+
+    return (uint_fast8_t)(((below & SWAR_ONES) * SWAR_ONES) >> 56);
+#endif
+}
+#endif
+
+/* Finds the start of each field in the sentence body and computes its
+ * checksum, up to the '*' which ends it. The body is only read, so each token
+ * runs up to the next ',' or '*'. Fields past NMEA_MAX_FIELDS are ignored,
+ * and missing fields read as empty. Returns a pointer to the '*', or NULL if
+ * the body reaches end first.
+ */
+static const char *tokenize(const char *nmea, const char *end, const char **token,
+                            uint_fast8_t *count, uint8_t *checksum)
+{
+    uint8_t sum = *checksum;
+    uint_fast8_t i = 0;
+
+    end = memchr(nmea, '*', (size_t)(end - nmea));
+    if (NULL == end) return NULL;
+
+#if GPS_SWAR
+    {
+        uint64_t sums = 0;
+
+        /* The checksum is the XOR of all characters, which is the XOR of
+         * the bytes of the XOR of all words. Separators are found with one
+         * mask test per word.
+         */
+        for (; end - nmea >= 8; nmea += 8)
+        {
+            uint64_t word = swar_load(nmea);
+            uint64_t commas = swar_match(word, ',');
+
+            sums ^= word;
+            while (commas)
+            {
+                if (i < NMEA_MAX_FIELDS) token[i++] = nmea + swar_first(commas) + 1;
+                commas &= commas - 1;
+            }
+        }
+
+        sums ^= sums >> 32;
+        sums ^= sums >> 16;
+        sums ^= sums >> 8;
+        sum ^= (uint8_t)sums;
+    }
+#endif
+
+    for (; nmea < end; ++nmea)
+    {
+        char c0 = *nmea;
+
+        sum ^= c0;
+        if ((',' == c0) && (i < NMEA_MAX_FIELDS)) token[i++] = nmea + 1;
+    }
+
+    *count = i;
+    while (i < NMEA_PARSED_FIELDS) token[i++] = "";
+
+    *checksum = sum;
+    return end;
+}
+
 static int32_t parse_number(const char *str)
 {
     int32_t value = 0;
@@ -102,7 +216,8 @@ static int32_t parse_number(const char *str)
         c0 = *str++;
     }
 
-    /* Store one or more decimal digits
+    /* Store one or more decimal digits, giving up on values which would
+     * overflow once scaled
      * Regex : [0-9]+
      */
     if (is_digit_0_to_9(c0))
@@ -110,6 +225,7 @@ static int32_t parse_number(const char *str)
         do
         {
             value = (value * 10) + (c0 - '0');
+            if (value > NUMBER_MAX) return GPS_INVALID_VALUE;
             c0 = *str++;
         }
         while (is_digit_0_to_9(c0));
@@ -526,10 +642,12 @@ static int32_t parse_speed(const char *nmea, const char unit)
     {
     case 'K':
         speed = parse_number(nmea);
-        return (speed * 10) / 36;
+        if (GPS_INVALID_VALUE == speed) break;
+        return (int32_t)(((int64_t)speed * 10) / 36);
     case 'N':
         speed = parse_number(nmea);
-        return (speed * 1000) / 1944;
+        if (GPS_INVALID_VALUE == speed) break;
+        return (int32_t)(((int64_t)speed * 1000) / 1944);
     default:
         break;
     }
@@ -556,6 +674,58 @@ static bool is_status_valid(const char status)
     return false;
 }
 
+static int64_t digits_to_int(const char *str, uint_fast8_t n)
+{
+    int64_t value = 0;
+
+    while (n--)
+    {
+        value = (value * 10) + (*str++ - '0');
+    }
+
+    return value;
+}
+
+static void int_to_digits(char *str, int64_t value, uint_fast8_t n)
+{
+    while (n--)
+    {
+        str[n] = (char)('0' + (value % 10));
+        value /= 10;
+    }
+}
+
+/* Days since 1970-01-01 for a proleptic Gregorian date. See Howard Hinnant's
+ * "chrono-Compatible Low-Level Date Algorithms".
+ */
+static int64_t days_from_civil(int64_t y, int64_t m, int64_t d)
+{
+    int64_t era, yoe, doy, doe;
+
+    y -= m <= 2;
+    era = (y >= 0 ? y : y - 399) / 400;
+    yoe = y - era * 400;
+    doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+    doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+
+    return era * 146097 + doe - 719468;
+}
+
+static void civil_from_days(int64_t z, int64_t *y, int64_t *m, int64_t *d)
+{
+    int64_t era, doe, yoe, doy, mp;
+
+    z += 719468;
+    era = (z >= 0 ? z : z - 146096) / 146097;
+    doe = z - era * 146097;
+    yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    mp  = (5 * doy + 2) / 153;
+    *d  = doy - (153 * mp + 2) / 5 + 1;
+    *m  = mp + (mp < 10 ? 3 : -9);
+    *y  = yoe + era * 400 + (*m <= 2);
+}
+
 static void parse_gga(struct gps_tpv *tpv, const char **token)
 {
     parse_time(tpv->time, token[0]);
@@ -604,6 +774,32 @@ static void parse_zda(struct gps_tpv *tpv, const char **token)
     parse_extended_date(tpv->time, token[1], token[2], token[3]);
 }
 
+/* Selects the parse function for a sentence ID, or NULL if unsupported */
+static parse_function find_parser(const char *id)
+{
+    /* TODO: Switch checking for sentences on and off using # defines and a config.h */
+    if (match_sentence_id(id, "GGA")) return parse_gga;
+    if (match_sentence_id(id, "GLL")) return parse_gll;
+    if (match_sentence_id(id, "GSA")) return parse_gsa;
+    if (match_sentence_id(id, "RMC")) return parse_rmc;
+    if (match_sentence_id(id, "VTG")) return parse_vtg;
+    if (match_sentence_id(id, "ZDA")) return parse_zda;
+
+    return NULL;
+}
+
+/* Validates the checksum and footer which follow the '*' at star, reading
+ * nothing at or past end
+ */
+static int check_footer(const char *star, const char *end, uint8_t checksum)
+{
+    if (end - star < 3) return GPS_ERROR_TRUNCATED;
+    if (checksum != build_hex_byte(star[1], star[2])) return GPS_ERROR_CHECKSUM;
+    if ((end - star < 5) || (star[3] != '\r') || (star[4] != '\n')) return GPS_ERROR_FOOT;
+
+    return GPS_OK;
+}
+
 void gps_init_tpv(struct gps_tpv *tpv)
 {
     assert(tpv != NULL);
@@ -660,11 +856,15 @@ int gps_decode(struct gps_tpv *tpv, char *nmea)
     assert(nmea != NULL);
 
     parse_function parse;
-    char *token[NMEA_MAX_FIELDS];
+    const char *token[NMEA_MAX_FIELDS];
+    const char *end;
+    const char *star;
+    uint_fast8_t count;
+    uint_fast8_t i;
     uint8_t checksum = 0;
-    uint8_t i = 0;
     char c0 = *nmea++;
     char c1;
+    int result;
 
     /* Check if the first character is the header */
     if (c0 != '$') return GPS_ERROR_HEAD;
@@ -680,69 +880,231 @@ int gps_decode(struct gps_tpv *tpv, char *nmea)
     checksum ^= c0 ^ c1;
 
     /* Use the sentence ID to determine which parsing function to use */
-    /* TODO: Switch checking for sentences on and off using # defines and a config.h */
-    if (memchr(nmea, '\0', SENTENCE_ID_SIZE))
-        return GPS_ERROR_TRUNCATED;
-    else if (match_sentence_id(nmea, "GGA"))
-        parse = parse_gga;
-    else if (match_sentence_id(nmea, "GLL"))
-        parse = parse_gll;
-    else if (match_sentence_id(nmea, "GSA"))
-        parse = parse_gsa;
-    else if (match_sentence_id(nmea, "RMC"))
-        parse = parse_rmc;
-    else if (match_sentence_id(nmea, "VTG"))
-        parse = parse_vtg;
-    else if (match_sentence_id(nmea, "ZDA"))
-        parse = parse_zda;
-    else
-        return GPS_ERROR_UNSUPPORTED;
-
-    /* Advance c0 to the first character in the sentence ID. This also syncs
-     * the NMEA string pointer with the current character being processed.
-     * This helps to make the tokenizing stage easier to maintain.
-     */
-    c0 = *nmea;
+    if (memchr(nmea, '\0', SENTENCE_ID_SIZE)) return GPS_ERROR_TRUNCATED;
+    parse = find_parser(nmea);
+    if (NULL == parse) return GPS_ERROR_UNSUPPORTED;
 
     /* Tokenize and compute the checksum for the body of the NMEA sentence.
      * Note that tokenizing begins after the first ',' is encountered. This
      * works because the sentence ID is the first string processed and we do
      * not need to store it as a token.
      */
-    while (c0 != '*')
+    end = nmea + strlen(nmea);
+    star = tokenize(nmea, end, token, &count, &checksum);
+    if (NULL == star) return GPS_ERROR_TRUNCATED;
+
+    /* Replace each ',' and the '*' with a NUL in order to mark the end of
+     * every token in the sentence.
+     */
+    for (i = 0; i < count; ++i)
     {
-        if (!c0) return GPS_ERROR_TRUNCATED;
-        checksum ^= c0;
-        if (',' == c0)
-        {
-            *nmea = '\0';
-            token[i++] = nmea + 1;
-        }
-        c0 = (++nmea)[0];
+        nmea[token[i] - nmea - 1] = '\0';
     }
+    nmea[star - nmea] = '\0';
 
-    /* Replace the '*' with a NUL in order to mark the end of the final token
-     * in the sentence. Then advance the pointer nmea one position ahead
-     * again.
-     */
-    *nmea++ = '\0';
-    c0 = *nmea++;
+    result = check_footer(star, end, checksum);
+    if (result != GPS_OK) return result;
 
-    /* Validate the checksum */
-    c1 = *nmea++;
-    if (checksum != build_hex_byte(c0, c1)) return GPS_ERROR_CHECKSUM;
-    c0 = *nmea++;
+    /* Parse the NMEA sentence tokens */
+    parse(tpv, token);
 
-    /* Check for the message footer */
-    c1 = *nmea++;
-    if ((c0 != '\r') || (c1 != '\n')) return GPS_ERROR_FOOT;
+    return GPS_OK;
+}
+
+/* Checks the header of a sentence held in read only memory, and that its
+ * talker and sentence IDs may be read
+ */
+static int check_header_const(const char *nmea, size_t size)
+{
+    if ((0 == size) || (nmea[0] != '$')) return GPS_ERROR_HEAD;
+    if (size < 3 + SENTENCE_ID_SIZE) return GPS_ERROR_TRUNCATED;
+
+    return GPS_OK;
+}
+
+/* Decodes a sentence held in read only memory, once its header has been
+ * checked, with the parse function its sentence ID selected, if any
+ */
+static int decode_const(struct gps_tpv *tpv, const char *nmea, size_t size, parse_function parse)
+{
+    const char *token[NMEA_MAX_FIELDS];
+    const char *end = nmea + size;
+    const char *star;
+    uint_fast8_t count;
+    uint8_t checksum;
+    int result;
+
+    /* Store the talker ID */
+    tpv->talker_id[0] = nmea[1];
+    tpv->talker_id[1] = nmea[2];
+    checksum = nmea[1] ^ nmea[2];
+    nmea += 3;
+
+    if (NULL == parse) return GPS_ERROR_UNSUPPORTED;
+
+    /* Tokenize the body without terminating the tokens. Every parse function
+     * stops at the first character it does not expect, so a ',' or '*' ends
+     * a field just as well as a NUL would.
+     */
+    star = tokenize(nmea, end, token, &count, &checksum);
+    if (NULL == star) return GPS_ERROR_TRUNCATED;
+
+    result = check_footer(star, end, checksum);
+    if (result != GPS_OK) return result;
 
     /* Parse the NMEA sentence tokens */
-    parse(tpv, (const char **)token);
+    parse(tpv, token);
 
     return GPS_OK;
 }
 
+/* Decodes a sentence only if it has the given sentence ID. Does not refer
+ * to find_parser(), so the parsers of other sentences may be left out.
+ */
+static int decode_only(struct gps_tpv *tpv, const char *nmea, size_t size, const char *id, parse_function parse)
+{
+    int result = check_header_const(nmea, size);
+
+    if (result != GPS_OK) return result;
+
+    return decode_const(tpv, nmea, size, match_sentence_id(nmea + 3, id) ? parse : NULL);
+}
+
+int gps_decode_const(struct gps_tpv *tpv, const char *nmea, size_t size)
+{
+    assert(tpv != NULL);
+    assert(nmea != NULL);
+
+    int result = check_header_const(nmea, size);
+
+    if (result != GPS_OK) return result;
+
+    return decode_const(tpv, nmea, size, find_parser(nmea + 3));
+}
+
+int gps_check_const(const char *nmea, size_t size)
+{
+    assert(nmea != NULL);
+
+    const char *end = nmea + size;
+    const char *star;
+    uint8_t checksum = 0;
+    int result = check_header_const(nmea, size);
+
+    if (result != GPS_OK) return result;
+
+    star = memchr(nmea, '*', size);
+    if (NULL == star) return GPS_ERROR_TRUNCATED;
+    for (++nmea; nmea < star; ++nmea) checksum ^= *nmea;
+
+    return check_footer(star, end, checksum);
+}
+
+int gps_decode_gga(struct gps_tpv *tpv, const char *nmea, size_t size)
+{
+    assert(tpv != NULL);
+    assert(nmea != NULL);
+
+    return decode_only(tpv, nmea, size, "GGA", parse_gga);
+}
+
+int gps_decode_gll(struct gps_tpv *tpv, const char *nmea, size_t size)
+{
+    assert(tpv != NULL);
+    assert(nmea != NULL);
+
+    return decode_only(tpv, nmea, size, "GLL", parse_gll);
+}
+
+int gps_decode_gsa(struct gps_tpv *tpv, const char *nmea, size_t size)
+{
+    assert(tpv != NULL);
+    assert(nmea != NULL);
+
+    return decode_only(tpv, nmea, size, "GSA", parse_gsa);
+}
+
+int gps_decode_rmc(struct gps_tpv *tpv, const char *nmea, size_t size)
+{
+    assert(tpv != NULL);
+    assert(nmea != NULL);
+
+    return decode_only(tpv, nmea, size, "RMC", parse_rmc);
+}
+
+int gps_decode_vtg(struct gps_tpv *tpv, const char *nmea, size_t size)
+{
+    assert(tpv != NULL);
+    assert(nmea != NULL);
+
+    return decode_only(tpv, nmea, size, "VTG", parse_vtg);
+}
+
+int gps_decode_zda(struct gps_tpv *tpv, const char *nmea, size_t size)
+{
+    assert(tpv != NULL);
+    assert(nmea != NULL);
+
+    return decode_only(tpv, nmea, size, "ZDA", parse_zda);
+}
+
+int64_t gps_time_to_ms(const char *time)
+{
+    assert(time != NULL);
+
+    int64_t year  = digits_to_int(time + 0, 4);
+    int64_t month = digits_to_int(time + 5, 2);
+    int64_t day   = digits_to_int(time + 8, 2);
+    int64_t ms;
+
+    ms  = digits_to_int(time + 11, 2) * 3600000;
+    ms += digits_to_int(time + 14, 2) * 60000;
+    ms += digits_to_int(time + 17, 2) * 1000;
+    ms += digits_to_int(time + 20, 3);
+
+    if (!gps_time_has_date(time)) return ms;
+
+    return days_from_civil(year, month, day) * GPS_MS_PER_DAY + ms;
+}
+
+int gps_time_has_date(const char *time)
+{
+    assert(time != NULL);
+
+    /* The decoder always writes the month when it writes a date */
+    return (time[5] != '0') || (time[6] != '0');
+}
+
+void gps_ms_to_time(char *time, int64_t ms, int has_date)
+{
+    assert(time != NULL);
+
+    int64_t days = ms / GPS_MS_PER_DAY;
+    int64_t year, month, day;
+
+    /* Floor the division so that times before the epoch stay in range */
+    ms %= GPS_MS_PER_DAY;
+    if (ms < 0)
+    {
+        ms += GPS_MS_PER_DAY;
+        --days;
+    }
+
+    strcpy(time, NULL_TIME);
+    if (has_date)
+    {
+        civil_from_days(days, &year, &month, &day);
+        int_to_digits(time + 0, year, 4);
+        int_to_digits(time + 5, month, 2);
+        int_to_digits(time + 8, day, 2);
+    }
+
+    int_to_digits(time + 11, ms / 3600000, 2);
+    int_to_digits(time + 14, (ms / 60000) % 60, 2);
+    int_to_digits(time + 17, (ms / 1000) % 60, 2);
+    int_to_digits(time + 20, ms % 1000, 3);
+}
+
 const char *gps_error_string(const int e)
 {
     static const char *msg[] = {
@@ -751,9 +1113,58 @@ const char *gps_error_string(const int e)
         "Footer CRLF missing",
         "Checksum did not match",
         "Sentence truncated",
-        "Unsupported NMEA sentence"
+        "Unsupported NMEA sentence",
+        "No more data",
+        "Buffer too small",
+        "I/O function failed",
+        "Encoded data is malformed",
+        "Data source restarted"
     };
 
     if ((0 <= e) && (e < ((int)(sizeof(msg) / sizeof(msg[0]))))) return msg[e];
     return "Unknown error";
 }
+
+#ifdef GPS_TEST_INTERNALS
+#include "gps_internal.h"
+
+#if GPS_INTERNAL_MAX_FIELDS != NMEA_MAX_FIELDS
+#error "GPS_INTERNAL_MAX_FIELDS does not match NMEA_MAX_FIELDS"
+#endif
+
+const char *gps_internal_tokenize(const char *nmea, const char *end, const char **token,
+                                  uint_fast8_t *count, uint8_t *checksum)
+{
+    return tokenize(nmea, end, token, count, checksum);
+}
+
+int gps_internal_find_parser(const char *id)
+{
+    return find_parser(id) != NULL;
+}
+
+int32_t gps_internal_parse_number(const char *field)
+{
+    return parse_number(field);
+}
+
+int32_t gps_internal_parse_angular_distance(const char *field, char direction)
+{
+    return parse_angular_distance(field, direction);
+}
+
+void gps_internal_parse_time(char *time, const char *field)
+{
+    parse_time(time, field);
+}
+
+void gps_internal_parse_date(char *time, const char *field)
+{
+    parse_date(time, field);
+}
+
+int32_t gps_internal_parse_speed(const char *field, char unit)
+{
+    return parse_speed(field, unit);
+}
+#endif
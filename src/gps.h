@@ -41,6 +41,7 @@ THE SOFTWARE.
 #ifndef _GPS_H_
 #define _GPS_H_
 
+#include <stddef.h>
 #include <stdint.h>
 
 /* String sizes */
@@ -54,6 +55,9 @@ THE SOFTWARE.
 #define GPS_VALUE_FACTOR   (1000)    /**< The scale factor for use with most data values */
 #define GPS_LAT_LON_FACTOR (1000000) /**< The scale factor for use with latitude and longitude values */
 
+/* Time constants */
+#define GPS_MS_PER_DAY (86400000) /**< The number of milliseconds in one day */
+
 /* Result codes */
 #define GPS_OK                (0) /**< Indicates no error has occured */
 #define GPS_ERROR_HEAD        (1) /**< The header is missing from the NMEA sentence */
@@ -61,6 +65,11 @@ THE SOFTWARE.
 #define GPS_ERROR_CHECKSUM    (3) /**< The checksum did not match the computer value */
 #define GPS_ERROR_TRUNCATED   (4) /**< The input NMEA sentence is incomplete */
 #define GPS_ERROR_UNSUPPORTED (5) /**< An unsupported operation was requested */
+#define GPS_ERROR_END         (6) /**< There is no more data to read */
+#define GPS_ERROR_OVERFLOW    (7) /**< The supplied buffer is too small */
+#define GPS_ERROR_IO          (8) /**< A user supplied I/O function failed */
+#define GPS_ERROR_CORRUPT     (9) /**< Encoded data is malformed */
+#define GPS_ERROR_RESTART     (10) /**< The source of the data was replaced and must be opened again */
 
 /**
  * @brief NMEA fix mode.
@@ -152,6 +161,136 @@ char *gps_encode(char *destination, const char *message);
  */
 int gps_decode(struct gps_tpv *tpv, char *nmea);
 
+/**
+ * @brief Decodes a NMEA sentence held in read only memory.
+ *
+ * Decodes the sentence in the first @p size characters of @p nmea in the same
+ * way as gps_decode(), but without writing to it. The sentence need not be
+ * NUL terminated, and any characters after its footer are ignored. This
+ * allows decoding straight out of a receive buffer, a DMA region or a memory
+ * mapped log.
+ *
+ * @param[out] tpv The data structure where the decoded values will be stored.
+ * @param[in] nmea The NMEA sentence to decode.
+ * @param[in] size The number of characters readable at @p nmea.
+ * @return A result code indicating what happened after the NMEA sentence was
+ *         decoded.
+ * @retval GPS_OK If and only if the NMEA sentence was valid.
+ * @retval GPS_ERROR_TRUNCATED If the sentence does not end within @p size
+ *         characters.
+ *
+ * @pre The pointer @p tpv must not be NULL.
+ * @pre The pointer @p nmea must not be NULL.
+ * @post The data in @p tpv is modified.
+ */
+int gps_decode_const(struct gps_tpv *tpv, const char *nmea, size_t size);
+
+/**
+ * @brief Checks the framing and checksum of a NMEA sentence without
+ *        decoding it.
+ *
+ * Unlike gps_decode_const(), which reports GPS_ERROR_UNSUPPORTED for any
+ * sentence it has no parser for, this validates every sentence type, such
+ * as GSV, TXT or proprietary $P sentences.
+ *
+ * @param[in] nmea The NMEA sentence to check, which is only read.
+ * @param[in] size The number of characters readable at @p nmea.
+ * @return GPS_OK if the sentence is intact, or the error gps_decode_const()
+ *         would report for its header, checksum or footer.
+ *
+ * @pre The pointer @p nmea must not be NULL.
+ */
+int gps_check_const(const char *nmea, size_t size);
+
+/**
+ * @brief Decodes a GGA sentence held in read only memory.
+ *
+ * Works like gps_decode_const(), except that only GGA sentences are
+ * decoded. Programs handling a few sentence types should call the function
+ * for each instead of gps_decode_const(), so that the parsers for the other
+ * types need not be linked in. gps.c is compiled with one section per
+ * function when the compiler supports it, so linking with --gc-sections
+ * drops them.
+ *
+ * @param[out] tpv The data structure where the decoded values will be stored.
+ * @param[in] nmea The NMEA sentence to decode.
+ * @param[in] size The number of characters readable at @p nmea.
+ * @return A result code, as for gps_decode_const().
+ * @retval GPS_ERROR_UNSUPPORTED If the sentence is not a GGA sentence.
+ *
+ * @pre The pointer @p tpv must not be NULL.
+ * @pre The pointer @p nmea must not be NULL.
+ * @post The data in @p tpv is modified.
+ */
+int gps_decode_gga(struct gps_tpv *tpv, const char *nmea, size_t size);
+
+/**
+ * @brief Decodes a GLL sentence held in read only memory, see gps_decode_gga().
+ */
+int gps_decode_gll(struct gps_tpv *tpv, const char *nmea, size_t size);
+
+/**
+ * @brief Decodes a GSA sentence held in read only memory, see gps_decode_gga().
+ */
+int gps_decode_gsa(struct gps_tpv *tpv, const char *nmea, size_t size);
+
+/**
+ * @brief Decodes a RMC sentence held in read only memory, see gps_decode_gga().
+ */
+int gps_decode_rmc(struct gps_tpv *tpv, const char *nmea, size_t size);
+
+/**
+ * @brief Decodes a VTG sentence held in read only memory, see gps_decode_gga().
+ */
+int gps_decode_vtg(struct gps_tpv *tpv, const char *nmea, size_t size);
+
+/**
+ * @brief Decodes a ZDA sentence held in read only memory, see gps_decode_gga().
+ */
+int gps_decode_zda(struct gps_tpv *tpv, const char *nmea, size_t size);
+
+/**
+ * @brief Converts a TPV time stamp to an integer number of milliseconds.
+ *
+ * Converts the ISO8601 string @p time, as stored in gps_tpv.time, to
+ * milliseconds since the Unix epoch. Sentences such as GGA only carry the
+ * time of day, leaving the date part of the time stamp as all zeros. In that
+ * case the result is the number of milliseconds since midnight, UTC, and
+ * gps_time_has_date() returns 0.
+ *
+ * @param[in] time The time stamp to convert.
+ * @return The time stamp in milliseconds.
+ *
+ * @pre The string @p time must be GPS_TIME_STRING_SIZE characters long.
+ */
+int64_t gps_time_to_ms(const char *time);
+
+/**
+ * @brief Checks if a TPV time stamp carries a date.
+ *
+ * @param[in] time The time stamp to check.
+ * @return Non-zero if the date part of @p time has been set.
+ *
+ * @pre The string @p time must be GPS_TIME_STRING_SIZE characters long.
+ */
+int gps_time_has_date(const char *time);
+
+/**
+ * @brief Converts an integer number of milliseconds to a TPV time stamp.
+ *
+ * This is the inverse of gps_time_to_ms(). If @p has_date is zero, then
+ * @p ms is treated as milliseconds since midnight and the date part of
+ * @p time is written as all zeros.
+ *
+ * @param[out] time The buffer where the time stamp will be stored.
+ * @param[in] ms The time in milliseconds.
+ * @param[in] has_date Non-zero if @p ms is relative to the Unix epoch.
+ *
+ * @pre The buffer @p time must hold at least GPS_TIME_STRING_SIZE characters.
+ * @post The data in @p time is modified.
+ */
+void gps_ms_to_time(char *time, int64_t ms, int has_date);
+
 /**
  * @brief Produces an error string.
  *
@@ -0,0 +1,261 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Jacob McGladdery
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/**
+ * @file gps.hpp
+ * @brief Header only C++17 interface to the decoder.
+ *
+ * gps::decoder decodes sentences given as std::string_view, straight from
+ * the caller's buffer and without copying them into a mutable string. The
+ * sentence types it handles are template parameters, so that
+ *
+ *     gps::decoder<gps::gga, gps::rmc> decoder;
+ *
+ * only references gps_decode_gga() and gps_decode_rmc(). The dispatch on
+ * the sentence ID is unrolled at compile time over those types, sentences
+ * of any other type are rejected without calling into the library, and the
+ * other parsers are dropped by a link with --gc-sections. gps::all_decoder
+ * handles every sentence type through gps_decode_const().
+ *
+ * gps::sentences() splits a buffer holding many sentences, such as a log
+ * file read into memory, into a range of std::string_view, one per line:
+ *
+ *     for (std::string_view nmea : gps::sentences(log)) decoder.decode(nmea);
+ *
+ * Like the C interface, nothing here allocates memory or throws.
+ */
+
+#ifndef _GPS_HPP_
+#define _GPS_HPP_
+
+#include "gps.h"
+
+#include <cstddef>
+#include <iterator>
+#include <string_view>
+#include <type_traits>
+
+namespace gps
+{
+
+/** Selects GGA sentences, see gps_decode_gga() */
+struct gga
+{
+    static constexpr std::string_view id = "GGA";
+    static int decode(gps_tpv *tpv, std::string_view nmea) { return gps_decode_gga(tpv, nmea.data(), nmea.size()); }
+};
+
+/** Selects GLL sentences, see gps_decode_gll() */
+struct gll
+{
+    static constexpr std::string_view id = "GLL";
+    static int decode(gps_tpv *tpv, std::string_view nmea) { return gps_decode_gll(tpv, nmea.data(), nmea.size()); }
+};
+
+/** Selects GSA sentences, see gps_decode_gsa() */
+struct gsa
+{
+    static constexpr std::string_view id = "GSA";
+    static int decode(gps_tpv *tpv, std::string_view nmea) { return gps_decode_gsa(tpv, nmea.data(), nmea.size()); }
+};
+
+/** Selects RMC sentences, see gps_decode_rmc() */
+struct rmc
+{
+    static constexpr std::string_view id = "RMC";
+    static int decode(gps_tpv *tpv, std::string_view nmea) { return gps_decode_rmc(tpv, nmea.data(), nmea.size()); }
+};
+
+/** Selects VTG sentences, see gps_decode_vtg() */
+struct vtg
+{
+    static constexpr std::string_view id = "VTG";
+    static int decode(gps_tpv *tpv, std::string_view nmea) { return gps_decode_vtg(tpv, nmea.data(), nmea.size()); }
+};
+
+/** Selects ZDA sentences, see gps_decode_zda() */
+struct zda
+{
+    static constexpr std::string_view id = "ZDA";
+    static int decode(gps_tpv *tpv, std::string_view nmea) { return gps_decode_zda(tpv, nmea.data(), nmea.size()); }
+};
+
+/** Selects every sentence type, see gps_decode_const() */
+struct all
+{
+    static int decode(gps_tpv *tpv, std::string_view nmea) { return gps_decode_const(tpv, nmea.data(), nmea.size()); }
+};
+
+/**
+ * @brief Decoder state for one receiver, handling the given sentence types.
+ *
+ * @tparam Sentences The sentence types to decode, among gps::gga,
+ *         gps::gll, gps::gsa, gps::rmc, gps::vtg, and gps::zda, or gps::all
+ *         alone.
+ */
+template <class... Sentences>
+class decoder
+{
+public:
+    static_assert(sizeof...(Sentences) > 0, "gps::decoder needs at least one sentence type");
+
+    /** Starts with a TPV set by gps_init_tpv() */
+    decoder() noexcept { reset(); }
+
+    /** Forgets everything decoded so far */
+    void reset() noexcept { gps_init_tpv(&tpv_); }
+
+    /**
+     * @brief Decodes a sentence into the TPV.
+     *
+     * @param[in] nmea The sentence, from the '$' through the CR LF. Any
+     *            characters after the footer are ignored.
+     * @return The result of gps_decode_const(). Sentences of a type not
+     *         selected give GPS_ERROR_UNSUPPORTED, and leave the TPV as it
+     *         was, talker ID included.
+     */
+    int decode(std::string_view nmea) noexcept
+    {
+        /* The checks gps_decode_const() makes before it looks at the ID */
+        if (nmea.empty() || (nmea[0] != '$')) return GPS_ERROR_HEAD;
+        if (nmea.size() < 6) return GPS_ERROR_TRUNCATED;
+
+        return dispatch<Sentences...>(nmea, nmea.substr(3, 3));
+    }
+
+    /** The TPV holding everything decoded so far */
+    const gps_tpv &tpv() const noexcept { return tpv_; }
+
+private:
+    template <class First, class... Rest>
+    int dispatch(std::string_view nmea, std::string_view id) noexcept
+    {
+        if constexpr (std::is_same_v<First, all>)
+        {
+            static_assert(sizeof...(Sentences) == 1, "gps::all must be the only sentence type");
+            (void)id;
+            return First::decode(&tpv_, nmea);
+        }
+        else
+        {
+            if (id == First::id) return First::decode(&tpv_, nmea);
+            if constexpr (sizeof...(Rest) > 0)
+            {
+                return dispatch<Rest...>(nmea, id);
+            }
+            else
+            {
+                return GPS_ERROR_UNSUPPORTED;
+            }
+        }
+    }
+
+    gps_tpv tpv_;
+};
+
+/** A decoder for every sentence type */
+using all_decoder = decoder<all>;
+
+/**
+ * @brief Range over the lines of a buffer.
+ *
+ * Each element is a line including its LF, or the rest of the buffer if it
+ * does not end with one. The buffer must outlive the range.
+ */
+class sentence_range
+{
+public:
+    /** Forward iterator over the lines */
+    class iterator
+    {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = std::string_view;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const std::string_view *;
+        using reference = const std::string_view &;
+
+        iterator() noexcept = default;
+
+        iterator(std::string_view rest) noexcept : rest_(rest) { next(); }
+
+        reference operator*() const noexcept { return line_; }
+        pointer operator->() const noexcept { return &line_; }
+
+        iterator &operator++() noexcept
+        {
+            rest_.remove_prefix(line_.size());
+            next();
+            return *this;
+        }
+
+        iterator operator++(int) noexcept
+        {
+            iterator previous = *this;
+            ++*this;
+            return previous;
+        }
+
+        /* Iterators over the same buffer are equal when they have the same
+         * number of characters left
+         */
+        bool operator==(const iterator &other) const noexcept { return rest_.size() == other.rest_.size(); }
+        bool operator!=(const iterator &other) const noexcept { return !(*this == other); }
+
+    private:
+        void next() noexcept
+        {
+            std::size_t lf = rest_.find('\n');
+
+            line_ = rest_.substr(0, (std::string_view::npos == lf) ? lf : lf + 1);
+        }
+
+        std::string_view rest_;
+        std::string_view line_;
+    };
+
+    explicit sentence_range(std::string_view buffer) noexcept : buffer_(buffer) {}
+
+    iterator begin() const noexcept { return iterator(buffer_); }
+    iterator end() const noexcept { return iterator(buffer_.substr(buffer_.size())); }
+
+private:
+    std::string_view buffer_;
+};
+
+/** Splits a buffer into a range of lines, see gps::sentence_range */
+inline sentence_range sentences(std::string_view buffer) noexcept
+{
+    return sentence_range(buffer);
+}
+
+/** The text of a result code, see gps_error_string() */
+inline std::string_view error_string(int e) noexcept
+{
+    return gps_error_string(e);
+}
+
+} // namespace gps
+
+#endif /* _GPS_HPP_ */
@@ -0,0 +1,164 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Jacob McGladdery
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include "gps_aggregate.h"
+
+#include <assert.h>
+#include <stddef.h>
+#include <string.h>
+
+#define HALF_TURN (180 * GPS_LAT_LON_FACTOR)
+#define FULL_TURN (360 * GPS_LAT_LON_FACTOR)
+
+/* Brings a longitude difference into -180 to 180 degrees */
+static int32_t wrap_longitude(int64_t longitude)
+{
+    if (longitude > HALF_TURN) longitude -= FULL_TURN;
+    else if (longitude <= -HALF_TURN) longitude += FULL_TURN;
+
+    return (int32_t)longitude;
+}
+
+/* Mean rounded half away from zero */
+static int32_t mean(int64_t sum, uint32_t count)
+{
+    int64_t half = count / 2;
+
+    return (int32_t)(((sum < 0) ? sum - half : sum + half) / count);
+}
+
+static void stat_init(struct gps_aggregate_stat *stat)
+{
+    stat->first = GPS_INVALID_VALUE;
+    stat->last = GPS_INVALID_VALUE;
+    stat->min = GPS_INVALID_VALUE;
+    stat->max = GPS_INVALID_VALUE;
+    stat->mean = GPS_INVALID_VALUE;
+    stat->count = 0;
+    stat->sum = 0;
+}
+
+static void stat_add(struct gps_aggregate_stat *stat, int32_t value)
+{
+    if (GPS_INVALID_VALUE == value) return;
+
+    if (0 == stat->count)
+    {
+        stat->first = value;
+        stat->min = value;
+        stat->max = value;
+    }
+    else
+    {
+        if (value < stat->min) stat->min = value;
+        if (value > stat->max) stat->max = value;
+    }
+    stat->last = value;
+    stat->sum += value;
+    stat->count++;
+}
+
+static void open_bucket(struct gps_aggregate *aggregate, int64_t start)
+{
+    struct gps_aggregate_bucket *bucket = &aggregate->bucket;
+
+    memset(bucket, 0, sizeof(*bucket));
+    bucket->start = start;
+    stat_init(&bucket->speed);
+    stat_init(&bucket->altitude);
+    aggregate->latitude_sum = 0;
+    aggregate->longitude_sum = 0;
+}
+
+void gps_aggregate_init(struct gps_aggregate *aggregate,
+                        int64_t width,
+                        gps_aggregate_function output,
+                        void *context)
+{
+    assert(aggregate != NULL);
+    assert(output != NULL);
+    assert(width > 0);
+
+    aggregate->width = width;
+    aggregate->output = output;
+    aggregate->context = context;
+    open_bucket(aggregate, 0);
+}
+
+void gps_aggregate_add(struct gps_aggregate *aggregate, const struct gps_tpv *tpv, int64_t time)
+{
+    assert(aggregate != NULL);
+    assert(tpv != NULL);
+
+    struct gps_aggregate_bucket *bucket = &aggregate->bucket;
+    int64_t offset = time % aggregate->width;
+    int64_t start = time - ((offset < 0) ? offset + aggregate->width : offset);
+
+    if ((bucket->samples > 0) && (start != bucket->start)) gps_aggregate_flush(aggregate);
+    if (0 == bucket->samples) bucket->start = start;
+
+    bucket->samples++;
+    if ((unsigned)tpv->mode < GPS_AGGREGATE_MODES) bucket->modes[tpv->mode]++;
+    stat_add(&bucket->speed, tpv->speed);
+    stat_add(&bucket->altitude, tpv->altitude);
+
+    /* Longitudes are summed relative to the first one, so that a bucket
+     * straddling the antimeridian does not average out to the other side
+     * of the globe
+     */
+    if ((tpv->latitude != GPS_INVALID_VALUE) && (tpv->longitude != GPS_INVALID_VALUE))
+    {
+        if (0 == bucket->positions) aggregate->longitude_base = tpv->longitude;
+        aggregate->latitude_sum += tpv->latitude;
+        aggregate->longitude_sum += wrap_longitude((int64_t)tpv->longitude - aggregate->longitude_base);
+        bucket->positions++;
+    }
+}
+
+void gps_aggregate_flush(struct gps_aggregate *aggregate)
+{
+    assert(aggregate != NULL);
+
+    struct gps_aggregate_bucket *bucket = &aggregate->bucket;
+
+    if (0 == bucket->samples) return;
+
+    if (bucket->speed.count > 0) bucket->speed.mean = mean(bucket->speed.sum, bucket->speed.count);
+    if (bucket->altitude.count > 0) bucket->altitude.mean = mean(bucket->altitude.sum, bucket->altitude.count);
+
+    if (bucket->positions > 0)
+    {
+        bucket->latitude = mean(aggregate->latitude_sum, bucket->positions);
+        bucket->longitude = wrap_longitude((int64_t)aggregate->longitude_base +
+                                           mean(aggregate->longitude_sum, bucket->positions));
+    }
+    else
+    {
+        bucket->latitude = GPS_INVALID_VALUE;
+        bucket->longitude = GPS_INVALID_VALUE;
+    }
+
+    aggregate->output(aggregate->context, bucket);
+    open_bucket(aggregate, 0);
+}
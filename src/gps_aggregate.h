@@ -0,0 +1,161 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Jacob McGladdery
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/**
+ * @file gps_aggregate.h
+ * @brief Downsamples a stream of TPVs to one summary per time bucket.
+ *
+ * Receivers report at 10 or 20 Hz where a dashboard needs a point per
+ * second or per minute. An aggregator takes the TPVs of one stream as they
+ * are decoded and sums them up per bucket of fixed width: the first, last,
+ * smallest, largest and mean speed and altitude, the centroid of the
+ * positions, and how often each fix mode was seen. The summary of a bucket
+ * is handed to a callback once a TPV of a later bucket arrives, so only
+ * one bucket is held at a time.
+ *
+ * All sums are kept in 64 bit integers of the gps_tpv units, and an
+ * aggregator takes a fixed amount of memory whatever the bucket width.
+ */
+
+#ifndef _GPS_AGGREGATE_H_
+#define _GPS_AGGREGATE_H_
+
+#include "gps.h"
+
+#include <stdint.h>
+
+#define GPS_AGGREGATE_MODES (4) /**< The number of gps_mode values */
+
+/**
+ * @brief Summary of one value over a bucket.
+ *
+ * Only valid values are counted. If there were none, every member but
+ * gps_aggregate_stat.count is GPS_INVALID_VALUE.
+ */
+struct gps_aggregate_stat
+{
+    int32_t first;  /**< The first value */
+    int32_t last;   /**< The last value */
+    int32_t min;    /**< The smallest value */
+    int32_t max;    /**< The largest value */
+    int32_t mean;   /**< The mean value, rounded */
+    uint32_t count; /**< The number of values */
+    int64_t sum;    /**< The sum of the values */
+};
+
+/**
+ * @brief Summary of the TPVs of one bucket.
+ */
+struct gps_aggregate_bucket
+{
+    int64_t start;                       /**< Start of the bucket, in the units of the times given */
+    uint32_t samples;                    /**< TPVs added */
+    struct gps_aggregate_stat speed;     /**< Speed, in gps_tpv.speed units */
+    struct gps_aggregate_stat altitude;  /**< Altitude, in gps_tpv.altitude units */
+    int32_t latitude;                    /**< Latitude of the centroid, or GPS_INVALID_VALUE */
+    int32_t longitude;                   /**< Longitude of the centroid, or GPS_INVALID_VALUE */
+    uint32_t positions;                  /**< TPVs with a valid position */
+    uint32_t modes[GPS_AGGREGATE_MODES]; /**< TPVs per gps_mode */
+};
+
+/**
+ * @brief Function receiving the summary of each bucket.
+ *
+ * @param[in] context The user pointer given to gps_aggregate_init().
+ * @param[in] bucket The summary, valid until the function returns.
+ */
+typedef void (*gps_aggregate_function)(void *context, const struct gps_aggregate_bucket *bucket);
+
+/**
+ * @brief Aggregator state.
+ */
+struct gps_aggregate
+{
+    struct gps_aggregate_bucket bucket; /**< The open bucket, if gps_aggregate_bucket.samples is not 0 */
+    int64_t width;                      /**< Width of the buckets */
+    int64_t latitude_sum;               /**< Sum of the latitudes */
+    int64_t longitude_sum;              /**< Sum of the longitudes relative to gps_aggregate.longitude_base */
+    int32_t longitude_base;             /**< First longitude of the bucket */
+    gps_aggregate_function output;      /**< Receives each bucket */
+    void *context;                      /**< User pointer passed to gps_aggregate.output */
+};
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Initializes an aggregator.
+ *
+ * @param[out] aggregate The aggregator to initialize.
+ * @param[in] width The width of the buckets, in the units of the times
+ *            given to gps_aggregate_add(), such as 1000 or 60000 for
+ *            milliseconds.
+ * @param[in] output The function receiving the summary of each bucket.
+ * @param[in] context A user pointer handed to @p output.
+ *
+ * @pre The pointers @p aggregate and @p output must not be NULL.
+ * @pre The width @p width must be positive.
+ */
+void gps_aggregate_init(struct gps_aggregate *aggregate,
+                        int64_t width,
+                        gps_aggregate_function output,
+                        void *context);
+
+/**
+ * @brief Adds a TPV to its bucket.
+ *
+ * Buckets start at multiples of the width. When @p time falls outside the
+ * open bucket, the open bucket is closed and handed to the output function
+ * first. This also happens when the time goes back, such as at midnight
+ * with times of day from gps_time_to_ms().
+ *
+ * Each TPV counts once, so add a TPV once per epoch for every epoch to
+ * weigh the same, or after every sentence to weigh epochs by sentences.
+ *
+ * @param[in,out] aggregate The aggregator.
+ * @param[in] tpv The TPV.
+ * @param[in] time The time of the TPV, such as gps_time_to_ms(tpv->time).
+ *
+ * @pre The pointers @p aggregate and @p tpv must not be NULL.
+ */
+void gps_aggregate_add(struct gps_aggregate *aggregate, const struct gps_tpv *tpv, int64_t time);
+
+/**
+ * @brief Closes the open bucket, if any, and hands it to the output function.
+ *
+ * Call at the end of a stream, or when a stream goes quiet, so that its
+ * last bucket is not held back until the next TPV.
+ *
+ * @param[in,out] aggregate The aggregator.
+ *
+ * @pre The pointer @p aggregate must not be NULL.
+ */
+void gps_aggregate_flush(struct gps_aggregate *aggregate);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _GPS_AGGREGATE_H_ */
@@ -0,0 +1,396 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Jacob McGladdery
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include "gps_archive.h"
+
+#include <assert.h>
+#include <stddef.h>
+#include <string.h>
+
+#define ARCHIVE_MAGIC   "GPSA"
+#define ARCHIVE_VERSION (1)
+
+/* Record flags */
+#define FLAG_MODE_MASK (0x03)
+#define FLAG_ALTITUDE  (0x04)
+#define FLAG_LATITUDE  (0x08)
+#define FLAG_LONGITUDE (0x10)
+#define FLAG_TRACK     (0x20)
+#define FLAG_SPEED     (0x40)
+#define FLAG_EXTENDED  (0x80)
+
+/* Extended flags, only present when FLAG_EXTENDED is set */
+#define EXTENDED_HAS_DATE (0x01)
+#define EXTENDED_TALKER   (0x02)
+
+static void put_u32(uint8_t *p, uint32_t v)
+{
+    p[0] = (uint8_t)(v);
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+static void put_u64(uint8_t *p, uint64_t v)
+{
+    put_u32(p, (uint32_t)v);
+    put_u32(p + 4, (uint32_t)(v >> 32));
+}
+
+static uint32_t get_u32(const uint8_t *p)
+{
+    return (uint32_t)p[0]
+         | ((uint32_t)p[1] << 8)
+         | ((uint32_t)p[2] << 16)
+         | ((uint32_t)p[3] << 24);
+}
+
+static uint64_t get_u64(const uint8_t *p)
+{
+    return (uint64_t)get_u32(p) | ((uint64_t)get_u32(p + 4) << 32);
+}
+
+static uint64_t zigzag_encode(int64_t v)
+{
+    return ((uint64_t)v << 1) ^ (uint64_t)(v >> 63);
+}
+
+static int64_t zigzag_decode(uint64_t v)
+{
+    return (int64_t)(v >> 1) ^ -(int64_t)(v & 1);
+}
+
+static uint8_t *put_varint(uint8_t *p, uint64_t v)
+{
+    while (v >= 0x80)
+    {
+        *p++ = (uint8_t)(v | 0x80);
+        v >>= 7;
+    }
+    *p++ = (uint8_t)v;
+    return p;
+}
+
+static const uint8_t *get_varint(const uint8_t *p, const uint8_t *end, uint64_t *v)
+{
+    uint64_t value;
+    uint_fast8_t shift;
+
+    /* Fast path, most deltas fit in a single byte */
+    if ((p < end) && (*p < 0x80))
+    {
+        *v = *p;
+        return p + 1;
+    }
+
+    value = 0;
+    for (shift = 0; (p < end) && (shift < 64); shift += 7)
+    {
+        uint8_t c0 = *p++;
+        value |= (uint64_t)(c0 & 0x7F) << shift;
+        if (c0 < 0x80)
+        {
+            *v = value;
+            return p;
+        }
+    }
+
+    return NULL;
+}
+
+static uint8_t *put_field(uint8_t *p, int32_t value, int32_t *previous)
+{
+    p = put_varint(p, zigzag_encode((int64_t)value - *previous));
+    *previous = value;
+    return p;
+}
+
+static const uint8_t *get_field(const uint8_t *p, const uint8_t *end, int32_t *value, int32_t *previous)
+{
+    uint64_t v;
+
+    p = get_varint(p, end, &v);
+    if (p) *value = *previous = (int32_t)(*previous + zigzag_decode(v));
+    return p;
+}
+
+static void reset_state(struct gps_archive_state *state)
+{
+    memset(state, 0, sizeof(*state));
+}
+
+static int write_header(struct gps_archive_writer *writer)
+{
+    uint8_t header[GPS_ARCHIVE_HEADER_SIZE] = { 0 };
+
+    memcpy(header, ARCHIVE_MAGIC, 4);
+    header[4] = ARCHIVE_VERSION;
+    if (writer->write(writer->context, header, sizeof(header))) return GPS_ERROR_IO;
+    writer->header_written = 1;
+
+    return GPS_OK;
+}
+
+static void start_block(struct gps_archive_writer *writer)
+{
+    writer->size = GPS_ARCHIVE_BLOCK_HEADER_SIZE;
+    writer->block.count = 0;
+    writer->block.time_min = INT64_MAX;
+    writer->block.time_max = INT64_MIN;
+    reset_state(&writer->state);
+}
+
+void gps_archive_writer_init(struct gps_archive_writer *writer,
+                             uint8_t *buffer,
+                             size_t capacity,
+                             gps_archive_write_function write,
+                             void *context)
+{
+    assert(writer != NULL);
+    assert(buffer != NULL);
+    assert(capacity >= GPS_ARCHIVE_BLOCK_HEADER_SIZE + GPS_ARCHIVE_RECORD_MAX_SIZE);
+    assert(write != NULL);
+
+    writer->write = write;
+    writer->context = context;
+    writer->buffer = buffer;
+    writer->capacity = capacity;
+    writer->block.offset = GPS_ARCHIVE_HEADER_SIZE;
+    writer->header_written = 0;
+    start_block(writer);
+}
+
+int gps_archive_write(struct gps_archive_writer *writer, const struct gps_tpv *tpv)
+{
+    assert(writer != NULL);
+    assert(tpv != NULL);
+
+    struct gps_archive_state *state = &writer->state;
+    uint8_t *p;
+    uint8_t *flags;
+    uint8_t extended;
+    uint8_t has_date;
+    int64_t time;
+
+    if ((writer->capacity - writer->size) < GPS_ARCHIVE_RECORD_MAX_SIZE)
+    {
+        int result = gps_archive_flush(writer);
+        if (result != GPS_OK) return result;
+    }
+
+    p = writer->buffer + writer->size;
+    has_date = (uint8_t)gps_time_has_date(tpv->time);
+    time = gps_time_to_ms(tpv->time);
+
+    /* Flags byte */
+    flags = p++;
+    *flags = (uint8_t)tpv->mode & FLAG_MODE_MASK;
+    if (tpv->altitude  != GPS_INVALID_VALUE) *flags |= FLAG_ALTITUDE;
+    if (tpv->latitude  != GPS_INVALID_VALUE) *flags |= FLAG_LATITUDE;
+    if (tpv->longitude != GPS_INVALID_VALUE) *flags |= FLAG_LONGITUDE;
+    if (tpv->track     != GPS_INVALID_VALUE) *flags |= FLAG_TRACK;
+    if (tpv->speed     != GPS_INVALID_VALUE) *flags |= FLAG_SPEED;
+
+    /* The date presence and talker ID rarely change, so they are only stored
+     * when they differ from the previous record.
+     */
+    extended = 0;
+    if (has_date != state->has_date) extended |= EXTENDED_HAS_DATE;
+    if (memcmp(tpv->talker_id, state->talker_id, 2) != 0) extended |= EXTENDED_TALKER;
+    if (extended)
+    {
+        *flags |= FLAG_EXTENDED;
+        *p++ = (has_date ? EXTENDED_HAS_DATE : 0) | (extended & EXTENDED_TALKER);
+        if (extended & EXTENDED_TALKER)
+        {
+            *p++ = (uint8_t)tpv->talker_id[0];
+            *p++ = (uint8_t)tpv->talker_id[1];
+            memcpy(state->talker_id, tpv->talker_id, 2);
+        }
+        state->has_date = has_date;
+    }
+
+    /* Time and field deltas */
+    p = put_varint(p, zigzag_encode(time - state->time));
+    state->time = time;
+    if (*flags & FLAG_ALTITUDE)  p = put_field(p, tpv->altitude, &state->altitude);
+    if (*flags & FLAG_LATITUDE)  p = put_field(p, tpv->latitude, &state->latitude);
+    if (*flags & FLAG_LONGITUDE) p = put_field(p, tpv->longitude, &state->longitude);
+    if (*flags & FLAG_TRACK)     p = put_field(p, tpv->track, &state->track);
+    if (*flags & FLAG_SPEED)     p = put_field(p, tpv->speed, &state->speed);
+
+    writer->size = (size_t)(p - writer->buffer);
+    writer->block.count++;
+    if (time < writer->block.time_min) writer->block.time_min = time;
+    if (time > writer->block.time_max) writer->block.time_max = time;
+
+    return GPS_OK;
+}
+
+int gps_archive_flush(struct gps_archive_writer *writer)
+{
+    assert(writer != NULL);
+
+    uint8_t *header = writer->buffer;
+    uint32_t size;
+
+    if (!writer->header_written)
+    {
+        int result = write_header(writer);
+        if (result != GPS_OK) return result;
+    }
+
+    if (0 == writer->block.count) return GPS_OK;
+
+    size = (uint32_t)(writer->size - GPS_ARCHIVE_BLOCK_HEADER_SIZE);
+    put_u32(header + 0, size);
+    put_u32(header + 4, writer->block.count);
+    put_u64(header + 8, (uint64_t)writer->block.time_min);
+    put_u64(header + 16, (uint64_t)writer->block.time_max);
+    if (writer->write(writer->context, writer->buffer, writer->size)) return GPS_ERROR_IO;
+
+    writer->block.offset += writer->size;
+    start_block(writer);
+
+    return GPS_OK;
+}
+
+int gps_archive_reader_init(struct gps_archive_reader *reader, const uint8_t *data, size_t size)
+{
+    assert(reader != NULL);
+
+    reader->data = data;
+    reader->size = size;
+    reader->offset = GPS_ARCHIVE_HEADER_SIZE;
+    reader->cursor = NULL;
+    reader->end = NULL;
+    reader->remaining = 0;
+    reset_state(&reader->state);
+
+    if ((NULL == data) || (size < GPS_ARCHIVE_HEADER_SIZE)) return GPS_ERROR_CORRUPT;
+    if (memcmp(data, ARCHIVE_MAGIC, 4) != 0) return GPS_ERROR_CORRUPT;
+    if (data[4] != ARCHIVE_VERSION) return GPS_ERROR_CORRUPT;
+
+    return GPS_OK;
+}
+
+int gps_archive_next_block(struct gps_archive_reader *reader, struct gps_archive_block *block)
+{
+    assert(reader != NULL);
+
+    const uint8_t *header = reader->data + reader->offset;
+    uint32_t size;
+
+    if (reader->offset == reader->size) return GPS_ERROR_END;
+    if ((reader->size - reader->offset) < GPS_ARCHIVE_BLOCK_HEADER_SIZE) return GPS_ERROR_CORRUPT;
+
+    size = get_u32(header);
+    if ((reader->size - reader->offset - GPS_ARCHIVE_BLOCK_HEADER_SIZE) < size) return GPS_ERROR_CORRUPT;
+
+    if (block)
+    {
+        block->offset = reader->offset;
+        block->size = size;
+        block->count = get_u32(header + 4);
+        block->time_min = (int64_t)get_u64(header + 8);
+        block->time_max = (int64_t)get_u64(header + 16);
+    }
+
+    reader->cursor = header + GPS_ARCHIVE_BLOCK_HEADER_SIZE;
+    reader->end = reader->cursor + size;
+    reader->remaining = get_u32(header + 4);
+    reader->offset += GPS_ARCHIVE_BLOCK_HEADER_SIZE + size;
+    reset_state(&reader->state);
+
+    return GPS_OK;
+}
+
+int gps_archive_seek(struct gps_archive_reader *reader, size_t offset)
+{
+    assert(reader != NULL);
+
+    if ((offset < GPS_ARCHIVE_HEADER_SIZE) || (offset > reader->size)) return GPS_ERROR_CORRUPT;
+
+    reader->offset = offset;
+    reader->cursor = NULL;
+    reader->end = NULL;
+    reader->remaining = 0;
+
+    return GPS_OK;
+}
+
+int gps_archive_read(struct gps_archive_reader *reader, struct gps_tpv *tpv)
+{
+    assert(reader != NULL);
+    assert(tpv != NULL);
+
+    struct gps_archive_state *state = &reader->state;
+    const uint8_t *p = reader->cursor;
+    const uint8_t *end = reader->end;
+    uint64_t v;
+    uint8_t flags;
+
+    if (0 == reader->remaining) return GPS_ERROR_END;
+    if (p >= end) return GPS_ERROR_CORRUPT;
+
+    flags = *p++;
+    if (flags & FLAG_EXTENDED)
+    {
+        uint8_t extended;
+
+        if (p >= end) return GPS_ERROR_CORRUPT;
+        extended = *p++;
+        state->has_date = extended & EXTENDED_HAS_DATE;
+        if (extended & EXTENDED_TALKER)
+        {
+            if ((end - p) < 2) return GPS_ERROR_CORRUPT;
+            state->talker_id[0] = (char)*p++;
+            state->talker_id[1] = (char)*p++;
+        }
+    }
+
+    p = get_varint(p, end, &v);
+    if (!p) return GPS_ERROR_CORRUPT;
+    state->time += zigzag_decode(v);
+
+    tpv->mode = (enum gps_mode)(flags & FLAG_MODE_MASK);
+    tpv->altitude = tpv->latitude = tpv->longitude = GPS_INVALID_VALUE;
+    tpv->track = tpv->speed = GPS_INVALID_VALUE;
+    if ((flags & FLAG_ALTITUDE) && p) p = get_field(p, end, &tpv->altitude, &state->altitude);
+    if ((flags & FLAG_LATITUDE) && p) p = get_field(p, end, &tpv->latitude, &state->latitude);
+    if ((flags & FLAG_LONGITUDE) && p) p = get_field(p, end, &tpv->longitude, &state->longitude);
+    if ((flags & FLAG_TRACK) && p) p = get_field(p, end, &tpv->track, &state->track);
+    if ((flags & FLAG_SPEED) && p) p = get_field(p, end, &tpv->speed, &state->speed);
+    if (!p) return GPS_ERROR_CORRUPT;
+
+    gps_ms_to_time(tpv->time, state->time, state->has_date);
+    tpv->talker_id[0] = state->talker_id[0];
+    tpv->talker_id[1] = state->talker_id[1];
+    tpv->talker_id[2] = '\0';
+
+    reader->cursor = p;
+    reader->remaining--;
+
+    return GPS_OK;
+}
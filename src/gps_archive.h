@@ -0,0 +1,232 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Jacob McGladdery
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/**
+ * @file gps_archive.h
+ * @brief Compact binary archive format for TPV records.
+ *
+ * An archive is a short file header followed by a sequence of independently
+ * decodable blocks. Each block header stores the size of the block, the
+ * number of records it holds, and the minimum and maximum record time so
+ * that readers may skip blocks without decoding them. Within a block every
+ * record stores a flags byte, the time delta from the previous record, and
+ * the delta from the previous valid value of each valid field. Deltas are
+ * zig-zag encoded and stored as variable length integers, so a typical
+ * 1 Hz fix costs around 10 bytes instead of the 140 or so bytes of NMEA it
+ * was decoded from.
+ *
+ * Like the decoder, neither the writer nor the reader allocates memory. The
+ * writer assembles each block in a buffer owned by the caller and hands
+ * complete blocks to a caller supplied write function. The reader decodes
+ * directly from an archive held in memory.
+ */
+
+#ifndef _GPS_ARCHIVE_H_
+#define _GPS_ARCHIVE_H_
+
+#include "gps.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define GPS_ARCHIVE_HEADER_SIZE       (8)  /**< The size of the archive file header */
+#define GPS_ARCHIVE_BLOCK_HEADER_SIZE (24) /**< The size of each block header */
+#define GPS_ARCHIVE_RECORD_MAX_SIZE   (40) /**< The largest possible encoded record */
+
+/**
+ * @brief Function used by the writer to output encoded data.
+ *
+ * @param[in] context The user pointer given to gps_archive_writer_init().
+ * @param[in] data The bytes to write.
+ * @param[in] size The number of bytes to write.
+ * @return Zero on success, any other value on failure.
+ */
+typedef int (*gps_archive_write_function)(void *context, const void *data, size_t size);
+
+/**
+ * @brief Delta coding state shared by the writer and reader.
+ */
+struct gps_archive_state
+{
+    int64_t time;       /**< Time of the previous record in milliseconds */
+    int32_t altitude;   /**< Previous valid altitude */
+    int32_t latitude;   /**< Previous valid latitude */
+    int32_t longitude;  /**< Previous valid longitude */
+    int32_t track;      /**< Previous valid track */
+    int32_t speed;      /**< Previous valid speed */
+    uint8_t has_date;   /**< Non-zero if the previous time included a date */
+    char talker_id[2];  /**< Previous talker ID */
+};
+
+/**
+ * @brief Summary of one archive block.
+ */
+struct gps_archive_block
+{
+    size_t offset;    /**< Offset of the block header from the start of the archive */
+    uint32_t size;    /**< Size of the block payload in bytes */
+    uint32_t count;   /**< Number of records in the block */
+    int64_t time_min; /**< Smallest record time in the block, see gps_time_to_ms() */
+    int64_t time_max; /**< Largest record time in the block, see gps_time_to_ms() */
+};
+
+/**
+ * @brief Streaming archive writer.
+ */
+struct gps_archive_writer
+{
+    gps_archive_write_function write; /**< Output function */
+    void *context;                    /**< User pointer passed to gps_archive_writer.write */
+    uint8_t *buffer;                  /**< Block assembly buffer */
+    size_t capacity;                  /**< Size of gps_archive_writer.buffer */
+    size_t size;                      /**< Bytes used in gps_archive_writer.buffer */
+    struct gps_archive_block block;   /**< Summary of the block being assembled */
+    struct gps_archive_state state;   /**< Delta coding state */
+    int header_written;               /**< Non-zero once the file header is out */
+};
+
+/**
+ * @brief Archive reader over an in-memory archive.
+ */
+struct gps_archive_reader
+{
+    const uint8_t *data;            /**< Start of the archive */
+    size_t size;                    /**< Size of the archive in bytes */
+    size_t offset;                  /**< Offset of the next block header */
+    const uint8_t *cursor;          /**< Next record in the current block */
+    const uint8_t *end;             /**< End of the current block */
+    uint32_t remaining;             /**< Records left in the current block */
+    struct gps_archive_state state; /**< Delta coding state */
+};
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Initializes an archive writer.
+ *
+ * @param[out] writer The writer to initialize.
+ * @param[in] buffer The buffer used to assemble blocks. Its size bounds the
+ *            size of each block.
+ * @param[in] capacity The size of @p buffer in bytes.
+ * @param[in] write The function which receives the encoded archive.
+ * @param[in] context A user pointer handed to @p write.
+ *
+ * @pre The pointer @p writer must not be NULL.
+ * @pre The buffer @p buffer must be at least GPS_ARCHIVE_BLOCK_HEADER_SIZE +
+ *      GPS_ARCHIVE_RECORD_MAX_SIZE bytes large.
+ * @pre The function @p write must not be NULL.
+ */
+void gps_archive_writer_init(struct gps_archive_writer *writer,
+                             uint8_t *buffer,
+                             size_t capacity,
+                             gps_archive_write_function write,
+                             void *context);
+
+/**
+ * @brief Appends a TPV record to the archive.
+ *
+ * Encodes @p tpv into the current block. If the block is full, then it is
+ * written out first and a new block is started.
+ *
+ * @param[in,out] writer The archive writer.
+ * @param[in] tpv The record to append.
+ * @return A result code.
+ * @retval GPS_OK The record was appended.
+ * @retval GPS_ERROR_IO The write function failed.
+ */
+int gps_archive_write(struct gps_archive_writer *writer, const struct gps_tpv *tpv);
+
+/**
+ * @brief Writes out the current block.
+ *
+ * Call this once all records have been appended, or whenever the data
+ * written so far must become readable.
+ *
+ * @param[in,out] writer The archive writer.
+ * @return A result code.
+ * @retval GPS_OK The block was written, or there was nothing to write.
+ * @retval GPS_ERROR_IO The write function failed.
+ */
+int gps_archive_flush(struct gps_archive_writer *writer);
+
+/**
+ * @brief Initializes an archive reader.
+ *
+ * @param[out] reader The reader to initialize.
+ * @param[in] data The archive contents.
+ * @param[in] size The size of @p data in bytes.
+ * @return A result code.
+ * @retval GPS_OK The archive header is valid.
+ * @retval GPS_ERROR_CORRUPT The archive header is missing or malformed.
+ */
+int gps_archive_reader_init(struct gps_archive_reader *reader, const uint8_t *data, size_t size);
+
+/**
+ * @brief Advances the reader to the next block.
+ *
+ * Any records left unread in the current block are skipped.
+ *
+ * @param[in,out] reader The archive reader.
+ * @param[out] block Receives the block summary. May be NULL.
+ * @return A result code.
+ * @retval GPS_OK The reader is positioned at the start of a block.
+ * @retval GPS_ERROR_END There are no more blocks.
+ * @retval GPS_ERROR_CORRUPT The block header is malformed.
+ */
+int gps_archive_next_block(struct gps_archive_reader *reader, struct gps_archive_block *block);
+
+/**
+ * @brief Positions the reader at the block header found at @p offset.
+ *
+ * This is meant for use with offsets previously reported in
+ * gps_archive_block.offset. The block itself is entered with the next call
+ * to gps_archive_next_block().
+ *
+ * @param[in,out] reader The archive reader.
+ * @param[in] offset The offset of a block header.
+ * @return A result code.
+ * @retval GPS_OK The reader was repositioned.
+ * @retval GPS_ERROR_CORRUPT The offset lies outside of the archive.
+ */
+int gps_archive_seek(struct gps_archive_reader *reader, size_t offset);
+
+/**
+ * @brief Reads the next record from the current block.
+ *
+ * @param[in,out] reader The archive reader.
+ * @param[out] tpv Receives the decoded record.
+ * @return A result code.
+ * @retval GPS_OK A record was decoded into @p tpv.
+ * @retval GPS_ERROR_END The current block has no more records.
+ * @retval GPS_ERROR_CORRUPT The record is malformed.
+ */
+int gps_archive_read(struct gps_archive_reader *reader, struct gps_tpv *tpv);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _GPS_ARCHIVE_H_ */
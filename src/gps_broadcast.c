@@ -0,0 +1,368 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Jacob McGladdery
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#define _GNU_SOURCE
+
+#include "gps_broadcast.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <stddef.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#define MESSAGE_MAGIC   "GB"
+#define MESSAGE_VERSION (1)
+
+/* Pending connections the kernel queues between two services */
+#define LISTEN_BACKLOG (16)
+
+static void put_u16(uint8_t *p, uint16_t v)
+{
+    p[0] = (uint8_t)(v);
+    p[1] = (uint8_t)(v >> 8);
+}
+
+static void put_u32(uint8_t *p, uint32_t v)
+{
+    put_u16(p, (uint16_t)v);
+    put_u16(p + 2, (uint16_t)(v >> 16));
+}
+
+static void put_u64(uint8_t *p, uint64_t v)
+{
+    put_u32(p, (uint32_t)v);
+    put_u32(p + 4, (uint32_t)(v >> 32));
+}
+
+static uint16_t get_u16(const uint8_t *p)
+{
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static uint32_t get_u32(const uint8_t *p)
+{
+    return (uint32_t)get_u16(p) | ((uint32_t)get_u16(p + 2) << 16);
+}
+
+static uint64_t get_u64(const uint8_t *p)
+{
+    return (uint64_t)get_u32(p) | ((uint64_t)get_u32(p + 4) << 32);
+}
+
+static int make_address(struct sockaddr_un *address, const char *path)
+{
+    size_t length = strlen(path);
+
+    if (length >= sizeof(address->sun_path)) return GPS_ERROR_OVERFLOW;
+
+    memset(address, 0, sizeof(*address));
+    address->sun_family = AF_UNIX;
+    memcpy(address->sun_path, path, length + 1);
+
+    return GPS_OK;
+}
+
+static void put_record(uint8_t *p, const struct gps_broadcast_record *record)
+{
+    const struct gps_compact_tpv *tpv = &record->tpv;
+
+    put_u16(p, record->device);
+    put_u16(p + 2, tpv->flags);
+    p[4] = (uint8_t)tpv->talker_id[0];
+    p[5] = (uint8_t)tpv->talker_id[1];
+    put_u16(p + 6, 0);
+    put_u64(p + 8, (uint64_t)tpv->time);
+    put_u32(p + 16, (uint32_t)tpv->latitude);
+    put_u32(p + 20, (uint32_t)tpv->longitude);
+    put_u32(p + 24, (uint32_t)tpv->altitude);
+    put_u32(p + 28, (uint32_t)tpv->track);
+    put_u32(p + 32, (uint32_t)tpv->speed);
+}
+
+static void get_record(const uint8_t *p, struct gps_broadcast_record *record)
+{
+    struct gps_compact_tpv *tpv = &record->tpv;
+
+    record->device = get_u16(p);
+    tpv->flags = get_u16(p + 2);
+    tpv->talker_id[0] = (char)p[4];
+    tpv->talker_id[1] = (char)p[5];
+    tpv->time = (int64_t)get_u64(p + 8);
+    tpv->latitude = (int32_t)get_u32(p + 16);
+    tpv->longitude = (int32_t)get_u32(p + 20);
+    tpv->altitude = (int32_t)get_u32(p + 24);
+    tpv->track = (int32_t)get_u32(p + 28);
+    tpv->speed = (int32_t)get_u32(p + 32);
+}
+
+static void accept_clients(struct gps_broadcast *broadcast)
+{
+    for (;;)
+    {
+        int fd = accept4(broadcast->listen_fd, NULL, NULL, SOCK_CLOEXEC);
+        size_t slot;
+
+        if (fd < 0) return;
+
+        for (slot = 0; slot < broadcast->capacity; ++slot)
+        {
+            if (broadcast->clients[slot].fd < 0) break;
+        }
+        if (slot == broadcast->capacity)
+        {
+            broadcast->refused++;
+            close(fd);
+            continue;
+        }
+
+        broadcast->clients[slot].fd = fd;
+        broadcast->clients[slot].sent = 0;
+        broadcast->clients[slot].skipped = 0;
+    }
+}
+
+int gps_broadcast_init(struct gps_broadcast *broadcast,
+                       struct gps_broadcast_client *clients,
+                       size_t capacity,
+                       const char *path,
+                       int64_t hold)
+{
+    assert(broadcast != NULL);
+    assert((clients != NULL) || (0 == capacity));
+    assert(path != NULL);
+
+    struct sockaddr_un address;
+    struct stat status;
+    int result;
+    size_t i;
+
+    broadcast->clients = clients;
+    broadcast->capacity = capacity;
+    broadcast->hold = hold;
+    broadcast->opened = 0;
+    broadcast->count = 0;
+    broadcast->sequence = 0;
+    broadcast->refused = 0;
+    broadcast->disconnected = 0;
+    broadcast->listen_fd = -1;
+    for (i = 0; i < capacity; ++i) clients[i].fd = -1;
+
+    result = make_address(&address, path);
+    if (result != GPS_OK) return result;
+
+    /* Only ever remove a socket, never a file given by mistake */
+    if ((0 == lstat(path, &status)) && S_ISSOCK(status.st_mode)) unlink(path);
+
+    broadcast->listen_fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (broadcast->listen_fd < 0) return GPS_ERROR_IO;
+
+    if ((bind(broadcast->listen_fd, (const struct sockaddr *)&address, sizeof(address)) < 0) ||
+        (listen(broadcast->listen_fd, LISTEN_BACKLOG) < 0))
+    {
+        close(broadcast->listen_fd);
+        broadcast->listen_fd = -1;
+        return GPS_ERROR_IO;
+    }
+
+    return GPS_OK;
+}
+
+void gps_broadcast_close(struct gps_broadcast *broadcast)
+{
+    assert(broadcast != NULL);
+
+    size_t i;
+
+    for (i = 0; i < broadcast->capacity; ++i)
+    {
+        if (broadcast->clients[i].fd >= 0) close(broadcast->clients[i].fd);
+        broadcast->clients[i].fd = -1;
+    }
+
+    if (broadcast->listen_fd >= 0) close(broadcast->listen_fd);
+    broadcast->listen_fd = -1;
+    broadcast->count = 0;
+}
+
+void gps_broadcast_update(struct gps_broadcast *broadcast,
+                          uint16_t device,
+                          const struct gps_tpv *tpv,
+                          int64_t now)
+{
+    assert(broadcast != NULL);
+    assert(tpv != NULL);
+
+    struct gps_broadcast_record record;
+    size_t i;
+
+    record.device = device;
+    gps_compact_from_tpv(&record.tpv, tpv);
+
+    for (i = 0; i < broadcast->count; ++i)
+    {
+        if (broadcast->pending[i].device != device) continue;
+
+        /* A later sentence of the same epoch */
+        if (broadcast->pending[i].tpv.time == record.tpv.time)
+        {
+            broadcast->pending[i] = record;
+            return;
+        }
+
+        /* The device started its next epoch, so the previous one is done */
+        gps_broadcast_flush(broadcast);
+        break;
+    }
+
+    if (GPS_BROADCAST_BATCH_SIZE == broadcast->count) gps_broadcast_flush(broadcast);
+
+    if (0 == broadcast->count) broadcast->opened = now;
+    broadcast->pending[broadcast->count++] = record;
+}
+
+int gps_broadcast_service(struct gps_broadcast *broadcast, int64_t now)
+{
+    assert(broadcast != NULL);
+
+    int64_t due;
+
+    if (broadcast->listen_fd >= 0) accept_clients(broadcast);
+
+    if (0 == broadcast->count) return -1;
+
+    due = broadcast->opened + broadcast->hold;
+    if (now >= due)
+    {
+        gps_broadcast_flush(broadcast);
+        return -1;
+    }
+
+    return (int)((due - now + 999999) / 1000000);
+}
+
+void gps_broadcast_flush(struct gps_broadcast *broadcast)
+{
+    assert(broadcast != NULL);
+
+    uint8_t message[GPS_BROADCAST_MESSAGE_SIZE];
+    size_t size;
+    size_t i;
+
+    if (0 == broadcast->count) return;
+
+    memcpy(message, MESSAGE_MAGIC, 2);
+    message[2] = MESSAGE_VERSION;
+    message[3] = (uint8_t)broadcast->count;
+    put_u32(message + 4, broadcast->sequence++);
+    for (i = 0; i < broadcast->count; ++i)
+    {
+        put_record(message + GPS_BROADCAST_HEADER_SIZE + i * GPS_BROADCAST_RECORD_SIZE, &broadcast->pending[i]);
+    }
+    size = GPS_BROADCAST_HEADER_SIZE + broadcast->count * GPS_BROADCAST_RECORD_SIZE;
+    broadcast->count = 0;
+
+    for (i = 0; i < broadcast->capacity; ++i)
+    {
+        struct gps_broadcast_client *client = &broadcast->clients[i];
+
+        if (client->fd < 0) continue;
+
+        if (send(client->fd, message, size, MSG_DONTWAIT | MSG_NOSIGNAL) == (ssize_t)size)
+        {
+            client->sent++;
+        }
+        else if ((EAGAIN == errno) || (EWOULDBLOCK == errno) || (ENOBUFS == errno))
+        {
+            client->skipped++;
+        }
+        else
+        {
+            close(client->fd);
+            client->fd = -1;
+            broadcast->disconnected++;
+        }
+    }
+}
+
+int gps_broadcast_connect(const char *path, int *fd)
+{
+    assert(path != NULL);
+    assert(fd != NULL);
+
+    struct sockaddr_un address;
+    int result;
+
+    result = make_address(&address, path);
+    if (result != GPS_OK) return result;
+
+    *fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+    if (*fd < 0) return GPS_ERROR_IO;
+
+    if (connect(*fd, (const struct sockaddr *)&address, sizeof(address)) < 0)
+    {
+        close(*fd);
+        *fd = -1;
+        return GPS_ERROR_IO;
+    }
+
+    return GPS_OK;
+}
+
+int gps_broadcast_parse(const void *message,
+                        size_t size,
+                        uint32_t *sequence,
+                        struct gps_broadcast_record *records,
+                        size_t *count)
+{
+    assert(message != NULL);
+    assert(sequence != NULL);
+    assert(records != NULL);
+    assert(count != NULL);
+
+    const uint8_t *p = message;
+    size_t n;
+    size_t i;
+
+    if ((size < GPS_BROADCAST_HEADER_SIZE) || (memcmp(p, MESSAGE_MAGIC, 2) != 0)) return GPS_ERROR_CORRUPT;
+    if (p[2] != MESSAGE_VERSION) return GPS_ERROR_UNSUPPORTED;
+
+    n = p[3];
+    if ((n > GPS_BROADCAST_BATCH_SIZE) || (size != GPS_BROADCAST_HEADER_SIZE + n * GPS_BROADCAST_RECORD_SIZE))
+    {
+        return GPS_ERROR_CORRUPT;
+    }
+
+    *sequence = get_u32(p + 4);
+    for (i = 0; i < n; ++i)
+    {
+        get_record(p + GPS_BROADCAST_HEADER_SIZE + i * GPS_BROADCAST_RECORD_SIZE, &records[i]);
+    }
+    *count = n;
+
+    return GPS_OK;
+}
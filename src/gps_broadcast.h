@@ -0,0 +1,231 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Jacob McGladdery
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/**
+ * @file gps_broadcast.h
+ * @brief Fans decoded TPVs out to local clients over Unix domain sockets.
+ *
+ * A broadcaster lets one process own the receivers and decode them once,
+ * typically with gps_session, while any number of local processes receive
+ * the TPVs instead of opening the devices or parsing NMEA themselves.
+ * Clients connect to a SOCK_SEQPACKET socket bound to a path, so every
+ * message arrives whole and a client never sees part of one.
+ *
+ * TPVs are gathered into batches, one record per device and epoch, and a
+ * batch goes out as a single message to every client. A record is replaced
+ * while further sentences of the same epoch arrive, and a batch is sent
+ * when a device starts its next epoch, when the batch is full, or when it
+ * is older than the hold time given to gps_broadcast_init(). A record may
+ * be sent again with the same time when sentences of its epoch arrive after
+ * its batch left.
+ *
+ * Messages are sent without blocking. A client whose socket buffer is full
+ * skips the batch, which it can tell from the gap in the batch sequence
+ * numbers, so a slow or stalled client never holds up the decoder or the
+ * other clients. A client which hung up is disconnected.
+ *
+ * Each message is a GPS_BROADCAST_HEADER_SIZE byte header, holding the
+ * magic "GB", the format version, the record count, and the batch sequence
+ * number, followed by GPS_BROADCAST_RECORD_SIZE bytes per record, holding
+ * the device number and the fields of gps_compact_tpv. Integers are little
+ * endian. gps_broadcast_parse() decodes messages for clients.
+ *
+ * This module requires Linux and is only built when sys/epoll.h is found.
+ */
+
+#ifndef _GPS_BROADCAST_H_
+#define _GPS_BROADCAST_H_
+
+#include "gps.h"
+#include "gps_compact.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define GPS_BROADCAST_HEADER_SIZE  (8)  /**< Bytes of the message header */
+#define GPS_BROADCAST_RECORD_SIZE  (36) /**< Bytes of each record */
+#define GPS_BROADCAST_BATCH_SIZE   (32) /**< The most records in a message */
+
+/** The largest message */
+#define GPS_BROADCAST_MESSAGE_SIZE (GPS_BROADCAST_HEADER_SIZE + GPS_BROADCAST_BATCH_SIZE * GPS_BROADCAST_RECORD_SIZE)
+
+/**
+ * @brief A TPV and the device it was decoded from.
+ */
+struct gps_broadcast_record
+{
+    uint16_t device;            /**< The device number, see gps_session_add() */
+    struct gps_compact_tpv tpv; /**< The TPV */
+};
+
+/**
+ * @brief Per client state.
+ */
+struct gps_broadcast_client
+{
+    int fd;           /**< Connected socket, or -1 for a free slot */
+    uint32_t sent;    /**< Batches sent */
+    uint32_t skipped; /**< Batches skipped because the socket buffer was full */
+};
+
+/**
+ * @brief Broadcaster state.
+ */
+struct gps_broadcast
+{
+    int listen_fd;                        /**< The listening socket */
+    struct gps_broadcast_client *clients; /**< Client slots */
+    size_t capacity;                      /**< Number of elements in gps_broadcast.clients */
+    int64_t hold;                         /**< The longest time a batch is held, in nanoseconds */
+    int64_t opened;                       /**< When the pending batch got its first record */
+    struct gps_broadcast_record pending[GPS_BROADCAST_BATCH_SIZE]; /**< Records of the pending batch */
+    size_t count;                         /**< Records in gps_broadcast.pending */
+    uint32_t sequence;                    /**< Batches sent so far */
+    uint32_t refused;                     /**< Connections refused because all slots were in use */
+    uint32_t disconnected;                /**< Clients disconnected after an error */
+};
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Initializes a broadcaster and starts listening.
+ *
+ * A socket left at @p path by an earlier run is removed first. The socket
+ * is not removed by gps_broadcast_close(), so the caller should unlink
+ * @p path when it is done.
+ *
+ * @param[out] broadcast The broadcaster to initialize.
+ * @param[in] clients Storage for the client slots.
+ * @param[in] capacity The number of elements in @p clients, which is the
+ *            largest number of clients connected at once.
+ * @param[in] path The path of the socket.
+ * @param[in] hold The longest time a batch is held back waiting for the end
+ *            of an epoch, in nanoseconds. Zero sends every batch as soon as
+ *            gps_broadcast_service() is called.
+ * @return A result code.
+ * @retval GPS_OK The broadcaster is listening.
+ * @retval GPS_ERROR_OVERFLOW The path is too long for a Unix socket.
+ * @retval GPS_ERROR_IO The socket could not be created, bound, or listened
+ *         on.
+ *
+ * @pre The pointers @p broadcast and @p path must not be NULL.
+ */
+int gps_broadcast_init(struct gps_broadcast *broadcast,
+                       struct gps_broadcast_client *clients,
+                       size_t capacity,
+                       const char *path,
+                       int64_t hold);
+
+/**
+ * @brief Disconnects all clients and stops listening.
+ *
+ * A pending batch is dropped, call gps_broadcast_flush() first to send it.
+ *
+ * @param[in,out] broadcast The broadcaster.
+ */
+void gps_broadcast_close(struct gps_broadcast *broadcast);
+
+/**
+ * @brief Adds a TPV to the pending batch.
+ *
+ * Call it with every TPV decoded, for instance from the callback of
+ * gps_session. If the batch holds a record for the device at the same
+ * time, it is replaced. If it holds one at another time, or is full, the
+ * batch is sent first.
+ *
+ * @param[in,out] broadcast The broadcaster.
+ * @param[in] device The number of the device the TPV was decoded from.
+ * @param[in] tpv The TPV.
+ * @param[in] now The current time on CLOCK_MONOTONIC, in nanoseconds.
+ */
+void gps_broadcast_update(struct gps_broadcast *broadcast,
+                          uint16_t device,
+                          const struct gps_tpv *tpv,
+                          int64_t now);
+
+/**
+ * @brief Accepts new clients and sends the pending batch once it is due.
+ *
+ * Call this in the loop waiting for input, with the returned time as the
+ * longest wait.
+ *
+ * @param[in,out] broadcast The broadcaster.
+ * @param[in] now The current time on CLOCK_MONOTONIC, in nanoseconds.
+ * @return The milliseconds until the pending batch is due, or -1 if there
+ *         is no pending batch.
+ */
+int gps_broadcast_service(struct gps_broadcast *broadcast, int64_t now);
+
+/**
+ * @brief Sends the pending batch to every client, if there is one.
+ *
+ * @param[in,out] broadcast The broadcaster.
+ */
+void gps_broadcast_flush(struct gps_broadcast *broadcast);
+
+/**
+ * @brief Connects a client to a broadcaster.
+ *
+ * Read messages from the socket into a buffer of GPS_BROADCAST_MESSAGE_SIZE
+ * bytes, and decode them with gps_broadcast_parse().
+ *
+ * @param[in] path The path given to gps_broadcast_init().
+ * @param[out] fd Receives the connected socket, which the caller closes.
+ * @return A result code.
+ * @retval GPS_OK The client is connected.
+ * @retval GPS_ERROR_OVERFLOW The path is too long for a Unix socket.
+ * @retval GPS_ERROR_IO The connection failed.
+ *
+ * @pre The pointers @p path and @p fd must not be NULL.
+ */
+int gps_broadcast_connect(const char *path, int *fd);
+
+/**
+ * @brief Decodes a message.
+ *
+ * @param[in] message The message.
+ * @param[in] size The size of @p message.
+ * @param[out] sequence Receives the batch sequence number. A client has
+ *             skipped batches when it is not one more than that of the
+ *             previous message.
+ * @param[out] records Receives the records, up to GPS_BROADCAST_BATCH_SIZE.
+ * @param[out] count Receives the number of records.
+ * @return A result code.
+ * @retval GPS_OK The message was decoded.
+ * @retval GPS_ERROR_UNSUPPORTED The message has another format version.
+ * @retval GPS_ERROR_CORRUPT The message is not one a broadcaster sends.
+ */
+int gps_broadcast_parse(const void *message,
+                        size_t size,
+                        uint32_t *sequence,
+                        struct gps_broadcast_record *records,
+                        size_t *count);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _GPS_BROADCAST_H_ */
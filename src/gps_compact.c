@@ -0,0 +1,235 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Jacob McGladdery
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include "gps_compact.h"
+
+#include <assert.h>
+#include <stddef.h>
+#include <string.h>
+
+/* Length of the date part of a time stamp, "YYYY-MM-DD" */
+#define DATE_SIZE (10)
+
+static const char NULL_DATE[] = "0000-00-00";
+
+static uint16_t pack_mode(const struct gps_tpv *tpv)
+{
+    uint16_t flags = (uint16_t)tpv->mode & GPS_COMPACT_MODE_MASK;
+
+    if (gps_time_has_date(tpv->time)) flags |= GPS_COMPACT_HAS_DATE;
+
+    return flags;
+}
+
+static int pack_letter(char c, uint16_t *bits)
+{
+    if ('\0' == c)
+    {
+        *bits = 0;
+    }
+    else if (('A' <= c) && (c <= 'Z'))
+    {
+        *bits = (uint16_t)(c - 'A' + 1);
+    }
+    else
+    {
+        return 0;
+    }
+
+    return 1;
+}
+
+static char unpack_letter(uint16_t bits)
+{
+    bits &= 0x1F;
+    return (0 == bits) ? '\0' : (char)('A' + bits - 1);
+}
+
+/* Packs a value stored as a multiple of unit in [min, max], or invalid */
+static int pack_scaled(int32_t value, int32_t unit, int32_t min, int32_t max, int32_t *packed)
+{
+    if ((value % unit) != 0) return 0;
+    value /= unit;
+    if ((value < min) || (value > max)) return 0;
+    *packed = value;
+    return 1;
+}
+
+void gps_compact_from_tpv(struct gps_compact_tpv *compact, const struct gps_tpv *tpv)
+{
+    assert(compact != NULL);
+    assert(tpv != NULL);
+
+    compact->time = gps_time_to_ms(tpv->time);
+    compact->latitude = tpv->latitude;
+    compact->longitude = tpv->longitude;
+    compact->altitude = tpv->altitude;
+    compact->track = tpv->track;
+    compact->speed = tpv->speed;
+    compact->flags = pack_mode(tpv);
+    compact->talker_id[0] = tpv->talker_id[0];
+    compact->talker_id[1] = tpv->talker_id[1];
+}
+
+void gps_compact_to_tpv(struct gps_tpv *tpv, const struct gps_compact_tpv *compact)
+{
+    assert(tpv != NULL);
+    assert(compact != NULL);
+
+    tpv->mode = (enum gps_mode)(compact->flags & GPS_COMPACT_MODE_MASK);
+    tpv->altitude = compact->altitude;
+    tpv->latitude = compact->latitude;
+    tpv->longitude = compact->longitude;
+    tpv->track = compact->track;
+    tpv->speed = compact->speed;
+    gps_ms_to_time(tpv->time, compact->time, compact->flags & GPS_COMPACT_HAS_DATE);
+    tpv->talker_id[0] = compact->talker_id[0];
+    tpv->talker_id[1] = compact->talker_id[1];
+    tpv->talker_id[2] = '\0';
+}
+
+int gps_compact16_from_tpv(struct gps_compact_tpv16 *compact, const struct gps_tpv *tpv, int32_t altitude_base)
+{
+    assert(compact != NULL);
+    assert(tpv != NULL);
+
+    uint16_t flags = pack_mode(tpv);
+    uint16_t letter0;
+    uint16_t letter1;
+    int32_t value;
+
+    if (!pack_letter(tpv->talker_id[0], &letter0) || !pack_letter(tpv->talker_id[1], &letter1))
+    {
+        return GPS_ERROR_OVERFLOW;
+    }
+    flags |= (uint16_t)((letter0 | (letter1 << 5)) << GPS_COMPACT_TALKER_SHIFT);
+
+    compact->altitude = 0;
+    if (tpv->altitude != GPS_INVALID_VALUE)
+    {
+        int64_t relative = (int64_t)tpv->altitude - altitude_base;
+
+        if ((relative < INT32_MIN) || (relative > INT32_MAX)) return GPS_ERROR_OVERFLOW;
+        if (!pack_scaled((int32_t)relative, GPS_COMPACT_ALTITUDE_UNIT, INT16_MIN, INT16_MAX, &value))
+        {
+            return GPS_ERROR_OVERFLOW;
+        }
+        compact->altitude = (int16_t)value;
+        flags |= GPS_COMPACT_ALTITUDE;
+    }
+
+    compact->speed = 0;
+    if (tpv->speed != GPS_INVALID_VALUE)
+    {
+        if (!pack_scaled(tpv->speed, 1, 0, UINT16_MAX, &value)) return GPS_ERROR_OVERFLOW;
+        compact->speed = (uint16_t)value;
+        flags |= GPS_COMPACT_SPEED;
+    }
+
+    compact->track = 0;
+    if (tpv->track != GPS_INVALID_VALUE)
+    {
+        if (!pack_scaled(tpv->track, GPS_COMPACT_TRACK_UNIT, 0, UINT16_MAX, &value)) return GPS_ERROR_OVERFLOW;
+        compact->track = (uint16_t)value;
+        flags |= GPS_COMPACT_TRACK;
+    }
+
+    compact->time = gps_time_to_ms(tpv->time);
+    compact->latitude = tpv->latitude;
+    compact->longitude = tpv->longitude;
+    compact->flags = flags;
+
+    return GPS_OK;
+}
+
+void gps_compact16_to_tpv(struct gps_tpv *tpv, const struct gps_compact_tpv16 *compact, int32_t altitude_base)
+{
+    assert(tpv != NULL);
+    assert(compact != NULL);
+
+    uint16_t flags = compact->flags;
+    uint16_t talker = flags >> GPS_COMPACT_TALKER_SHIFT;
+
+    tpv->mode = (enum gps_mode)(flags & GPS_COMPACT_MODE_MASK);
+    tpv->latitude = compact->latitude;
+    tpv->longitude = compact->longitude;
+
+    tpv->altitude = GPS_INVALID_VALUE;
+    if (flags & GPS_COMPACT_ALTITUDE)
+    {
+        tpv->altitude = altitude_base + (int32_t)compact->altitude * GPS_COMPACT_ALTITUDE_UNIT;
+    }
+
+    tpv->speed = (flags & GPS_COMPACT_SPEED) ? (int32_t)compact->speed : GPS_INVALID_VALUE;
+    tpv->track = (flags & GPS_COMPACT_TRACK) ? (int32_t)compact->track * GPS_COMPACT_TRACK_UNIT : GPS_INVALID_VALUE;
+
+    gps_ms_to_time(tpv->time, compact->time, flags & GPS_COMPACT_HAS_DATE);
+    tpv->talker_id[0] = unpack_letter(talker);
+    tpv->talker_id[1] = unpack_letter(talker >> 5);
+    tpv->talker_id[2] = '\0';
+}
+
+int gps_compact_decode(struct gps_tpv *state, struct gps_compact_tpv *compact, char *nmea)
+{
+    assert(state != NULL);
+    assert(compact != NULL);
+    assert(nmea != NULL);
+
+    char time[GPS_TIME_STRING_SIZE];
+    int result;
+
+    memcpy(time, state->time, sizeof(time));
+    result = gps_decode(state, nmea);
+    if (result != GPS_OK) return result;
+
+    compact->latitude = state->latitude;
+    compact->longitude = state->longitude;
+    compact->altitude = state->altitude;
+    compact->track = state->track;
+    compact->speed = state->speed;
+    compact->flags = pack_mode(state);
+    compact->talker_id[0] = state->talker_id[0];
+    compact->talker_id[1] = state->talker_id[1];
+
+    if (0 == memcmp(time, state->time, sizeof(time))) return GPS_OK;
+
+    /* Most sentences only move the time of day, in which case the day
+     * number is kept rather than converted from the date again
+     */
+    if ((compact->flags & GPS_COMPACT_HAS_DATE) && (0 == memcmp(time, state->time, DATE_SIZE)))
+    {
+        int64_t days = compact->time / GPS_MS_PER_DAY;
+
+        if (compact->time % GPS_MS_PER_DAY < 0) --days;
+        memcpy(time, state->time, sizeof(time));
+        memcpy(time, NULL_DATE, DATE_SIZE);
+        compact->time = days * GPS_MS_PER_DAY + gps_time_to_ms(time);
+    }
+    else
+    {
+        compact->time = gps_time_to_ms(state->time);
+    }
+
+    return GPS_OK;
+}
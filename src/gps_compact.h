@@ -0,0 +1,163 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Jacob McGladdery
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/**
+ * @file gps_compact.h
+ * @brief Packed TPV layouts for keeping many fixes in memory.
+ *
+ * gps_tpv is convenient to decode into but costs 52 bytes, half of them
+ * the ISO8601 time stamp. The compact layouts replace the string with an
+ * integer time in milliseconds, see gps_time_to_ms(), and fold the fix mode
+ * and flags into a few bits.
+ *
+ * gps_compact_tpv takes 32 bytes, so two fixes share a 64 byte cache line,
+ * and converts to and from gps_tpv without loss. gps_compact_tpv16 takes
+ * 24 bytes by storing the altitude relative to a base chosen by the caller,
+ * the speed, and the track in 16 bits each. Conversion to it fails instead
+ * of rounding when a TPV does not fit, so a caller may fall back to the 32
+ * byte layout for those fixes.
+ */
+
+#ifndef _GPS_COMPACT_H_
+#define _GPS_COMPACT_H_
+
+#include "gps.h"
+
+#include <stdint.h>
+
+#define GPS_COMPACT_MODE_MASK     (0x0003) /**< Bits holding the gps_mode */
+#define GPS_COMPACT_HAS_DATE      (0x0004) /**< The time is relative to the Unix epoch, not midnight */
+#define GPS_COMPACT_ALTITUDE      (0x0008) /**< gps_compact_tpv16.altitude is valid */
+#define GPS_COMPACT_SPEED         (0x0010) /**< gps_compact_tpv16.speed is valid */
+#define GPS_COMPACT_TRACK         (0x0020) /**< gps_compact_tpv16.track is valid */
+#define GPS_COMPACT_TALKER_SHIFT  (6)      /**< First bit of the gps_compact_tpv16 talker ID */
+
+#define GPS_COMPACT_ALTITUDE_UNIT (100) /**< gps_compact_tpv16.altitude unit, in gps_tpv.altitude units */
+#define GPS_COMPACT_TRACK_UNIT    (10)  /**< gps_compact_tpv16.track unit, in gps_tpv.track units */
+
+/**
+ * @brief TPV in 32 bytes.
+ *
+ * Invalid values are stored as GPS_INVALID_VALUE, like in gps_tpv.
+ */
+struct gps_compact_tpv
+{
+    int64_t time;       /**< Milliseconds since the epoch or midnight, see GPS_COMPACT_HAS_DATE */
+    int32_t latitude;   /**< Same as gps_tpv.latitude */
+    int32_t longitude;  /**< Same as gps_tpv.longitude */
+    int32_t altitude;   /**< Same as gps_tpv.altitude */
+    int32_t track;      /**< Same as gps_tpv.track */
+    int32_t speed;      /**< Same as gps_tpv.speed */
+    uint16_t flags;     /**< The mode and GPS_COMPACT_HAS_DATE */
+    char talker_id[2];  /**< Talker ID, not NUL terminated */
+};
+
+/**
+ * @brief TPV in 24 bytes, with 16 bit altitude, speed, and track.
+ *
+ * The flags hold the mode, GPS_COMPACT_HAS_DATE, one validity bit for each
+ * 16 bit value, and the talker ID as two 5 bit letters from GPS_COMPACT_TALKER_SHIFT
+ * on, where 0 is a NUL and 1 to 26 are 'A' to 'Z'.
+ */
+struct gps_compact_tpv16
+{
+    int64_t time;       /**< Milliseconds since the epoch or midnight, see GPS_COMPACT_HAS_DATE */
+    int32_t latitude;   /**< Same as gps_tpv.latitude */
+    int32_t longitude;  /**< Same as gps_tpv.longitude */
+    int16_t altitude;   /**< Altitude above the base in decimeters */
+    uint16_t speed;     /**< Speed in millimeters per second */
+    uint16_t track;     /**< Track in hundredths of a degree */
+    uint16_t flags;     /**< The mode, validity bits, and talker ID */
+};
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Packs a TPV into 32 bytes.
+ *
+ * The conversion is exact for every TPV filled in by gps_decode() from
+ * valid sentences, so gps_compact_to_tpv() gives back the same TPV.
+ *
+ * @param[out] compact The packed TPV.
+ * @param[in] tpv The TPV to pack.
+ */
+void gps_compact_from_tpv(struct gps_compact_tpv *compact, const struct gps_tpv *tpv);
+
+/**
+ * @brief Unpacks a 32 byte TPV.
+ *
+ * @param[out] tpv The unpacked TPV.
+ * @param[in] compact The packed TPV.
+ */
+void gps_compact_to_tpv(struct gps_tpv *tpv, const struct gps_compact_tpv *compact);
+
+/**
+ * @brief Packs a TPV into 24 bytes.
+ *
+ * @param[out] compact The packed TPV.
+ * @param[in] tpv The TPV to pack.
+ * @param[in] altitude_base The altitude that gps_compact_tpv16.altitude is
+ *            relative to, in gps_tpv.altitude units, for instance the first
+ *            altitude of a track.
+ * @return A result code.
+ * @retval GPS_OK The TPV was packed, and gps_compact16_to_tpv() gives it
+ *         back unchanged.
+ * @retval GPS_ERROR_OVERFLOW A value is out of range or finer than the 16
+ *         bit unit, or the talker ID is not made of capital letters. The
+ *         contents of @p compact are undefined.
+ */
+int gps_compact16_from_tpv(struct gps_compact_tpv16 *compact, const struct gps_tpv *tpv, int32_t altitude_base);
+
+/**
+ * @brief Unpacks a 24 byte TPV.
+ *
+ * @param[out] tpv The unpacked TPV.
+ * @param[in] compact The packed TPV.
+ * @param[in] altitude_base The base given to gps_compact16_from_tpv().
+ */
+void gps_compact16_to_tpv(struct gps_tpv *tpv, const struct gps_compact_tpv16 *compact, int32_t altitude_base);
+
+/**
+ * @brief Decodes a NMEA sentence straight into a 32 byte TPV.
+ *
+ * Sentences update parts of the time stamp and fix independently, so the
+ * decoder keeps a full TPV per receiver in @p state. Only the time stamp
+ * characters are converted, and only when the sentence changed them.
+ *
+ * @param[in,out] state The decoder state, initialized with gps_init_tpv().
+ * @param[in,out] compact The packed TPV, updated on success. It must hold
+ *                the result of the previous decode for @p state, or of
+ *                gps_compact_from_tpv() on @p state.
+ * @param[in,out] nmea The NMEA sentence to decode, see gps_decode().
+ * @return The result of gps_decode().
+ */
+int gps_compact_decode(struct gps_tpv *state, struct gps_compact_tpv *compact, char *nmea);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _GPS_COMPACT_H_ */
@@ -0,0 +1,169 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Jacob McGladdery
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include "gps_dedup.h"
+
+#include <assert.h>
+#include <string.h>
+
+#define FNV_OFFSET (2166136261u)
+#define FNV_PRIME  (16777619u)
+
+/* Longest first field hashed, enough for "HHMMSS.SSS" */
+#define FIELD_SIZE (10)
+
+/* Digits at the start of a first field holding a fix time, "HHMMSS" */
+#define TIME_DIGITS (6)
+
+static uint32_t hash(uint32_t h, const char *str, size_t n)
+{
+    while (n--)
+    {
+        h ^= (uint8_t)*str++;
+        h *= FNV_PRIME;
+    }
+
+    return h;
+}
+
+/* Checks whether a first field of the given length starts with "HHMMSS" */
+static int is_time(const char *field, size_t length)
+{
+    size_t i;
+
+    if (length < TIME_DIGITS) return 0;
+    for (i = 0; i < TIME_DIGITS; ++i)
+    {
+        if ((field[i] < '0') || (field[i] > '9')) return 0;
+    }
+
+    return 1;
+}
+
+/* Hashes the talker and sentence IDs, then the first field and the checksum
+ * characters when the first field is a fix time, or else the whole body.
+ * Returns 0 if the sentence is too malformed to key.
+ */
+static uint32_t sentence_key(const char *nmea, size_t size)
+{
+    const char *star;
+    size_t field;
+    uint32_t h;
+
+    /* "$TTIII," */
+    if ((size < 7) || (nmea[0] != '$')) return 0;
+
+    /* The checksum is normally 5 characters from the end */
+    if ((size >= 5) && ('*' == nmea[size - 5]))
+    {
+        star = nmea + size - 5;
+    }
+    else
+    {
+        star = memchr(nmea, '*', size);
+        if ((NULL == star) || (nmea + size - star < 3)) return 0;
+    }
+
+    for (field = 0; (7 + field < (size_t)(star - nmea)) && (field < FIELD_SIZE); ++field)
+    {
+        if (',' == nmea[7 + field]) break;
+    }
+
+    h = hash(FNV_OFFSET, nmea + 1, 5);
+    if (is_time(nmea + 7, field))
+    {
+        h = hash(h, nmea + 7, field);
+        h = hash(h, star + 1, 2);
+    }
+    else
+    {
+        /* Such as GSA, whose first field is the same in every sentence */
+        h = hash(h, nmea + 6, (size_t)(star - nmea) - 6);
+    }
+
+    /* 0 marks a free slot */
+    return h ? h : 1;
+}
+
+void gps_dedup_init(struct gps_dedup *dedup, struct gps_dedup_entry *entries, size_t capacity,
+                    uint32_t window)
+{
+    assert(dedup != NULL);
+    assert(entries != NULL);
+    assert(capacity >= GPS_DEDUP_PROBES);
+    assert((capacity & (capacity - 1)) == 0);
+
+    memset(entries, 0, capacity * sizeof(*entries));
+    dedup->entries = entries;
+    dedup->mask = capacity - 1;
+    dedup->window = window;
+    dedup->hits = 0;
+    dedup->misses = 0;
+}
+
+int gps_dedup_check(struct gps_dedup *dedup, const char *nmea, size_t size, uint32_t now)
+{
+    assert(dedup != NULL);
+    assert(nmea != NULL);
+
+    struct gps_dedup_entry *unused = NULL;
+    struct gps_dedup_entry *oldest = NULL;
+    struct gps_dedup_entry *victim;
+    uint32_t key = sentence_key(nmea, size);
+    uint32_t oldest_age = 0;
+    size_t i;
+
+    if (0 == key) return 0;
+
+    /* Look through every slot the key may use, since it may sit past a slot
+     * which has expired since it was stored
+     */
+    for (i = 0; i < GPS_DEDUP_PROBES; ++i)
+    {
+        struct gps_dedup_entry *entry = &dedup->entries[(key + i) & dedup->mask];
+        uint32_t age = now - entry->time;
+
+        if ((0 == entry->key) || (age > dedup->window))
+        {
+            if (NULL == unused) unused = entry;
+        }
+        else if (entry->key == key)
+        {
+            dedup->hits++;
+            return 1;
+        }
+        else if ((NULL == oldest) || (age > oldest_age))
+        {
+            oldest = entry;
+            oldest_age = age;
+        }
+    }
+
+    victim = (unused != NULL) ? unused : oldest;
+    victim->key = key;
+    victim->time = now;
+    dedup->misses++;
+
+    return 0;
+}
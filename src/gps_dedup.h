@@ -0,0 +1,113 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Jacob McGladdery
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/**
+ * @file gps_dedup.h
+ * @brief Drops duplicate sentences before they are decoded.
+ *
+ * Redundant receivers, and gateways which get one feed over two links,
+ * deliver the same sentence more than once. gps_dedup_check() keys each
+ * sentence on a hash of its talker and sentence IDs. When its first field
+ * is a fix time, as for GGA, RMC and ZDA, the key adds that field and the
+ * checksum. Otherwise, as for GSA and GSV, whose first fields repeat within
+ * an epoch, it adds the whole body. None of these need the sentence to be
+ * decoded. A key seen within the time window is reported as a duplicate,
+ * so the caller can skip gps_decode() for it.
+ *
+ * Keys live in a fixed size open addressing table owned by the caller.
+ * Entries expire once they are older than the window, and when every slot
+ * a key may use is live, the oldest one is replaced. A full table therefore
+ * lets some duplicates through, but never drops a new sentence other than
+ * on a hash collision.
+ */
+
+#ifndef _GPS_DEDUP_H_
+#define _GPS_DEDUP_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define GPS_DEDUP_PROBES (4) /**< The number of slots a key may use */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Slot of the table.
+ */
+struct gps_dedup_entry
+{
+    uint32_t key;  /**< Hash of the sentence, 0 for a free slot */
+    uint32_t time; /**< When the sentence was last seen, in milliseconds */
+};
+
+/**
+ * @brief Duplicate filter state.
+ */
+struct gps_dedup
+{
+    struct gps_dedup_entry *entries; /**< The table, owned by the caller */
+    size_t mask;                     /**< The number of entries minus one */
+    uint32_t window;                 /**< How long a sentence counts as seen, in milliseconds */
+    uint32_t hits;                   /**< Duplicates found */
+    uint32_t misses;                 /**< New sentences found */
+};
+
+/**
+ * @brief Initializes a duplicate filter.
+ *
+ * @param[out] dedup The filter to initialize.
+ * @param[out] entries The table.
+ * @param[in] capacity The number of entries in @p entries.
+ * @param[in] window How long a sentence counts as seen, in milliseconds.
+ *
+ * @pre The pointers @p dedup and @p entries must not be NULL.
+ * @pre @p capacity must be a power of two, and at least GPS_DEDUP_PROBES.
+ */
+void gps_dedup_init(struct gps_dedup *dedup, struct gps_dedup_entry *entries, size_t capacity,
+                    uint32_t window);
+
+/**
+ * @brief Checks a sentence against the ones seen within the window.
+ *
+ * The sentence is recorded as seen at @p now. Sentences too malformed to
+ * key are never reported as duplicates, so gps_decode() can report them.
+ *
+ * @param[in,out] dedup The filter.
+ * @param[in] nmea The sentence, which is only read.
+ * @param[in] size The number of characters in @p nmea.
+ * @param[in] now The current time in milliseconds, from any clock which
+ *            wraps around at 2^32.
+ * @return Non-zero if the sentence is a duplicate.
+ *
+ * @pre The pointers @p dedup and @p nmea must not be NULL.
+ */
+int gps_dedup_check(struct gps_dedup *dedup, const char *nmea, size_t size, uint32_t now);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,287 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Jacob McGladdery
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include "gps_fixed.h"
+
+#define ANGLE_EIGHTH_TURN (UINT64_C(1) << 37)
+
+/* 2^60 / 360e6, converts micro-degrees to binary angles with a 20 bit shift */
+#define ANGLE_PER_MICRODEGREE_Q20 INT64_C(3202559735)
+
+/* pi / 2 in Q30, converts angles within a quarter turn to radians in Q30 */
+#define HALF_PI_Q30 INT64_C(1686629713)
+
+/* pi / 4 and pi / 2 in Q40 */
+#define QUARTER_PI_Q40 INT64_C(863554413089)
+#define HALF_PI_Q40    INT64_C(1727108826179)
+
+/* pi / 360e6 in Q60, converts micro-degrees to half angles in radians Q40 */
+#define HALF_RADIANS_PER_MICRODEGREE_Q60 INT64_C(10061138136)
+
+#define MILLIDEGREES_PER_TURN UINT64_C(360000)
+
+/* atan(2^-i) as binary angles */
+static const uint64_t cordic_atan[] = {
+    UINT64_C(137438953472), UINT64_C(81134951838), UINT64_C(42869480287),
+    UINT64_C(21761217566), UINT64_C(10922836750), UINT64_C(5466743129),
+    UINT64_C(2734038620), UINT64_C(1367102738), UINT64_C(683561799),
+    UINT64_C(341782203), UINT64_C(170891265), UINT64_C(85445653),
+    UINT64_C(42722829), UINT64_C(21361415), UINT64_C(10680707),
+    UINT64_C(5340354), UINT64_C(2670177), UINT64_C(1335088), UINT64_C(667544),
+    UINT64_C(333772), UINT64_C(166886), UINT64_C(83443), UINT64_C(41722),
+    UINT64_C(20861), UINT64_C(10430), UINT64_C(5215), UINT64_C(2608),
+    UINT64_C(1304), UINT64_C(652), UINT64_C(326), UINT64_C(163), UINT64_C(81),
+    UINT64_C(41), UINT64_C(20), UINT64_C(10), UINT64_C(5), UINT64_C(3),
+    UINT64_C(1), UINT64_C(1)
+};
+
+uint_fast8_t gps_fixed_bit_length(uint64_t n)
+{
+    uint_fast8_t length = 0;
+
+    if (n >> 32) { n >>= 32; length += 32; }
+    if (n >> 16) { n >>= 16; length += 16; }
+    if (n >> 8)  { n >>= 8;  length += 8; }
+    if (n >> 4)  { n >>= 4;  length += 4; }
+    if (n >> 2)  { n >>= 2;  length += 2; }
+    if (n >> 1)  { n >>= 1;  length += 1; }
+
+    return length + (uint_fast8_t)n;
+}
+
+uint64_t gps_fixed_isqrt(uint64_t n)
+{
+    uint64_t root = 0;
+    uint64_t bit;
+
+    if (0 == n) return 0;
+    bit = UINT64_C(1) << ((gps_fixed_bit_length(n) - 1) & ~1u);
+
+    /* Branch free, the comparison is unpredictable */
+    while (bit)
+    {
+        uint64_t trial = root + bit;
+        uint64_t mask = (uint64_t)0 - (uint64_t)(n >= trial);
+
+        n -= trial & mask;
+        root = (root >> 1) + (bit & mask);
+        bit >>= 2;
+    }
+
+    return root;
+}
+
+int64_t gps_fixed_mul_q40(int64_t x, int64_t y)
+{
+    /* Split y into 20 bit halves so that neither partial product overflows */
+    return ((x * (y >> 20)) + ((x * (y & 0xFFFFF)) >> 20)) >> 20;
+}
+
+int64_t gps_fixed_hypot(int64_t x, int64_t y)
+{
+    uint_fast8_t length, shift;
+
+    if (x < 0) x = -x;
+    if (y < 0) y = -y;
+
+    /* Shift both down just enough for the squares to fit */
+    length = gps_fixed_bit_length((uint64_t)(x | y));
+    shift = (length > 31) ? (uint_fast8_t)(length - 31) : 0;
+    x >>= shift;
+    y >>= shift;
+
+    return (int64_t)gps_fixed_isqrt((uint64_t)(x * x) + (uint64_t)(y * y)) << shift;
+}
+
+int64_t gps_fixed_wrap_longitude(int64_t delta)
+{
+    if (delta > GPS_FIXED_MICRODEGREES_PER_HALF_TURN) return delta - GPS_FIXED_MICRODEGREES_PER_TURN;
+    if (delta < -GPS_FIXED_MICRODEGREES_PER_HALF_TURN) return delta + GPS_FIXED_MICRODEGREES_PER_TURN;
+    return delta;
+}
+
+uint64_t gps_fixed_angle(int64_t microdegrees)
+{
+    return (uint64_t)((microdegrees * ANGLE_PER_MICRODEGREE_Q20) >> 20) & (GPS_FIXED_ANGLE_TURN - 1);
+}
+
+int64_t gps_fixed_radians_q40(int64_t microdegrees)
+{
+    return (microdegrees * (2 * HALF_RADIANS_PER_MICRODEGREE_Q60)) >> 20;
+}
+
+int32_t gps_fixed_angle_to_millidegrees(uint64_t angle)
+{
+    uint64_t value = (((angle & (GPS_FIXED_ANGLE_TURN - 1)) * MILLIDEGREES_PER_TURN) +
+                      GPS_FIXED_ANGLE_HALF_TURN) >> 40;
+
+    if (value == MILLIDEGREES_PER_TURN) return 0;
+    return (int32_t)value;
+}
+
+/* sin(x) / x for x in [0, pi/4] radians, Q30 in and out */
+static int64_t sin_poly_factor(int64_t x)
+{
+    int64_t x2 = (x * x) >> 30;
+    int64_t t;
+
+    t = GPS_FIXED_Q30_ONE - x2 / 72;
+    t = GPS_FIXED_Q30_ONE - ((x2 * t) >> 30) / 42;
+    t = GPS_FIXED_Q30_ONE - ((x2 * t) >> 30) / 20;
+    t = GPS_FIXED_Q30_ONE - ((x2 * t) >> 30) / 6;
+
+    return t;
+}
+
+/* sin(x) for x in [0, pi/4] radians, Q30 in and out */
+static int64_t sin_poly(int64_t x)
+{
+    return (x * sin_poly_factor(x)) >> 30;
+}
+
+/* cos(x) for x in [0, pi/4] radians, Q30 in and out */
+static int64_t cos_poly(int64_t x)
+{
+    int64_t x2 = (x * x) >> 30;
+    int64_t t;
+
+    t = GPS_FIXED_Q30_ONE - x2 / 90;
+    t = GPS_FIXED_Q30_ONE - ((x2 * t) >> 30) / 56;
+    t = GPS_FIXED_Q30_ONE - ((x2 * t) >> 30) / 30;
+    t = GPS_FIXED_Q30_ONE - ((x2 * t) >> 30) / 12;
+    t = GPS_FIXED_Q30_ONE - ((x2 * t) >> 30) / 2;
+
+    return t;
+}
+
+static int64_t quarter_angle_to_radians(uint64_t angle)
+{
+    return ((int64_t)(angle >> 8) * HALF_PI_Q30) >> 30;
+}
+
+int64_t gps_fixed_sin_q30(uint64_t angle)
+{
+    uint64_t r = angle & (GPS_FIXED_ANGLE_QUARTER_TURN - 1);
+    int64_t s, c;
+
+    /* Evaluate the polynomials on [0, pi/4] only, where they converge
+     * quickly, and use symmetry for the rest of the quarter turn.
+     */
+    if (r <= ANGLE_EIGHTH_TURN)
+    {
+        s = sin_poly(quarter_angle_to_radians(r));
+        c = cos_poly(quarter_angle_to_radians(r));
+    }
+    else
+    {
+        s = cos_poly(quarter_angle_to_radians(GPS_FIXED_ANGLE_QUARTER_TURN - r));
+        c = sin_poly(quarter_angle_to_radians(GPS_FIXED_ANGLE_QUARTER_TURN - r));
+    }
+
+    switch ((angle >> 38) & 3)
+    {
+    case 0: return s;
+    case 1: return c;
+    case 2: return -s;
+    default: break;
+    }
+
+    return -c;
+}
+
+int64_t gps_fixed_cos_q30(uint64_t angle)
+{
+    return gps_fixed_sin_q30(angle + GPS_FIXED_ANGLE_QUARTER_TURN);
+}
+
+int64_t gps_fixed_sin_half_q40(int64_t microdegrees)
+{
+    int64_t x, t;
+    uint_fast8_t length;
+    uint_fast8_t shift = 0;
+
+    if (microdegrees < 0) return -gps_fixed_sin_half_q40(-microdegrees);
+
+    x = (microdegrees * HALF_RADIANS_PER_MICRODEGREE_Q60) >> 20;
+
+    /* Large angles only need relative precision */
+    if (x > QUARTER_PI_Q40) return cos_poly((HALF_PI_Q40 - x) >> 10) << 10;
+
+    /* sin(x) = x * t, shifting x down just enough for the product to fit */
+    t = sin_poly_factor(x >> 10);
+    length = gps_fixed_bit_length((uint64_t)x);
+    if (length > 33) shift = (uint_fast8_t)(length - 33);
+
+    return ((x >> shift) * t) >> (30 - shift);
+}
+
+int64_t gps_fixed_cos_half_q40(int64_t microdegrees)
+{
+    if (microdegrees < 0) microdegrees = -microdegrees;
+
+    return gps_fixed_sin_half_q40(GPS_FIXED_MICRODEGREES_PER_HALF_TURN - microdegrees);
+}
+
+uint64_t gps_fixed_atan2(int64_t y, int64_t x)
+{
+    uint64_t angle = 0;
+    uint_fast8_t length;
+    uint_fast8_t i;
+
+    if ((0 == x) && (0 == y)) return 0;
+
+    /* Rotate into the right half plane */
+    if (x < 0)
+    {
+        x = -x;
+        y = -y;
+        angle = GPS_FIXED_ANGLE_HALF_TURN;
+    }
+
+    /* Scale small vectors up so that the shifts below keep their precision.
+     * The CORDIC gain of about 1.65 leaves plenty of headroom.
+     */
+    length = gps_fixed_bit_length((uint64_t)x | (uint64_t)(y < 0 ? -y : y));
+    if (length < 58)
+    {
+        x *= INT64_C(1) << (58 - length);
+        y *= INT64_C(1) << (58 - length);
+    }
+
+    /* Rotate towards the x axis. The direction of each step depends on the
+     * sign of y, which is applied with a mask rather than a branch.
+     */
+    for (i = 0; i < sizeof(cordic_atan) / sizeof(cordic_atan[0]); ++i)
+    {
+        int64_t sign = y >> 63;
+        int64_t dx = y >> i;
+        int64_t dy = x >> i;
+
+        x += (dx ^ sign) - sign;
+        y -= (dy ^ sign) - sign;
+        angle += (cordic_atan[i] ^ (uint64_t)sign) - (uint64_t)sign;
+    }
+
+    return angle & (GPS_FIXED_ANGLE_TURN - 1);
+}
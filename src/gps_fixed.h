@@ -0,0 +1,149 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Jacob McGladdery
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/**
+ * @file gps_fixed.h
+ * @brief Fixed-point arithmetic and trigonometry shared by the optional
+ *        modules.
+ *
+ * This is an internal header, it is not part of the public API. Angles are
+ * either micro-degrees, matching the TPV coordinates, or binary angles that
+ * map one full turn onto 2^40. Fractions are Q30 or Q40 fixed-point values.
+ */
+
+#ifndef _GPS_FIXED_H_
+#define _GPS_FIXED_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Fixed-point one in Q30 format */
+#define GPS_FIXED_Q30_ONE (INT64_C(1) << 30)
+
+/** Fixed-point one in Q40 format */
+#define GPS_FIXED_Q40_ONE (INT64_C(1) << 40)
+
+/** Binary angle of one full turn */
+#define GPS_FIXED_ANGLE_TURN         (UINT64_C(1) << 40)
+/** Binary angle of half a turn */
+#define GPS_FIXED_ANGLE_HALF_TURN    (UINT64_C(1) << 39)
+/** Binary angle of a quarter turn */
+#define GPS_FIXED_ANGLE_QUARTER_TURN (UINT64_C(1) << 38)
+
+/** Micro-degrees in one full turn */
+#define GPS_FIXED_MICRODEGREES_PER_TURN      INT64_C(360000000)
+/** Micro-degrees in half a turn */
+#define GPS_FIXED_MICRODEGREES_PER_HALF_TURN INT64_C(180000000)
+
+/**
+ * @brief Number of significant bits in n.
+ */
+uint_fast8_t gps_fixed_bit_length(uint64_t n);
+
+/**
+ * @brief Integer square root, rounded down.
+ */
+uint64_t gps_fixed_isqrt(uint64_t n);
+
+/**
+ * @brief Product of two Q40 values.
+ *
+ * The result is exact apart from the final rounding down.
+ *
+ * @pre |x| < 2^43 and |x * y| < 2^83
+ */
+int64_t gps_fixed_mul_q40(int64_t x, int64_t y);
+
+/**
+ * @brief sqrt(x^2 + y^2), rounded to about 31 significant bits.
+ */
+int64_t gps_fixed_hypot(int64_t x, int64_t y);
+
+/**
+ * @brief Wraps a longitude difference in micro-degrees into
+ *        [-180, 180] degrees.
+ */
+int64_t gps_fixed_wrap_longitude(int64_t delta);
+
+/**
+ * @brief Converts micro-degrees to a binary angle.
+ */
+uint64_t gps_fixed_angle(int64_t microdegrees);
+
+/**
+ * @brief Converts micro-degrees to radians in Q40.
+ *
+ * @pre |microdegrees| <= 360 degrees
+ */
+int64_t gps_fixed_radians_q40(int64_t microdegrees);
+
+/**
+ * @brief Converts a binary angle to millidegrees within [0, 360) degrees.
+ */
+int32_t gps_fixed_angle_to_millidegrees(uint64_t angle);
+
+/**
+ * @brief sin of a binary angle in Q30.
+ */
+int64_t gps_fixed_sin_q30(uint64_t angle);
+
+/**
+ * @brief cos of a binary angle in Q30.
+ */
+int64_t gps_fixed_cos_q30(uint64_t angle);
+
+/**
+ * @brief sin(x / 2) for an angle x in micro-degrees, in Q40.
+ *
+ * Unlike gps_fixed_sin_q30() the result keeps its absolute precision for
+ * tiny angles, which is what the formulas working on coordinate
+ * differences need.
+ *
+ * @pre |microdegrees| <= 180 degrees
+ */
+int64_t gps_fixed_sin_half_q40(int64_t microdegrees);
+
+/**
+ * @brief cos(x / 2) for an angle x in micro-degrees, in Q40.
+ *
+ * @pre |microdegrees| <= 180 degrees
+ */
+int64_t gps_fixed_cos_half_q40(int64_t microdegrees);
+
+/**
+ * @brief Angle of the vector (x, y) from the x axis towards the y axis, as
+ *        a binary angle within [0, 1) turns.
+ *
+ * @pre |x| < 2^58 and |y| < 2^58
+ */
+uint64_t gps_fixed_atan2(int64_t y, int64_t x);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _GPS_FIXED_H_ */
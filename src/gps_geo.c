@@ -0,0 +1,207 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Jacob McGladdery
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include "gps_geo.h"
+#include "gps_fixed.h"
+
+#include <assert.h>
+#include <stddef.h>
+#include <math.h>
+
+/* Earth circumference in millimeters for the mean radius of 6371008.8 m */
+#define CIRCUMFERENCE_MM UINT64_C(40030228884)
+
+/* Millimeters per micro-degree of arc divided by 8, times 10^6 */
+#define MM_PER_MICRODEGREE_DIV_8_E6 UINT64_C(13899385)
+
+/* Equirectangular projection of the second point relative to the first, in
+ * eighths of a micro-degree of arc along the east and north axes.
+ */
+static void project(int64_t *east, int64_t *north,
+                    int32_t lat1, int32_t lon1, int32_t lat2, int32_t lon2)
+{
+    int64_t mid = ((int64_t)lat1 + lat2) / 2;
+    int64_t dlon = gps_fixed_wrap_longitude((int64_t)lon2 - lon1);
+
+    *east = (dlon * gps_fixed_cos_q30(gps_fixed_angle(mid))) >> 27;
+    *north = ((int64_t)lat2 - lat1) * 8;
+}
+
+int32_t gps_geo_distance_fast(int32_t lat1, int32_t lon1, int32_t lat2, int32_t lon2)
+{
+    int64_t east, north;
+    uint64_t length;
+    uint64_t distance;
+
+    project(&east, &north, lat1, lon1, lat2, lon2);
+    length = gps_fixed_isqrt((uint64_t)(east * east) + (uint64_t)(north * north));
+    distance = ((length * MM_PER_MICRODEGREE_DIV_8_E6) + 500000) / 1000000;
+
+    if (distance > INT32_MAX) return INT32_MAX;
+    return (int32_t)distance;
+}
+
+int64_t gps_geo_distance(int32_t lat1, int32_t lon1, int32_t lat2, int32_t lon2)
+{
+    int64_t dlat = (int64_t)lat2 - lat1;
+    int64_t dlon = gps_fixed_wrap_longitude((int64_t)lon2 - lon1);
+    int64_t sum = (int64_t)lat1 + lat2;
+    int64_t sin_dlat, cos_dlat, sin_dlon, cos_dlon, sin_mean, cos_mean;
+    uint64_t half_angle;
+
+    if (dlon < 0) dlon = -dlon;
+    if (dlat < 0) dlat = -dlat;
+    if (sum < 0) sum = -sum;
+
+    /* Haversine : a = sin^2(dlat/2) + cos(lat1) cos(lat2) sin^2(dlon/2)
+     *
+     * Written in terms of the mean latitude m, this is the same as
+     *
+     *   a     = sin^2(dlat/2) cos^2(dlon/2) + cos^2(m) sin^2(dlon/2)
+     *   1 - a = cos^2(dlat/2) cos^2(dlon/2) + sin^2(m) sin^2(dlon/2)
+     *
+     * Both are sums of squares, so neither loses precision when it gets
+     * small. That happens to a for short distances and to 1 - a for nearly
+     * antipodal points.
+     */
+    sin_dlat = gps_fixed_sin_half_q40(dlat);
+    cos_dlat = gps_fixed_cos_half_q40(dlat);
+    sin_dlon = gps_fixed_sin_half_q40(dlon);
+    cos_dlon = gps_fixed_cos_half_q40(dlon);
+    sin_mean = gps_fixed_sin_half_q40(sum);
+    cos_mean = gps_fixed_cos_half_q40(sum);
+
+    /* c = 2 atan2(sqrt(a), sqrt(1 - a)) */
+    half_angle = gps_fixed_atan2(
+        gps_fixed_hypot(gps_fixed_mul_q40(sin_dlat, cos_dlon), gps_fixed_mul_q40(cos_mean, sin_dlon)),
+        gps_fixed_hypot(gps_fixed_mul_q40(cos_dlat, cos_dlon), gps_fixed_mul_q40(sin_mean, sin_dlon)));
+
+    /* CORDIC may settle a hair below zero for coincident points */
+    if (half_angle >= GPS_FIXED_ANGLE_HALF_TURN) half_angle = 0;
+
+    /* d = c * circumference / 2^40, split to stay within 64 bits */
+    return (int64_t)((((half_angle >> 16) * CIRCUMFERENCE_MM) >> 23) +
+                     ((((half_angle & 0xFFFF) * CIRCUMFERENCE_MM) + (UINT64_C(1) << 38)) >> 39));
+}
+
+int32_t gps_geo_bearing_fast(int32_t lat1, int32_t lon1, int32_t lat2, int32_t lon2)
+{
+    int64_t east, north;
+
+    project(&east, &north, lat1, lon1, lat2, lon2);
+
+    return gps_fixed_angle_to_millidegrees(gps_fixed_atan2(east, north));
+}
+
+int32_t gps_geo_bearing(int32_t lat1, int32_t lon1, int32_t lat2, int32_t lon2)
+{
+    uint64_t phi1 = gps_fixed_angle(lat1);
+    uint64_t phi2 = gps_fixed_angle(lat2);
+    uint64_t dlon = gps_fixed_angle(gps_fixed_wrap_longitude((int64_t)lon2 - lon1));
+    int64_t sin_phi1 = gps_fixed_sin_q30(phi1);
+    int64_t cos_phi1 = gps_fixed_cos_q30(phi1);
+    int64_t sin_phi2 = gps_fixed_sin_q30(phi2);
+    int64_t cos_phi2 = gps_fixed_cos_q30(phi2);
+    int64_t east, north;
+
+    /* theta = atan2(sin(dlon) cos(lat2),
+     *               cos(lat1) sin(lat2) - sin(lat1) cos(lat2) cos(dlon))
+     */
+    east = (gps_fixed_sin_q30(dlon) * cos_phi2) >> 30;
+    north = ((cos_phi1 * sin_phi2) >> 30) - ((((sin_phi1 * cos_phi2) >> 30) * gps_fixed_cos_q30(dlon)) >> 30);
+
+    return gps_fixed_angle_to_millidegrees(gps_fixed_atan2(east, north));
+}
+
+int32_t gps_geo_speed(const struct gps_tpv *from, const struct gps_tpv *to)
+{
+    assert(from != NULL);
+    assert(to != NULL);
+
+    int64_t elapsed;
+    int64_t distance;
+    int64_t speed;
+
+    if ((GPS_INVALID_VALUE == from->latitude) || (GPS_INVALID_VALUE == from->longitude) ||
+        (GPS_INVALID_VALUE == to->latitude) || (GPS_INVALID_VALUE == to->longitude))
+    {
+        return GPS_INVALID_VALUE;
+    }
+
+    elapsed = gps_time_to_ms(to->time) - gps_time_to_ms(from->time);
+    if ((elapsed < 0) && !gps_time_has_date(from->time) && !gps_time_has_date(to->time))
+    {
+        elapsed += GPS_MS_PER_DAY;
+    }
+    if (elapsed <= 0) return GPS_INVALID_VALUE;
+
+    distance = gps_geo_distance(from->latitude, from->longitude, to->latitude, to->longitude);
+
+    /* A glitched position can imply any speed, which must not wrap around
+     * or read as GPS_INVALID_VALUE
+     */
+    speed = (distance * 1000 + elapsed / 2) / elapsed;
+    if (speed >= GPS_INVALID_VALUE) speed = GPS_INVALID_VALUE - 1;
+
+    return (int32_t)speed;
+}
+
+void gps_geo_distance_fast_batch(int32_t *restrict distance,
+                                 const int32_t *restrict lat1,
+                                 const int32_t *restrict lon1,
+                                 const int32_t *restrict lat2,
+                                 const int32_t *restrict lon2,
+                                 size_t n)
+{
+    /* Radians per micro-degree and millimeters per micro-degree of arc */
+    const float radians = 1.745329252e-8f;
+    const float millimeters = 111.195080f;
+    const float limit = 2147483520.0f;
+    size_t i;
+
+    /* Keep the loop body free of branches and calls, apart from the square
+     * root, so that it vectorizes.
+     */
+    for (i = 0; i < n; ++i)
+    {
+        int32_t dlon = lon2[i] - lon1[i];
+        float mid, mid2, c, east, north, d;
+
+        dlon -= ((dlon > 180000000) - (dlon < -180000000)) * 360000000;
+
+        mid = (float)lat1[i] * (0.5f * radians) + (float)lat2[i] * (0.5f * radians);
+        mid2 = mid * mid;
+        c = 1.0f - mid2 / 90.0f;
+        c = 1.0f - mid2 * c / 56.0f;
+        c = 1.0f - mid2 * c / 30.0f;
+        c = 1.0f - mid2 * c / 12.0f;
+        c = 1.0f - mid2 * c / 2.0f;
+
+        east = (float)dlon * c;
+        north = (float)(lat2[i] - lat1[i]);
+        d = sqrtf(east * east + north * north) * millimeters;
+        d = (d < limit) ? d : limit;
+        distance[i] = (int32_t)(d + 0.5f);
+    }
+}
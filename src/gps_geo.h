@@ -0,0 +1,159 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Jacob McGladdery
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/**
+ * @file gps_geo.h
+ * @brief Fixed-point distance and bearing between TPV coordinates.
+ *
+ * These functions operate directly on the latitude and longitude values
+ * stored in gps_tpv, that is degrees times GPS_LAT_LON_FACTOR. All of the
+ * scalar functions use integer arithmetic only. Trigonometry is done with
+ * fixed-point polynomials and CORDIC, so no floating point coprocessor or
+ * math library is needed.
+ *
+ * Distances assume a spherical Earth with the IUGG mean radius of
+ * 6371008.8 meters, which is also what the usual floating point haversine
+ * implementations use. Distances are reported in meters times
+ * GPS_VALUE_FACTOR and bearings in degrees from true north times
+ * GPS_VALUE_FACTOR, matching gps_tpv.track.
+ */
+
+#ifndef _GPS_GEO_H_
+#define _GPS_GEO_H_
+
+#include "gps.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Computes the distance between two points with the equirectangular
+ *        approximation.
+ *
+ * This is the cheapest distance function. The error is well below 0.1% for
+ * points less than about 100 km apart, but grows with distance and towards
+ * the poles.
+ *
+ * @param[in] lat1 Latitude of the first point.
+ * @param[in] lon1 Longitude of the first point.
+ * @param[in] lat2 Latitude of the second point.
+ * @param[in] lon2 Longitude of the second point.
+ * @return The distance in meters times GPS_VALUE_FACTOR, saturated to
+ *         INT32_MAX.
+ */
+int32_t gps_geo_distance_fast(int32_t lat1, int32_t lon1, int32_t lat2, int32_t lon2);
+
+/**
+ * @brief Computes the great circle distance between two points.
+ *
+ * Uses the haversine formula in fixed point. The result is within a few
+ * centimeters of a double precision haversine at any separation.
+ *
+ * @param[in] lat1 Latitude of the first point.
+ * @param[in] lon1 Longitude of the first point.
+ * @param[in] lat2 Latitude of the second point.
+ * @param[in] lon2 Longitude of the second point.
+ * @return The distance in meters times GPS_VALUE_FACTOR.
+ */
+int64_t gps_geo_distance(int32_t lat1, int32_t lon1, int32_t lat2, int32_t lon2);
+
+/**
+ * @brief Computes the bearing from one point to another with the
+ *        equirectangular approximation.
+ *
+ * @param[in] lat1 Latitude of the start point.
+ * @param[in] lon1 Longitude of the start point.
+ * @param[in] lat2 Latitude of the end point.
+ * @param[in] lon2 Longitude of the end point.
+ * @return The bearing in degrees from true north times GPS_VALUE_FACTOR,
+ *         in the range [0, 360000).
+ */
+int32_t gps_geo_bearing_fast(int32_t lat1, int32_t lon1, int32_t lat2, int32_t lon2);
+
+/**
+ * @brief Computes the initial great circle bearing from one point to
+ *        another.
+ *
+ * @param[in] lat1 Latitude of the start point.
+ * @param[in] lon1 Longitude of the start point.
+ * @param[in] lat2 Latitude of the end point.
+ * @param[in] lon2 Longitude of the end point.
+ * @return The bearing in degrees from true north times GPS_VALUE_FACTOR,
+ *         in the range [0, 360000).
+ */
+int32_t gps_geo_bearing(int32_t lat1, int32_t lon1, int32_t lat2, int32_t lon2);
+
+/**
+ * @brief Computes the average speed between two fixes.
+ *
+ * The distance is the great circle distance between the positions of
+ * @p from and @p to and the elapsed time comes from their time stamps. If
+ * neither time stamp carries a date, then a single midnight rollover is
+ * accounted for.
+ *
+ * @param[in] from The earlier fix.
+ * @param[in] to The later fix.
+ * @return The speed in meters per second times GPS_VALUE_FACTOR, saturated
+ *         to INT32_MAX - 1, or GPS_INVALID_VALUE if a position is invalid
+ *         or no time elapsed.
+ *
+ * @pre The pointers @p from and @p to must not be NULL.
+ */
+int32_t gps_geo_speed(const struct gps_tpv *from, const struct gps_tpv *to);
+
+/**
+ * @brief Computes equirectangular distances over arrays of coordinates.
+ *
+ * Computes the same result as gps_geo_distance_fast() for each index, up
+ * to single precision rounding. This variant is intended for backends with a
+ * floating point unit. The loop is branch free single precision math over
+ * separate arrays, so optimizing compilers (-O3) vectorize it on x86 and
+ * similar targets.
+ *
+ * @param[out] distance Receives @p n distances in meters times
+ *             GPS_VALUE_FACTOR, saturated to INT32_MAX.
+ * @param[in] lat1 Latitudes of the first points.
+ * @param[in] lon1 Longitudes of the first points.
+ * @param[in] lat2 Latitudes of the second points.
+ * @param[in] lon2 Longitudes of the second points.
+ * @param[in] n The number of elements in each array.
+ *
+ * @pre The output array must not overlap the input arrays.
+ */
+void gps_geo_distance_fast_batch(int32_t *distance,
+                                 const int32_t *lat1,
+                                 const int32_t *lon1,
+                                 const int32_t *lat2,
+                                 const int32_t *lon2,
+                                 size_t n);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _GPS_GEO_H_ */
@@ -0,0 +1,325 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Jacob McGladdery
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include "gps_geofence.h"
+
+#include <assert.h>
+#include <stddef.h>
+
+/* Crossing number test, exact in 64 bit integer arithmetic. Edges are
+ * half-open along latitude, which makes the result consistent for points
+ * on vertices and on edges shared between polygons.
+ */
+static int contains(const struct gps_geofence_polygon *polygon, int32_t latitude, int32_t longitude)
+{
+    const int32_t *lat = polygon->latitude;
+    const int32_t *lon = polygon->longitude;
+    uint32_t i, j;
+    int inside = 0;
+
+    for (i = 0, j = polygon->count - 1; i < polygon->count; j = i++)
+    {
+        if ((lat[i] > latitude) != (lat[j] > latitude))
+        {
+            /* Is the point west of the edge at this latitude?
+             * longitude < lon[i] + (latitude - lat[i]) * (lon[j] - lon[i]) / (lat[j] - lat[i])
+             */
+            int64_t lhs = ((int64_t)longitude - lon[i]) * ((int64_t)lat[j] - lat[i]);
+            int64_t rhs = ((int64_t)latitude - lat[i]) * ((int64_t)lon[j] - lon[i]);
+
+            if ((lat[j] > lat[i]) ? (lhs < rhs) : (lhs > rhs)) inside = !inside;
+        }
+    }
+
+    return inside;
+}
+
+static int in_bounds(const struct gps_geofence_polygon *polygon, int32_t latitude, int32_t longitude)
+{
+    return (latitude >= polygon->min_latitude) && (latitude <= polygon->max_latitude) &&
+           (longitude >= polygon->min_longitude) && (longitude <= polygon->max_longitude);
+}
+
+static uint32_t cell_index(const struct gps_geofence *geofence, int64_t latitude, int64_t longitude)
+{
+    uint32_t row = (uint32_t)((latitude - geofence->origin_latitude) / geofence->cell_height);
+    uint32_t column = (uint32_t)((longitude - geofence->origin_longitude) / geofence->cell_width);
+
+    if (row >= geofence->rows) row = geofence->rows - 1;
+    if (column >= geofence->columns) column = geofence->columns - 1;
+
+    return row * geofence->columns + column;
+}
+
+void gps_geofence_init(struct gps_geofence *geofence, struct gps_geofence_polygon *polygons, size_t capacity)
+{
+    assert(geofence != NULL);
+
+    geofence->polygons = polygons;
+    geofence->count = 0;
+    geofence->capacity = capacity;
+    geofence->cell_start = NULL;
+    geofence->cell_items = NULL;
+    geofence->columns = 0;
+    geofence->rows = 0;
+}
+
+int gps_geofence_add(struct gps_geofence *geofence,
+                     uint32_t id,
+                     const int32_t *latitude,
+                     const int32_t *longitude,
+                     uint32_t count)
+{
+    assert(geofence != NULL);
+    assert(latitude != NULL);
+    assert(longitude != NULL);
+
+    struct gps_geofence_polygon *polygon;
+    uint32_t i;
+
+    if (count < 3) return GPS_ERROR_UNSUPPORTED;
+    if (geofence->count == geofence->capacity) return GPS_ERROR_OVERFLOW;
+
+    polygon = &geofence->polygons[geofence->count++];
+    polygon->latitude = latitude;
+    polygon->longitude = longitude;
+    polygon->count = count;
+    polygon->id = id;
+    polygon->min_latitude = polygon->max_latitude = latitude[0];
+    polygon->min_longitude = polygon->max_longitude = longitude[0];
+    for (i = 1; i < count; ++i)
+    {
+        if (latitude[i] < polygon->min_latitude) polygon->min_latitude = latitude[i];
+        if (latitude[i] > polygon->max_latitude) polygon->max_latitude = latitude[i];
+        if (longitude[i] < polygon->min_longitude) polygon->min_longitude = longitude[i];
+        if (longitude[i] > polygon->max_longitude) polygon->max_longitude = longitude[i];
+    }
+
+    /* The index no longer covers every polygon */
+    geofence->cell_start = NULL;
+    geofence->cell_items = NULL;
+
+    return GPS_OK;
+}
+
+int gps_geofence_build(struct gps_geofence *geofence,
+                       uint32_t columns,
+                       uint32_t rows,
+                       uint32_t *cell_start,
+                       uint32_t *cell_items,
+                       size_t items_capacity)
+{
+    assert(geofence != NULL);
+    assert(columns > 0);
+    assert(rows > 0);
+    assert(cell_start != NULL);
+    assert(cell_items != NULL);
+
+    const uint32_t cells = columns * rows;
+    int64_t min_lat, max_lat, min_lon, max_lon;
+    size_t total = 0;
+    uint32_t pass, p, c;
+
+    /* The old index no longer matches the grid, so until the new one is
+     * complete, queries test every polygon
+     */
+    geofence->cell_start = NULL;
+    geofence->cell_items = NULL;
+
+    if (0 == geofence->count) return GPS_OK;
+
+    /* Grid bounds */
+    min_lat = max_lat = geofence->polygons[0].min_latitude;
+    min_lon = max_lon = geofence->polygons[0].min_longitude;
+    for (p = 0; p < geofence->count; ++p)
+    {
+        const struct gps_geofence_polygon *polygon = &geofence->polygons[p];
+
+        if (polygon->min_latitude < min_lat) min_lat = polygon->min_latitude;
+        if (polygon->max_latitude > max_lat) max_lat = polygon->max_latitude;
+        if (polygon->min_longitude < min_lon) min_lon = polygon->min_longitude;
+        if (polygon->max_longitude > max_lon) max_lon = polygon->max_longitude;
+    }
+
+    geofence->columns = columns;
+    geofence->rows = rows;
+    geofence->origin_latitude = (int32_t)min_lat;
+    geofence->origin_longitude = (int32_t)min_lon;
+    geofence->cell_height = (int32_t)((max_lat - min_lat) / rows + 1);
+    geofence->cell_width = (int32_t)((max_lon - min_lon) / columns + 1);
+
+    /* The first pass counts the polygons in each cell, the second pass fills
+     * in the lists. In between, cell_start is turned into end offsets, which
+     * the second pass then walks back to start offsets.
+     */
+    for (c = 0; c <= cells; ++c) cell_start[c] = 0;
+    for (pass = 0; pass < 2; ++pass)
+    {
+        for (p = 0; p < geofence->count; ++p)
+        {
+            const struct gps_geofence_polygon *polygon = &geofence->polygons[p];
+            uint32_t first = cell_index(geofence, polygon->min_latitude, polygon->min_longitude);
+            uint32_t last = cell_index(geofence, polygon->max_latitude, polygon->max_longitude);
+            uint32_t row, column;
+
+            for (row = first / columns; row <= last / columns; ++row)
+            {
+                for (column = first % columns; column <= last % columns; ++column)
+                {
+                    c = row * columns + column;
+                    if (0 == pass)
+                    {
+                        cell_start[c]++;
+                    }
+                    else
+                    {
+                        cell_items[--cell_start[c]] = p;
+                    }
+                }
+            }
+        }
+
+        if (0 == pass)
+        {
+            for (c = 0; c < cells; ++c)
+            {
+                total += cell_start[c];
+                cell_start[c] = (uint32_t)total;
+            }
+            cell_start[cells] = (uint32_t)total;
+            if (total > items_capacity) return GPS_ERROR_OVERFLOW;
+        }
+    }
+
+    geofence->cell_start = cell_start;
+    geofence->cell_items = cell_items;
+
+    return GPS_OK;
+}
+
+size_t gps_geofence_query(const struct gps_geofence *geofence,
+                          int32_t latitude,
+                          int32_t longitude,
+                          uint32_t *indices,
+                          size_t max)
+{
+    assert(geofence != NULL);
+    assert(indices != NULL);
+
+    size_t found = 0;
+    uint32_t begin, end, i;
+
+    if (!geofence->cell_start)
+    {
+        /* No index, test every polygon */
+        for (i = 0; (i < geofence->count) && (found < max); ++i)
+        {
+            const struct gps_geofence_polygon *polygon = &geofence->polygons[i];
+
+            if (in_bounds(polygon, latitude, longitude) && contains(polygon, latitude, longitude))
+            {
+                indices[found++] = i;
+            }
+        }
+        return found;
+    }
+
+    if ((latitude < geofence->origin_latitude) || (longitude < geofence->origin_longitude)) return 0;
+    if ((int64_t)latitude - geofence->origin_latitude >= (int64_t)geofence->cell_height * geofence->rows) return 0;
+    if ((int64_t)longitude - geofence->origin_longitude >= (int64_t)geofence->cell_width * geofence->columns) return 0;
+
+    /* Cell lists hold polygon indices in descending order, see
+     * gps_geofence_build(), so walk them backwards.
+     */
+    begin = geofence->cell_start[cell_index(geofence, latitude, longitude)];
+    end = geofence->cell_start[cell_index(geofence, latitude, longitude) + 1];
+    for (i = end; (i > begin) && (found < max); --i)
+    {
+        uint32_t index = geofence->cell_items[i - 1];
+        const struct gps_geofence_polygon *polygon = &geofence->polygons[index];
+
+        if (in_bounds(polygon, latitude, longitude) && contains(polygon, latitude, longitude))
+        {
+            indices[found++] = index;
+        }
+    }
+
+    return found;
+}
+
+void gps_geofence_object_init(struct gps_geofence_object *object)
+{
+    assert(object != NULL);
+
+    object->count = 0;
+}
+
+size_t gps_geofence_update(const struct gps_geofence *geofence,
+                           struct gps_geofence_object *object,
+                           const struct gps_tpv *tpv,
+                           gps_geofence_event_function event,
+                           void *context)
+{
+    assert(geofence != NULL);
+    assert(object != NULL);
+    assert(tpv != NULL);
+    assert(event != NULL);
+
+    uint32_t inside[GPS_GEOFENCE_MAX_INSIDE];
+    size_t count;
+    size_t events = 0;
+    size_t i, j;
+
+    if ((GPS_INVALID_VALUE == tpv->latitude) || (GPS_INVALID_VALUE == tpv->longitude)) return 0;
+
+    count = gps_geofence_query(geofence, tpv->latitude, tpv->longitude, inside, GPS_GEOFENCE_MAX_INSIDE);
+
+    /* Both sets are sorted by polygon index, so a single merge finds the
+     * differences.
+     */
+    for (i = 0, j = 0; i < object->count; ++i)
+    {
+        while ((j < count) && (inside[j] < object->inside[i])) ++j;
+        if ((j == count) || (inside[j] != object->inside[i]))
+        {
+            event(context, geofence->polygons[object->inside[i]].id, GPS_GEOFENCE_EXIT);
+            ++events;
+        }
+    }
+
+    for (i = 0, j = 0; i < count; ++i)
+    {
+        while ((j < object->count) && (object->inside[j] < inside[i])) ++j;
+        if ((j == object->count) || (object->inside[j] != inside[i]))
+        {
+            event(context, geofence->polygons[inside[i]].id, GPS_GEOFENCE_ENTER);
+            ++events;
+        }
+    }
+
+    for (i = 0; i < count; ++i) object->inside[i] = inside[i];
+    object->count = (uint32_t)count;
+
+    return events;
+}
@@ -0,0 +1,228 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Jacob McGladdery
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/**
+ * @file gps_geofence.h
+ * @brief Polygon geofences over TPV positions.
+ *
+ * Polygons are given as vertex arrays of latitude and longitude values in the
+ * same fixed-point units as gps_tpv. A uniform grid over the bounding box of
+ * all polygons narrows each query down to the polygons whose bounding boxes
+ * overlap the cell the point falls in, and those candidates are then tested
+ * with an exact integer point-in-polygon test. Points exactly on an edge are
+ * resolved consistently, so a point on the boundary shared by two adjacent
+ * polygons belongs to exactly one of them.
+ *
+ * The caller owns all storage. Polygon vertices are referenced rather than
+ * copied, so they must outlive the geofence. Each tracked object keeps the set
+ * of polygons it is currently inside in a gps_geofence_object, which lets
+ * gps_geofence_update() report only enter and exit transitions.
+ *
+ * Polygons which cross the antimeridian are not supported. Split them into
+ * one polygon on each side instead.
+ */
+
+#ifndef _GPS_GEOFENCE_H_
+#define _GPS_GEOFENCE_H_
+
+#include "gps.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define GPS_GEOFENCE_MAX_INSIDE (8) /**< The most polygons one object is tracked inside of at once */
+
+/* Transition events */
+#define GPS_GEOFENCE_ENTER (0) /**< The object moved into a polygon */
+#define GPS_GEOFENCE_EXIT  (1) /**< The object moved out of a polygon */
+
+/**
+ * @brief Function called for each geofence transition.
+ *
+ * @param[in] context The user pointer given to gps_geofence_update().
+ * @param[in] id The ID of the polygon which was entered or exited.
+ * @param[in] event Either GPS_GEOFENCE_ENTER or GPS_GEOFENCE_EXIT.
+ */
+typedef void (*gps_geofence_event_function)(void *context, uint32_t id, int event);
+
+/**
+ * @brief One polygon registered with a geofence.
+ */
+struct gps_geofence_polygon
+{
+    const int32_t *latitude;  /**< Vertex latitudes */
+    const int32_t *longitude; /**< Vertex longitudes */
+    uint32_t count;           /**< Number of vertices */
+    uint32_t id;              /**< User supplied polygon ID */
+    int32_t min_latitude;     /**< Bounding box */
+    int32_t max_latitude;     /**< Bounding box */
+    int32_t min_longitude;    /**< Bounding box */
+    int32_t max_longitude;    /**< Bounding box */
+};
+
+/**
+ * @brief A set of polygons and the grid index over them.
+ */
+struct gps_geofence
+{
+    struct gps_geofence_polygon *polygons; /**< Polygon storage */
+    size_t count;                          /**< Number of polygons added */
+    size_t capacity;                       /**< Size of gps_geofence.polygons */
+    uint32_t *cell_start;                  /**< Offset of each cell's list in gps_geofence.cell_items */
+    uint32_t *cell_items;                  /**< Polygon indices, grouped by cell */
+    uint32_t columns;                      /**< Grid columns, along longitude */
+    uint32_t rows;                         /**< Grid rows, along latitude */
+    int32_t origin_latitude;               /**< South edge of the grid */
+    int32_t origin_longitude;              /**< West edge of the grid */
+    int32_t cell_height;                   /**< Cell size along latitude */
+    int32_t cell_width;                    /**< Cell size along longitude */
+};
+
+/**
+ * @brief The polygons a tracked object is currently inside.
+ */
+struct gps_geofence_object
+{
+    uint32_t inside[GPS_GEOFENCE_MAX_INSIDE]; /**< Indices of the polygons */
+    uint32_t count;                           /**< Number of valid entries in gps_geofence_object.inside */
+};
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Initializes an empty geofence.
+ *
+ * @param[out] geofence The geofence to initialize.
+ * @param[in] polygons Storage for the polygon descriptors.
+ * @param[in] capacity The number of elements in @p polygons.
+ *
+ * @pre The pointer @p geofence must not be NULL.
+ */
+void gps_geofence_init(struct gps_geofence *geofence, struct gps_geofence_polygon *polygons, size_t capacity);
+
+/**
+ * @brief Adds a polygon to the geofence.
+ *
+ * The polygon is closed implicitly, so the last vertex should not repeat the
+ * first. It may be convex or concave but must not intersect itself. Adding
+ * a polygon invalidates the index until gps_geofence_build() is called
+ * again.
+ *
+ * @param[in,out] geofence The geofence.
+ * @param[in] id An ID reported back in transition events.
+ * @param[in] latitude The vertex latitudes.
+ * @param[in] longitude The vertex longitudes.
+ * @param[in] count The number of vertices, at least 3.
+ * @return A result code.
+ * @retval GPS_OK The polygon was added.
+ * @retval GPS_ERROR_OVERFLOW The polygon storage is full.
+ * @retval GPS_ERROR_UNSUPPORTED The polygon has fewer than 3 vertices.
+ */
+int gps_geofence_add(struct gps_geofence *geofence,
+                     uint32_t id,
+                     const int32_t *latitude,
+                     const int32_t *longitude,
+                     uint32_t count);
+
+/**
+ * @brief Builds the grid index over all polygons added so far.
+ *
+ * The grid spans the bounding box of all polygons. Each polygon is listed in
+ * every cell which its bounding box overlaps, so @p items_capacity should be
+ * comfortably larger than the number of polygons when polygons are large
+ * compared to the cells. A good starting point is one cell per polygon.
+ *
+ * @param[in,out] geofence The geofence.
+ * @param[in] columns The number of grid columns.
+ * @param[in] rows The number of grid rows.
+ * @param[in] cell_start Storage for @p columns * @p rows + 1 offsets.
+ * @param[in] cell_items Storage for the per cell polygon lists.
+ * @param[in] items_capacity The number of elements in @p cell_items.
+ * @return A result code.
+ * @retval GPS_OK The index was built.
+ * @retval GPS_ERROR_OVERFLOW @p cell_items is too small. The geofence is
+ *         left without an index, so queries test every polygon until a
+ *         build succeeds.
+ *
+ * @pre Both @p columns and @p rows must be greater than zero.
+ */
+int gps_geofence_build(struct gps_geofence *geofence,
+                       uint32_t columns,
+                       uint32_t rows,
+                       uint32_t *cell_start,
+                       uint32_t *cell_items,
+                       size_t items_capacity);
+
+/**
+ * @brief Finds the polygons which contain a point.
+ *
+ * @param[in] geofence The geofence.
+ * @param[in] latitude The latitude of the point.
+ * @param[in] longitude The longitude of the point.
+ * @param[out] indices Receives the indices of the containing polygons, in
+ *             the order in which they were added.
+ * @param[in] max The number of elements in @p indices.
+ * @return The number of indices written.
+ */
+size_t gps_geofence_query(const struct gps_geofence *geofence,
+                          int32_t latitude,
+                          int32_t longitude,
+                          uint32_t *indices,
+                          size_t max);
+
+/**
+ * @brief Initializes the state of a tracked object.
+ *
+ * @param[out] object The object to initialize. It starts outside of all
+ *             polygons.
+ */
+void gps_geofence_object_init(struct gps_geofence_object *object);
+
+/**
+ * @brief Updates a tracked object with a new fix and reports transitions.
+ *
+ * Calls @p event once for every polygon the object left and then once for
+ * every polygon it entered since the previous update. Fixes without a valid
+ * position leave the object unchanged.
+ *
+ * @param[in] geofence The geofence.
+ * @param[in,out] object The state of the tracked object.
+ * @param[in] tpv The new fix.
+ * @param[in] event The function which receives transitions.
+ * @param[in] context A user pointer handed to @p event.
+ * @return The number of transitions reported.
+ */
+size_t gps_geofence_update(const struct gps_geofence *geofence,
+                           struct gps_geofence_object *object,
+                           const struct gps_tpv *tpv,
+                           gps_geofence_event_function event,
+                           void *context);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _GPS_GEOFENCE_H_ */
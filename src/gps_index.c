@@ -0,0 +1,532 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Jacob McGladdery
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include "gps_index.h"
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define INDEX_VERSION (1)
+
+/* Smallest tile and bucket sizes, which keep cell and bucket numbers
+ * within 32 bits
+ */
+#define TILE_SIZE_MIN   (5000)
+#define BUCKET_SIZE_MIN (1000)
+
+#define MICRODEGREES_LATITUDE  (180000000)
+#define MICRODEGREES_LONGITUDE (360000000)
+
+/* Serialized output is staged in whole keys and postings */
+#define STAGING_SIZE (GPS_INDEX_KEY_SIZE * 32)
+
+struct output
+{
+    gps_archive_write_function write;
+    void *context;
+    uint8_t buffer[STAGING_SIZE];
+    size_t size;
+};
+
+static void put_u32(uint8_t *p, uint32_t v)
+{
+    p[0] = (uint8_t)(v);
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+static void put_u64(uint8_t *p, uint64_t v)
+{
+    put_u32(p, (uint32_t)v);
+    put_u32(p + 4, (uint32_t)(v >> 32));
+}
+
+static uint32_t get_u32(const uint8_t *p)
+{
+    return (uint32_t)p[0]
+         | ((uint32_t)p[1] << 8)
+         | ((uint32_t)p[2] << 16)
+         | ((uint32_t)p[3] << 24);
+}
+
+static uint64_t get_u64(const uint8_t *p)
+{
+    return (uint64_t)get_u32(p) | ((uint64_t)get_u32(p + 4) << 32);
+}
+
+static uint32_t tile_count(uint32_t span, uint32_t tile_size)
+{
+    return (span + tile_size - 1) / tile_size;
+}
+
+static uint32_t tile(int32_t value, uint32_t span, uint32_t tile_size)
+{
+    int64_t shifted = (int64_t)value + span / 2;
+    uint32_t count = tile_count(span, tile_size);
+    int64_t n;
+
+    if (shifted < 0) shifted = 0;
+    n = shifted / tile_size;
+    if (n >= count) n = count - 1;
+
+    return (uint32_t)n;
+}
+
+static uint32_t bucket(int64_t time, uint32_t bucket_size)
+{
+    int64_t n;
+
+    if (time < 0) return 0;
+    n = time / bucket_size;
+    if (n > UINT32_MAX) return UINT32_MAX;
+
+    return (uint32_t)n;
+}
+
+static int compare_postings(const struct gps_index_posting *a, const struct gps_index_posting *b)
+{
+    if (a->archive != b->archive) return (a->archive < b->archive) ? -1 : 1;
+    if (a->offset != b->offset) return (a->offset < b->offset) ? -1 : 1;
+    return 0;
+}
+
+static int compare_posting_items(const void *a, const void *b)
+{
+    return compare_postings(a, b);
+}
+
+static int compare_entries(const void *a, const void *b)
+{
+    const struct gps_index_entry *x = a;
+    const struct gps_index_entry *y = b;
+
+    if (x->cell != y->cell) return (x->cell < y->cell) ? -1 : 1;
+    if (x->bucket != y->bucket) return (x->bucket < y->bucket) ? -1 : 1;
+    return compare_postings(&x->posting, &y->posting);
+}
+
+static int same_key(const struct gps_index_entry *a, const struct gps_index_entry *b)
+{
+    return (a->cell == b->cell) && (a->bucket == b->bucket);
+}
+
+static int flush(struct output *out)
+{
+    if (out->size > 0)
+    {
+        if (out->write(out->context, out->buffer, out->size) != 0) return GPS_ERROR_IO;
+        out->size = 0;
+    }
+
+    return GPS_OK;
+}
+
+/* Reserves room for size bytes in the staging buffer */
+static uint8_t *reserve(struct output *out, size_t size)
+{
+    uint8_t *p;
+
+    if ((out->size + size > sizeof(out->buffer)) && (flush(out) != GPS_OK)) return NULL;
+
+    p = out->buffer + out->size;
+    out->size += size;
+
+    return p;
+}
+
+int gps_index_builder_init(struct gps_index_builder *builder,
+                           uint32_t tile_size,
+                           uint32_t bucket_size,
+                           struct gps_index_entry *entries,
+                           size_t capacity)
+{
+    assert(builder != NULL);
+    assert((entries != NULL) || (0 == capacity));
+
+    if ((tile_size < TILE_SIZE_MIN) || (bucket_size < BUCKET_SIZE_MIN)) return GPS_ERROR_UNSUPPORTED;
+
+    builder->tile_size = tile_size;
+    builder->bucket_size = bucket_size;
+    builder->columns = tile_count(MICRODEGREES_LONGITUDE, tile_size);
+    builder->entries = entries;
+    builder->capacity = capacity;
+    builder->count = 0;
+
+    return GPS_OK;
+}
+
+int gps_index_builder_add(struct gps_index_builder *builder,
+                          uint32_t archive,
+                          const uint8_t *data,
+                          size_t size)
+{
+    assert(builder != NULL);
+    assert(data != NULL);
+
+    struct gps_archive_reader reader;
+    struct gps_archive_block block;
+    struct gps_tpv tpv;
+    int result;
+
+    result = gps_archive_reader_init(&reader, data, size);
+    if (result != GPS_OK) return result;
+
+    while (GPS_OK == (result = gps_archive_next_block(&reader, &block)))
+    {
+        /* Entries of the current block, which are checked for duplicates.
+         * A block covers a short stretch of track, so there are few.
+         */
+        size_t first = builder->count;
+
+        while (GPS_OK == (result = gps_archive_read(&reader, &tpv)))
+        {
+            struct gps_index_entry entry;
+            size_t i;
+
+            if ((GPS_INVALID_VALUE == tpv.latitude) || (GPS_INVALID_VALUE == tpv.longitude)) continue;
+
+            entry.cell = tile(tpv.latitude, MICRODEGREES_LATITUDE, builder->tile_size) * builder->columns +
+                         tile(tpv.longitude, MICRODEGREES_LONGITUDE, builder->tile_size);
+            entry.bucket = bucket(gps_time_to_ms(tpv.time), builder->bucket_size);
+            entry.posting.archive = archive;
+            entry.posting.offset = block.offset;
+
+            /* Walk backwards, the last key is the most likely match */
+            for (i = builder->count; i > first; --i)
+            {
+                if (same_key(&builder->entries[i - 1], &entry)) break;
+            }
+            if (i > first) continue;
+
+            if (builder->count == builder->capacity) return GPS_ERROR_OVERFLOW;
+            builder->entries[builder->count++] = entry;
+        }
+
+        if (result != GPS_ERROR_END) return result;
+    }
+
+    return (GPS_ERROR_END == result) ? GPS_OK : result;
+}
+
+int gps_index_builder_write(struct gps_index_builder *builder,
+                            gps_archive_write_function write,
+                            void *context)
+{
+    assert(builder != NULL);
+    assert(write != NULL);
+
+    struct gps_index_entry *entries = builder->entries;
+    struct output out;
+    uint32_t keys = 0;
+    uint32_t postings = 0;
+    size_t count = 0;
+    size_t i;
+    uint8_t *p;
+
+    /* Sort and drop duplicate entries, which appear when an archive has
+     * been added twice.
+     */
+    if (builder->count > 0)
+    {
+        qsort(entries, builder->count, sizeof(entries[0]), compare_entries);
+        count = 1;
+        for (i = 1; i < builder->count; ++i)
+        {
+            if (compare_entries(&entries[count - 1], &entries[i]) != 0) entries[count++] = entries[i];
+        }
+        builder->count = count;
+    }
+
+    for (i = 0; i < count; ++i)
+    {
+        if ((0 == i) || !same_key(&entries[i - 1], &entries[i])) ++keys;
+    }
+    postings = (uint32_t)count;
+
+    out.write = write;
+    out.context = context;
+    out.size = 0;
+
+    if (NULL == (p = reserve(&out, GPS_INDEX_HEADER_SIZE))) return GPS_ERROR_IO;
+    memcpy(p, "GPSI", 4);
+    p[4] = INDEX_VERSION;
+    p[5] = p[6] = p[7] = 0;
+    put_u32(p + 8, builder->tile_size);
+    put_u32(p + 12, builder->bucket_size);
+    put_u32(p + 16, keys);
+    put_u32(p + 20, postings);
+
+    for (i = 0; i < count; ++i)
+    {
+        if ((i > 0) && same_key(&entries[i - 1], &entries[i])) continue;
+
+        if (NULL == (p = reserve(&out, GPS_INDEX_KEY_SIZE))) return GPS_ERROR_IO;
+        put_u32(p, entries[i].cell);
+        put_u32(p + 4, entries[i].bucket);
+        put_u32(p + 8, (uint32_t)i);
+    }
+
+    if (NULL == (p = reserve(&out, 4))) return GPS_ERROR_IO;
+    put_u32(p, postings);
+
+    for (i = 0; i < count; ++i)
+    {
+        if (NULL == (p = reserve(&out, GPS_INDEX_POSTING_SIZE))) return GPS_ERROR_IO;
+        put_u32(p, entries[i].posting.archive);
+        put_u64(p + 4, entries[i].posting.offset);
+    }
+
+    return flush(&out);
+}
+
+/* Index of the first posting of key k. The posting count follows the last
+ * key, so this also works for k == key_count.
+ */
+static uint32_t first_posting(const struct gps_index *index, uint32_t k)
+{
+    const uint8_t *key = index->keys + (size_t)k * GPS_INDEX_KEY_SIZE;
+
+    return get_u32((k < index->key_count) ? (key + 8) : key);
+}
+
+int gps_index_init(struct gps_index *index, const uint8_t *data, size_t size)
+{
+    assert(index != NULL);
+    assert((data != NULL) || (0 == size));
+
+    uint32_t previous = 0;
+    uint32_t i;
+
+    if ((size < GPS_INDEX_HEADER_SIZE) || (memcmp(data, "GPSI", 4) != 0) || (data[4] != INDEX_VERSION))
+    {
+        return GPS_ERROR_CORRUPT;
+    }
+
+    index->tile_size = get_u32(data + 8);
+    index->bucket_size = get_u32(data + 12);
+    index->key_count = get_u32(data + 16);
+    index->posting_count = get_u32(data + 20);
+    index->keys = data + GPS_INDEX_HEADER_SIZE;
+    index->postings = index->keys + (size_t)index->key_count * GPS_INDEX_KEY_SIZE + 4;
+
+    if ((index->tile_size < TILE_SIZE_MIN) || (index->bucket_size < BUCKET_SIZE_MIN)) return GPS_ERROR_CORRUPT;
+    if ((uint64_t)size != GPS_INDEX_HEADER_SIZE + (uint64_t)index->key_count * GPS_INDEX_KEY_SIZE + 4 +
+                          (uint64_t)index->posting_count * GPS_INDEX_POSTING_SIZE)
+    {
+        return GPS_ERROR_CORRUPT;
+    }
+
+    /* Queries trust the posting ranges, so check them once up front */
+    for (i = 0; i <= index->key_count; ++i)
+    {
+        uint32_t first = first_posting(index, i);
+
+        if ((first < previous) || (first > index->posting_count)) return GPS_ERROR_CORRUPT;
+        previous = first;
+    }
+    if (previous != index->posting_count) return GPS_ERROR_CORRUPT;
+
+    index->columns = tile_count(MICRODEGREES_LONGITUDE, index->tile_size);
+    index->rows = tile_count(MICRODEGREES_LATITUDE, index->tile_size);
+
+    return GPS_OK;
+}
+
+/* Index of the first key not less than (cell, bucket) */
+static uint32_t lower_bound(const struct gps_index *index, uint64_t cell, uint32_t bucket)
+{
+    uint32_t low = 0;
+    uint32_t high = index->key_count;
+
+    while (low < high)
+    {
+        uint32_t middle = low + (high - low) / 2;
+        const uint8_t *key = index->keys + (size_t)middle * GPS_INDEX_KEY_SIZE;
+        uint32_t key_cell = get_u32(key);
+
+        if ((key_cell < cell) || ((key_cell == cell) && (get_u32(key + 4) < bucket)))
+        {
+            low = middle + 1;
+        }
+        else
+        {
+            high = middle;
+        }
+    }
+
+    return low;
+}
+
+/* Sorts the postings and drops duplicates, returning the new count */
+static size_t unique_postings(struct gps_index_posting *postings, size_t count)
+{
+    size_t unique = 0;
+    size_t i;
+
+    if (0 == count) return 0;
+
+    qsort(postings, count, sizeof(postings[0]), compare_posting_items);
+    for (i = 1, unique = 1; i < count; ++i)
+    {
+        if (compare_postings(&postings[unique - 1], &postings[i]) != 0) postings[unique++] = postings[i];
+    }
+
+    return unique;
+}
+
+int gps_index_query(const struct gps_index *index,
+                    const struct gps_index_query *query,
+                    struct gps_index_posting *postings,
+                    size_t capacity,
+                    size_t *count)
+{
+    assert(index != NULL);
+    assert(query != NULL);
+    assert((postings != NULL) || (0 == capacity));
+    assert(count != NULL);
+    assert(query->latitude_min <= query->latitude_max);
+    assert(query->longitude_min <= query->longitude_max);
+
+    uint32_t row_min = tile(query->latitude_min, MICRODEGREES_LATITUDE, index->tile_size);
+    uint32_t row_max = tile(query->latitude_max, MICRODEGREES_LATITUDE, index->tile_size);
+    uint32_t column_min = tile(query->longitude_min, MICRODEGREES_LONGITUDE, index->tile_size);
+    uint32_t column_max = tile(query->longitude_max, MICRODEGREES_LONGITUDE, index->tile_size);
+    uint32_t bucket_min = bucket(query->time_min, index->bucket_size);
+    uint32_t bucket_max = bucket(query->time_max, index->bucket_size);
+    size_t found = 0;
+    uint32_t row;
+
+    *count = 0;
+    if ((query->time_max < query->time_min) || (query->time_max < 0)) return GPS_OK;
+
+    for (row = row_min; row <= row_max; ++row)
+    {
+        uint64_t last = (uint64_t)row * index->columns + column_max;
+        uint32_t k = lower_bound(index, (uint64_t)row * index->columns + column_min, bucket_min);
+
+        /* Visit each cell of the row that has keys, skipping straight to
+         * the time range within it
+         */
+        while (k < index->key_count)
+        {
+            const uint8_t *key = index->keys + (size_t)k * GPS_INDEX_KEY_SIZE;
+            uint32_t cell = get_u32(key);
+            uint32_t key_bucket = get_u32(key + 4);
+            uint32_t first, end;
+
+            if (cell > last) break;
+            if (key_bucket < bucket_min)
+            {
+                k = lower_bound(index, cell, bucket_min);
+                continue;
+            }
+            if (key_bucket > bucket_max)
+            {
+                k = lower_bound(index, (uint64_t)cell + 1, bucket_min);
+                continue;
+            }
+
+            first = first_posting(index, k);
+            end = first_posting(index, k + 1);
+            for (; first < end; ++first)
+            {
+                const uint8_t *p = index->postings + (size_t)first * GPS_INDEX_POSTING_SIZE;
+
+                /* Neighboring tiles and buckets share most of their blocks,
+                 * so compact before giving up
+                 */
+                if (found == capacity)
+                {
+                    found = unique_postings(postings, found);
+                    if (found == capacity) return GPS_ERROR_OVERFLOW;
+                }
+
+                postings[found].archive = get_u32(p);
+                postings[found].offset = get_u64(p + 4);
+                ++found;
+            }
+
+            ++k;
+        }
+    }
+
+    *count = unique_postings(postings, found);
+
+    return GPS_OK;
+}
+
+int gps_index_match(const struct gps_index_query *query, const struct gps_tpv *tpv)
+{
+    assert(query != NULL);
+    assert(tpv != NULL);
+
+    int64_t time;
+
+    if ((GPS_INVALID_VALUE == tpv->latitude) || (GPS_INVALID_VALUE == tpv->longitude)) return 0;
+    if ((tpv->latitude < query->latitude_min) || (tpv->latitude > query->latitude_max)) return 0;
+    if ((tpv->longitude < query->longitude_min) || (tpv->longitude > query->longitude_max)) return 0;
+
+    time = gps_time_to_ms(tpv->time);
+
+    return (time >= query->time_min) && (time <= query->time_max);
+}
+
+int gps_index_scan(struct gps_archive_reader *reader,
+                   uint32_t archive,
+                   const struct gps_index_query *query,
+                   const struct gps_index_posting *postings,
+                   size_t count,
+                   gps_index_match_function match,
+                   void *context)
+{
+    assert(reader != NULL);
+    assert(query != NULL);
+    assert((postings != NULL) || (0 == count));
+    assert(match != NULL);
+
+    struct gps_archive_block block;
+    struct gps_tpv tpv;
+    size_t i;
+    int result;
+
+    for (i = 0; i < count; ++i)
+    {
+        if (postings[i].archive != archive) continue;
+        if (postings[i].offset > SIZE_MAX) return GPS_ERROR_CORRUPT;
+
+        if ((result = gps_archive_seek(reader, (size_t)postings[i].offset)) != GPS_OK) return result;
+        if ((result = gps_archive_next_block(reader, &block)) != GPS_OK) return GPS_ERROR_CORRUPT;
+
+        while (GPS_OK == (result = gps_archive_read(reader, &tpv)))
+        {
+            if (gps_index_match(query, &tpv)) match(context, &tpv);
+        }
+        if (result != GPS_ERROR_END) return result;
+    }
+
+    return GPS_OK;
+}
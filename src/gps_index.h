@@ -0,0 +1,276 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Jacob McGladdery
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/**
+ * @file gps_index.h
+ * @brief Spatial and temporal index over TPV archives.
+ *
+ * The index maps tiles of latitude and longitude and buckets of time onto
+ * posting lists of the archive blocks holding records inside them. Queries
+ * for a bounding box and a time range look up the matching tiles and
+ * buckets and return the blocks to decode, so only a small part of a large
+ * set of archives is ever read.
+ *
+ * Indexes are built from one or more archives with gps_index_builder and
+ * serialized with a caller supplied write function, the same way as the
+ * archives themselves. Queries run directly on the serialized index held in
+ * memory. No function in this module allocates memory.
+ *
+ * The serialized index holds a header, the sorted keys, and the postings,
+ * all little endian:
+ *
+ *   "GPSI", version, 3 reserved bytes, tile size, bucket size, key count,
+ *   posting count (u32 each)
+ *   per key: cell, bucket, first posting (u32 each), then the posting count
+ *   per posting: archive (u32), block offset (u64)
+ */
+
+#ifndef _GPS_INDEX_H_
+#define _GPS_INDEX_H_
+
+#include "gps.h"
+#include "gps_archive.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define GPS_INDEX_HEADER_SIZE  (24) /**< The size of the index header */
+#define GPS_INDEX_KEY_SIZE     (12) /**< The size of each serialized key */
+#define GPS_INDEX_POSTING_SIZE (12) /**< The size of each serialized posting */
+
+/**
+ * @brief Reference to one archive block.
+ */
+struct gps_index_posting
+{
+    uint32_t archive; /**< Archive identifier given to gps_index_builder_add() */
+    uint64_t offset;  /**< Offset of the block, see gps_archive_seek() */
+};
+
+/**
+ * @brief One tile, bucket and block triple seen by the builder.
+ */
+struct gps_index_entry
+{
+    uint32_t cell;                    /**< Tile number, rows of longitude tiles from the south */
+    uint32_t bucket;                  /**< Time bucket number */
+    struct gps_index_posting posting; /**< Block holding records in the tile and bucket */
+};
+
+/**
+ * @brief Index builder.
+ */
+struct gps_index_builder
+{
+    uint32_t tile_size;              /**< Tile size in degrees times GPS_LAT_LON_FACTOR */
+    uint32_t bucket_size;            /**< Bucket size in milliseconds */
+    uint32_t columns;                /**< Number of tiles around a parallel */
+    struct gps_index_entry *entries; /**< Entry storage */
+    size_t capacity;                 /**< Size of gps_index_builder.entries */
+    size_t count;                    /**< Entries used */
+};
+
+/**
+ * @brief Serialized index opened for queries.
+ */
+struct gps_index
+{
+    uint32_t tile_size;      /**< Tile size in degrees times GPS_LAT_LON_FACTOR */
+    uint32_t bucket_size;    /**< Bucket size in milliseconds */
+    uint32_t columns;        /**< Number of tiles around a parallel */
+    uint32_t rows;           /**< Number of tiles from pole to pole */
+    uint32_t key_count;      /**< Number of keys */
+    uint32_t posting_count;  /**< Number of postings */
+    const uint8_t *keys;     /**< Start of the serialized keys */
+    const uint8_t *postings; /**< Start of the serialized postings */
+};
+
+/**
+ * @brief Bounding box and time range to search for.
+ *
+ * All bounds are inclusive. Times are in milliseconds, see gps_time_to_ms().
+ */
+struct gps_index_query
+{
+    int32_t latitude_min;  /**< Southern edge */
+    int32_t latitude_max;  /**< Northern edge */
+    int32_t longitude_min; /**< Western edge */
+    int32_t longitude_max; /**< Eastern edge */
+    int64_t time_min;      /**< Start of the time range */
+    int64_t time_max;      /**< End of the time range */
+};
+
+/**
+ * @brief Function receiving the records found by gps_index_scan().
+ *
+ * @param[in] context The user pointer given to gps_index_scan().
+ * @param[in] tpv The matching record.
+ */
+typedef void (*gps_index_match_function)(void *context, const struct gps_tpv *tpv);
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Initializes an index builder.
+ *
+ * Smaller tiles and buckets make queries read fewer blocks, at the cost of
+ * more entries and a larger index.
+ *
+ * @param[out] builder The builder to initialize.
+ * @param[in] tile_size The tile size in degrees times GPS_LAT_LON_FACTOR.
+ * @param[in] bucket_size The bucket size in milliseconds.
+ * @param[in] entries Storage for the entries collected while building.
+ * @param[in] capacity The number of elements in @p entries.
+ * @return A result code.
+ * @retval GPS_OK The builder is ready.
+ * @retval GPS_ERROR_UNSUPPORTED The tile size is below 0.005 degrees, or the
+ *         bucket size is below one second.
+ *
+ * @pre The pointer @p builder must not be NULL.
+ */
+int gps_index_builder_init(struct gps_index_builder *builder,
+                           uint32_t tile_size,
+                           uint32_t bucket_size,
+                           struct gps_index_entry *entries,
+                           size_t capacity);
+
+/**
+ * @brief Adds the records of an archive to the index.
+ *
+ * Records without a valid position are not indexed.
+ *
+ * @param[in,out] builder The index builder.
+ * @param[in] archive An identifier for the archive, reported back in
+ *            gps_index_posting.archive.
+ * @param[in] data The archive contents.
+ * @param[in] size The size of @p data in bytes.
+ * @return A result code.
+ * @retval GPS_OK The archive was added.
+ * @retval GPS_ERROR_OVERFLOW The entry storage is full.
+ * @retval GPS_ERROR_CORRUPT The archive is malformed.
+ */
+int gps_index_builder_add(struct gps_index_builder *builder,
+                          uint32_t archive,
+                          const uint8_t *data,
+                          size_t size);
+
+/**
+ * @brief Writes out the index.
+ *
+ * Sorts the collected entries in place, so the builder may keep adding
+ * archives and write an updated index afterwards.
+ *
+ * @param[in,out] builder The index builder.
+ * @param[in] write The function which receives the serialized index.
+ * @param[in] context A user pointer handed to @p write.
+ * @return A result code.
+ * @retval GPS_OK The index was written.
+ * @retval GPS_ERROR_IO The write function failed.
+ */
+int gps_index_builder_write(struct gps_index_builder *builder,
+                            gps_archive_write_function write,
+                            void *context);
+
+/**
+ * @brief Opens a serialized index for queries.
+ *
+ * @param[out] index The index to initialize.
+ * @param[in] data The serialized index. It must remain valid while the index
+ *            is in use.
+ * @param[in] size The size of @p data in bytes.
+ * @return A result code.
+ * @retval GPS_OK The index is ready.
+ * @retval GPS_ERROR_CORRUPT The index is malformed.
+ */
+int gps_index_init(struct gps_index *index, const uint8_t *data, size_t size);
+
+/**
+ * @brief Finds the archive blocks which may hold records matching a query.
+ *
+ * The blocks are reported once each, sorted by archive and offset. They
+ * hold every matching record, but may also hold records outside of the
+ * query that shared a tile or bucket with it.
+ *
+ * @param[in] index The index.
+ * @param[in] query The bounding box and time range.
+ * @param[out] postings Receives the blocks.
+ * @param[in] capacity The number of elements in @p postings.
+ * @param[out] count Receives the number of blocks found.
+ * @return A result code.
+ * @retval GPS_OK All matching blocks were reported.
+ * @retval GPS_ERROR_OVERFLOW More than @p capacity blocks match.
+ *
+ * @pre The query bounds must not be reversed. Boxes crossing the
+ *      antimeridian are searched as two queries.
+ */
+int gps_index_query(const struct gps_index *index,
+                    const struct gps_index_query *query,
+                    struct gps_index_posting *postings,
+                    size_t capacity,
+                    size_t *count);
+
+/**
+ * @brief Checks a record against a query.
+ *
+ * @param[in] query The bounding box and time range.
+ * @param[in] tpv The record.
+ * @return Non-zero if the record has a valid position inside the box and a
+ *         time inside the range.
+ */
+int gps_index_match(const struct gps_index_query *query, const struct gps_tpv *tpv);
+
+/**
+ * @brief Decodes the blocks of one archive found by gps_index_query() and
+ *        reports the matching records.
+ *
+ * Postings of other archives are skipped, so the same list may be passed for
+ * each archive in turn.
+ *
+ * @param[in,out] reader A reader over the archive.
+ * @param[in] archive The identifier of the archive.
+ * @param[in] query The bounding box and time range.
+ * @param[in] postings The blocks to decode.
+ * @param[in] count The number of elements in @p postings.
+ * @param[in] match The function receiving each matching record.
+ * @param[in] context A user pointer handed to @p match.
+ * @return A result code.
+ * @retval GPS_OK All blocks were decoded.
+ * @retval GPS_ERROR_CORRUPT The archive is malformed or does not match the
+ *         index.
+ */
+int gps_index_scan(struct gps_archive_reader *reader,
+                   uint32_t archive,
+                   const struct gps_index_query *query,
+                   const struct gps_index_posting *postings,
+                   size_t count,
+                   gps_index_match_function match,
+                   void *context);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _GPS_INDEX_H_ */
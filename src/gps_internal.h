@@ -0,0 +1,99 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Jacob McGladdery
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/**
+ * @file gps_internal.h
+ * @brief Entry points into the decoder internals, for tests and benchmarks.
+ *
+ * The parsers behind gps_decode() are static, so the compiler may inline
+ * them into it. These wrappers expose each one on its own so it can be
+ * checked and timed in isolation. They only exist when gps.c is compiled
+ * with GPS_TEST_INTERNALS defined, which the library build never does, and
+ * they are not part of the API.
+ */
+
+#ifndef _GPS_INTERNAL_H_
+#define _GPS_INTERNAL_H_
+
+#include "gps.h"
+
+#include <stdint.h>
+
+#define GPS_INTERNAL_MAX_FIELDS (32) /**< The size of the token array given to gps_internal_tokenize() */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Finds the fields of a sentence body and computes its checksum.
+ *
+ * @param[in] nmea The body, starting after the talker ID.
+ * @param[in] end One past the last character which may be read.
+ * @param[out] token The start of each field.
+ * @param[out] count The number of fields found.
+ * @param[in,out] checksum The checksum so far, updated with the body.
+ * @return The '*' ending the body, or NULL if there is none before @p end.
+ */
+const char *gps_internal_tokenize(const char *nmea, const char *end, const char **token,
+                                  uint_fast8_t *count, uint8_t *checksum);
+
+/**
+ * @brief Checks whether a sentence ID is supported.
+ *
+ * @param[in] id The three characters of the sentence ID.
+ * @return Nonzero if gps_decode() has a parser for @p id.
+ */
+int gps_internal_find_parser(const char *id);
+
+/**
+ * @brief Parses a decimal number field, scaled by GPS_VALUE_FACTOR.
+ */
+int32_t gps_internal_parse_number(const char *field);
+
+/**
+ * @brief Parses a latitude or longitude field with its direction letter.
+ */
+int32_t gps_internal_parse_angular_distance(const char *field, char direction);
+
+/**
+ * @brief Parses a time field into an ISO8601 time stamp.
+ */
+void gps_internal_parse_time(char *time, const char *field);
+
+/**
+ * @brief Parses a date field into an ISO8601 time stamp.
+ */
+void gps_internal_parse_date(char *time, const char *field);
+
+/**
+ * @brief Parses a speed field with its unit letter, in meters per second.
+ */
+int32_t gps_internal_parse_speed(const char *field, char unit);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,240 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Jacob McGladdery
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include "gps_interpolate.h"
+#include "gps_fixed.h"
+
+#include <assert.h>
+#include <stddef.h>
+
+/* Mean circumference of the Earth */
+#define CIRCUMFERENCE_MM INT64_C(40030228884)
+
+/* Smallest cosine of the latitude dead reckoning divides by, about 89.94
+ * degrees, so that the longitude rate stays bounded near the poles
+ */
+#define MIN_COS_LATITUDE_Q30 (GPS_FIXED_Q30_ONE >> 10)
+
+#define MAX_LATITUDE    INT64_C(90000000)
+#define TRACK_TURN      (360000)
+#define TRACK_HALF_TURN (180000)
+
+/* Change of a Q20 rate over some milliseconds, rounded */
+#define ADVANCE(rate, elapsed) (((rate) * (elapsed) + (INT64_C(1) << 19)) >> 20)
+
+/* Sample at position k counting from the oldest one */
+static const struct gps_interpolate_sample *sample(const struct gps_interpolate *interpolate, size_t k)
+{
+    return &interpolate->samples[(interpolate->newest - (interpolate->count - 1 - k)) & interpolate->mask];
+}
+
+/* value * num / den rounded to the nearest integer, for a positive den */
+static int64_t scale(int64_t value, int64_t num, int64_t den)
+{
+    int64_t product = value * num;
+
+    return ((product >= 0) ? product + den / 2 : product - den / 2) / den;
+}
+
+static int32_t interpolate_track(int32_t from, int32_t to, int64_t num, int64_t den)
+{
+    int64_t delta = (int64_t)to - from;
+    int64_t track;
+
+    if (delta > TRACK_HALF_TURN) delta -= TRACK_TURN;
+    if (delta < -TRACK_HALF_TURN) delta += TRACK_TURN;
+
+    track = from + scale(delta, num, den);
+    if (track < 0) track += TRACK_TURN;
+    if (track >= TRACK_TURN) track -= TRACK_TURN;
+
+    return (int32_t)track;
+}
+
+/* Works out how fast the coordinates change after the newest fix */
+static void update_rates(struct gps_interpolate *interpolate)
+{
+    const struct gps_interpolate_sample *newest = &interpolate->samples[interpolate->newest];
+
+    if ((newest->speed != GPS_INVALID_VALUE) && (newest->track != GPS_INVALID_VALUE))
+    {
+        uint64_t angle = gps_fixed_angle((int64_t)newest->track * 1000);
+        int64_t cos_latitude = gps_fixed_cos_q30(gps_fixed_angle(newest->latitude));
+        int64_t north;
+        int64_t east;
+
+        /* Millimeters per second in Q20, then micro-degrees per millisecond */
+        north = (newest->speed * gps_fixed_cos_q30(angle)) >> 10;
+        east = (newest->speed * gps_fixed_sin_q30(angle)) >> 10;
+        north = north * 360000 / CIRCUMFERENCE_MM;
+        east = east * 360000 / CIRCUMFERENCE_MM;
+
+        if (cos_latitude < MIN_COS_LATITUDE_Q30) cos_latitude = MIN_COS_LATITUDE_Q30;
+        interpolate->latitude_rate = north;
+        interpolate->longitude_rate = east * GPS_FIXED_Q30_ONE / cos_latitude;
+    }
+    else if (interpolate->count >= 2)
+    {
+        const struct gps_interpolate_sample *previous = sample(interpolate, interpolate->count - 2);
+        int64_t span = newest->time - previous->time;
+        int64_t delta = gps_fixed_wrap_longitude((int64_t)newest->longitude - previous->longitude);
+
+        interpolate->latitude_rate = ((int64_t)newest->latitude - previous->latitude) * (INT64_C(1) << 20) / span;
+        interpolate->longitude_rate = delta * (INT64_C(1) << 20) / span;
+    }
+    else
+    {
+        interpolate->latitude_rate = 0;
+        interpolate->longitude_rate = 0;
+    }
+}
+
+void gps_interpolate_init(struct gps_interpolate *interpolate,
+                          struct gps_interpolate_sample *samples,
+                          size_t capacity,
+                          int64_t horizon)
+{
+    assert(interpolate != NULL);
+    assert(samples != NULL);
+    assert(capacity >= 2);
+    assert((capacity & (capacity - 1)) == 0);
+    assert(horizon >= 0);
+
+    interpolate->samples = samples;
+    interpolate->mask = capacity - 1;
+    interpolate->count = 0;
+    interpolate->newest = 0;
+    interpolate->horizon = horizon;
+    interpolate->latitude_rate = 0;
+    interpolate->longitude_rate = 0;
+}
+
+int gps_interpolate_add(struct gps_interpolate *interpolate, const struct gps_tpv *tpv, int64_t time)
+{
+    assert(interpolate != NULL);
+    assert(tpv != NULL);
+
+    struct gps_interpolate_sample *newest;
+
+    if ((GPS_INVALID_VALUE == tpv->latitude) || (GPS_INVALID_VALUE == tpv->longitude))
+    {
+        return GPS_ERROR_UNSUPPORTED;
+    }
+
+    /* A later sentence of the same epoch replaces the fix */
+    if ((0 == interpolate->count) || (time != interpolate->samples[interpolate->newest].time))
+    {
+        if ((interpolate->count > 0) && (time < interpolate->samples[interpolate->newest].time))
+        {
+            interpolate->count = 0;
+        }
+
+        interpolate->newest = (interpolate->newest + 1) & interpolate->mask;
+        if (interpolate->count <= interpolate->mask) ++interpolate->count;
+    }
+
+    newest = &interpolate->samples[interpolate->newest];
+    newest->time = time;
+    newest->latitude = tpv->latitude;
+    newest->longitude = tpv->longitude;
+    newest->speed = tpv->speed;
+    newest->track = tpv->track;
+    update_rates(interpolate);
+
+    return GPS_OK;
+}
+
+int gps_interpolate_at(const struct gps_interpolate *interpolate,
+                       int64_t time,
+                       struct gps_interpolate_sample *fix)
+{
+    assert(interpolate != NULL);
+    assert(fix != NULL);
+
+    const struct gps_interpolate_sample *a;
+    const struct gps_interpolate_sample *b;
+    size_t low;
+    size_t high;
+    int64_t num;
+    int64_t den;
+
+    if (0 == interpolate->count) return GPS_ERROR_END;
+
+    /* After the newest fix, which is where a control loop usually asks */
+    a = &interpolate->samples[interpolate->newest];
+    if (time >= a->time)
+    {
+        int64_t elapsed = time - a->time;
+        int64_t latitude;
+
+        if (elapsed > interpolate->horizon) return GPS_ERROR_END;
+
+        latitude = a->latitude + ADVANCE(interpolate->latitude_rate, elapsed);
+        if (latitude > MAX_LATITUDE) latitude = MAX_LATITUDE;
+        if (latitude < -MAX_LATITUDE) latitude = -MAX_LATITUDE;
+
+        fix->time = time;
+        fix->latitude = (int32_t)latitude;
+        fix->longitude = (int32_t)gps_fixed_wrap_longitude(a->longitude +
+                                                           ADVANCE(interpolate->longitude_rate, elapsed));
+        fix->speed = a->speed;
+        fix->track = a->track;
+        return GPS_OK;
+    }
+
+    if (time < sample(interpolate, 0)->time) return GPS_ERROR_END;
+
+    /* The oldest fix is at or before the time, and the newest after it */
+    low = 0;
+    high = interpolate->count - 1;
+    while (high - low > 1)
+    {
+        size_t middle = low + (high - low) / 2;
+
+        if (sample(interpolate, middle)->time <= time) low = middle;
+        else high = middle;
+    }
+
+    a = sample(interpolate, low);
+    b = sample(interpolate, high);
+    num = time - a->time;
+    den = b->time - a->time;
+
+    fix->time = time;
+    fix->latitude = (int32_t)(a->latitude + scale((int64_t)b->latitude - a->latitude, num, den));
+    fix->longitude = (int32_t)gps_fixed_wrap_longitude(
+        a->longitude + scale(gps_fixed_wrap_longitude((int64_t)b->longitude - a->longitude), num, den));
+    fix->speed = a->speed;
+    fix->track = a->track;
+    if ((a->speed != GPS_INVALID_VALUE) && (b->speed != GPS_INVALID_VALUE))
+    {
+        fix->speed = (int32_t)(a->speed + scale((int64_t)b->speed - a->speed, num, den));
+    }
+    if ((a->track != GPS_INVALID_VALUE) && (b->track != GPS_INVALID_VALUE))
+    {
+        fix->track = interpolate_track(a->track, b->track, num, den);
+    }
+
+    return GPS_OK;
+}
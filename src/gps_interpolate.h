@@ -0,0 +1,147 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Jacob McGladdery
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/**
+ * @file gps_interpolate.h
+ * @brief Estimates the fix at any time from the recent decoded TPVs.
+ *
+ * Control loops run at 100 Hz or more while receivers report at 1 to
+ * 10 Hz. An interpolator keeps the last few fixes in a ring owned by the
+ * caller, and gps_interpolate_at() estimates the position, speed and track
+ * at any time from them. Between two fixes the values are interpolated
+ * along the straight line joining them. After the newest fix the position
+ * is dead reckoned from its speed and track, or from the last two
+ * positions when the receiver sends no velocity, for up to a horizon the
+ * caller chooses.
+ *
+ * Everything is integer arithmetic. The rate of change of the coordinates
+ * is worked out once per fix, so an estimate after the newest fix costs a
+ * few multiplications, and an estimate within the ring a binary search over
+ * at most log2 of its capacity fixes.
+ */
+
+#ifndef _GPS_INTERPOLATE_H_
+#define _GPS_INTERPOLATE_H_
+
+#include "gps.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Fix held in the ring, or estimated from it.
+ *
+ * The units are those of gps_tpv. Speed and track are GPS_INVALID_VALUE
+ * when unknown.
+ */
+struct gps_interpolate_sample
+{
+    int64_t time;      /**< Time in milliseconds */
+    int32_t latitude;  /**< Latitude in degrees times 10e6 */
+    int32_t longitude; /**< Longitude in degrees times 10e6 */
+    int32_t speed;     /**< Speed over ground, meters per second times 10e3 */
+    int32_t track;     /**< Course over ground, degrees from true north times 10e3 */
+};
+
+/**
+ * @brief Interpolator state.
+ */
+struct gps_interpolate
+{
+    struct gps_interpolate_sample *samples; /**< The ring, owned by the caller */
+    size_t mask;                            /**< The number of samples in the ring minus one */
+    size_t count;                           /**< Fixes held, at most the size of the ring */
+    size_t newest;                          /**< Index of the newest fix */
+    int64_t horizon;                        /**< How far past the newest fix to extrapolate, in milliseconds */
+    int64_t latitude_rate;                  /**< Latitude change after the newest fix, per millisecond, Q20 */
+    int64_t longitude_rate;                 /**< Longitude change after the newest fix, per millisecond, Q20 */
+};
+
+/**
+ * @brief Initializes an interpolator.
+ *
+ * @param[out] interpolate The interpolator to initialize.
+ * @param[out] samples The ring of fixes.
+ * @param[in] capacity The number of elements in @p samples.
+ * @param[in] horizon How long after the newest fix estimates are made, in
+ *            milliseconds, such as twice the interval between fixes.
+ *
+ * @pre The pointers @p interpolate and @p samples must not be NULL.
+ * @pre @p capacity must be a power of two, and at least 2.
+ * @pre @p horizon must not be negative.
+ */
+void gps_interpolate_init(struct gps_interpolate *interpolate,
+                          struct gps_interpolate_sample *samples,
+                          size_t capacity,
+                          int64_t horizon);
+
+/**
+ * @brief Adds a fix to the ring.
+ *
+ * A fix with the same time as the newest one replaces it, so a TPV may be
+ * added after every sentence of an epoch, such as GGA then RMC. A fix older
+ * than the newest one, such as the first after midnight with times of day
+ * from gps_time_to_ms(), empties the ring first. Once the ring is full the
+ * oldest fix is dropped.
+ *
+ * @param[in,out] interpolate The interpolator.
+ * @param[in] tpv The TPV.
+ * @param[in] time The time of the TPV in milliseconds, such as
+ *            gps_time_to_ms(tpv->time).
+ * @return GPS_OK, or GPS_ERROR_UNSUPPORTED if the TPV has no position, in
+ *         which case the ring is unchanged.
+ *
+ * @pre The pointers @p interpolate and @p tpv must not be NULL.
+ */
+int gps_interpolate_add(struct gps_interpolate *interpolate, const struct gps_tpv *tpv, int64_t time);
+
+/**
+ * @brief Estimates the fix at a time.
+ *
+ * @param[in] interpolate The interpolator.
+ * @param[in] time The time in milliseconds, on the clock of the times
+ *            given to gps_interpolate_add().
+ * @param[out] fix The estimate. Between two fixes its speed and track are
+ *             interpolated when both fixes have them, and otherwise are
+ *             those of the earlier fix. After the newest fix they are those
+ *             of the newest fix.
+ * @return GPS_OK, or GPS_ERROR_END if @p time is before the oldest fix or
+ *         more than the horizon after the newest, or there is no fix yet.
+ *         @p fix is only written on GPS_OK.
+ *
+ * @pre The pointers @p interpolate and @p fix must not be NULL.
+ */
+int gps_interpolate_at(const struct gps_interpolate *interpolate,
+                       int64_t time,
+                       struct gps_interpolate_sample *fix);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _GPS_INTERPOLATE_H_ */
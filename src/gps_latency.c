@@ -0,0 +1,166 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Jacob McGladdery
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include "gps_latency.h"
+
+#include <assert.h>
+#include <stddef.h>
+#include <string.h>
+
+#define HALF_BUCKETS (1 << (GPS_HISTOGRAM_SUB_BITS - 1))
+
+/* Position of the highest set bit of a non-zero value */
+static int highest_bit(uint64_t value)
+{
+#if defined(__GNUC__)
+    return 63 - __builtin_clzll(value);
+#else
+    int bit = 0;
+
+    while (value >>= 1) ++bit;
+    return bit;
+#endif
+}
+
+/* Values below 2^SUB_BITS have a bucket each. Above that, the values with
+ * their highest bit at position b share HALF_BUCKETS buckets, each
+ * 2^(b-SUB_BITS+1) wide.
+ */
+static size_t bucket_of(uint64_t value)
+{
+    int bit;
+    int shift;
+
+    if (value < (1u << GPS_HISTOGRAM_SUB_BITS)) return (size_t)value;
+
+    bit = highest_bit(value);
+    if (bit >= GPS_HISTOGRAM_MAX_BITS) return GPS_HISTOGRAM_BUCKETS - 1;
+
+    shift = bit - GPS_HISTOGRAM_SUB_BITS + 1;
+    return (size_t)(1 << GPS_HISTOGRAM_SUB_BITS) + (size_t)(shift - 1) * HALF_BUCKETS +
+           (size_t)(value >> shift) - HALF_BUCKETS;
+}
+
+/* The largest value counted in a bucket */
+static int64_t bucket_top(size_t bucket)
+{
+    size_t group;
+    int shift;
+
+    if (bucket < (1u << GPS_HISTOGRAM_SUB_BITS)) return (int64_t)bucket;
+
+    group = bucket - (1u << GPS_HISTOGRAM_SUB_BITS);
+    shift = (int)(group / HALF_BUCKETS) + 1;
+    return (int64_t)(((uint64_t)(group % HALF_BUCKETS + HALF_BUCKETS + 1) << shift) - 1);
+}
+
+void gps_histogram_init(struct gps_histogram *histogram)
+{
+    assert(histogram != NULL);
+
+    memset(histogram->counts, 0, sizeof(histogram->counts));
+    histogram->count = 0;
+    histogram->sum = 0;
+    histogram->min = INT64_MAX;
+    histogram->max = 0;
+}
+
+void gps_histogram_record(struct gps_histogram *histogram, int64_t value)
+{
+    assert(histogram != NULL);
+
+    if (value < 0) value = 0;
+
+    histogram->counts[bucket_of((uint64_t)value)]++;
+    histogram->count++;
+    histogram->sum += value;
+    if (value < histogram->min) histogram->min = value;
+    if (value > histogram->max) histogram->max = value;
+}
+
+void gps_histogram_add(struct gps_histogram *histogram, const struct gps_histogram *other)
+{
+    assert(histogram != NULL);
+    assert(other != NULL);
+
+    size_t i;
+
+    for (i = 0; i < GPS_HISTOGRAM_BUCKETS; ++i) histogram->counts[i] += other->counts[i];
+    histogram->count += other->count;
+    histogram->sum += other->sum;
+    if (other->min < histogram->min) histogram->min = other->min;
+    if (other->max > histogram->max) histogram->max = other->max;
+}
+
+int64_t gps_histogram_quantile(const struct gps_histogram *histogram, uint32_t millionths)
+{
+    assert(histogram != NULL);
+
+    uint64_t rank;
+    uint64_t seen = 0;
+    int64_t value;
+    size_t i;
+
+    if (0 == histogram->count) return 0;
+    if (0 == millionths) return histogram->min;
+    if (millionths >= 1000000) return histogram->max;
+
+    /* The rank of the value, counting from 1 */
+    rank = (histogram->count * millionths + 999999) / 1000000;
+
+    for (i = 0; i < GPS_HISTOGRAM_BUCKETS - 1; ++i)
+    {
+        seen += histogram->counts[i];
+        if (seen >= rank) break;
+    }
+
+    /* The last bucket holds everything too large to tell apart */
+    value = (GPS_HISTOGRAM_BUCKETS - 1 == i) ? histogram->max : bucket_top(i);
+    if (value < histogram->min) value = histogram->min;
+    if (value > histogram->max) value = histogram->max;
+
+    return value;
+}
+
+void gps_latency_init(struct gps_latency *latency)
+{
+    assert(latency != NULL);
+
+    int s;
+
+    for (s = 0; s < GPS_LATENCY_STAGES; ++s) gps_histogram_init(&latency->stages[s]);
+}
+
+void gps_latency_record(struct gps_latency *latency,
+                        const struct gps_latency_stamps *stamps,
+                        int64_t dispatched)
+{
+    assert(latency != NULL);
+    assert(stamps != NULL);
+
+    gps_histogram_record(&latency->stages[GPS_LATENCY_RECEIVE], stamps->end - stamps->start);
+    gps_histogram_record(&latency->stages[GPS_LATENCY_DECODE], stamps->decoded - stamps->end);
+    gps_histogram_record(&latency->stages[GPS_LATENCY_DISPATCH], dispatched - stamps->decoded);
+    gps_histogram_record(&latency->stages[GPS_LATENCY_TOTAL], dispatched - stamps->start);
+}
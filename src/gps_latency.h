@@ -0,0 +1,174 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Jacob McGladdery
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/**
+ * @file gps_latency.h
+ * @brief Sentence timestamps and constant memory latency histograms.
+ *
+ * A fix is already old when the control loop sees it. Its age is made of
+ * the time the sentence takes on the wire, the time spent decoding it, and
+ * the time until the loop picks up the result. struct gps_latency_stamps
+ * carries the monotonic time of each of these steps alongside a TPV, and
+ * gps_latency_record() adds them to one histogram per stage.
+ *
+ * The histograms are log-linear, like HdrHistogram: every power of two is
+ * split into the same number of equal buckets, so any value is recorded
+ * within a fixed relative error in constant time, in a fixed amount of
+ * memory, and without allocation. gps_session.h fills in the timestamps
+ * when asked to. Any other input path can fill them in with its own clock.
+ */
+
+#ifndef _GPS_LATENCY_H_
+#define _GPS_LATENCY_H_
+
+#include <stdint.h>
+
+#define GPS_HISTOGRAM_SUB_BITS (6)  /**< Buckets per power of two are 2^(GPS_HISTOGRAM_SUB_BITS-1) */
+#define GPS_HISTOGRAM_MAX_BITS (36) /**< Values from 2^GPS_HISTOGRAM_MAX_BITS go in the last bucket */
+
+/** The number of buckets of a histogram */
+#define GPS_HISTOGRAM_BUCKETS ((1 << GPS_HISTOGRAM_SUB_BITS) + \
+    (GPS_HISTOGRAM_MAX_BITS - GPS_HISTOGRAM_SUB_BITS) * (1 << (GPS_HISTOGRAM_SUB_BITS - 1)))
+
+#define GPS_LATENCY_RECEIVE  (0) /**< From the '$' to the CR LF of the sentence */
+#define GPS_LATENCY_DECODE   (1) /**< From the CR LF to the end of decoding */
+#define GPS_LATENCY_DISPATCH (2) /**< From the end of decoding to the consumer */
+#define GPS_LATENCY_TOTAL    (3) /**< From the '$' to the consumer */
+#define GPS_LATENCY_STAGES   (4) /**< The number of stages */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Monotonic timestamps of a sentence, in nanoseconds.
+ */
+struct gps_latency_stamps
+{
+    int64_t start;   /**< When the '$' was received */
+    int64_t end;     /**< When the CR LF was received */
+    int64_t decoded; /**< When decoding completed */
+};
+
+/**
+ * @brief Log-linear histogram of non-negative values.
+ *
+ * Values below 2^GPS_HISTOGRAM_SUB_BITS are counted exactly. Larger values
+ * are counted with a relative error of at most 2^(1-GPS_HISTOGRAM_SUB_BITS),
+ * which is about 3%. With nanoseconds, values up to 68 seconds are told
+ * apart. The exact smallest and largest values are kept as well.
+ */
+struct gps_histogram
+{
+    uint32_t counts[GPS_HISTOGRAM_BUCKETS]; /**< Values recorded per bucket */
+    uint64_t count;                         /**< Values recorded in total */
+    int64_t sum;                            /**< Sum of the values recorded */
+    int64_t min;                            /**< Smallest value recorded */
+    int64_t max;                            /**< Largest value recorded */
+};
+
+/**
+ * @brief Latency histograms of every stage.
+ */
+struct gps_latency
+{
+    struct gps_histogram stages[GPS_LATENCY_STAGES]; /**< Indexed by GPS_LATENCY_RECEIVE and so on */
+};
+
+/**
+ * @brief Empties a histogram.
+ *
+ * @param[out] histogram The histogram to initialize.
+ *
+ * @pre The pointer @p histogram must not be NULL.
+ */
+void gps_histogram_init(struct gps_histogram *histogram);
+
+/**
+ * @brief Counts a value.
+ *
+ * @param[in,out] histogram The histogram.
+ * @param[in] value The value. Negative values, which a clock stepping back
+ *            would produce, are counted as 0.
+ *
+ * @pre The pointer @p histogram must not be NULL.
+ */
+void gps_histogram_record(struct gps_histogram *histogram, int64_t value);
+
+/**
+ * @brief Adds the values counted by one histogram to another.
+ *
+ * Lets every thread or session keep its own histogram, and the totals be
+ * taken from time to time.
+ *
+ * @param[in,out] histogram The histogram to add to.
+ * @param[in] other The histogram to add.
+ *
+ * @pre The pointers @p histogram and @p other must not be NULL.
+ */
+void gps_histogram_add(struct gps_histogram *histogram, const struct gps_histogram *other);
+
+/**
+ * @brief Finds the value below which a share of the recorded values fall.
+ *
+ * @param[in] histogram The histogram.
+ * @param[in] millionths The share, in millionths. 0 gives the smallest value,
+ *            500000 the median, 999000 the 99.9th percentile, and 1000000
+ *            the largest value.
+ * @return The largest value counted in the same bucket as the value at
+ *         that rank, bounded by the smallest and largest values recorded,
+ *         or 0 if the histogram is empty.
+ *
+ * @pre The pointer @p histogram must not be NULL.
+ */
+int64_t gps_histogram_quantile(const struct gps_histogram *histogram, uint32_t millionths);
+
+/**
+ * @brief Empties the histograms of every stage.
+ *
+ * @param[out] latency The histograms to initialize.
+ *
+ * @pre The pointer @p latency must not be NULL.
+ */
+void gps_latency_init(struct gps_latency *latency);
+
+/**
+ * @brief Counts the latencies of a sentence.
+ *
+ * @param[in,out] latency The histograms.
+ * @param[in] stamps The timestamps of the sentence.
+ * @param[in] dispatched When the consumer picked up the result, on the same
+ *            clock as @p stamps.
+ *
+ * @pre The pointers @p latency and @p stamps must not be NULL.
+ */
+void gps_latency_record(struct gps_latency *latency,
+                        const struct gps_latency_stamps *stamps,
+                        int64_t dispatched);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _GPS_LATENCY_H_ */
@@ -0,0 +1,116 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Jacob McGladdery
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include "gps_latest.h"
+
+#include <assert.h>
+#include <stdatomic.h>
+#include <stddef.h>
+#include <string.h>
+
+/* The layout of struct gps_latest, as atomics */
+struct latest
+{
+    atomic_uint_least32_t sequence;               /* Twice the publish count, odd during a publish */
+    atomic_uint_least32_t words[GPS_LATEST_WORDS]; /* The TPV */
+};
+
+_Static_assert(sizeof(struct latest) == sizeof(struct gps_latest), "atomic words must be 32 bits");
+_Static_assert(_Alignof(struct latest) <= _Alignof(struct gps_latest), "atomic words must be 32 bit aligned");
+
+void gps_latest_init(struct gps_latest *latest)
+{
+    assert(latest != NULL);
+
+    struct latest *state = (struct latest *)latest;
+    uint32_t words[GPS_LATEST_WORDS];
+    struct gps_tpv tpv;
+    size_t i;
+
+    gps_init_tpv(&tpv);
+    words[GPS_LATEST_WORDS - 1] = 0;
+    memcpy(words, &tpv, sizeof(tpv));
+
+    atomic_init(&state->sequence, 0);
+    for (i = 0; i < GPS_LATEST_WORDS; ++i) atomic_init(&state->words[i], words[i]);
+}
+
+void gps_latest_publish(struct gps_latest *latest, const struct gps_tpv *tpv)
+{
+    assert(latest != NULL);
+    assert(tpv != NULL);
+
+    struct latest *state = (struct latest *)latest;
+    uint32_t words[GPS_LATEST_WORDS];
+    uint32_t sequence;
+    uint32_t next;
+    size_t i;
+
+    words[GPS_LATEST_WORDS - 1] = 0;
+    memcpy(words, tpv, sizeof(*tpv));
+
+    /* The odd sequence must be visible before any of the words change */
+    sequence = atomic_load_explicit(&state->sequence, memory_order_relaxed);
+    atomic_store_explicit(&state->sequence, sequence + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+
+    for (i = 0; i < GPS_LATEST_WORDS; ++i)
+    {
+        atomic_store_explicit(&state->words[i], words[i], memory_order_relaxed);
+    }
+
+    /* Zero is kept for nothing published, so the count wraps around to 1 */
+    next = sequence + 2;
+    if (0 == next) next = 2;
+    atomic_store_explicit(&state->sequence, next, memory_order_release);
+}
+
+uint32_t gps_latest_read(const struct gps_latest *latest, struct gps_tpv *tpv)
+{
+    assert(latest != NULL);
+    assert(tpv != NULL);
+
+    const struct latest *state = (const struct latest *)latest;
+    uint32_t words[GPS_LATEST_WORDS];
+    uint32_t before;
+    uint32_t after;
+    size_t i;
+
+    do
+    {
+        before = atomic_load_explicit(&state->sequence, memory_order_acquire);
+        for (i = 0; i < GPS_LATEST_WORDS; ++i)
+        {
+            words[i] = atomic_load_explicit(&state->words[i], memory_order_relaxed);
+        }
+
+        /* None of the words may be read after the sequence is checked */
+        atomic_thread_fence(memory_order_acquire);
+        after = atomic_load_explicit(&state->sequence, memory_order_relaxed);
+    } while ((before & 1) || (before != after));
+
+    memcpy(tpv, words, sizeof(*tpv));
+
+    return before / 2;
+}
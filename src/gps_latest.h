@@ -0,0 +1,114 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Jacob McGladdery
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/**
+ * @file gps_latest.h
+ * @brief Publishes the latest TPV to many reader threads without locks.
+ *
+ * A single writer, typically the thread running the decoder, publishes a
+ * copy of its TPV after every sentence or epoch. Any number of readers take
+ * consistent copies of the last published TPV at any time. Neither side
+ * takes a lock, so a reader can never block the writer or another reader,
+ * and a preempted reader holds up nobody.
+ *
+ * The TPV is guarded by a sequence lock. The writer makes the sequence odd
+ * while it updates the copy, and even again when it is done. Readers copy
+ * the TPV between two loads of the sequence and retry if it was odd or has
+ * changed. A read costs one copy of the TPV plus two loads when no publish
+ * is in progress, which is the common case since publishing only takes as
+ * long as copying the TPV.
+ *
+ * This module requires C11 atomics and is only built when stdatomic.h is
+ * found.
+ */
+
+#ifndef _GPS_LATEST_H_
+#define _GPS_LATEST_H_
+
+#include "gps.h"
+
+#include <stdint.h>
+
+/** The number of 32 bit words holding the TPV */
+#define GPS_LATEST_WORDS ((sizeof(struct gps_tpv) + sizeof(uint32_t) - 1) / sizeof(uint32_t))
+
+/**
+ * @brief The latest TPV and the sequence guarding it.
+ *
+ * The members are private. gps_latest.c accesses the storage as C11 atomic
+ * words, so that reading the TPV during a publish is well defined, if torn,
+ * before the reader notices the sequence change and retries. The atomic
+ * types are kept out of this header so that C++ code can include it.
+ */
+struct gps_latest
+{
+    uint32_t storage[1 + GPS_LATEST_WORDS]; /**< The sequence, then the TPV */
+};
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Initializes the publisher with an unset TPV.
+ *
+ * Must be called before the publisher is shared with other threads.
+ *
+ * @param[out] latest The publisher to initialize.
+ */
+void gps_latest_init(struct gps_latest *latest);
+
+/**
+ * @brief Publishes a TPV.
+ *
+ * Only one thread may publish to a given publisher. Callers publishing from
+ * several threads must serialize the calls themselves.
+ *
+ * @param[in,out] latest The publisher.
+ * @param[in] tpv The TPV to publish.
+ */
+void gps_latest_publish(struct gps_latest *latest, const struct gps_tpv *tpv);
+
+/**
+ * @brief Reads the latest TPV.
+ *
+ * Safe to call from any number of threads, concurrently with each other and
+ * with gps_latest_publish(). The copy in @p tpv is always a TPV exactly as
+ * it was published, never a mix of two.
+ *
+ * @param[in] latest The publisher.
+ * @param[out] tpv The latest TPV.
+ * @return The number of TPVs published so far, which readers may compare
+ *         with the value from an earlier read to tell whether the TPV is
+ *         new. It counts up to 2^31 - 1 and then wraps around to 1, so zero
+ *         always means nothing was published yet, and @p tpv is as set by
+ *         gps_init_tpv().
+ */
+uint32_t gps_latest_read(const struct gps_latest *latest, struct gps_tpv *tpv);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _GPS_LATEST_H_ */
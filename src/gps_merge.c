@@ -0,0 +1,233 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Jacob McGladdery
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include "gps_merge.h"
+
+#include <assert.h>
+#include <string.h>
+
+#define HALF_DAY (GPS_MS_PER_DAY / 2)
+
+/* Time part of a time stamp, "HH:MM:SS.SSS" */
+#define TIME_OFFSET (11)
+#define TIME_SIZE   (12)
+#define UNSET_HOUR  ('?')
+
+static int64_t floor_div(int64_t a, int64_t b)
+{
+    int64_t q = a / b;
+
+    if ((a % b != 0) && ((a < 0) != (b < 0))) --q;
+    return q;
+}
+
+/* Sets the merge time of the fix just loaded into source */
+static void update_time(struct gps_merge_source *source)
+{
+    int64_t time = gps_time_to_ms(source->fix.time) + source->skew;
+
+    if (!gps_time_has_date(source->fix.time)) time += source->day;
+    time += source->unwrap * GPS_MS_PER_DAY;
+
+    if (source->started)
+    {
+        /* Whole days which bring the time within half a day of the previous
+         * fix, forward after a midnight without a new date, and back once
+         * the date catches up
+         */
+        int64_t days = floor_div(source->time - time + HALF_DAY, GPS_MS_PER_DAY);
+
+        source->unwrap += days;
+        time += days * GPS_MS_PER_DAY;
+
+        if (time < source->time) time = source->time;
+    }
+
+    source->time = time;
+    source->started = 1;
+}
+
+/* Decodes sentences until a fix is complete. A fix is complete when the
+ * time of day changes, or when the log ends. Returns non-zero if a fix was
+ * loaded into source->fix.
+ */
+static int advance(struct gps_merge_source *source)
+{
+    while (source->offset < source->size)
+    {
+        const char *start = source->data + source->offset;
+        const char *end = source->data + source->size;
+        const char *header = memchr(start, '$', (size_t)(end - start));
+        const char *footer;
+        struct gps_tpv next;
+        int complete = 0;
+
+        if (NULL == header)
+        {
+            source->offset = source->size;
+            break;
+        }
+
+        footer = memchr(header, '\n', (size_t)(end - header));
+        footer = (NULL == footer) ? end : footer + 1;
+        source->offset = (size_t)(footer - source->data);
+
+        /* Before the first time is set, the null time reads as midnight, so
+         * the hour is marked to tell whether the sentence carried a time
+         */
+        next = source->state;
+        if (!source->assembling) next.time[TIME_OFFSET] = UNSET_HOUR;
+        if (gps_decode_const(&next, header, (size_t)(footer - header)) != GPS_OK)
+        {
+            source->errors++;
+            continue;
+        }
+
+        if (!source->assembling)
+        {
+            if (next.time[TIME_OFFSET] != UNSET_HOUR) source->assembling = 1;
+            else next.time[TIME_OFFSET] = source->state.time[TIME_OFFSET];
+        }
+        else if (memcmp(next.time + TIME_OFFSET, source->state.time + TIME_OFFSET, TIME_SIZE) != 0)
+        {
+            source->fix = source->state;
+            complete = 1;
+        }
+
+        source->state = next;
+        if (complete)
+        {
+            update_time(source);
+            return 1;
+        }
+    }
+
+    if (source->assembling)
+    {
+        source->fix = source->state;
+        source->assembling = 0;
+        update_time(source);
+        return 1;
+    }
+
+    return 0;
+}
+
+static int earlier(const struct gps_merge *merge, size_t a, size_t b)
+{
+    const struct gps_merge_source *sa = &merge->sources[a];
+    const struct gps_merge_source *sb = &merge->sources[b];
+
+    if (sa->time != sb->time) return sa->time < sb->time;
+    return a < b;
+}
+
+static void sift_down(struct gps_merge *merge, size_t i)
+{
+    size_t *heap = merge->heap;
+
+    for (;;)
+    {
+        size_t child = 2 * i + 1;
+        size_t swap;
+
+        if (child >= merge->count) break;
+        if ((child + 1 < merge->count) && earlier(merge, heap[child + 1], heap[child])) ++child;
+        if (!earlier(merge, heap[child], heap[i])) break;
+
+        swap = heap[i];
+        heap[i] = heap[child];
+        heap[child] = swap;
+        i = child;
+    }
+}
+
+void gps_merge_source_init(struct gps_merge_source *source, const char *data, size_t size,
+                           int64_t skew, int64_t day)
+{
+    assert(source != NULL);
+    assert(data != NULL);
+
+    source->data = data;
+    source->size = size;
+    source->offset = 0;
+    source->skew = skew;
+    source->day = day;
+    source->unwrap = 0;
+    source->time = 0;
+    gps_init_tpv(&source->state);
+    gps_init_tpv(&source->fix);
+    source->assembling = 0;
+    source->started = 0;
+    source->errors = 0;
+}
+
+int gps_merge_init(struct gps_merge *merge, struct gps_merge_source *sources, size_t count)
+{
+    assert(merge != NULL);
+    assert(sources != NULL);
+
+    size_t i;
+
+    if (count > GPS_MERGE_MAX_SOURCES) return GPS_ERROR_OVERFLOW;
+
+    merge->sources = sources;
+    merge->count = 0;
+    for (i = 0; i < count; ++i)
+    {
+        if (advance(&sources[i])) merge->heap[merge->count++] = i;
+    }
+
+    for (i = merge->count / 2; i-- > 0;)
+    {
+        sift_down(merge, i);
+    }
+
+    return GPS_OK;
+}
+
+int gps_merge_next(struct gps_merge *merge, struct gps_tpv *tpv, size_t *source, int64_t *time)
+{
+    assert(merge != NULL);
+    assert(tpv != NULL);
+
+    struct gps_merge_source *first;
+    size_t index;
+
+    if (0 == merge->count) return GPS_ERROR_END;
+
+    index = merge->heap[0];
+    first = &merge->sources[index];
+    *tpv = first->fix;
+    if (source != NULL) *source = index;
+    if (time != NULL) *time = first->time;
+
+    /* Replace the fix with the next one of the same source, or drop the
+     * source once it is exhausted
+     */
+    if (!advance(first)) merge->heap[0] = merge->heap[--merge->count];
+    sift_down(merge, 0);
+
+    return GPS_OK;
+}
@@ -0,0 +1,147 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Jacob McGladdery
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/**
+ * @file gps_merge.h
+ * @brief Time ordered merge of the NMEA logs of several receivers.
+ *
+ * Each source is an NMEA log held in memory, which is decoded in place with
+ * gps_decode_const() as the merge advances. A source groups the sentences of
+ * one fix, the ones sharing a time of day, into a single TPV. The merge
+ * keeps the next TPV of every source in a binary heap keyed on its time and
+ * hands them out in time order, so it holds one fix per source no matter
+ * how long the logs are. Ties go to the source listed first.
+ *
+ * Sentences such as GGA only carry a time of day. The decoder keeps the last
+ * date it saw, so after midnight such a TPV reads as a day earlier until the
+ * next RMC or ZDA. The merge unwraps times per source, so that consecutive
+ * fixes of a source never step by more than half a day. Before a source has
+ * seen any date, its times of day count from the day given to
+ * gps_merge_source_init().
+ *
+ * Receiver clocks are corrected by a fixed skew per source. Within a source
+ * fixes are never reordered: a fix whose corrected time falls behind the
+ * previous one is handed out at the time of the previous one.
+ */
+
+#ifndef _GPS_MERGE_H_
+#define _GPS_MERGE_H_
+
+#include "gps.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define GPS_MERGE_MAX_SOURCES (32) /**< The most sources one merge can hold */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Per source state.
+ */
+struct gps_merge_source
+{
+    const char *data;     /**< The NMEA log */
+    size_t size;          /**< Characters in gps_merge_source.data */
+    size_t offset;        /**< Next character to decode */
+    int64_t skew;         /**< Milliseconds added to every time of this source */
+    int64_t day;          /**< Milliseconds added to times without a date */
+    int64_t unwrap;       /**< Whole days added to undo midnight rollover */
+    int64_t time;         /**< Merge time of gps_merge_source.fix */
+    struct gps_tpv state; /**< Decoder state, the fix being assembled */
+    struct gps_tpv fix;   /**< The next fix to hand out */
+    int assembling;       /**< Non-zero once gps_merge_source.state holds a timed fix */
+    int started;          /**< Non-zero once a fix has been handed out */
+    uint32_t errors;      /**< Sentences which failed to decode */
+};
+
+/**
+ * @brief Merge state.
+ */
+struct gps_merge
+{
+    struct gps_merge_source *sources;        /**< Sources, owned by the caller */
+    size_t heap[GPS_MERGE_MAX_SOURCES];      /**< Sources with a fix, ordered by time */
+    size_t count;                            /**< Entries in gps_merge.heap */
+};
+
+/**
+ * @brief Initializes a source over an NMEA log.
+ *
+ * @param[out] source The source to initialize.
+ * @param[in] data The NMEA log, which is only read.
+ * @param[in] size The number of characters in @p data.
+ * @param[in] skew Milliseconds added to every time of this source, to
+ *            correct for its clock.
+ * @param[in] day Milliseconds since the epoch of the midnight which times are
+ *            counted from before the log gives a date, or 0 to merge by time
+ *            of day alone.
+ *
+ * @pre The pointers @p source and @p data must not be NULL.
+ * @pre @p data must stay valid as long as the merge is used.
+ */
+void gps_merge_source_init(struct gps_merge_source *source, const char *data, size_t size,
+                           int64_t skew, int64_t day);
+
+/**
+ * @brief Starts a merge of the given sources.
+ *
+ * Reads the first fix of every source.
+ *
+ * @param[out] merge The merge to initialize.
+ * @param[in,out] sources The sources, initialized with
+ *                gps_merge_source_init().
+ * @param[in] count The number of sources.
+ * @return A result code indicating what happened.
+ * @retval GPS_OK If the merge was started.
+ * @retval GPS_ERROR_OVERFLOW If @p count exceeds GPS_MERGE_MAX_SOURCES.
+ *
+ * @pre The pointers @p merge and @p sources must not be NULL.
+ */
+int gps_merge_init(struct gps_merge *merge, struct gps_merge_source *sources, size_t count);
+
+/**
+ * @brief Hands out the earliest fix of all sources.
+ *
+ * @param[in,out] merge The merge.
+ * @param[out] tpv The fix.
+ * @param[out] source The index of the source of the fix. May be NULL.
+ * @param[out] time The merge time of the fix, in milliseconds since the
+ *             epoch, or since the day given to the source. May be NULL.
+ * @return A result code indicating what happened.
+ * @retval GPS_OK If a fix was handed out.
+ * @retval GPS_ERROR_END If every source is exhausted.
+ *
+ * @pre The pointers @p merge and @p tpv must not be NULL.
+ * @post The data in @p tpv is modified.
+ */
+int gps_merge_next(struct gps_merge *merge, struct gps_tpv *tpv, size_t *source, int64_t *time);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,510 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Jacob McGladdery
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include "gps_project.h"
+#include "gps_fixed.h"
+
+#include <assert.h>
+#include <stddef.h>
+
+/* WGS84 semi-major axis in millimeters */
+#define SEMI_MAJOR_AXIS_MM INT64_C(6378137000)
+
+/* e^2, 1 - e^2 and e'^2 = e^2 / (1 - e^2) of WGS84 in Q40 */
+#define E2_Q40          INT64_C(7360548640)
+#define ONE_MINUS_E2_Q40 INT64_C(1092151079136)
+#define EP2_Q40         INT64_C(7410155033)
+
+/* UTM scale factor on the central meridian in Q40 */
+#define UTM_K0_Q40 INT64_C(1099071823125)
+
+/* UTM false easting and southern false northing in millimeters */
+#define UTM_FALSE_EASTING_MM  INT64_C(500000000)
+#define UTM_FALSE_NORTHING_MM INT64_C(10000000000)
+
+/* Meridian arc coefficients in millimeters, up to e^6 */
+#define ARC_A_MM INT64_C(6367449146)
+#define ARC_B_MM INT64_C(16038508)
+#define ARC_C_MM INT64_C(16832)
+#define ARC_D_MM INT64_C(22)
+
+/* Floating point versions of the above */
+#define SEMI_MAJOR_AXIS_M 6378137.0
+#define E2                0.0066943799901413165
+#define EP2               0.006739496742276434
+#define UTM_K0            0.9996
+#define ARC_A_M           6367449.145960816
+#define ARC_B_M           16038.508333155591
+#define ARC_C_M           16.832200728068772
+#define ARC_D_M           0.021800766212621795
+
+/* pi / 360e6, converts micro-degrees to half angles in radians */
+#define HALF_RADIANS_PER_MICRODEGREE 8.7266462599716478e-9
+
+#define Q40_TO_REAL (1.0 / 1099511627776.0)
+
+static int64_t mul(int64_t x, int64_t y)
+{
+    return gps_fixed_mul_q40(x, y);
+}
+
+/* 1 / sqrt(1 - x) for x = e^2 sin^2(latitude), in Q40 */
+static int64_t inverse_root(int64_t x)
+{
+    int64_t t;
+
+    t = (35 * GPS_FIXED_Q40_ONE) / 128;
+    t = (5 * GPS_FIXED_Q40_ONE) / 16 + mul(x, t);
+    t = (3 * GPS_FIXED_Q40_ONE) / 8 + mul(x, t);
+    t = GPS_FIXED_Q40_ONE / 2 + mul(x, t);
+
+    return GPS_FIXED_Q40_ONE + mul(x, t);
+}
+
+/* (f(x) - f(x0)) / (x - x0) for f = inverse_root, in Q40 */
+static int64_t inverse_root_slope(int64_t x, int64_t x0)
+{
+    int64_t sum = x + x0;
+    int64_t squares = mul(x, x) + mul(x0, x0);
+    int64_t t;
+
+    t = mul((35 * GPS_FIXED_Q40_ONE) / 128, mul(sum, squares));
+    t += mul((5 * GPS_FIXED_Q40_ONE) / 16, squares + mul(x, x0));
+    t += mul((3 * GPS_FIXED_Q40_ONE) / 8, sum);
+
+    return GPS_FIXED_Q40_ONE / 2 + t;
+}
+
+void gps_project_origin_init(struct gps_project_origin *origin,
+                             int32_t latitude,
+                             int32_t longitude,
+                             int32_t altitude)
+{
+    assert(origin != NULL);
+
+    origin->latitude = latitude;
+    origin->longitude = longitude;
+    origin->altitude = altitude;
+    origin->sin_latitude = gps_fixed_sin_half_q40(2 * (int64_t)latitude);
+    origin->cos_latitude = gps_fixed_cos_half_q40(2 * (int64_t)latitude);
+    origin->eccentricity = mul(E2_Q40, mul(origin->sin_latitude, origin->sin_latitude));
+    origin->radius = mul(SEMI_MAJOR_AXIS_MM, inverse_root(origin->eccentricity));
+}
+
+/* The local frame is the geocentric frame rotated by the longitude and
+ * latitude of the origin. Subtracting the geocentric coordinates of the
+ * origin and the point directly would cancel all but a few digits, so the
+ * differences are expanded with the identities
+ *
+ *   sin(lat) - sin(lat0) = cos(lat0) sin(dlat) - sin(lat0) (1 - cos(dlat))
+ *   cos(lat) - cos(lat0) = -sin(lat0) sin(dlat) - cos(lat0) (1 - cos(dlat))
+ *   1 - cos(dlat) = 2 sin^2(dlat / 2)
+ *
+ * which keep their precision for small differences. With N the prime
+ * vertical radius of curvature and h the height, rotating the geocentric
+ * frame by the longitude of the origin gives
+ *
+ *   dx = (N + h) cos(lat) cos(dlon) - (N0 + h0) cos(lat0)
+ *   dy = (N + h) cos(lat) sin(dlon)
+ *   dz = (N (1 - e^2) + h) sin(lat) - (N0 (1 - e^2) + h0) sin(lat0)
+ *
+ * and then east = dy, north = cos(lat0) dz - sin(lat0) dx and
+ * up = cos(lat0) dx + sin(lat0) dz.
+ */
+static void project_enu(const struct gps_project_origin *origin,
+                        int32_t *east, int32_t *north, int32_t *up,
+                        int32_t latitude, int32_t longitude, int64_t height)
+{
+    int64_t dlat = (int64_t)latitude - origin->latitude;
+    int64_t dlon = gps_fixed_wrap_longitude((int64_t)longitude - origin->longitude);
+    int64_t sin_lat0 = origin->sin_latitude;
+    int64_t cos_lat0 = origin->cos_latitude;
+    int64_t sin_half_dlat = gps_fixed_sin_half_q40(dlat);
+    int64_t cos_half_dlat = gps_fixed_cos_half_q40(dlat);
+    int64_t sin_half_dlon = gps_fixed_sin_half_q40(dlon);
+    int64_t cos_half_dlon = gps_fixed_cos_half_q40(dlon);
+    int64_t sin_dlat = 2 * mul(sin_half_dlat, cos_half_dlat);
+    int64_t versine_dlat = 2 * mul(sin_half_dlat, sin_half_dlat);
+    int64_t delta_sin = mul(cos_lat0, sin_dlat) - mul(sin_lat0, versine_dlat);
+    int64_t delta_cos = -mul(sin_lat0, sin_dlat) - mul(cos_lat0, versine_dlat);
+    int64_t sin_lat = sin_lat0 + delta_sin;
+    int64_t cos_lat = cos_lat0 + delta_cos;
+    int64_t delta_eccentricity = mul(E2_Q40, mul(delta_sin, sin_lat + sin_lat0));
+    int64_t delta_radius, radius, dx, dy, dz;
+
+    /* N - N0, from the divided difference of its series */
+    delta_radius = mul(SEMI_MAJOR_AXIS_MM,
+                       mul(delta_eccentricity,
+                           inverse_root_slope(origin->eccentricity + delta_eccentricity,
+                                              origin->eccentricity)));
+
+    radius = mul(origin->radius + origin->altitude + delta_radius + height, cos_lat);
+
+    dx = mul(delta_radius + height, cos_lat) + mul(origin->radius + origin->altitude, delta_cos) -
+         2 * mul(radius, mul(sin_half_dlon, sin_half_dlon));
+    dy = 2 * mul(mul(radius, sin_half_dlon), cos_half_dlon);
+    dz = mul(mul(delta_radius, ONE_MINUS_E2_Q40) + height, sin_lat) +
+         mul(mul(origin->radius, ONE_MINUS_E2_Q40) + origin->altitude, delta_sin);
+
+    *east = (int32_t)dy;
+    *north = (int32_t)(mul(dz, cos_lat0) - mul(dx, sin_lat0));
+    *up = (int32_t)(mul(dx, cos_lat0) + mul(dz, sin_lat0));
+}
+
+void gps_project_enu(const struct gps_project_origin *origin,
+                     int32_t *east,
+                     int32_t *north,
+                     int32_t *up,
+                     const int32_t *latitude,
+                     const int32_t *longitude,
+                     const int32_t *altitude,
+                     size_t n)
+{
+    assert(origin != NULL);
+    assert((east != NULL) || (0 == n));
+    assert((north != NULL) || (0 == n));
+    assert((up != NULL) || (0 == n));
+    assert((latitude != NULL) || (0 == n));
+    assert((longitude != NULL) || (0 == n));
+
+    size_t i;
+
+    for (i = 0; i < n; ++i)
+    {
+        int64_t height = (altitude != NULL) ? ((int64_t)altitude[i] - origin->altitude) : 0;
+
+        project_enu(origin, &east[i], &north[i], &up[i], latitude[i], longitude[i], height);
+    }
+}
+
+/* Origin values for the floating point version of project_enu() */
+struct origin_float
+{
+    int32_t latitude;
+    int32_t longitude;
+    int32_t altitude;
+    float sin_latitude;
+    float cos_latitude;
+    float eccentricity;
+    float radius;
+    float height;
+};
+
+/* Same as project_enu(), free of branches and calls so that the loops
+ * calling it are vectorized
+ */
+static void project_enu_float(const struct origin_float *origin,
+                              float *east, float *north, float *up,
+                              int32_t latitude, int32_t longitude, float height)
+{
+    const float half_radians = (float)HALF_RADIANS_PER_MICRODEGREE;
+    const float a = (float)SEMI_MAJOR_AXIS_M;
+    const float e2 = (float)E2;
+    const float sin_lat0 = origin->sin_latitude;
+    const float cos_lat0 = origin->cos_latitude;
+    const float eccentricity0 = origin->eccentricity;
+    int32_t dlon = longitude - origin->longitude;
+    float x, x2, sin_half_dlat, cos_half_dlat, sin_half_dlon, cos_half_dlon;
+    float sin_dlat, versine_dlat, delta_sin, delta_cos, sin_lat, cos_lat;
+    float eccentricity, slope, delta_radius, radius, dx, dy, dz;
+
+    dlon -= ((dlon > 180000000) - (dlon < -180000000)) * 360000000;
+
+    /* Polynomials are accurate to single precision on [-pi/2, pi/2] */
+    x = (float)(latitude - origin->latitude) * half_radians;
+    x2 = x * x;
+    sin_half_dlat = x * (1.0f - x2 * (1.0f / 6.0f) * (1.0f - x2 * (1.0f / 20.0f) *
+                    (1.0f - x2 * (1.0f / 42.0f) * (1.0f - x2 * (1.0f / 72.0f) *
+                    (1.0f - x2 * (1.0f / 110.0f))))));
+    cos_half_dlat = 1.0f - x2 * 0.5f * (1.0f - x2 * (1.0f / 12.0f) *
+                    (1.0f - x2 * (1.0f / 30.0f) * (1.0f - x2 * (1.0f / 56.0f) *
+                    (1.0f - x2 * (1.0f / 90.0f) * (1.0f - x2 * (1.0f / 132.0f))))));
+
+    x = (float)dlon * half_radians;
+    x2 = x * x;
+    sin_half_dlon = x * (1.0f - x2 * (1.0f / 6.0f) * (1.0f - x2 * (1.0f / 20.0f) *
+                    (1.0f - x2 * (1.0f / 42.0f) * (1.0f - x2 * (1.0f / 72.0f) *
+                    (1.0f - x2 * (1.0f / 110.0f))))));
+    cos_half_dlon = 1.0f - x2 * 0.5f * (1.0f - x2 * (1.0f / 12.0f) *
+                    (1.0f - x2 * (1.0f / 30.0f) * (1.0f - x2 * (1.0f / 56.0f) *
+                    (1.0f - x2 * (1.0f / 90.0f) * (1.0f - x2 * (1.0f / 132.0f))))));
+
+    sin_dlat = 2.0f * sin_half_dlat * cos_half_dlat;
+    versine_dlat = 2.0f * sin_half_dlat * sin_half_dlat;
+    delta_sin = cos_lat0 * sin_dlat - sin_lat0 * versine_dlat;
+    delta_cos = -sin_lat0 * sin_dlat - cos_lat0 * versine_dlat;
+    sin_lat = sin_lat0 + delta_sin;
+    cos_lat = cos_lat0 + delta_cos;
+
+    /* The cubic term of the series is below single precision */
+    eccentricity = e2 * delta_sin * (sin_lat + sin_lat0);
+    x = eccentricity0 + eccentricity;
+    slope = 0.5f + 0.375f * (x + eccentricity0) +
+            0.3125f * (x * x + x * eccentricity0 + eccentricity0 * eccentricity0);
+    delta_radius = a * eccentricity * slope;
+
+    radius = (origin->radius + origin->height + delta_radius + height) * cos_lat;
+
+    dx = (delta_radius + height) * cos_lat + (origin->radius + origin->height) * delta_cos -
+         2.0f * radius * sin_half_dlon * sin_half_dlon;
+    dy = 2.0f * radius * sin_half_dlon * cos_half_dlon;
+    dz = (delta_radius * (1.0f - e2) + height) * sin_lat +
+         (origin->radius * (1.0f - e2) + origin->height) * delta_sin;
+
+    *east = dy;
+    *north = cos_lat0 * dz - sin_lat0 * dx;
+    *up = cos_lat0 * dx + sin_lat0 * dz;
+}
+
+void gps_project_enu_float(const struct gps_project_origin *origin,
+                           float *restrict east,
+                           float *restrict north,
+                           float *restrict up,
+                           const int32_t *restrict latitude,
+                           const int32_t *restrict longitude,
+                           const int32_t *restrict altitude,
+                           size_t n)
+{
+    assert(origin != NULL);
+    assert((east != NULL) || (0 == n));
+    assert((north != NULL) || (0 == n));
+    assert((up != NULL) || (0 == n));
+    assert((latitude != NULL) || (0 == n));
+    assert((longitude != NULL) || (0 == n));
+
+    struct origin_float o;
+    size_t i;
+
+    o.latitude = origin->latitude;
+    o.longitude = origin->longitude;
+    o.altitude = origin->altitude;
+    o.sin_latitude = (float)(origin->sin_latitude * Q40_TO_REAL);
+    o.cos_latitude = (float)(origin->cos_latitude * Q40_TO_REAL);
+    o.eccentricity = (float)(origin->eccentricity * Q40_TO_REAL);
+    o.radius = (float)(origin->radius / 1000.0);
+    o.height = (float)(origin->altitude / 1000.0);
+
+    /* Separate loops keep the test for altitudes out of the loop body */
+    if (NULL == altitude)
+    {
+        for (i = 0; i < n; ++i)
+        {
+            project_enu_float(&o, &east[i], &north[i], &up[i], latitude[i], longitude[i], 0.0f);
+        }
+    }
+    else
+    {
+        for (i = 0; i < n; ++i)
+        {
+            project_enu_float(&o, &east[i], &north[i], &up[i], latitude[i], longitude[i],
+                              (float)(altitude[i] - o.altitude) * 0.001f);
+        }
+    }
+}
+
+int gps_project_utm_zone(int32_t latitude, int32_t longitude)
+{
+    int zone = (int)(((int64_t)longitude + 180000000) / 6000000) + 1;
+
+    if (zone > 60) zone = 60;
+    if (zone < 1) zone = 1;
+
+    /* Southern Norway is part of zone 32 */
+    if ((latitude >= 56000000) && (latitude < 64000000) &&
+        (longitude >= 3000000) && (longitude < 12000000))
+    {
+        return 32;
+    }
+
+    /* Svalbard only uses the odd zones 31 to 37 */
+    if ((latitude >= 72000000) && (longitude >= 0) && (longitude < 42000000))
+    {
+        if (longitude < 9000000) return 31;
+        if (longitude < 21000000) return 33;
+        if (longitude < 33000000) return 35;
+        return 37;
+    }
+
+    return zone;
+}
+
+static int32_t central_meridian(int zone)
+{
+    return (int32_t)(zone * 6 - 183) * 1000000;
+}
+
+/* USGS series (Snyder, Map Projections - A Working Manual, equations 8-9
+ * and 8-10). The usual form divides by cos(lat) through tan(lat), which is
+ * multiplied out here so that only products of sin(lat), cos(lat) and the
+ * longitude difference L in radians are left.
+ */
+static void project_utm(int64_t *easting, int64_t *northing,
+                        int32_t latitude, int64_t dlon)
+{
+    int64_t phi = gps_fixed_radians_q40(latitude);
+    int64_t l = gps_fixed_radians_q40(dlon);
+    int64_t s = gps_fixed_sin_half_q40(2 * (int64_t)latitude);
+    int64_t c = gps_fixed_cos_half_q40(2 * (int64_t)latitude);
+    int64_t s2 = mul(s, s);
+    int64_t c2 = mul(c, c);
+    int64_t s4 = mul(s2, s2);
+    int64_t c3 = mul(c2, c);
+    int64_t c5 = mul(c3, c2);
+    int64_t c7 = mul(c5, c2);
+    int64_t l2 = mul(l, l);
+    int64_t l4 = mul(l2, l2);
+    int64_t sin2 = 2 * mul(s, c);
+    int64_t cos2 = c2 - s2;
+    int64_t sin4 = 2 * mul(sin2, cos2);
+    int64_t cos4 = GPS_FIXED_Q40_ONE - 2 * mul(sin2, sin2);
+    int64_t sin6 = mul(sin4, cos2) + mul(cos4, sin2);
+    int64_t arc, radius, t, x, y;
+
+    /* Meridian arc from the equator */
+    arc = mul(ARC_A_MM, phi) - mul(ARC_B_MM, sin2) + mul(ARC_C_MM, sin4) - mul(ARC_D_MM, sin6);
+
+    /* k0 N */
+    radius = mul(mul(SEMI_MAJOR_AXIS_MM, inverse_root(mul(E2_Q40, s2))), UTM_K0_Q40);
+
+    /* x = k0 N (A + (1 - T + C) A^3 / 6 + (5 - 18 T + T^2 + 72 C - 58 e'^2) A^5 / 120) */
+    x = mul(l, c);
+    t = c3 - mul(s2, c) + mul(EP2_Q40, c5);
+    x += mul(mul(l2, l), t) / 6;
+    t = 5 * c5 - 18 * mul(s2, c3) + mul(s4, c) + 72 * mul(EP2_Q40, c7) - 58 * mul(EP2_Q40, c5);
+    x += mul(mul(l4, l), t) / 120;
+
+    /* y = k0 (M + N tan(lat) (A^2 / 2 + (5 - T + 9 C + 4 C^2) A^4 / 24
+     *                         + (61 - 58 T + T^2 + 600 C - 330 e'^2) A^6 / 720))
+     */
+    y = mul(l2, c) / 2;
+    t = 5 * c3 - mul(s2, c) + 9 * mul(EP2_Q40, c5) + 4 * mul(mul(EP2_Q40, EP2_Q40), c7);
+    y += mul(l4, t) / 24;
+    t = 61 * c5 - 58 * mul(s2, c3) + mul(s4, c) + 600 * mul(EP2_Q40, c7) - 330 * mul(EP2_Q40, c5);
+    y += mul(mul(l4, l2), t) / 720;
+
+    *easting = UTM_FALSE_EASTING_MM + mul(radius, x);
+    *northing = mul(arc, UTM_K0_Q40) + mul(mul(radius, s), y);
+    if (latitude < 0) *northing += UTM_FALSE_NORTHING_MM;
+}
+
+void gps_project_utm(int zone,
+                     int64_t *easting,
+                     int64_t *northing,
+                     const int32_t *latitude,
+                     const int32_t *longitude,
+                     size_t n)
+{
+    assert((zone >= 1) && (zone <= 60));
+    assert((easting != NULL) || (0 == n));
+    assert((northing != NULL) || (0 == n));
+    assert((latitude != NULL) || (0 == n));
+    assert((longitude != NULL) || (0 == n));
+
+    int32_t meridian = central_meridian(zone);
+    size_t i;
+
+    for (i = 0; i < n; ++i)
+    {
+        int64_t dlon = gps_fixed_wrap_longitude((int64_t)longitude[i] - meridian);
+
+        project_utm(&easting[i], &northing[i], latitude[i], dlon);
+    }
+}
+
+void gps_project_utm_double(int zone,
+                            double *restrict easting,
+                            double *restrict northing,
+                            const int32_t *restrict latitude,
+                            const int32_t *restrict longitude,
+                            size_t n)
+{
+    assert((zone >= 1) && (zone <= 60));
+    assert((easting != NULL) || (0 == n));
+    assert((northing != NULL) || (0 == n));
+    assert((latitude != NULL) || (0 == n));
+    assert((longitude != NULL) || (0 == n));
+
+    const int32_t meridian = central_meridian(zone);
+    size_t i;
+
+    /* Same as project_utm(), with the loop body kept free of branches and
+     * calls so that it vectorizes.
+     */
+    for (i = 0; i < n; ++i)
+    {
+        int32_t dlon = longitude[i] - meridian;
+        double x, x2, sin_half, cos_half, s, c, s2, c2, s4, c3, c5, c7, l, l2, l4;
+        double sin2, cos2, sin4, cos4, sin6, arc, radius, t, e, w;
+
+        dlon -= ((dlon > 180000000) - (dlon < -180000000)) * 360000000;
+
+        /* Polynomials are accurate to double precision on [-pi/4, pi/4] */
+        x = (double)latitude[i] * HALF_RADIANS_PER_MICRODEGREE;
+        x2 = x * x;
+        sin_half = x * (1.0 - x2 / 6.0 * (1.0 - x2 / 20.0 * (1.0 - x2 / 42.0 *
+                   (1.0 - x2 / 72.0 * (1.0 - x2 / 110.0 * (1.0 - x2 / 156.0 *
+                   (1.0 - x2 / 210.0)))))));
+        cos_half = 1.0 - x2 / 2.0 * (1.0 - x2 / 12.0 * (1.0 - x2 / 30.0 *
+                   (1.0 - x2 / 56.0 * (1.0 - x2 / 90.0 * (1.0 - x2 / 132.0 *
+                   (1.0 - x2 / 182.0 * (1.0 - x2 / 240.0)))))));
+
+        s = 2.0 * sin_half * cos_half;
+        c = 1.0 - 2.0 * sin_half * sin_half;
+        s2 = s * s;
+        c2 = c * c;
+        s4 = s2 * s2;
+        c3 = c2 * c;
+        c5 = c3 * c2;
+        c7 = c5 * c2;
+        l = (double)dlon * (2.0 * HALF_RADIANS_PER_MICRODEGREE);
+        l2 = l * l;
+        l4 = l2 * l2;
+        sin2 = 2.0 * s * c;
+        cos2 = c2 - s2;
+        sin4 = 2.0 * sin2 * cos2;
+        cos4 = 1.0 - 2.0 * sin2 * sin2;
+        sin6 = sin4 * cos2 + cos4 * sin2;
+
+        arc = ARC_A_M * 2.0 * x - ARC_B_M * sin2 + ARC_C_M * sin4 - ARC_D_M * sin6;
+
+        w = E2 * s2;
+        radius = UTM_K0 * SEMI_MAJOR_AXIS_M *
+                 (1.0 + w * (0.5 + w * (0.375 + w * (0.3125 + w * 0.2734375))));
+
+        e = l * c;
+        t = c3 - s2 * c + EP2 * c5;
+        e += l2 * l * t / 6.0;
+        t = 5.0 * c5 - 18.0 * s2 * c3 + s4 * c + 72.0 * EP2 * c7 - 58.0 * EP2 * c5;
+        e += l4 * l * t / 120.0;
+
+        w = l2 * c / 2.0;
+        t = 5.0 * c3 - s2 * c + 9.0 * EP2 * c5 + 4.0 * EP2 * EP2 * c7;
+        w += l4 * t / 24.0;
+        t = 61.0 * c5 - 58.0 * s2 * c3 + s4 * c + 600.0 * EP2 * c7 - 330.0 * EP2 * c5;
+        w += l4 * l2 * t / 720.0;
+
+        easting[i] = 500000.0 + radius * e;
+        northing[i] = UTM_K0 * arc + radius * s * w + ((latitude[i] < 0) ? 10000000.0 : 0.0);
+    }
+}
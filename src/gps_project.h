@@ -0,0 +1,215 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Jacob McGladdery
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/**
+ * @file gps_project.h
+ * @brief Batch projection of TPV coordinates to local ENU and UTM.
+ *
+ * Trackers and fusion filters usually work in meters on a plane rather than
+ * in degrees. These functions convert arrays of coordinates at a time, laid
+ * out as separate latitude, longitude and altitude arrays so that the loops
+ * stay simple enough for the compiler to vectorize.
+ *
+ * Each projection comes in two flavors. The fixed-point functions use
+ * integer arithmetic only and report meters times GPS_VALUE_FACTOR, like
+ * the rest of the library. The floating point functions report meters and
+ * are written to be vectorized on targets with a SIMD unit.
+ *
+ * Both use the WGS84 ellipsoid. Altitudes are taken as heights above the
+ * ellipsoid; NMEA altitudes are relative to mean sea level, which only
+ * shifts the up axis by the local geoid separation.
+ */
+
+#ifndef _GPS_PROJECT_H_
+#define _GPS_PROJECT_H_
+
+#include "gps.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Origin of a local east, north, up frame.
+ *
+ * Holds the values derived from the origin coordinates that every
+ * projected point needs.
+ */
+struct gps_project_origin
+{
+    /** Latitude of the origin, degrees times GPS_LAT_LON_FACTOR */
+    int32_t latitude;
+
+    /** Longitude of the origin, degrees times GPS_LAT_LON_FACTOR */
+    int32_t longitude;
+
+    /** Height of the origin, meters times GPS_VALUE_FACTOR */
+    int32_t altitude;
+
+    /** sin(latitude) in Q40 */
+    int64_t sin_latitude;
+
+    /** cos(latitude) in Q40 */
+    int64_t cos_latitude;
+
+    /** e^2 sin^2(latitude) in Q40 */
+    int64_t eccentricity;
+
+    /** Prime vertical radius of curvature, millimeters */
+    int64_t radius;
+};
+
+/**
+ * @brief Initializes a local frame around an origin.
+ *
+ * @param[out] origin The frame to initialize
+ * @param[in] latitude Latitude of the origin
+ * @param[in] longitude Longitude of the origin
+ * @param[in] altitude Height of the origin
+ */
+void gps_project_origin_init(struct gps_project_origin *origin,
+                             int32_t latitude,
+                             int32_t longitude,
+                             int32_t altitude);
+
+/**
+ * @brief Projects points to a local east, north, up frame with integer
+ *        arithmetic.
+ *
+ * The conversion is exact apart from rounding, there is no flat Earth
+ * approximation involved. The error is within 1 centimeter for points up to
+ * 1000 km from the origin, beyond which the results may overflow.
+ *
+ * @param[in] origin The local frame
+ * @param[out] east East offsets, meters times GPS_VALUE_FACTOR
+ * @param[out] north North offsets, meters times GPS_VALUE_FACTOR
+ * @param[out] up Up offsets, meters times GPS_VALUE_FACTOR
+ * @param[in] latitude Latitudes of the points
+ * @param[in] longitude Longitudes of the points
+ * @param[in] altitude Heights of the points or NULL to use the height of the
+ *                     origin for all of them
+ * @param[in] n Number of points
+ */
+void gps_project_enu(const struct gps_project_origin *origin,
+                     int32_t *east,
+                     int32_t *north,
+                     int32_t *up,
+                     const int32_t *latitude,
+                     const int32_t *longitude,
+                     const int32_t *altitude,
+                     size_t n);
+
+/**
+ * @brief Projects points to a local east, north, up frame with single
+ *        precision floating point arithmetic.
+ *
+ * Works on differences to the origin throughout, so single precision is
+ * enough. The error is within 1 centimeter plus 0.3 parts per million of
+ * the distance for points up to 1000 km from the origin.
+ *
+ * @param[in] origin The local frame
+ * @param[out] east East offsets, meters
+ * @param[out] north North offsets, meters
+ * @param[out] up Up offsets, meters
+ * @param[in] latitude Latitudes of the points
+ * @param[in] longitude Longitudes of the points
+ * @param[in] altitude Heights of the points or NULL to use the height of the
+ *                     origin for all of them
+ * @param[in] n Number of points
+ */
+void gps_project_enu_float(const struct gps_project_origin *origin,
+                           float *east,
+                           float *north,
+                           float *up,
+                           const int32_t *latitude,
+                           const int32_t *longitude,
+                           const int32_t *altitude,
+                           size_t n);
+
+/**
+ * @brief Returns the UTM zone containing a point.
+ *
+ * Includes the exceptions around southern Norway and Svalbard.
+ *
+ * @param[in] latitude Latitude of the point
+ * @param[in] longitude Longitude of the point
+ * @return The zone number, from 1 to 60
+ */
+int gps_project_utm_zone(int32_t latitude, int32_t longitude);
+
+/**
+ * @brief Projects points to UTM with integer arithmetic.
+ *
+ * All points are projected to the same zone, points south of the equator
+ * use the southern false northing. Uses the USGS series expansion, which is
+ * within 5 millimeters of the exact projection inside the zone and stays
+ * within a few centimeters up to 3 degrees beyond its edges.
+ *
+ * @param[in] zone The UTM zone, from 1 to 60
+ * @param[out] easting Eastings, meters times GPS_VALUE_FACTOR
+ * @param[out] northing Northings, meters times GPS_VALUE_FACTOR
+ * @param[in] latitude Latitudes of the points
+ * @param[in] longitude Longitudes of the points
+ * @param[in] n Number of points
+ * @pre Latitudes are within the UTM limits of 80 degrees south and 84
+ *      degrees north
+ */
+void gps_project_utm(int zone,
+                     int64_t *easting,
+                     int64_t *northing,
+                     const int32_t *latitude,
+                     const int32_t *longitude,
+                     size_t n);
+
+/**
+ * @brief Projects points to UTM with double precision floating point
+ *        arithmetic.
+ *
+ * Same as gps_project_utm(), but reports meters. Double precision is used
+ * because northings need more digits than single precision offers.
+ *
+ * @param[in] zone The UTM zone, from 1 to 60
+ * @param[out] easting Eastings, meters
+ * @param[out] northing Northings, meters
+ * @param[in] latitude Latitudes of the points
+ * @param[in] longitude Longitudes of the points
+ * @param[in] n Number of points
+ * @pre Latitudes are within the UTM limits of 80 degrees south and 84
+ *      degrees north
+ */
+void gps_project_utm_double(int zone,
+                            double *easting,
+                            double *northing,
+                            const int32_t *latitude,
+                            const int32_t *longitude,
+                            size_t n);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _GPS_PROJECT_H_ */
@@ -0,0 +1,234 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Jacob McGladdery
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include "gps_recorder.h"
+
+#include <assert.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+
+#define NS_PER_S (1000000000)
+
+/* Each record is a 16 bit length, a 64 bit arrival time, then the sentence,
+ * in native byte order and without alignment. A record which does not fit
+ * before the end of the arena goes to its start instead, and a length of
+ * WRAP_MARK is left where it would have been. With fewer than
+ * GPS_RECORDER_HEADER_SIZE bytes left, the wrap goes without saying.
+ */
+#define WRAP_MARK (0xFFFF)
+
+/* The start of the record at or after offset */
+static size_t record_at(const struct gps_recorder *recorder, size_t offset)
+{
+    uint16_t length;
+
+    if (recorder->size - offset < GPS_RECORDER_HEADER_SIZE) return 0;
+
+    memcpy(&length, recorder->arena + offset, sizeof(length));
+    return (WRAP_MARK == length) ? 0 : offset;
+}
+
+/* Reads the header of the record at offset and returns the offset after it */
+static size_t read_record(const struct gps_recorder *recorder, size_t offset, uint16_t *length, int64_t *time)
+{
+    memcpy(length, recorder->arena + offset, sizeof(*length));
+    memcpy(time, recorder->arena + offset + sizeof(*length), sizeof(*time));
+
+    return offset + GPS_RECORDER_HEADER_SIZE + *length;
+}
+
+void gps_recorder_init(struct gps_recorder *recorder, char *arena, size_t size)
+{
+    assert(recorder != NULL);
+    assert((arena != NULL) || (0 == size));
+
+    recorder->arena = arena;
+    recorder->size = size;
+    recorder->head = 0;
+    recorder->tail = 0;
+    recorder->count = 0;
+    recorder->stored = 0;
+    recorder->overwritten = 0;
+}
+
+int gps_recorder_store(struct gps_recorder *recorder, const char *nmea, size_t size, int64_t time)
+{
+    assert(recorder != NULL);
+    assert(nmea != NULL);
+
+    size_t need = GPS_RECORDER_HEADER_SIZE + size;
+    size_t head = recorder->head;
+    size_t pos;
+    uint16_t length = (uint16_t)size;
+
+    if ((size > GPS_RECORDER_MAX_SENTENCE) || (need > recorder->size)) return GPS_ERROR_OVERFLOW;
+
+    /* Either the bytes from the head on are overwritten, or those from the
+     * head to the end and from the start on
+     */
+    pos = (head + need <= recorder->size) ? head : 0;
+
+    /* Drop the oldest records in the way */
+    while (recorder->count > 0)
+    {
+        size_t tail = recorder->tail;
+        uint16_t dropped;
+        int64_t ignored;
+
+        if (pos == head)
+        {
+            if ((tail < head) || (tail >= head + need)) break;
+        }
+        else if ((tail < head) && (tail >= need))
+        {
+            break;
+        }
+
+        tail = read_record(recorder, tail, &dropped, &ignored);
+        recorder->tail = record_at(recorder, tail);
+        recorder->count--;
+        recorder->overwritten++;
+    }
+
+    if (0 == recorder->count) recorder->tail = pos;
+    if ((pos != head) && (recorder->size - head >= GPS_RECORDER_HEADER_SIZE))
+    {
+        uint16_t mark = WRAP_MARK;
+
+        memcpy(recorder->arena + head, &mark, sizeof(mark));
+    }
+
+    memcpy(recorder->arena + pos, &length, sizeof(length));
+    memcpy(recorder->arena + pos + sizeof(length), &time, sizeof(time));
+    memcpy(recorder->arena + pos + GPS_RECORDER_HEADER_SIZE, nmea, size);
+
+    recorder->head = pos + need;
+    recorder->count++;
+    recorder->stored++;
+
+    return GPS_OK;
+}
+
+int gps_recorder_decode(struct gps_recorder *recorder,
+                        struct gps_tpv *tpv,
+                        const char *nmea,
+                        size_t size,
+                        int64_t time)
+{
+    assert(recorder != NULL);
+
+    int result = gps_decode_const(tpv, nmea, size);
+
+    /* Sentences the decoder has no parser for are kept if they are intact */
+    if ((GPS_OK == result) ||
+        ((GPS_ERROR_UNSUPPORTED == result) && (GPS_OK == gps_check_const(nmea, size))))
+    {
+        gps_recorder_store(recorder, nmea, size, time);
+    }
+
+    return result;
+}
+
+void gps_recorder_begin(const struct gps_recorder *recorder, struct gps_recorder_cursor *cursor)
+{
+    assert(recorder != NULL);
+    assert(cursor != NULL);
+
+    cursor->offset = recorder->tail;
+    cursor->remaining = recorder->count;
+}
+
+int gps_recorder_next(const struct gps_recorder *recorder,
+                      struct gps_recorder_cursor *cursor,
+                      const char **nmea,
+                      size_t *size,
+                      int64_t *time)
+{
+    assert(recorder != NULL);
+    assert(cursor != NULL);
+    assert(nmea != NULL);
+    assert(size != NULL);
+
+    size_t offset;
+    uint16_t length;
+    int64_t arrival;
+
+    if (0 == cursor->remaining) return GPS_ERROR_END;
+
+    offset = record_at(recorder, cursor->offset);
+    cursor->offset = read_record(recorder, offset, &length, &arrival);
+    cursor->remaining--;
+
+    *nmea = recorder->arena + offset + GPS_RECORDER_HEADER_SIZE;
+    *size = length;
+    if (time != NULL) *time = arrival;
+
+    return GPS_OK;
+}
+
+int gps_recorder_dump(const struct gps_recorder *recorder, const char *path)
+{
+    assert(recorder != NULL);
+    assert(path != NULL);
+
+    struct gps_recorder_cursor cursor;
+    char temp[FILENAME_MAX];
+    size_t length = strlen(path);
+    const char *nmea;
+    size_t size;
+    int64_t time;
+    FILE *file;
+    int ok;
+
+    if (length + sizeof(".tmp") > sizeof(temp)) return GPS_ERROR_OVERFLOW;
+    memcpy(temp, path, length);
+    memcpy(temp + length, ".tmp", sizeof(".tmp"));
+
+    file = fopen(temp, "wb");
+    if (NULL == file) return GPS_ERROR_IO;
+
+    gps_recorder_begin(recorder, &cursor);
+    while (GPS_OK == gps_recorder_next(recorder, &cursor, &nmea, &size, &time))
+    {
+        if (time < 0) time = 0;
+        fprintf(file, "%" PRId64 ".%09" PRId64 " ", time / NS_PER_S, time % NS_PER_S);
+        fwrite(nmea, 1, size, file);
+
+        /* Sentences stored without their line ending get one */
+        if ((0 == size) || (nmea[size - 1] != '\n')) fputs("\r\n", file);
+    }
+
+    ok = !ferror(file);
+    if (fclose(file) != 0) ok = 0;
+
+    /* Replaces the previous dump, if any, in one step */
+    if (!ok || (rename(temp, path) != 0))
+    {
+        remove(temp);
+        return GPS_ERROR_IO;
+    }
+
+    return GPS_OK;
+}
@@ -0,0 +1,187 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Jacob McGladdery
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/**
+ * @file gps_recorder.h
+ * @brief Flight recorder of the latest raw sentences in a fixed arena.
+ *
+ * A recorder keeps the sentences most recently received in a byte arena
+ * owned by the caller, so that the last minutes of raw NMEA are at hand
+ * when something goes wrong, without writing everything to flash. Each
+ * record is the sentence prefixed by its length and arrival time. Records
+ * are never split across the end of the arena, so storing one is a single
+ * copy, and reading one gives a pointer into the arena. Once the arena is
+ * full, the oldest records are overwritten.
+ *
+ * gps_recorder_decode() decodes a sentence and stores it only once its
+ * checksum has been verified. gps_recorder_dump() writes the records to a
+ * file in the log format gps_replay() paces by arrival time.
+ */
+
+#ifndef _GPS_RECORDER_H_
+#define _GPS_RECORDER_H_
+
+#include "gps.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define GPS_RECORDER_HEADER_SIZE (10)    /**< Bytes in front of each sentence in the arena */
+#define GPS_RECORDER_MAX_SENTENCE (4096) /**< The longest sentence stored */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Recorder state.
+ */
+struct gps_recorder
+{
+    char *arena;          /**< The arena, owned by the caller */
+    size_t size;          /**< Bytes in gps_recorder.arena */
+    size_t head;          /**< Where the next record goes */
+    size_t tail;          /**< Where the oldest record is */
+    size_t count;         /**< Records held */
+    uint32_t stored;      /**< Records stored in total */
+    uint32_t overwritten; /**< Records overwritten by newer ones */
+};
+
+/**
+ * @brief Position of a reader in a recorder.
+ */
+struct gps_recorder_cursor
+{
+    size_t offset;    /**< Where the next record is */
+    size_t remaining; /**< Records left to read */
+};
+
+/**
+ * @brief Initializes a recorder.
+ *
+ * @param[out] recorder The recorder to initialize.
+ * @param[in] arena Storage for the records. Its contents are overwritten.
+ * @param[in] size The number of bytes at @p arena.
+ *
+ * @pre The pointer @p recorder must not be NULL.
+ * @pre The pointer @p arena must not be NULL unless @p size is 0.
+ */
+void gps_recorder_init(struct gps_recorder *recorder, char *arena, size_t size);
+
+/**
+ * @brief Stores a sentence, overwriting the oldest ones if needed.
+ *
+ * @param[in,out] recorder The recorder.
+ * @param[in] nmea The sentence, with or without its line ending.
+ * @param[in] size The number of characters at @p nmea.
+ * @param[in] time The arrival time of the sentence in nanoseconds, such as
+ *            gps_latency_stamps.start.
+ * @return A result code.
+ * @retval GPS_OK The sentence was stored.
+ * @retval GPS_ERROR_OVERFLOW The sentence is longer than
+ *         GPS_RECORDER_MAX_SENTENCE or does not fit in the arena.
+ *
+ * @pre The pointers @p recorder and @p nmea must not be NULL.
+ */
+int gps_recorder_store(struct gps_recorder *recorder, const char *nmea, size_t size, int64_t time);
+
+/**
+ * @brief Decodes a sentence and stores it if it passes the checksum.
+ *
+ * Sentences the decoder does not support, such as GSV or proprietary ones,
+ * are stored as well when gps_check_const() finds them intact. Sentences
+ * with a bad header, checksum or footer are not stored.
+ *
+ * @param[in,out] recorder The recorder.
+ * @param[out] tpv The data structure where the decoded values will be stored.
+ * @param[in] nmea The sentence, which is only read.
+ * @param[in] size The number of characters at @p nmea.
+ * @param[in] time The arrival time of the sentence in nanoseconds.
+ * @return The result of gps_decode_const().
+ *
+ * @pre The pointers @p recorder, @p tpv and @p nmea must not be NULL.
+ */
+int gps_recorder_decode(struct gps_recorder *recorder,
+                        struct gps_tpv *tpv,
+                        const char *nmea,
+                        size_t size,
+                        int64_t time);
+
+/**
+ * @brief Positions a cursor on the oldest record.
+ *
+ * A cursor is valid until the next sentence is stored.
+ *
+ * @param[in] recorder The recorder.
+ * @param[out] cursor The cursor.
+ *
+ * @pre The pointers @p recorder and @p cursor must not be NULL.
+ */
+void gps_recorder_begin(const struct gps_recorder *recorder, struct gps_recorder_cursor *cursor);
+
+/**
+ * @brief Reads a record and moves the cursor to the next newer one.
+ *
+ * @param[in] recorder The recorder.
+ * @param[in,out] cursor The cursor.
+ * @param[out] nmea Receives a pointer to the sentence in the arena.
+ * @param[out] size Receives the number of characters of the sentence.
+ * @param[out] time Receives the arrival time of the sentence. May be NULL.
+ * @return A result code.
+ * @retval GPS_OK A record was read.
+ * @retval GPS_ERROR_END Every record has been read.
+ *
+ * @pre The pointers @p recorder, @p cursor, @p nmea and @p size must not be NULL.
+ */
+int gps_recorder_next(const struct gps_recorder *recorder,
+                      struct gps_recorder_cursor *cursor,
+                      const char **nmea,
+                      size_t *size,
+                      int64_t *time);
+
+/**
+ * @brief Writes every record to a file, oldest first.
+ *
+ * Each record becomes a line holding its arrival time in decimal seconds,
+ * a space, and the sentence, which gps_replay() reads with
+ * GPS_REPLAY_ARRIVAL_TIME. The lines are written to a temporary file next
+ * to @p path, which is then renamed to @p path, so a reader of @p path
+ * never sees a partial dump. Do not store sentences while this runs.
+ *
+ * @param[in] recorder The recorder.
+ * @param[in] path The file to write.
+ * @return A result code.
+ * @retval GPS_OK The file was written.
+ * @retval GPS_ERROR_OVERFLOW The path is too long.
+ * @retval GPS_ERROR_IO The file could not be written.
+ *
+ * @pre The pointers @p recorder and @p path must not be NULL.
+ */
+int gps_recorder_dump(const struct gps_recorder *recorder, const char *path);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _GPS_RECORDER_H_ */
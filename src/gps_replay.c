@@ -0,0 +1,246 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Jacob McGladdery
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "gps_replay.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define NS_PER_MS  (INT64_C(1000000))
+#define NS_PER_S   (INT64_C(1000000000))
+#define NS_PER_DAY (GPS_MS_PER_DAY * NS_PER_MS)
+
+/* Time part of a time stamp, "HH:MM:SS.SSS" */
+#define TIME_OFFSET (11)
+#define TIME_SIZE   (12)
+
+static int now_ns(int64_t *ns)
+{
+    struct timespec ts;
+
+    if (clock_gettime(CLOCK_MONOTONIC, &ts) < 0) return GPS_ERROR_IO;
+    *ns = (int64_t)ts.tv_sec * NS_PER_S + ts.tv_nsec;
+
+    return GPS_OK;
+}
+
+static int wait_until(int64_t deadline)
+{
+    struct timespec ts;
+    int result;
+
+    ts.tv_sec = (time_t)(deadline / NS_PER_S);
+    ts.tv_nsec = (long)(deadline % NS_PER_S);
+
+    do
+    {
+        result = clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL);
+    }
+    while (EINTR == result);
+
+    return (0 == result) ? GPS_OK : GPS_ERROR_IO;
+}
+
+/* Parses the arrival time in front of a line, "[0-9]+(\.[0-9]{1,9})?" and
+ * white space. Returns the number of characters to skip, or 0 if the line
+ * does not start with an arrival time.
+ */
+static size_t parse_arrival(const char *line, size_t length, int64_t *ns)
+{
+    int64_t seconds = 0;
+    int64_t fraction = 0;
+    int64_t factor = NS_PER_S;
+    size_t i = 0;
+
+    while ((i < length) && (line[i] >= '0') && (line[i] <= '9') && (i < 12))
+    {
+        seconds = seconds * 10 + (line[i++] - '0');
+    }
+    if (0 == i) return 0;
+
+    if ((i < length) && ('.' == line[i]))
+    {
+        ++i;
+        while ((i < length) && (line[i] >= '0') && (line[i] <= '9'))
+        {
+            if (factor > 1)
+            {
+                factor /= 10;
+                fraction += (line[i] - '0') * factor;
+            }
+            ++i;
+        }
+    }
+
+    if ((i == length) || ((line[i] != ' ') && (line[i] != '\t'))) return 0;
+    while ((i < length) && ((' ' == line[i]) || ('\t' == line[i]))) ++i;
+
+    *ns = seconds * NS_PER_S + fraction;
+    return i;
+}
+
+int gps_replay(const char *data, size_t size, int pacing, uint32_t speed,
+               gps_replay_write_function output, void *context, struct gps_replay_stats *stats)
+{
+    assert(data != NULL);
+    assert(output != NULL);
+
+    struct gps_replay_stats local;
+    struct gps_tpv state;
+    const char *end = data + size;
+    int64_t first = 0;
+    int64_t last = 0;
+    int64_t start = 0;
+    int64_t unwrap = 0;
+    int64_t now;
+    int timed = 0;
+    int result;
+
+    if (NULL == stats) stats = &local;
+    memset(stats, 0, sizeof(*stats));
+    gps_init_tpv(&state);
+
+    while (data < end)
+    {
+        const char *line = data;
+        const char *eol = memchr(line, '\n', (size_t)(end - line));
+        size_t length;
+        int64_t time = 0;
+        int has_time = 0;
+
+        data = (NULL == eol) ? end : eol + 1;
+        length = (size_t)(data - line);
+
+        if (GPS_REPLAY_ARRIVAL_TIME == pacing)
+        {
+            size_t skip = parse_arrival(line, length, &time);
+
+            if (0 == skip)
+            {
+                stats->skipped++;
+                continue;
+            }
+            line += skip;
+            length -= skip;
+            has_time = 1;
+        }
+        else
+        {
+            const char *header = memchr(line, '$', length);
+            struct gps_tpv next = state;
+
+            /* A sentence sets the time when it changes the time of day */
+            if ((header != NULL) &&
+                (gps_decode_const(&next, header, length - (size_t)(header - line)) == GPS_OK) &&
+                (memcmp(next.time + TIME_OFFSET, state.time + TIME_OFFSET, TIME_SIZE) != 0))
+            {
+                time = (gps_time_to_ms(next.time) % GPS_MS_PER_DAY) * NS_PER_MS + unwrap;
+                if (timed && (time < last - NS_PER_DAY / 2))
+                {
+                    unwrap += NS_PER_DAY;
+                    time += NS_PER_DAY;
+                }
+                has_time = 1;
+            }
+            state = next;
+        }
+
+        if (has_time)
+        {
+            result = now_ns(&now);
+            if (result != GPS_OK) return result;
+
+            if (!timed)
+            {
+                first = time;
+                start = now;
+                timed = 1;
+            }
+            else if (speed > 0)
+            {
+                int64_t deadline = start + (time - first) / (int64_t)speed;
+                int64_t late;
+
+                if (deadline > now)
+                {
+                    result = wait_until(deadline);
+                    if (result != GPS_OK) return result;
+                    result = now_ns(&now);
+                    if (result != GPS_OK) return result;
+                }
+
+                late = now - deadline;
+                if (late < 0) late = 0;
+                stats->deadlines++;
+                stats->late_total_ns += late;
+                if (late > stats->late_max_ns) stats->late_max_ns = late;
+            }
+            last = time;
+        }
+
+        result = output(context, line, length);
+        if (result != 0) return result;
+        stats->lines++;
+    }
+
+    if (timed)
+    {
+        result = now_ns(&now);
+        if (result != GPS_OK) return result;
+
+        stats->span_ns = last - first;
+        stats->elapsed_ns = now - start;
+    }
+
+    return GPS_OK;
+}
+
+int gps_replay_write_fd(void *context, const void *data, size_t size)
+{
+    assert(context != NULL);
+    assert(data != NULL);
+
+    const char *p = data;
+    int fd = *(const int *)context;
+
+    while (size > 0)
+    {
+        ssize_t count = write(fd, p, size);
+
+        if (count < 0)
+        {
+            if (EINTR == errno) continue;
+            return GPS_ERROR_IO;
+        }
+        p += count;
+        size -= (size_t)count;
+    }
+
+    return GPS_OK;
+}
@@ -0,0 +1,130 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Jacob McGladdery
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/**
+ * @file gps_replay.h
+ * @brief Replays a recorded NMEA log with its original timing.
+ *
+ * Every line of the log is written out unchanged, including sentences the
+ * decoder does not support and ones with bad checksums, so a field incident
+ * is reproduced exactly. Lines are paced either by the fix times decoded
+ * from the log or by arrival times recorded in front of each line, and the
+ * pace may be sped up for soak tests.
+ *
+ * Lines are scheduled against absolute deadlines on CLOCK_MONOTONIC with
+ * clock_nanosleep(), so time spent writing and waking up late does not add
+ * up over a long replay. How late each deadline was met is reported in
+ * gps_replay_stats.
+ *
+ * This module requires POSIX timers and is only built when clock_nanosleep
+ * is found.
+ */
+
+#ifndef _GPS_REPLAY_H_
+#define _GPS_REPLAY_H_
+
+#include "gps.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Pacing */
+#define GPS_REPLAY_FIX_TIME     (0) /**< Pace lines by the fix times decoded from them */
+#define GPS_REPLAY_ARRIVAL_TIME (1) /**< Pace lines by a time in seconds in front of each */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Function receiving each replayed line.
+ *
+ * @param[in] context The user pointer given to gps_replay().
+ * @param[in] data The line, including its line ending.
+ * @param[in] size The number of characters in @p data.
+ * @return Zero on success, any other value stops the replay and is
+ *         returned by gps_replay().
+ */
+typedef int (*gps_replay_write_function)(void *context, const void *data, size_t size);
+
+/**
+ * @brief Statistics of a replay.
+ */
+struct gps_replay_stats
+{
+    uint32_t lines;        /**< Lines written */
+    uint32_t skipped;      /**< Lines without an arrival time, which were not written */
+    uint32_t deadlines;    /**< Times the replay waited for the next time in the log */
+    int64_t span_ns;       /**< Log time from the first line to the last */
+    int64_t elapsed_ns;    /**< Wall time from the first line to the last */
+    int64_t late_total_ns; /**< Sum over all deadlines of how late they were met */
+    int64_t late_max_ns;   /**< How late the latest deadline was met */
+};
+
+/**
+ * @brief Replays a log.
+ *
+ * Blocks until every line has been written. With GPS_REPLAY_FIX_TIME, a line
+ * which does not change the fix time is written right after the previous
+ * one. Fix times which go back by more than half a day are taken to have
+ * crossed midnight. With GPS_REPLAY_ARRIVAL_TIME, each line starts with its
+ * arrival time as decimal seconds from any origin, followed by white space,
+ * which is not written.
+ *
+ * @param[in] data The log, which is only read.
+ * @param[in] size The number of characters in @p data.
+ * @param[in] pacing GPS_REPLAY_FIX_TIME or GPS_REPLAY_ARRIVAL_TIME.
+ * @param[in] speed How many times faster than recorded to replay, or 0 to
+ *            write every line without waiting.
+ * @param[in] output The function receiving each line.
+ * @param[in] context User pointer passed to @p output.
+ * @param[out] stats The statistics of the replay. May be NULL.
+ * @return A result code indicating what happened.
+ * @retval GPS_OK If every line was written.
+ * @retval GPS_ERROR_IO If the clock failed.
+ *
+ * @pre The pointers @p data and @p output must not be NULL.
+ */
+int gps_replay(const char *data, size_t size, int pacing, uint32_t speed,
+               gps_replay_write_function output, void *context, struct gps_replay_stats *stats);
+
+/**
+ * @brief Writes a line to a file descriptor, such as a pipe or pty.
+ *
+ * For use as the write function of gps_replay(), with a pointer to the file
+ * descriptor as the context.
+ *
+ * @param[in] context Pointer to the file descriptor.
+ * @param[in] data The line.
+ * @param[in] size The number of characters in @p data.
+ * @retval GPS_OK If the whole line was written.
+ * @retval GPS_ERROR_IO If writing failed.
+ */
+int gps_replay_write_fd(void *context, const void *data, size_t size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
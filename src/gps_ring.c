@@ -0,0 +1,126 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Jacob McGladdery
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include "gps_ring.h"
+
+#include <assert.h>
+#include <string.h>
+
+/* Returns the offset from the index from of the first c within the next count
+ * characters of the ring, or count if there is none
+ */
+static size_t ring_find(const struct gps_ring *ring, size_t from, size_t count, char c)
+{
+    size_t first = ring->size - from;
+    const char *found;
+
+    if (first > count) first = count;
+    found = memchr(ring->base + from, c, first);
+    if (found) return (size_t)(found - (ring->base + from));
+
+    found = memchr(ring->base, c, count - first);
+    if (found) return first + (size_t)(found - ring->base);
+
+    return count;
+}
+
+static void ring_advance(struct gps_ring *ring, size_t count)
+{
+    ring->read += count;
+    if (ring->read >= ring->size) ring->read -= ring->size;
+}
+
+void gps_ring_init(struct gps_ring *ring, const char *base, size_t size, size_t read)
+{
+    assert(ring != NULL);
+    assert(base != NULL);
+    assert(read < size);
+
+    ring->base = base;
+    ring->size = size;
+    ring->read = read;
+}
+
+int gps_ring_decode(struct gps_ring *ring, size_t write, struct gps_tpv *tpv)
+{
+    assert(ring != NULL);
+    assert(tpv != NULL);
+    assert(write < ring->size);
+
+    char line[GPS_RING_SENTENCE_SIZE];
+    size_t available;
+    size_t limit;
+    size_t footer;
+    size_t length;
+    size_t next;
+    size_t from;
+    size_t first;
+
+    available = (write >= ring->read) ? write - ring->read : write + ring->size - ring->read;
+
+    /* Drop anything before the header */
+    next = ring_find(ring, ring->read, available, '$');
+    ring_advance(ring, next);
+    available -= next;
+    if (0 == available) return GPS_ERROR_END;
+
+    /* Look for the footer, but no further than the longest sentence */
+    limit = (available < GPS_RING_SENTENCE_SIZE) ? available : GPS_RING_SENTENCE_SIZE;
+    footer = ring_find(ring, ring->read, limit, '\n');
+    length = (footer < limit) ? footer + 1 : limit;
+
+    /* A second header before the footer means this sentence was cut short */
+    from = ring->read + 1;
+    if (from == ring->size) from = 0;
+    next = 1 + ring_find(ring, from, length - 1, '$');
+    if (next < length)
+    {
+        ring_advance(ring, next);
+        return GPS_ERROR_TRUNCATED;
+    }
+
+    if (footer == limit)
+    {
+        if (limit < GPS_RING_SENTENCE_SIZE) return GPS_ERROR_END;
+
+        ring_advance(ring, 1);
+        return GPS_ERROR_OVERFLOW;
+    }
+
+    /* Decode in place unless the sentence wraps around the end */
+    first = ring->size - ring->read;
+    if (length <= first)
+    {
+        const char *sentence = ring->base + ring->read;
+
+        ring_advance(ring, length);
+        return gps_decode_const(tpv, sentence, length);
+    }
+
+    memcpy(line, ring->base + ring->read, first);
+    memcpy(line + first, ring->base, length - first);
+    ring_advance(ring, length);
+
+    return gps_decode_const(tpv, line, length);
+}
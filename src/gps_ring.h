@@ -0,0 +1,117 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Jacob McGladdery
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/**
+ * @file gps_ring.h
+ * @brief Decoding straight out of a DMA circular receive buffer.
+ *
+ * On bare metal targets a UART is commonly drained by a DMA channel in
+ * circular mode, which writes received characters into a fixed buffer and
+ * wraps around at its end. The application only learns the DMA write index,
+ * usually from the remaining transfer count. gps_ring_decode() finds
+ * complete sentences between the read and write indices and decodes them
+ * where the DMA left them, with gps_decode_const(), so characters are
+ * neither copied out first nor NUL terminated in place.
+ *
+ * The buffer is only ever read. A sentence which wraps around the end of the
+ * buffer is the one exception to decoding in place: its two halves are
+ * joined in a GPS_RING_SENTENCE_SIZE byte buffer on the stack.
+ *
+ * The ring cannot tell when the DMA has lapped the reader, so the caller
+ * must drain it at least once per buffer length of received characters. On
+ * targets with a data cache, the received region must also be invalidated
+ * before calling gps_ring_decode().
+ */
+
+#ifndef _GPS_RING_H_
+#define _GPS_RING_H_
+
+#include "gps.h"
+
+#include <stddef.h>
+
+#define GPS_RING_SENTENCE_SIZE (128) /**< The longest sentence accepted, from '$' to "\r\n" */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Read side of a circular receive buffer.
+ */
+struct gps_ring
+{
+    const char *base; /**< First character of the buffer */
+    size_t size;      /**< Number of characters in the buffer */
+    size_t read;      /**< Index of the next character to read */
+};
+
+/**
+ * @brief Initializes a ring over a circular receive buffer.
+ *
+ * @param[out] ring The ring to initialize.
+ * @param[in] base The first character of the buffer.
+ * @param[in] size The number of characters in the buffer.
+ * @param[in] read The index of the first character to read, usually the
+ *            write index of the DMA when reception starts.
+ *
+ * @pre The pointers @p ring and @p base must not be NULL.
+ * @pre @p read must be less than @p size.
+ */
+void gps_ring_init(struct gps_ring *ring, const char *base, size_t size, size_t read);
+
+/**
+ * @brief Decodes the next sentence from a circular receive buffer.
+ *
+ * Skips any characters before the next '$' and decodes the sentence which
+ * starts there, if its footer was received before @p write. Each call
+ * decodes at most one sentence, so the caller should call again until it
+ * returns GPS_ERROR_END.
+ *
+ * A sentence is consumed whether it decodes or not. A sentence which is
+ * longer than GPS_RING_SENTENCE_SIZE, or which is cut short by the header of
+ * the next one, is dropped up to the next '$'.
+ *
+ * @param[in,out] ring The ring to read from.
+ * @param[in] write The index at which the next received character will be
+ *            written.
+ * @param[out] tpv The data structure where the decoded values will be stored.
+ * @return A result code indicating what happened.
+ * @retval GPS_OK If a sentence was decoded.
+ * @retval GPS_ERROR_END If no complete sentence is waiting. The partial
+ *         sentence, if any, is kept for the next call.
+ * @retval GPS_ERROR_OVERFLOW If a sentence was dropped for being too long.
+ * @retval GPS_ERROR_TRUNCATED If a sentence was dropped for being cut short.
+ *
+ * @pre The pointers @p ring and @p tpv must not be NULL.
+ * @pre @p write must be less than the ring size.
+ * @post The data in @p tpv is modified if a sentence was found.
+ */
+int gps_ring_decode(struct gps_ring *ring, size_t write, struct gps_tpv *tpv);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,244 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Jacob McGladdery
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include "gps_session.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <stddef.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <time.h>
+#include <unistd.h>
+
+/* Bytes read from a device per poll. Several sentences at a time, yet small
+ * enough to keep the devices served in turn.
+ */
+#define READ_SIZE (512)
+
+/* Events handled per call to epoll_wait() */
+#define MAX_EVENTS (64)
+
+/* The event data holds both the slot and the descriptor, so that events for
+ * a device removed by a callback earlier in the same batch are recognized
+ */
+static uint64_t event_data(size_t slot, int fd)
+{
+    return ((uint64_t)(uint32_t)fd << 32) | (uint32_t)slot;
+}
+
+static int64_t monotonic_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static void hang_up(struct gps_session *session, size_t slot)
+{
+    struct gps_session_device *device = &session->devices[slot];
+
+    gps_session_remove(session, slot);
+    device->callback(device->context, slot, NULL);
+}
+
+/* Received is the time data was read, or -1 without timestamps */
+static void feed(struct gps_session_device *device, size_t slot, const char *data, size_t size,
+                 int64_t received)
+{
+    int fd = device->fd;
+    size_t i;
+
+    for (i = 0; i < size; ++i)
+    {
+        char c = data[i];
+        int result;
+
+        /* Resynchronize on every header, dropping anything before it */
+        if ('$' == c)
+        {
+            if (device->length > 0) device->errors++;
+            device->length = 0;
+            device->stamps.start = received;
+        }
+        else if (0 == device->length)
+        {
+            continue;
+        }
+
+        if (device->length == GPS_SESSION_LINE_SIZE - 1)
+        {
+            device->errors++;
+            device->length = 0;
+            continue;
+        }
+
+        device->line[device->length++] = c;
+        if (c != '\n') continue;
+
+        device->line[device->length] = '\0';
+        device->length = 0;
+
+        result = gps_decode(&device->tpv, device->line);
+        if (received >= 0)
+        {
+            device->stamps.end = received;
+            device->stamps.decoded = monotonic_ns();
+        }
+        if (GPS_OK == result)
+        {
+            device->sentences++;
+            device->callback(device->context, slot, &device->tpv);
+
+            /* The callback may have removed the device */
+            if (device->fd != fd) return;
+        }
+        else if (result != GPS_ERROR_UNSUPPORTED)
+        {
+            device->errors++;
+        }
+    }
+}
+
+int gps_session_init(struct gps_session *session, struct gps_session_device *devices, size_t capacity)
+{
+    assert(session != NULL);
+    assert((devices != NULL) || (0 == capacity));
+
+    size_t i;
+
+    session->devices = devices;
+    session->capacity = capacity;
+    session->timestamps = 0;
+    for (i = 0; i < capacity; ++i) devices[i].fd = -1;
+
+    session->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (session->epoll_fd < 0) return GPS_ERROR_IO;
+
+    return GPS_OK;
+}
+
+void gps_session_close(struct gps_session *session)
+{
+    assert(session != NULL);
+
+    if (session->epoll_fd >= 0) close(session->epoll_fd);
+    session->epoll_fd = -1;
+}
+
+int gps_session_add(struct gps_session *session,
+                    int fd,
+                    gps_session_tpv_function callback,
+                    void *context,
+                    size_t *device)
+{
+    assert(session != NULL);
+    assert(fd >= 0);
+    assert(callback != NULL);
+
+    struct gps_session_device *d;
+    struct epoll_event event;
+    size_t slot;
+
+    for (slot = 0; slot < session->capacity; ++slot)
+    {
+        if (session->devices[slot].fd < 0) break;
+    }
+    if (slot == session->capacity) return GPS_ERROR_OVERFLOW;
+
+    memset(&event, 0, sizeof(event));
+    event.events = EPOLLIN;
+    event.data.u64 = event_data(slot, fd);
+    if (epoll_ctl(session->epoll_fd, EPOLL_CTL_ADD, fd, &event) < 0) return GPS_ERROR_IO;
+
+    d = &session->devices[slot];
+    d->fd = fd;
+    d->callback = callback;
+    d->context = context;
+    gps_init_tpv(&d->tpv);
+    d->length = 0;
+    d->sentences = 0;
+    d->errors = 0;
+    memset(&d->stamps, 0, sizeof(d->stamps));
+
+    if (device != NULL) *device = slot;
+
+    return GPS_OK;
+}
+
+void gps_session_remove(struct gps_session *session, size_t device)
+{
+    assert(session != NULL);
+    assert(device < session->capacity);
+
+    struct gps_session_device *d = &session->devices[device];
+
+    if (d->fd < 0) return;
+
+    /* Fails harmlessly if the descriptor has been closed already */
+    epoll_ctl(session->epoll_fd, EPOLL_CTL_DEL, d->fd, NULL);
+    d->fd = -1;
+}
+
+void gps_session_set_timestamps(struct gps_session *session, int enable)
+{
+    assert(session != NULL);
+
+    session->timestamps = enable;
+}
+
+int gps_session_poll(struct gps_session *session, int timeout)
+{
+    assert(session != NULL);
+
+    struct epoll_event events[MAX_EVENTS];
+    char buffer[READ_SIZE];
+    int count;
+    int i;
+
+    count = epoll_wait(session->epoll_fd, events, MAX_EVENTS, timeout);
+    if (count < 0) return (EINTR == errno) ? GPS_OK : GPS_ERROR_IO;
+
+    for (i = 0; i < count; ++i)
+    {
+        size_t slot = (size_t)(uint32_t)events[i].data.u64;
+        struct gps_session_device *device = &session->devices[slot];
+        ssize_t size;
+
+        if ((device->fd < 0) || (events[i].data.u64 != event_data(slot, device->fd))) continue;
+
+        size = read(device->fd, buffer, sizeof(buffer));
+        if (size > 0)
+        {
+            feed(device, slot, buffer, (size_t)size, session->timestamps ? monotonic_ns() : -1);
+        }
+        else if ((0 == size) || ((errno != EAGAIN) && (errno != EWOULDBLOCK) && (errno != EINTR)))
+        {
+            hang_up(session, slot);
+        }
+    }
+
+    return GPS_OK;
+}
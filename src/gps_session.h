@@ -0,0 +1,195 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Jacob McGladdery
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/**
+ * @file gps_session.h
+ * @brief Decodes NMEA from many receivers in a single epoll loop.
+ *
+ * A session multiplexes the file descriptors of many receivers, such as
+ * serial ports or pseudo-terminals, through one epoll instance. Each device
+ * keeps its line assembly buffer and decoder state in a slot of an array
+ * owned by the caller, so adding a receiver costs no memory allocation and
+ * no thread. Decoded TPVs are handed to a callback registered per device.
+ *
+ * Sessions are independent of each other. To spread the work of many
+ * devices over a few cores, run one session per thread and divide the
+ * devices between them.
+ *
+ * When timestamps are enabled with gps_session_set_timestamps(), every
+ * sentence is stamped on CLOCK_MONOTONIC for gps_latency_record(). The
+ * times a sentence starts and ends are those of the read() calls returning
+ * its '$' and its LF, so they are as fine as the reads are frequent, and
+ * leave out the time spent in the driver and in the epoll wait.
+ *
+ * This module requires Linux and is only built when sys/epoll.h is found.
+ */
+
+#ifndef _GPS_SESSION_H_
+#define _GPS_SESSION_H_
+
+#include "gps.h"
+#include "gps_latency.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+/** The size of each line assembly buffer, enough for any NMEA sentence */
+#define GPS_SESSION_LINE_SIZE (128)
+
+/**
+ * @brief Function receiving the TPVs decoded from a device.
+ *
+ * Called after every sentence that decodes successfully, with the TPV
+ * holding everything decoded from the device so far. If timestamps are
+ * enabled, gps_session_device.stamps holds those of the sentence while the
+ * function runs. When the device hangs up or fails, it is removed from the
+ * session and the function is called one last time with @p tpv set to NULL.
+ *
+ * @param[in] context The user pointer given to gps_session_add().
+ * @param[in] device The device number reported by gps_session_add().
+ * @param[in] tpv The updated TPV, or NULL if the device was removed.
+ */
+typedef void (*gps_session_tpv_function)(void *context, size_t device, const struct gps_tpv *tpv);
+
+/**
+ * @brief Per device state.
+ */
+struct gps_session_device
+{
+    int fd;                                /**< File descriptor, or -1 for a free slot */
+    gps_session_tpv_function callback;     /**< TPV callback */
+    void *context;                         /**< User pointer passed to the callback */
+    struct gps_tpv tpv;                    /**< Decoder state */
+    char line[GPS_SESSION_LINE_SIZE];      /**< Sentence being assembled */
+    size_t length;                         /**< Characters in gps_session_device.line */
+    uint32_t sentences;                    /**< Sentences decoded successfully */
+    uint32_t errors;                       /**< Sentences that failed to decode, or were too long */
+    struct gps_latency_stamps stamps;      /**< Timestamps of the sentence passed to the callback */
+};
+
+/**
+ * @brief Session state.
+ */
+struct gps_session
+{
+    int epoll_fd;                       /**< The epoll instance */
+    struct gps_session_device *devices; /**< Device slots */
+    size_t capacity;                    /**< Number of elements in gps_session.devices */
+    int timestamps;                     /**< Non-zero to fill in gps_session_device.stamps */
+};
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Initializes a session.
+ *
+ * @param[out] session The session to initialize.
+ * @param[in] devices Storage for the device slots.
+ * @param[in] capacity The number of elements in @p devices, which is the
+ *            largest number of devices the session can hold.
+ * @return A result code.
+ * @retval GPS_OK The session is ready.
+ * @retval GPS_ERROR_IO The epoll instance could not be created.
+ *
+ * @pre The pointer @p session must not be NULL.
+ */
+int gps_session_init(struct gps_session *session, struct gps_session_device *devices, size_t capacity);
+
+/**
+ * @brief Releases the epoll instance of a session.
+ *
+ * The device file descriptors belong to the caller and are left open.
+ *
+ * @param[in,out] session The session.
+ */
+void gps_session_close(struct gps_session *session);
+
+/**
+ * @brief Adds a device to a session.
+ *
+ * @param[in,out] session The session.
+ * @param[in] fd A readable file descriptor for the device. Pseudo-terminals
+ *            and serial ports should be in raw mode, so that sentences keep
+ *            their CR LF terminators.
+ * @param[in] callback The function receiving TPVs decoded from the device.
+ * @param[in] context A user pointer handed to @p callback.
+ * @param[out] device Receives the device number. May be NULL.
+ * @return A result code.
+ * @retval GPS_OK The device was added.
+ * @retval GPS_ERROR_OVERFLOW All device slots are in use.
+ * @retval GPS_ERROR_IO The file descriptor could not be watched.
+ *
+ * @pre The function @p callback must not be NULL.
+ */
+int gps_session_add(struct gps_session *session,
+                    int fd,
+                    gps_session_tpv_function callback,
+                    void *context,
+                    size_t *device);
+
+/**
+ * @brief Removes a device from a session.
+ *
+ * The file descriptor is left open and the callback is not called.
+ *
+ * @param[in,out] session The session.
+ * @param[in] device The device number reported by gps_session_add().
+ */
+void gps_session_remove(struct gps_session *session, size_t device);
+
+/**
+ * @brief Enables or disables the timestamps of sentences.
+ *
+ * Timestamps are disabled by a new session, as they cost one clock read
+ * per sentence plus one per read().
+ *
+ * @param[in,out] session The session.
+ * @param[in] enable Non-zero to fill in gps_session_device.stamps.
+ */
+void gps_session_set_timestamps(struct gps_session *session, int enable);
+
+/**
+ * @brief Waits for input and decodes it.
+ *
+ * Reads once from every device that is ready, so a busy device cannot
+ * starve the others, and invokes the callbacks for all sentences
+ * completed by the data read. Call this in a loop.
+ *
+ * @param[in,out] session The session.
+ * @param[in] timeout The longest time to wait for input in milliseconds,
+ *            or -1 to wait indefinitely.
+ * @return A result code.
+ * @retval GPS_OK Input was processed, or the timeout expired.
+ * @retval GPS_ERROR_IO Waiting for input failed. Interruptions by signals
+ *         are not errors.
+ */
+int gps_session_poll(struct gps_session *session, int timeout);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _GPS_SESSION_H_ */
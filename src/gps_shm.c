@@ -0,0 +1,339 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Jacob McGladdery
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "gps_shm.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdatomic.h>
+#include <stddef.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define SEGMENT_MAGIC   (0x52535047u) /* "GPSR" */
+#define SEGMENT_VERSION (2)
+
+/* The number of 32 bit words holding a TPV */
+#define TPV_WORDS ((sizeof(struct gps_tpv) + sizeof(uint32_t) - 1) / sizeof(uint32_t))
+
+/* Slots fill whole cache lines, so the writer filling a slot never
+ * invalidates the line of one being read
+ */
+struct slot
+{
+    _Alignas(64) atomic_uint_least32_t sequence; /* Odd while written, then twice the record number plus two */
+    atomic_uint_least32_t words[TPV_WORDS];
+};
+
+struct gps_shm_segment
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t slots;
+    uint32_t slot_size;
+    uint32_t generation;            /* One more than the ring this one replaced */
+    atomic_uint_least32_t head;     /* Number of the next record */
+    atomic_uint_least32_t replaced; /* Set once a new writer has replaced the ring */
+    struct slot slot[];
+};
+
+static uint32_t written(uint32_t number)
+{
+    return 2 * number + 2;
+}
+
+/* Tells the readers of an earlier writer's ring that it is being replaced,
+ * and returns its generation, or 0 if there is no such ring
+ */
+static uint32_t retire(const char *name)
+{
+    struct gps_shm_segment *segment;
+    struct stat status;
+    void *address;
+    uint32_t generation = 0;
+    int fd;
+
+    fd = shm_open(name, O_RDWR, 0);
+    if (fd < 0) return 0;
+    if ((fstat(fd, &status) < 0) || ((size_t)status.st_size < sizeof(struct gps_shm_segment)))
+    {
+        close(fd);
+        return 0;
+    }
+
+    address = mmap(NULL, sizeof(struct gps_shm_segment), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (MAP_FAILED == address) return 0;
+
+    segment = address;
+    if ((SEGMENT_MAGIC == segment->magic) && (SEGMENT_VERSION == segment->version))
+    {
+        generation = segment->generation;
+        atomic_store_explicit(&segment->replaced, 1, memory_order_release);
+    }
+    munmap(address, sizeof(struct gps_shm_segment));
+
+    return generation;
+}
+
+int gps_shm_writer_open(struct gps_shm_writer *writer, const char *name, uint32_t slots)
+{
+    assert(writer != NULL);
+    assert(name != NULL);
+    assert((slots > 0) && (0 == (slots & (slots - 1))));
+
+    struct gps_shm_segment *segment;
+    size_t size = sizeof(struct gps_shm_segment) + (size_t)slots * sizeof(struct slot);
+    void *address;
+    uint32_t generation;
+    uint32_t i;
+    int fd;
+
+    writer->segment = NULL;
+    writer->size = 0;
+    writer->head = 0;
+
+    /* Readers of an earlier ring keep their mapping of it, which resizing
+     * it in place would pull away, so it is unlinked and a new object made
+     */
+    generation = retire(name) + 1;
+    if ((shm_unlink(name) < 0) && (errno != ENOENT)) return GPS_ERROR_IO;
+
+    fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0644);
+    if (fd < 0) return GPS_ERROR_IO;
+
+    if (ftruncate(fd, (off_t)size) < 0)
+    {
+        close(fd);
+        return GPS_ERROR_IO;
+    }
+
+    address = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (MAP_FAILED == address) return GPS_ERROR_IO;
+
+    segment = address;
+    segment->version = SEGMENT_VERSION;
+    segment->slots = slots;
+    segment->slot_size = (uint32_t)sizeof(struct slot);
+    segment->generation = generation;
+    atomic_init(&segment->head, 0);
+    atomic_init(&segment->replaced, 0);
+    for (i = 0; i < slots; ++i)
+    {
+        size_t w;
+
+        atomic_init(&segment->slot[i].sequence, 0);
+        for (w = 0; w < TPV_WORDS; ++w) atomic_init(&segment->slot[i].words[w], 0);
+    }
+
+    /* Readers check the magic before anything else */
+    atomic_thread_fence(memory_order_release);
+    segment->magic = SEGMENT_MAGIC;
+
+    writer->segment = segment;
+    writer->size = size;
+
+    return GPS_OK;
+}
+
+void gps_shm_writer_close(struct gps_shm_writer *writer)
+{
+    assert(writer != NULL);
+
+    if (writer->segment != NULL) munmap(writer->segment, writer->size);
+    writer->segment = NULL;
+}
+
+uint32_t gps_shm_publish(struct gps_shm_writer *writer, const struct gps_tpv *tpv)
+{
+    assert(writer != NULL);
+    assert(writer->segment != NULL);
+    assert(tpv != NULL);
+
+    struct gps_shm_segment *segment = writer->segment;
+    uint32_t number = writer->head;
+    struct slot *slot = &segment->slot[number & (segment->slots - 1)];
+    uint32_t words[TPV_WORDS];
+    size_t i;
+
+    words[TPV_WORDS - 1] = 0;
+    memcpy(words, tpv, sizeof(*tpv));
+
+    /* The odd sequence must be visible before any of the words change */
+    atomic_store_explicit(&slot->sequence, written(number) - 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+
+    for (i = 0; i < TPV_WORDS; ++i)
+    {
+        atomic_store_explicit(&slot->words[i], words[i], memory_order_relaxed);
+    }
+
+    atomic_store_explicit(&slot->sequence, written(number), memory_order_release);
+    atomic_store_explicit(&segment->head, number + 1, memory_order_release);
+    writer->head = number + 1;
+
+    return number;
+}
+
+int gps_shm_reader_open(struct gps_shm_reader *reader, const char *name)
+{
+    assert(reader != NULL);
+    assert(name != NULL);
+
+    const struct gps_shm_segment *segment;
+    struct stat status;
+    void *address;
+    size_t size;
+    int result = GPS_OK;
+    int fd;
+
+    reader->segment = NULL;
+    reader->size = 0;
+    reader->next = 0;
+    reader->lost = 0;
+    reader->generation = 0;
+
+    fd = shm_open(name, O_RDONLY, 0);
+    if (fd < 0) return GPS_ERROR_IO;
+    if (fstat(fd, &status) < 0)
+    {
+        close(fd);
+        return GPS_ERROR_IO;
+    }
+    size = (size_t)status.st_size;
+    if (size < sizeof(struct gps_shm_segment))
+    {
+        close(fd);
+        return GPS_ERROR_CORRUPT;
+    }
+
+    address = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (MAP_FAILED == address) return GPS_ERROR_IO;
+
+    segment = address;
+    if (segment->magic != SEGMENT_MAGIC)
+    {
+        result = GPS_ERROR_CORRUPT;
+    }
+    else
+    {
+        atomic_thread_fence(memory_order_acquire);
+        if (segment->version != SEGMENT_VERSION)
+        {
+            result = GPS_ERROR_UNSUPPORTED;
+        }
+        else if ((segment->slot_size != sizeof(struct slot)) ||
+                 (0 == segment->slots) || (segment->slots & (segment->slots - 1)) ||
+                 ((size - sizeof(struct gps_shm_segment)) / sizeof(struct slot) < segment->slots))
+        {
+            result = GPS_ERROR_CORRUPT;
+        }
+    }
+
+    if (result != GPS_OK)
+    {
+        munmap(address, size);
+        return result;
+    }
+
+    reader->segment = segment;
+    reader->size = size;
+    reader->next = atomic_load_explicit(&segment->head, memory_order_acquire);
+    reader->generation = segment->generation;
+
+    return GPS_OK;
+}
+
+void gps_shm_reader_close(struct gps_shm_reader *reader)
+{
+    assert(reader != NULL);
+
+    if (reader->segment != NULL) munmap((void *)reader->segment, reader->size);
+    reader->segment = NULL;
+}
+
+int gps_shm_read(struct gps_shm_reader *reader, struct gps_tpv *tpv, uint32_t *number)
+{
+    assert(reader != NULL);
+    assert(reader->segment != NULL);
+    assert(tpv != NULL);
+
+    const struct gps_shm_segment *segment = reader->segment;
+    uint32_t words[TPV_WORDS];
+
+    for (;;)
+    {
+        uint32_t head = atomic_load_explicit(&segment->head, memory_order_acquire);
+        const struct slot *slot;
+        uint32_t before;
+        uint32_t after;
+        size_t i;
+
+        /* Only once every record of a replaced ring has been read */
+        if (head == reader->next)
+        {
+            if (atomic_load_explicit(&segment->replaced, memory_order_acquire)) return GPS_ERROR_RESTART;
+            return GPS_ERROR_END;
+        }
+
+        /* More than a ring behind, so skip to the oldest record in it */
+        if (head - reader->next > segment->slots)
+        {
+            reader->lost += head - segment->slots - reader->next;
+            reader->next = head - segment->slots;
+        }
+
+        slot = &segment->slot[reader->next & (segment->slots - 1)];
+        before = atomic_load_explicit(&slot->sequence, memory_order_acquire);
+        if (before == written(reader->next))
+        {
+            for (i = 0; i < TPV_WORDS; ++i)
+            {
+                words[i] = atomic_load_explicit(&slot->words[i], memory_order_relaxed);
+            }
+
+            /* The words must be read before the sequence is checked again */
+            atomic_thread_fence(memory_order_acquire);
+            after = atomic_load_explicit(&slot->sequence, memory_order_relaxed);
+            if (after == before) break;
+        }
+
+        /* The writer has moved on to the slot, so the record is lost */
+        reader->lost++;
+        reader->next++;
+    }
+
+    memcpy(tpv, words, sizeof(*tpv));
+    if (number != NULL) *number = reader->next;
+    reader->next++;
+
+    return GPS_OK;
+}
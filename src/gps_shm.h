@@ -0,0 +1,178 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Jacob McGladdery
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/**
+ * @file gps_shm.h
+ * @brief Broadcasts decoded TPVs to other processes through shared memory.
+ *
+ * A writer creates a POSIX shared memory object holding a ring of TPV
+ * records, and publishes every TPV it decodes into the next slot. Any
+ * number of reader processes map the same object read only and poll it.
+ * Neither side makes a system call after opening the ring, and readers
+ * never write to it, so a reader cannot slow the writer or another reader.
+ *
+ * Records are numbered from zero. Every slot is guarded by a sequence like
+ * gps_latest, which the writer makes odd while it fills the slot, and then
+ * sets from the number of the record it holds. A reader which falls more
+ * than a ring behind finds its next record overwritten. It then skips to
+ * the oldest record still in the ring, counting the records it lost, so it
+ * catches up rather than reading a mix of two records.
+ *
+ * Record numbers and sequences are 32 bits wide and wrap around, which is
+ * harmless as long as readers are never 2^31 records behind.
+ *
+ * A restarted writer creates a new object under the same name rather than
+ * reusing the old one, so readers of the old ring keep a valid mapping.
+ * Once they have read the records left in it, gps_shm_read() reports
+ * GPS_ERROR_RESTART, and opening the reader again follows the new ring.
+ *
+ * This module requires C11 atomics and shm_open, and is only built when
+ * both are found. The atomics must be lock free, as they are on every
+ * common target, for them to work across processes.
+ */
+
+#ifndef _GPS_SHM_H_
+#define _GPS_SHM_H_
+
+#include "gps.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+/** The shared memory object, private to gps_shm.c */
+struct gps_shm_segment;
+
+/**
+ * @brief Writer state.
+ */
+struct gps_shm_writer
+{
+    struct gps_shm_segment *segment; /**< The mapped object */
+    size_t size;                     /**< Bytes mapped */
+    uint32_t head;                   /**< Number of the next record */
+};
+
+/**
+ * @brief Reader state.
+ */
+struct gps_shm_reader
+{
+    const struct gps_shm_segment *segment; /**< The mapped object */
+    size_t size;                           /**< Bytes mapped */
+    uint32_t next;                         /**< Number of the next record to read */
+    uint32_t lost;                         /**< Records overwritten before they were read */
+    uint32_t generation;                   /**< Rings created under the name up to this one */
+};
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Creates a ring, or replaces the one of an earlier writer.
+ *
+ * An earlier ring is marked as replaced and unlinked, and a new object is
+ * created in its place, with the next generation number. The object is not
+ * removed by gps_shm_writer_close(). Call shm_unlink() with @p name once it
+ * is no longer needed.
+ *
+ * @param[out] writer The writer to initialize.
+ * @param[in] name The name of the shared memory object, such as "/gps".
+ * @param[in] slots The number of records the ring holds.
+ * @return A result code.
+ * @retval GPS_OK The ring is ready.
+ * @retval GPS_ERROR_IO The object could not be created or mapped.
+ *
+ * @pre The pointers @p writer and @p name must not be NULL.
+ * @pre @p slots must be a power of two.
+ */
+int gps_shm_writer_open(struct gps_shm_writer *writer, const char *name, uint32_t slots);
+
+/**
+ * @brief Unmaps the ring of a writer.
+ *
+ * Readers which have it open keep reading the records already published.
+ *
+ * @param[in,out] writer The writer.
+ */
+void gps_shm_writer_close(struct gps_shm_writer *writer);
+
+/**
+ * @brief Publishes a TPV.
+ *
+ * Only one thread of one process may publish to a given ring.
+ *
+ * @param[in,out] writer The writer.
+ * @param[in] tpv The TPV to publish.
+ * @return The number of the record.
+ */
+uint32_t gps_shm_publish(struct gps_shm_writer *writer, const struct gps_tpv *tpv);
+
+/**
+ * @brief Opens the ring of a writer for reading.
+ *
+ * The reader starts with the next record published.
+ *
+ * @param[out] reader The reader to initialize.
+ * @param[in] name The name given to gps_shm_writer_open().
+ * @return A result code.
+ * @retval GPS_OK The reader is ready.
+ * @retval GPS_ERROR_IO The object does not exist or could not be mapped.
+ * @retval GPS_ERROR_UNSUPPORTED The ring was created by another version of
+ *         this module.
+ * @retval GPS_ERROR_CORRUPT The object is not a ring.
+ *
+ * @pre The pointers @p reader and @p name must not be NULL.
+ */
+int gps_shm_reader_open(struct gps_shm_reader *reader, const char *name);
+
+/**
+ * @brief Unmaps the ring of a reader.
+ *
+ * @param[in,out] reader The reader.
+ */
+void gps_shm_reader_close(struct gps_shm_reader *reader);
+
+/**
+ * @brief Reads the next record, without waiting.
+ *
+ * If the next record was overwritten, the reader skips to the oldest one
+ * in the ring and adds the records skipped to gps_shm_reader.lost.
+ *
+ * @param[in,out] reader The reader.
+ * @param[out] tpv The TPV of the record.
+ * @param[out] number Receives the number of the record. May be NULL.
+ * @return A result code.
+ * @retval GPS_OK A record was read.
+ * @retval GPS_ERROR_END No record was published since the last one read.
+ * @retval GPS_ERROR_RESTART Every record was read, and a new writer has
+ *         replaced the ring. Close the reader and open it again.
+ */
+int gps_shm_read(struct gps_shm_reader *reader, struct gps_tpv *tpv, uint32_t *number);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _GPS_SHM_H_ */
@@ -0,0 +1,255 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Jacob McGladdery
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include "gps_simplify.h"
+#include "gps_fixed.h"
+
+#include <assert.h>
+#include <string.h>
+
+/* Millimeters per micro-degree of arc divided by 8, times 10^6 */
+#define MM_PER_MICRODEGREE_DIV_8_E6 INT64_C(13899385)
+
+/* Points are projected onto a local equirectangular frame around the start
+ * of the segment, in eighths of a micro-degree of arc along the east and
+ * north axes, or about 14 mm. Within a few hundred kilometers of the start,
+ * squares and cross products of these coordinates fit in 64 bits.
+ */
+struct frame
+{
+    int32_t latitude;  /* Start of the segment */
+    int32_t longitude;
+    int64_t scale;     /* cos of the latitude in Q30 */
+};
+
+static void frame_init(struct frame *frame, int32_t latitude, int32_t longitude)
+{
+    frame->latitude = latitude;
+    frame->longitude = longitude;
+    frame->scale = gps_fixed_cos_q30(gps_fixed_angle(latitude));
+}
+
+static void project(const struct frame *frame, int32_t latitude, int32_t longitude, int64_t *east, int64_t *north)
+{
+    int64_t dlon = gps_fixed_wrap_longitude((int64_t)longitude - frame->longitude);
+
+    *east = (dlon * frame->scale) >> 27;
+    *north = ((int64_t)latitude - frame->latitude) * 8;
+}
+
+/* Converts a tolerance in millimeters to projection units */
+static int64_t to_units(int32_t tolerance)
+{
+    return ((int64_t)tolerance * 1000000 + MM_PER_MICRODEGREE_DIV_8_E6 / 2) / MM_PER_MICRODEGREE_DIV_8_E6;
+}
+
+/* Distance from the point (px, py) to the segment from the origin to
+ * (bx, by), whose length is given
+ */
+static int64_t distance(int64_t bx, int64_t by, uint64_t length, int64_t px, int64_t py)
+{
+    int64_t dot = px * bx + py * by;
+    int64_t cross;
+
+    if ((dot <= 0) || (0 == length))
+    {
+        return (int64_t)gps_fixed_isqrt((uint64_t)(px * px + py * py));
+    }
+    if (dot >= bx * bx + by * by)
+    {
+        px -= bx;
+        py -= by;
+        return (int64_t)gps_fixed_isqrt((uint64_t)(px * px + py * py));
+    }
+
+    cross = bx * py - by * px;
+    if (cross < 0) cross = -cross;
+    return cross / (int64_t)length;
+}
+
+static void keep_point(struct gps_simplify *simplify, const struct gps_simplify_point *point)
+{
+    simplify->kept++;
+    simplify->output(simplify->context, point);
+}
+
+/* Checks whether the segment from the last kept point to the given one
+ * passes too far from a point of the window
+ */
+static int deviates(const struct gps_simplify *simplify, const struct gps_simplify_point *point)
+{
+    const struct gps_simplify_point *anchor = &simplify->window[0];
+    struct frame frame;
+    int64_t bx, by;
+    uint64_t length;
+    size_t i;
+
+    frame.latitude = anchor->latitude;
+    frame.longitude = anchor->longitude;
+    frame.scale = simplify->scale;
+    project(&frame, point->latitude, point->longitude, &bx, &by);
+    length = gps_fixed_isqrt((uint64_t)(bx * bx + by * by));
+
+    for (i = 1; i < simplify->count; ++i)
+    {
+        int64_t px, py;
+
+        project(&frame, simplify->window[i].latitude, simplify->window[i].longitude, &px, &py);
+        if (distance(bx, by, length, px, py) > simplify->tolerance) return 1;
+    }
+
+    return 0;
+}
+
+void gps_simplify_init(struct gps_simplify *simplify,
+                       int32_t tolerance,
+                       gps_simplify_function output,
+                       void *context)
+{
+    assert(simplify != NULL);
+    assert(output != NULL);
+    assert(tolerance >= 0);
+
+    simplify->count = 0;
+    simplify->tolerance = to_units(tolerance);
+    simplify->scale = 0;
+    simplify->output = output;
+    simplify->context = context;
+    simplify->points = 0;
+    simplify->kept = 0;
+}
+
+void gps_simplify_add(struct gps_simplify *simplify, const struct gps_tpv *tpv, int64_t time)
+{
+    assert(simplify != NULL);
+    assert(tpv != NULL);
+
+    struct gps_simplify_point point;
+
+    if ((GPS_INVALID_VALUE == tpv->latitude) || (GPS_INVALID_VALUE == tpv->longitude)) return;
+
+    point.latitude = tpv->latitude;
+    point.longitude = tpv->longitude;
+    point.time = time;
+    simplify->points++;
+
+    if (0 == simplify->count)
+    {
+        simplify->window[0] = point;
+        simplify->count = 1;
+        simplify->scale = gps_fixed_cos_q30(gps_fixed_angle(point.latitude));
+        keep_point(simplify, &point);
+        return;
+    }
+
+    /* Keep the newest point of the window, which starts the next segment */
+    if ((simplify->count > 1) &&
+        ((GPS_SIMPLIFY_WINDOW == simplify->count) || deviates(simplify, &point)))
+    {
+        simplify->window[0] = simplify->window[simplify->count - 1];
+        simplify->count = 1;
+        simplify->scale = gps_fixed_cos_q30(gps_fixed_angle(simplify->window[0].latitude));
+        keep_point(simplify, &simplify->window[0]);
+    }
+
+    simplify->window[simplify->count++] = point;
+}
+
+void gps_simplify_flush(struct gps_simplify *simplify)
+{
+    assert(simplify != NULL);
+
+    if (simplify->count > 1) keep_point(simplify, &simplify->window[simplify->count - 1]);
+    simplify->count = 0;
+}
+
+size_t gps_simplify_track(const int32_t *latitude,
+                          const int32_t *longitude,
+                          size_t count,
+                          int32_t tolerance,
+                          uint8_t *keep)
+{
+    assert(((latitude != NULL) && (longitude != NULL) && (keep != NULL)) || (0 == count));
+    assert(tolerance >= 0);
+
+    int64_t units = to_units(tolerance);
+    size_t kept;
+    size_t start = 0;
+
+    if (0 == count) return 0;
+
+    memset(keep, 0, count);
+    keep[0] = 1;
+    keep[count - 1] = 1;
+    kept = (count > 1) ? 2 : 1;
+
+    /* Splits the segment from start to the next kept point at its farthest
+     * point until that is within the tolerance, then moves on. The kept
+     * flags stand in for the recursion stack.
+     */
+    while (start < count - 1)
+    {
+        size_t end = start + 1;
+
+        while (!keep[end]) ++end;
+
+        if (end - start > 1)
+        {
+            struct frame frame;
+            int64_t bx, by;
+            uint64_t length;
+            int64_t farthest = -1;
+            size_t split = start;
+            size_t i;
+
+            frame_init(&frame, latitude[start], longitude[start]);
+            project(&frame, latitude[end], longitude[end], &bx, &by);
+            length = gps_fixed_isqrt((uint64_t)(bx * bx + by * by));
+
+            for (i = start + 1; i < end; ++i)
+            {
+                int64_t px, py, d;
+
+                project(&frame, latitude[i], longitude[i], &px, &py);
+                d = distance(bx, by, length, px, py);
+                if (d > farthest)
+                {
+                    farthest = d;
+                    split = i;
+                }
+            }
+
+            if (farthest > units)
+            {
+                keep[split] = 1;
+                kept++;
+                continue;
+            }
+        }
+
+        start = end;
+    }
+
+    return kept;
+}
@@ -0,0 +1,167 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Jacob McGladdery
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/**
+ * @file gps_simplify.h
+ * @brief Drops the points of a track which a straight line already describes.
+ *
+ * A track sampled at 1 Hz or faster holds many points on straight stretches
+ * which tell nothing the points at either end do not. Two simplifiers keep
+ * only the points needed for every dropped point to lie within a tolerance
+ * of the simplified track.
+ *
+ * struct gps_simplify works on a stream, for the device. It keeps the last
+ * kept point and the points after it in a window of GPS_SIMPLIFY_WINDOW
+ * points, and keeps the newest point of the window once the segment from
+ * the last kept point to the incoming one passes too far from any point in
+ * between, or once the window is full. Its cost per point is bounded by the
+ * window size.
+ *
+ * gps_simplify_track() runs Douglas-Peucker over a whole track, for the
+ * backend. It keeps fewer points for the same tolerance, at the cost of
+ * seeing the whole track first.
+ *
+ * Both measure distances in meters times GPS_VALUE_FACTOR in a local
+ * equirectangular projection around the start of each segment, with
+ * integer arithmetic only. Segments are expected to be shorter than a few
+ * hundred kilometers.
+ */
+
+#ifndef _GPS_SIMPLIFY_H_
+#define _GPS_SIMPLIFY_H_
+
+#include "gps.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define GPS_SIMPLIFY_WINDOW (32) /**< The most points a streaming simplifier holds */
+
+/**
+ * @brief Point of a track.
+ */
+struct gps_simplify_point
+{
+    int32_t latitude;  /**< Same as gps_tpv.latitude */
+    int32_t longitude; /**< Same as gps_tpv.longitude */
+    int64_t time;      /**< Time of the point, passed through unchanged */
+};
+
+/**
+ * @brief Function receiving each point a streaming simplifier keeps.
+ *
+ * @param[in] context The user pointer given to gps_simplify_init().
+ * @param[in] point The point.
+ */
+typedef void (*gps_simplify_function)(void *context, const struct gps_simplify_point *point);
+
+/**
+ * @brief Streaming simplifier state.
+ */
+struct gps_simplify
+{
+    struct gps_simplify_point window[GPS_SIMPLIFY_WINDOW]; /**< The last kept point, then the points after it */
+    size_t count;                                         /**< Points in gps_simplify.window */
+    int64_t tolerance;                                    /**< Tolerance in projection units */
+    int64_t scale;                                        /**< cos of the latitude of the last kept point, Q30 */
+    gps_simplify_function output;                         /**< Receives each kept point */
+    void *context;                                        /**< User pointer passed to gps_simplify.output */
+    uint32_t points;                                      /**< Points added */
+    uint32_t kept;                                        /**< Points kept */
+};
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Initializes a streaming simplifier.
+ *
+ * @param[out] simplify The simplifier to initialize.
+ * @param[in] tolerance The largest distance allowed between a dropped point
+ *            and the simplified track, in meters times GPS_VALUE_FACTOR.
+ * @param[in] output The function receiving each point kept.
+ * @param[in] context A user pointer handed to @p output.
+ *
+ * @pre The pointers @p simplify and @p output must not be NULL.
+ * @pre The tolerance @p tolerance must not be negative.
+ */
+void gps_simplify_init(struct gps_simplify *simplify,
+                       int32_t tolerance,
+                       gps_simplify_function output,
+                       void *context);
+
+/**
+ * @brief Adds the position of a TPV to the track.
+ *
+ * The first point is kept right away. Any other is kept later, if at all.
+ * TPVs without a valid position are ignored.
+ *
+ * @param[in,out] simplify The simplifier.
+ * @param[in] tpv The TPV.
+ * @param[in] time The time of the TPV, handed back with the point if kept.
+ *
+ * @pre The pointers @p simplify and @p tpv must not be NULL.
+ */
+void gps_simplify_add(struct gps_simplify *simplify, const struct gps_tpv *tpv, int64_t time);
+
+/**
+ * @brief Keeps the last point added, ending the track.
+ *
+ * The next point added starts a new track.
+ *
+ * @param[in,out] simplify The simplifier.
+ *
+ * @pre The pointer @p simplify must not be NULL.
+ */
+void gps_simplify_flush(struct gps_simplify *simplify);
+
+/**
+ * @brief Simplifies a whole track with the Douglas-Peucker algorithm.
+ *
+ * The first and last points are always kept.
+ *
+ * @param[in] latitude The latitudes of the points.
+ * @param[in] longitude The longitudes of the points.
+ * @param[in] count The number of points.
+ * @param[in] tolerance The largest distance allowed between a dropped point
+ *            and the simplified track, in meters times GPS_VALUE_FACTOR.
+ * @param[out] keep Set to 1 for each point kept, and 0 for the others.
+ * @return The number of points kept.
+ *
+ * @pre The pointers @p latitude, @p longitude and @p keep must not be NULL
+ *      unless @p count is 0.
+ * @pre The tolerance @p tolerance must not be negative.
+ */
+size_t gps_simplify_track(const int32_t *latitude,
+                          const int32_t *longitude,
+                          size_t count,
+                          int32_t tolerance,
+                          uint8_t *keep);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _GPS_SIMPLIFY_H_ */
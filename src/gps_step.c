@@ -0,0 +1,99 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Jacob McGladdery
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include "gps_step.h"
+
+#include <assert.h>
+
+void gps_step_init(struct gps_step *step)
+{
+    assert(step != NULL);
+
+    step->length = 0;
+    step->pending = GPS_ERROR_END;
+}
+
+size_t gps_step_feed(struct gps_step *step, const char *data, size_t size, size_t budget)
+{
+    assert(step != NULL);
+    assert((data != NULL) || (0 == size));
+
+    size_t i;
+
+    if (step->pending != GPS_ERROR_END) return 0;
+    if (size > budget) size = budget;
+
+    for (i = 0; i < size; ++i)
+    {
+        char c = data[i];
+
+        /* Resynchronize on every header, dropping anything before it */
+        if ('$' == c)
+        {
+            if (step->length > 0)
+            {
+                step->length = 0;
+                step->pending = GPS_ERROR_TRUNCATED;
+                return i;
+            }
+        }
+        else if (0 == step->length)
+        {
+            continue;
+        }
+
+        if (step->length == GPS_STEP_SENTENCE_SIZE)
+        {
+            step->length = 0;
+            step->pending = GPS_ERROR_OVERFLOW;
+            return i;
+        }
+
+        step->line[step->length++] = c;
+        if ('\n' == c)
+        {
+            step->pending = GPS_OK;
+            return i + 1;
+        }
+    }
+
+    return i;
+}
+
+int gps_step_decode(struct gps_step *step, struct gps_tpv *tpv)
+{
+    assert(step != NULL);
+    assert(tpv != NULL);
+
+    int result = step->pending;
+
+    if (GPS_OK == result)
+    {
+        result = gps_decode_const(tpv, step->line, step->length);
+        step->length = 0;
+    }
+    step->pending = GPS_ERROR_END;
+
+    return result;
+}
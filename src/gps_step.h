@@ -0,0 +1,113 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Jacob McGladdery
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/**
+ * @file gps_step.h
+ * @brief Decoding in steps of bounded cost, for hard real time loops.
+ *
+ * gps_decode() runs to completion, so its cost depends on what it is given.
+ * A stepper splits the work in two kinds of call whose cost has a fixed
+ * upper bound. gps_step_feed() assembles a sentence from at most a given
+ * number of received characters. gps_step_decode() decodes the assembled
+ * sentence, which is at most GPS_STEP_SENTENCE_SIZE characters long. A
+ * control loop calls each once per cycle and resumes where it left off on
+ * the next.
+ *
+ * example/wcet_benchmark.c measures the worst case of every entry point
+ * against adversarial sentences.
+ */
+
+#ifndef _GPS_STEP_H_
+#define _GPS_STEP_H_
+
+#include "gps.h"
+
+#include <stddef.h>
+
+#define GPS_STEP_SENTENCE_SIZE (128) /**< The longest sentence accepted, from '$' to "\r\n" */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Stepper state.
+ */
+struct gps_step
+{
+    char line[GPS_STEP_SENTENCE_SIZE]; /**< Sentence being assembled */
+    size_t length;                     /**< Characters in gps_step.line */
+    int pending;                       /**< Result waiting for gps_step_decode(), or GPS_ERROR_END */
+};
+
+/**
+ * @brief Initializes a stepper.
+ *
+ * @param[out] step The stepper to initialize.
+ *
+ * @pre The pointer @p step must not be NULL.
+ */
+void gps_step_init(struct gps_step *step);
+
+/**
+ * @brief Assembles a sentence from received characters.
+ *
+ * Examines at most @p budget characters of @p data. Characters before a
+ * '$' are dropped. Stops early once a sentence is complete, or once a
+ * sentence is dropped for being too long or for being cut short by the next
+ * header. Nothing is consumed until gps_step_decode() has taken that
+ * sentence or error.
+ *
+ * @param[in,out] step The stepper.
+ * @param[in] data The received characters.
+ * @param[in] size The number of characters at @p data.
+ * @param[in] budget The most characters to examine in this call.
+ * @return The number of characters consumed from @p data.
+ *
+ * @pre The pointer @p step must not be NULL.
+ * @pre The pointer @p data must not be NULL unless @p size is 0.
+ */
+size_t gps_step_feed(struct gps_step *step, const char *data, size_t size, size_t budget);
+
+/**
+ * @brief Decodes the sentence assembled by gps_step_feed().
+ *
+ * @param[in,out] step The stepper.
+ * @param[out] tpv The data structure where the decoded values will be stored.
+ * @return A result code indicating what happened.
+ * @retval GPS_OK If a sentence was decoded.
+ * @retval GPS_ERROR_END If no sentence is complete yet.
+ * @retval GPS_ERROR_OVERFLOW If a sentence was dropped for being too long.
+ * @retval GPS_ERROR_TRUNCATED If a sentence was dropped for being cut short.
+ *
+ * @pre The pointers @p step and @p tpv must not be NULL.
+ * @post The data in @p tpv is modified if a sentence was complete.
+ */
+int gps_step_decode(struct gps_step *step, struct gps_tpv *tpv);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,407 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Jacob McGladdery
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include "gps_stream.h"
+
+#include <assert.h>
+#include <string.h>
+
+#ifdef GPS_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+#ifdef GPS_HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+/* Waits for a free block and returns the space left in the one being
+ * filled. Called by the decompressing thread only.
+ */
+static char *output(struct gps_stream *stream, size_t *space)
+{
+    size_t block;
+
+    if (0 == stream->fill)
+    {
+        pthread_mutex_lock(&stream->lock);
+        while (stream->produced - stream->consumed == GPS_STREAM_BLOCKS)
+        {
+            pthread_cond_wait(&stream->emptied, &stream->lock);
+        }
+        pthread_mutex_unlock(&stream->lock);
+    }
+
+    block = stream->produced % GPS_STREAM_BLOCKS;
+    *space = GPS_STREAM_BLOCK_SIZE - stream->fill;
+    return stream->blocks[block] + stream->fill;
+}
+
+/* Hands the block being filled to the decoding thread */
+static void publish(struct gps_stream *stream)
+{
+    if (0 == stream->fill) return;
+
+    pthread_mutex_lock(&stream->lock);
+    stream->lengths[stream->produced % GPS_STREAM_BLOCKS] = stream->fill;
+    stream->produced++;
+    pthread_cond_signal(&stream->filled);
+    pthread_mutex_unlock(&stream->lock);
+
+    stream->fill = 0;
+}
+
+/* Accounts for bytes written after output(), publishing the block once full */
+static void advance(struct gps_stream *stream, size_t size)
+{
+    stream->fill += size;
+    stream->decompressed += size;
+    if (GPS_STREAM_BLOCK_SIZE == stream->fill) publish(stream);
+}
+
+static size_t read_input(struct gps_stream *stream)
+{
+    size_t size = fread(stream->input, 1, sizeof(stream->input), stream->file);
+
+    stream->compressed += size;
+    return size;
+}
+
+static int copy_plain(struct gps_stream *stream, size_t size)
+{
+    do
+    {
+        const unsigned char *input = stream->input;
+
+        while (size > 0)
+        {
+            size_t space;
+            char *out = output(stream, &space);
+            size_t n = (size < space) ? size : space;
+
+            memcpy(out, input, n);
+            advance(stream, n);
+            input += n;
+            size -= n;
+        }
+
+        size = read_input(stream);
+    }
+    while (size > 0);
+
+    return ferror(stream->file) ? GPS_ERROR_IO : GPS_OK;
+}
+
+#ifdef GPS_HAVE_ZLIB
+static int inflate_gzip(struct gps_stream *stream, size_t size)
+{
+    z_stream z;
+    int status = Z_OK;
+    int result = GPS_OK;
+
+    memset(&z, 0, sizeof(z));
+
+    /* 15 for the largest window, plus 32 to accept gzip and zlib headers */
+    if (inflateInit2(&z, 15 + 32) != Z_OK) return GPS_ERROR_IO;
+    z.next_in = stream->input;
+    z.avail_in = (uInt)size;
+
+    for (;;)
+    {
+        size_t space;
+
+        if (0 == z.avail_in)
+        {
+            size = read_input(stream);
+            if (0 == size)
+            {
+                if (ferror(stream->file)) result = GPS_ERROR_IO;
+                else if (status != Z_STREAM_END) result = GPS_ERROR_TRUNCATED;
+                break;
+            }
+            z.next_in = stream->input;
+            z.avail_in = (uInt)size;
+        }
+
+        /* More input after the end of a member starts another one */
+        if (Z_STREAM_END == status) inflateReset(&z);
+
+        z.next_out = (Bytef *)output(stream, &space);
+        z.avail_out = (uInt)space;
+        status = inflate(&z, Z_NO_FLUSH);
+        advance(stream, space - z.avail_out);
+
+        if ((status != Z_OK) && (status != Z_STREAM_END) && (status != Z_BUF_ERROR))
+        {
+            result = GPS_ERROR_CORRUPT;
+            break;
+        }
+    }
+
+    inflateEnd(&z);
+    return result;
+}
+#endif
+
+#ifdef GPS_HAVE_ZSTD
+static int decompress_zstd(struct gps_stream *stream, size_t size)
+{
+    ZSTD_DStream *z = ZSTD_createDStream();
+    ZSTD_inBuffer in;
+    size_t status = 0;
+    int result = GPS_OK;
+
+    if (NULL == z) return GPS_ERROR_IO;
+    ZSTD_initDStream(z);
+    in.src = stream->input;
+    in.size = size;
+    in.pos = 0;
+
+    for (;;)
+    {
+        ZSTD_outBuffer out;
+
+        if (in.pos == in.size)
+        {
+            size = read_input(stream);
+            if (0 == size)
+            {
+                /* A non-zero status means the last frame is incomplete */
+                if (ferror(stream->file)) result = GPS_ERROR_IO;
+                else if (status != 0) result = GPS_ERROR_TRUNCATED;
+                break;
+            }
+            in.size = size;
+            in.pos = 0;
+        }
+
+        out.dst = output(stream, &out.size);
+        out.pos = 0;
+        status = ZSTD_decompressStream(z, &out, &in);
+        advance(stream, out.pos);
+
+        if (ZSTD_isError(status))
+        {
+            result = GPS_ERROR_CORRUPT;
+            break;
+        }
+    }
+
+    ZSTD_freeDStream(z);
+    return result;
+}
+#endif
+
+static int detect_format(const unsigned char *input, size_t size)
+{
+    if ((size >= 2) && (0x1F == input[0]) && (0x8B == input[1])) return GPS_STREAM_GZIP;
+    if ((size >= 4) && (0x28 == input[0]) && (0xB5 == input[1]) && (0x2F == input[2]) && (0xFD == input[3]))
+    {
+        return GPS_STREAM_ZSTD;
+    }
+
+    return GPS_STREAM_PLAIN;
+}
+
+/* Body of the decompressing thread */
+static void *decompress(void *argument)
+{
+    struct gps_stream *stream = argument;
+    size_t size = read_input(stream);
+    int result = GPS_ERROR_UNSUPPORTED;
+
+    stream->format = detect_format(stream->input, size);
+    switch (stream->format)
+    {
+#ifdef GPS_HAVE_ZLIB
+    case GPS_STREAM_GZIP:
+        result = inflate_gzip(stream, size);
+        break;
+#endif
+#ifdef GPS_HAVE_ZSTD
+    case GPS_STREAM_ZSTD:
+        result = decompress_zstd(stream, size);
+        break;
+#endif
+    case GPS_STREAM_PLAIN:
+        result = copy_plain(stream, size);
+        break;
+    default:
+        break;
+    }
+
+    publish(stream);
+
+    pthread_mutex_lock(&stream->lock);
+    stream->result = result;
+    stream->done = 1;
+    pthread_cond_signal(&stream->filled);
+    pthread_mutex_unlock(&stream->lock);
+
+    return NULL;
+}
+
+/* Decodes a whole line, from its first '$' */
+static void decode_line(struct gps_stream *stream, const char *line, size_t size,
+                        gps_stream_tpv_function callback, void *context)
+{
+    const char *nmea = memchr(line, '$', size);
+    int result;
+
+    if (NULL == nmea) return;
+
+    result = gps_decode_const(&stream->tpv, nmea, size - (size_t)(nmea - line));
+    if (GPS_OK == result)
+    {
+        stream->sentences++;
+        callback(context, &stream->tpv);
+    }
+    else if (result != GPS_ERROR_UNSUPPORTED)
+    {
+        stream->errors++;
+    }
+}
+
+/* Decodes the lines of a block. Lines lying within the block are decoded in
+ * place. The start of a line left at the end of the block is kept, and the
+ * line is completed from the next block.
+ */
+static void decode_block(struct gps_stream *stream, const char *data, size_t size,
+                         gps_stream_tpv_function callback, void *context)
+{
+    const char *end = data + size;
+
+    while (data < end)
+    {
+        const char *eol = memchr(data, '\n', (size_t)(end - data));
+        size_t n = (size_t)(((NULL == eol) ? end : eol + 1) - data);
+
+        if ((stream->length > 0) || stream->overlong || (NULL == eol))
+        {
+            if (stream->overlong || (stream->length + n > GPS_STREAM_LINE_SIZE))
+            {
+                if (!stream->overlong) stream->errors++;
+                stream->overlong = 1;
+                stream->length = 0;
+            }
+            else
+            {
+                memcpy(stream->line + stream->length, data, n);
+                stream->length += n;
+            }
+
+            if (eol != NULL)
+            {
+                if (stream->length > 0) decode_line(stream, stream->line, stream->length, callback, context);
+                stream->length = 0;
+                stream->overlong = 0;
+            }
+        }
+        else
+        {
+            decode_line(stream, data, n, callback, context);
+        }
+
+        data += n;
+    }
+}
+
+int gps_stream_decode(struct gps_stream *stream, FILE *file, gps_stream_tpv_function callback, void *context)
+{
+    assert(stream != NULL);
+    assert(file != NULL);
+    assert(callback != NULL);
+
+    pthread_t thread;
+
+    stream->length = 0;
+    stream->overlong = 0;
+    stream->file = file;
+    stream->fill = 0;
+    stream->produced = 0;
+    stream->consumed = 0;
+    stream->done = 0;
+    stream->result = GPS_OK;
+    gps_init_tpv(&stream->tpv);
+    stream->format = GPS_STREAM_PLAIN;
+    stream->compressed = 0;
+    stream->decompressed = 0;
+    stream->sentences = 0;
+    stream->errors = 0;
+
+    if (pthread_mutex_init(&stream->lock, NULL) != 0) return GPS_ERROR_IO;
+    if (pthread_cond_init(&stream->filled, NULL) != 0)
+    {
+        pthread_mutex_destroy(&stream->lock);
+        return GPS_ERROR_IO;
+    }
+    if (pthread_cond_init(&stream->emptied, NULL) != 0)
+    {
+        pthread_cond_destroy(&stream->filled);
+        pthread_mutex_destroy(&stream->lock);
+        return GPS_ERROR_IO;
+    }
+
+    if (pthread_create(&thread, NULL, decompress, stream) != 0)
+    {
+        stream->result = GPS_ERROR_IO;
+    }
+    else
+    {
+        for (;;)
+        {
+            size_t block;
+
+            pthread_mutex_lock(&stream->lock);
+            while ((stream->consumed == stream->produced) && !stream->done)
+            {
+                pthread_cond_wait(&stream->filled, &stream->lock);
+            }
+            if (stream->consumed == stream->produced)
+            {
+                pthread_mutex_unlock(&stream->lock);
+                break;
+            }
+            block = stream->consumed % GPS_STREAM_BLOCKS;
+            pthread_mutex_unlock(&stream->lock);
+
+            decode_block(stream, stream->blocks[block], stream->lengths[block], callback, context);
+
+            pthread_mutex_lock(&stream->lock);
+            stream->consumed++;
+            pthread_cond_signal(&stream->emptied);
+            pthread_mutex_unlock(&stream->lock);
+        }
+
+        pthread_join(thread, NULL);
+
+        /* A last sentence without a line ending */
+        if ((stream->length > 0) && (memchr(stream->line, '$', stream->length) != NULL)) stream->errors++;
+    }
+
+    pthread_cond_destroy(&stream->emptied);
+    pthread_cond_destroy(&stream->filled);
+    pthread_mutex_destroy(&stream->lock);
+
+    return stream->result;
+}
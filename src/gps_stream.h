@@ -0,0 +1,145 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Jacob McGladdery
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/**
+ * @file gps_stream.h
+ * @brief Decodes gzip or zstd compressed NMEA logs as they are decompressed.
+ *
+ * gps_stream_decode() reads a compressed log from a file and decodes every
+ * sentence in it, without writing the decompressed log anywhere. A thread
+ * of its own decompresses the log into a ring of blocks, while the calling
+ * thread decodes the sentences straight out of the blocks it has filled,
+ * so decompression and decoding overlap. Only a sentence which spans two
+ * blocks is copied, to join its two parts.
+ *
+ * The format is recognized from the first bytes of the file. gzip needs
+ * zlib, and zstd needs libzstd, each of which is used when found at
+ * configure time. Uncompressed logs are read as they are. Lines may start
+ * with anything before the '$', such as the arrival times written by
+ * gps_recorder_dump().
+ *
+ * All buffers live in struct gps_stream, which is large enough that it
+ * should be static. The compression libraries allocate their own state.
+ *
+ * This module requires POSIX threads and zlib or libzstd, and is only built
+ * when these are found.
+ */
+
+#ifndef _GPS_STREAM_H_
+#define _GPS_STREAM_H_
+
+#include "gps.h"
+
+#include <pthread.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+/* Formats */
+#define GPS_STREAM_PLAIN (0) /**< Uncompressed */
+#define GPS_STREAM_GZIP  (1) /**< gzip, or any number of gzip members in a row */
+#define GPS_STREAM_ZSTD  (2) /**< zstd, or any number of zstd frames in a row */
+
+#define GPS_STREAM_BLOCK_SIZE (65536) /**< Bytes of decompressed log per block */
+#define GPS_STREAM_BLOCKS     (4)     /**< Blocks the decompressing thread may fill ahead */
+#define GPS_STREAM_INPUT_SIZE (65536) /**< Bytes of compressed log read at a time */
+#define GPS_STREAM_LINE_SIZE  (256)   /**< The longest line which may span two blocks */
+
+/**
+ * @brief Function receiving the TPVs decoded from a log.
+ *
+ * Called on the thread which called gps_stream_decode(), after every
+ * sentence that decodes successfully, with the TPV holding everything
+ * decoded from the log so far.
+ *
+ * @param[in] context The user pointer given to gps_stream_decode().
+ * @param[in] tpv The updated TPV.
+ */
+typedef void (*gps_stream_tpv_function)(void *context, const struct gps_tpv *tpv);
+
+/**
+ * @brief Stream state and buffers.
+ *
+ * The members up to gps_stream.tpv are private. The statistics are valid
+ * once gps_stream_decode() has returned.
+ */
+struct gps_stream
+{
+    char blocks[GPS_STREAM_BLOCKS][GPS_STREAM_BLOCK_SIZE]; /**< Decompressed blocks */
+    size_t lengths[GPS_STREAM_BLOCKS];                     /**< Bytes in each block */
+    unsigned char input[GPS_STREAM_INPUT_SIZE];            /**< Compressed input */
+    char line[GPS_STREAM_LINE_SIZE];                       /**< Line spanning two blocks */
+    size_t length;                                         /**< Characters in gps_stream.line */
+    int overlong;                                          /**< Non-zero while skipping a line too long */
+    FILE *file;                                            /**< The log */
+    size_t fill;                                           /**< Bytes in the block being filled */
+    pthread_mutex_t lock;                                  /**< Guards the counts below */
+    pthread_cond_t filled;                                 /**< Signaled when a block is filled */
+    pthread_cond_t emptied;                                /**< Signaled when a block is decoded */
+    size_t produced;                                       /**< Blocks filled */
+    size_t consumed;                                       /**< Blocks decoded */
+    int done;                                              /**< Non-zero once the last block is filled */
+    int result;                                            /**< Result of the decompression */
+    struct gps_tpv tpv;                                    /**< Decoder state */
+    int format;                                            /**< The format found */
+    uint64_t compressed;                                   /**< Bytes read from the file */
+    uint64_t decompressed;                                 /**< Bytes of log decompressed */
+    uint32_t sentences;                                    /**< Sentences decoded successfully */
+    uint32_t errors;                                       /**< Sentences that failed to decode, or were too long */
+};
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Decodes every sentence of a compressed log.
+ *
+ * Returns once the whole file has been read and every sentence in it has
+ * been handed to @p callback.
+ *
+ * @param[out] stream The stream state.
+ * @param[in] file The log, open for reading in binary mode.
+ * @param[in] callback The function receiving the decoded TPVs.
+ * @param[in] context A user pointer handed to @p callback.
+ * @return A result code.
+ * @retval GPS_OK The log was decoded to its end.
+ * @retval GPS_ERROR_UNSUPPORTED The log is compressed in a format this
+ *         build cannot decompress.
+ * @retval GPS_ERROR_CORRUPT The compressed data is invalid. The sentences
+ *         decompressed before the error have been decoded.
+ * @retval GPS_ERROR_TRUNCATED The compressed data ends early. The sentences
+ *         decompressed before the end have been decoded.
+ * @retval GPS_ERROR_IO Reading the file failed, or the thread or the
+ *         decompressor could not be set up.
+ *
+ * @pre The pointers @p stream, @p file and @p callback must not be NULL.
+ */
+int gps_stream_decode(struct gps_stream *stream, FILE *file, gps_stream_tpv_function callback, void *context);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _GPS_STREAM_H_ */
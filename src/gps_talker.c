@@ -0,0 +1,258 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Jacob McGladdery
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include "gps_talker.h"
+
+#include <assert.h>
+#include <stddef.h>
+#include <string.h>
+
+static const char NULL_TIME[] = "0000-00-00T00:00:00.000Z";
+
+#define MS_PER_DAY INT64_C(86400000)
+
+/* Talker of each second character after a 'G', indexed from 'A' */
+static const uint8_t g_talkers[26] = {
+    ['A' - 'A'] = GPS_TALKER_GA,
+    ['B' - 'A'] = GPS_TALKER_GB,
+    ['C' - 'A'] = GPS_TALKER_OTHER,
+    ['D' - 'A'] = GPS_TALKER_OTHER,
+    ['E' - 'A'] = GPS_TALKER_OTHER,
+    ['F' - 'A'] = GPS_TALKER_OTHER,
+    ['G' - 'A'] = GPS_TALKER_OTHER,
+    ['H' - 'A'] = GPS_TALKER_OTHER,
+    ['I' - 'A'] = GPS_TALKER_GI,
+    ['J' - 'A'] = GPS_TALKER_OTHER,
+    ['K' - 'A'] = GPS_TALKER_OTHER,
+    ['L' - 'A'] = GPS_TALKER_GL,
+    ['M' - 'A'] = GPS_TALKER_OTHER,
+    ['N' - 'A'] = GPS_TALKER_GN,
+    ['O' - 'A'] = GPS_TALKER_OTHER,
+    ['P' - 'A'] = GPS_TALKER_GP,
+    ['Q' - 'A'] = GPS_TALKER_GQ,
+    ['R' - 'A'] = GPS_TALKER_OTHER,
+    ['S' - 'A'] = GPS_TALKER_OTHER,
+    ['T' - 'A'] = GPS_TALKER_OTHER,
+    ['U' - 'A'] = GPS_TALKER_OTHER,
+    ['V' - 'A'] = GPS_TALKER_OTHER,
+    ['W' - 'A'] = GPS_TALKER_OTHER,
+    ['X' - 'A'] = GPS_TALKER_OTHER,
+    ['Y' - 'A'] = GPS_TALKER_OTHER,
+    ['Z' - 'A'] = GPS_TALKER_OTHER
+};
+
+static const uint8_t default_precedence[GPS_TALKER_COUNT] = {
+    GPS_TALKER_GN,
+    GPS_TALKER_GP,
+    GPS_TALKER_GL,
+    GPS_TALKER_GA,
+    GPS_TALKER_GB,
+    GPS_TALKER_GQ,
+    GPS_TALKER_GI,
+    GPS_TALKER_OTHER
+};
+
+static int has_group(const struct gps_tpv *tpv, int group)
+{
+    switch (group)
+    {
+    case GPS_TALKER_POSITION:
+        return (tpv->latitude != GPS_INVALID_VALUE) && (tpv->longitude != GPS_INVALID_VALUE);
+    case GPS_TALKER_VELOCITY:
+        return (tpv->track != GPS_INVALID_VALUE) || (tpv->speed != GPS_INVALID_VALUE);
+    case GPS_TALKER_TIME:
+        return strcmp(tpv->time, NULL_TIME) != 0;
+    default:
+        return tpv->mode != GPS_MODE_UNKNOWN;
+    }
+}
+
+static void copy_group(struct gps_tpv *combined, const struct gps_tpv *tpv, int group)
+{
+    switch (group)
+    {
+    case GPS_TALKER_POSITION:
+        combined->latitude = tpv->latitude;
+        combined->longitude = tpv->longitude;
+        combined->altitude = tpv->altitude;
+        memcpy(combined->talker_id, tpv->talker_id, GPS_TALKER_ID_SIZE);
+        break;
+    case GPS_TALKER_VELOCITY:
+        combined->track = tpv->track;
+        combined->speed = tpv->speed;
+        break;
+    case GPS_TALKER_TIME:
+        memcpy(combined->time, tpv->time, GPS_TIME_STRING_SIZE);
+        break;
+    default:
+        combined->mode = tpv->mode;
+        break;
+    }
+}
+
+/* Rebuilds the combined TPV from the talker TPVs, group by group */
+static void combine(struct gps_talker_table *table)
+{
+    int group;
+    size_t i;
+
+    gps_init_tpv(&table->combined);
+    for (group = 0; group < GPS_TALKER_GROUPS; ++group)
+    {
+        table->source[group] = GPS_TALKER_NONE;
+        for (i = 0; (i < GPS_TALKER_COUNT) && (table->precedence[group][i] != GPS_TALKER_NONE); ++i)
+        {
+            const uint8_t talker = table->precedence[group][i];
+            const struct gps_tpv *tpv = &table->tpv[talker];
+
+            if ((table->epoch - table->heard[talker] <= table->max_age) && has_group(tpv, group))
+            {
+                copy_group(&table->combined, tpv, group);
+                table->source[group] = talker;
+                break;
+            }
+        }
+    }
+}
+
+void gps_talker_init(struct gps_talker_table *table)
+{
+    assert(table != NULL);
+
+    int group;
+    size_t i;
+
+    for (i = 0; i < GPS_TALKER_COUNT; ++i)
+    {
+        gps_init_tpv(&table->tpv[i]);
+        table->sentences[i] = 0;
+        table->heard[i] = 0;
+    }
+
+    table->epoch = 0;
+    table->max_age = GPS_TALKER_MAX_AGE;
+    table->epoch_time = -1;
+
+    for (group = 0; group < GPS_TALKER_GROUPS; ++group)
+    {
+        memcpy(table->precedence[group], default_precedence, GPS_TALKER_COUNT);
+        table->source[group] = GPS_TALKER_NONE;
+    }
+
+    gps_init_tpv(&table->combined);
+}
+
+void gps_talker_set_precedence(struct gps_talker_table *table, int group, const uint8_t *order, size_t count)
+{
+    assert(table != NULL);
+    assert((group >= 0) && (group < GPS_TALKER_GROUPS));
+    assert((order != NULL) || (0 == count));
+    assert(count <= GPS_TALKER_COUNT);
+
+    size_t i;
+
+    for (i = 0; i < GPS_TALKER_COUNT; ++i)
+    {
+        if (i < count)
+        {
+            assert(order[i] < GPS_TALKER_COUNT);
+            table->precedence[group][i] = order[i];
+        }
+        else
+        {
+            table->precedence[group][i] = GPS_TALKER_NONE;
+        }
+    }
+
+    combine(table);
+}
+
+void gps_talker_set_max_age(struct gps_talker_table *table, uint32_t max_age)
+{
+    assert(table != NULL);
+
+    table->max_age = max_age;
+    combine(table);
+}
+
+int gps_talker_index(const char *talker_id)
+{
+    assert(talker_id != NULL);
+
+    unsigned char second = (unsigned char)talker_id[1];
+
+    if ('G' == talker_id[0])
+    {
+        if ((second >= 'A') && (second <= 'Z')) return g_talkers[second - 'A'];
+        return GPS_TALKER_OTHER;
+    }
+
+    /* BeiDou sentences are sent as BD by older receivers */
+    if (('B' == talker_id[0]) && ('D' == second)) return GPS_TALKER_GB;
+
+    return GPS_TALKER_OTHER;
+}
+
+int gps_talker_decode(struct gps_talker_table *table, const char *nmea, size_t size)
+{
+    assert(table != NULL);
+    assert(nmea != NULL);
+
+    struct gps_tpv tpv;
+    int talker;
+    int result;
+
+    /* Decode into a copy so that a bad sentence leaves the table unchanged */
+    if ((size < 3) || (nmea[0] != '$'))
+    {
+        gps_init_tpv(&tpv);
+        return gps_decode_const(&tpv, nmea, size);
+    }
+
+    talker = gps_talker_index(nmea + 1);
+    tpv = table->tpv[talker];
+    result = gps_decode_const(&tpv, nmea, size);
+    if (result != GPS_OK) return result;
+
+    /* A new time starts an epoch, unless it is the first time seen, which
+     * belongs to the epoch of the sentences before it
+     */
+    if (strcmp(tpv.time, table->tpv[talker].time) != 0)
+    {
+        int64_t time = gps_time_to_ms(tpv.time) % MS_PER_DAY;
+
+        if (time != table->epoch_time)
+        {
+            if (table->epoch_time >= 0) ++table->epoch;
+            table->epoch_time = time;
+        }
+    }
+
+    table->tpv[talker] = tpv;
+    table->heard[talker] = table->epoch;
+    ++table->sentences[talker];
+    combine(table);
+
+    return GPS_OK;
+}
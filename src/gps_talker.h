@@ -0,0 +1,157 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Jacob McGladdery
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/**
+ * @file gps_talker.h
+ * @brief Keeps the state of each talker apart and combines it by precedence.
+ *
+ * Multi-constellation receivers send GP, GL, GA and GB sentences for GPS,
+ * GLONASS, Galileo and BeiDou, and GN sentences for the combined solution,
+ * each with its own subset of sentence types. Decoding all of them into
+ * one gps_tpv lets a GLGSA overwrite the mode of a GNGSA. A talker table
+ * instead decodes every sentence into the TPV of its talker, found in
+ * constant time from the two talker ID characters, so each constellation
+ * keeps its own values.
+ *
+ * After every sentence decoded, the combined TPV is rebuilt from the talker
+ * TPVs. Its fields are taken in groups, such as the position or the fix
+ * mode, and each group comes from the first talker in its precedence list
+ * which has a valid value for it. By default GN comes first, then GP, GL,
+ * GA, GB, GQ, GI and any other talker, for every group.
+ *
+ * Receivers switch between GN and single system output as satellites come
+ * and go, so a talker only counts while it is current. A new epoch starts
+ * whenever a sentence brings a new time, and a talker not heard from for
+ * more than the maximum age, in epochs, is skipped. The default age of one
+ * epoch lets a preferred talker whose sentences come later in the epoch
+ * keep its place, and hands its groups to the next talker once it has
+ * missed a whole epoch.
+ */
+
+#ifndef _GPS_TALKER_H_
+#define _GPS_TALKER_H_
+
+#include "gps.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define GPS_TALKER_GP    (0) /**< GPS */
+#define GPS_TALKER_GL    (1) /**< GLONASS */
+#define GPS_TALKER_GA    (2) /**< Galileo */
+#define GPS_TALKER_GB    (3) /**< BeiDou, also sent as BD */
+#define GPS_TALKER_GQ    (4) /**< QZSS */
+#define GPS_TALKER_GI    (5) /**< NavIC */
+#define GPS_TALKER_GN    (6) /**< Combined solution of several systems */
+#define GPS_TALKER_OTHER (7) /**< Any other talker */
+#define GPS_TALKER_COUNT (8) /**< The number of talker TPVs */
+
+#define GPS_TALKER_POSITION (0) /**< Latitude, longitude and altitude */
+#define GPS_TALKER_VELOCITY (1) /**< Track and speed */
+#define GPS_TALKER_TIME     (2) /**< Time stamp */
+#define GPS_TALKER_MODE     (3) /**< Fix mode */
+#define GPS_TALKER_GROUPS   (4) /**< The number of field groups */
+
+#define GPS_TALKER_NONE (0xFF) /**< Ends a precedence list shorter than GPS_TALKER_COUNT */
+
+#define GPS_TALKER_MAX_AGE (1) /**< Default epochs a talker stays current after it was last heard */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Talker table state.
+ */
+struct gps_talker_table
+{
+    struct gps_tpv tpv[GPS_TALKER_COUNT];                      /**< Decoder state of each talker */
+    uint32_t sentences[GPS_TALKER_COUNT];                      /**< Sentences decoded per talker */
+    uint32_t heard[GPS_TALKER_COUNT];                          /**< Epoch each talker was last heard in */
+    uint32_t epoch;                                            /**< Epochs started since the first time */
+    uint32_t max_age;                                          /**< Epochs a talker stays current */
+    int64_t epoch_time;                                        /**< Time of day of the epoch in milliseconds, or -1 */
+    uint8_t precedence[GPS_TALKER_GROUPS][GPS_TALKER_COUNT];   /**< Talkers in order of preference, per group */
+    uint8_t source[GPS_TALKER_GROUPS];                         /**< Talker each group of gps_talker_table.combined came from */
+    struct gps_tpv combined;                                   /**< The combined TPV */
+};
+
+/**
+ * @brief Initializes a talker table with the default precedence.
+ *
+ * @param[out] table The table to initialize.
+ */
+void gps_talker_init(struct gps_talker_table *table);
+
+/**
+ * @brief Sets the precedence of the talkers for a group of fields.
+ *
+ * Talkers left out of @p order are never used for the group. The combined
+ * TPV is rebuilt with the new precedence.
+ *
+ * @param[in,out] table The table.
+ * @param[in] group The group, such as GPS_TALKER_POSITION.
+ * @param[in] order The talkers, such as GPS_TALKER_GN, most preferred first.
+ * @param[in] count The number of elements in @p order, at most
+ *            GPS_TALKER_COUNT.
+ */
+void gps_talker_set_precedence(struct gps_talker_table *table, int group, const uint8_t *order, size_t count);
+
+/**
+ * @brief Sets how long a talker stays current.
+ *
+ * The combined TPV is rebuilt with the new age.
+ *
+ * @param[in,out] table The table.
+ * @param[in] max_age The number of epochs after the one a talker was last
+ *            heard in for which it is still used, 0 for only the current
+ *            epoch.
+ */
+void gps_talker_set_max_age(struct gps_talker_table *table, uint32_t max_age);
+
+/**
+ * @brief Finds the talker TPV for a talker ID.
+ *
+ * @param[in] talker_id The two characters of the talker ID.
+ * @return The talker, such as GPS_TALKER_GP, or GPS_TALKER_OTHER.
+ */
+int gps_talker_index(const char *talker_id);
+
+/**
+ * @brief Decodes a sentence into the TPV of its talker and rebuilds the
+ *        combined TPV.
+ *
+ * @param[in,out] table The table.
+ * @param[in] nmea The sentence, see gps_decode_const().
+ * @param[in] size The number of characters readable at @p nmea.
+ * @return The result of gps_decode_const(). The table only changes when it
+ *         is GPS_OK.
+ */
+int gps_talker_decode(struct gps_talker_table *table, const char *nmea, size_t size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _GPS_TALKER_H_ */
@@ -0,0 +1,210 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Jacob McGladdery
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include "gps.h"
+#include "gps_aggregate.h"
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <string.h>
+#include <cmocka.h>
+
+#define MAX_BUCKETS (8)
+
+struct emitted
+{
+    struct gps_aggregate_bucket buckets[MAX_BUCKETS];
+    int count;
+};
+
+static void on_bucket(void *context, const struct gps_aggregate_bucket *bucket)
+{
+    struct emitted *e = context;
+
+    assert_true(e->count < MAX_BUCKETS);
+    e->buckets[e->count++] = *bucket;
+}
+
+static void fix(struct gps_tpv *tpv, int32_t speed, int32_t altitude, int32_t latitude, int32_t longitude)
+{
+    gps_init_tpv(tpv);
+    tpv->mode = GPS_MODE_3D_FIX;
+    tpv->speed = speed;
+    tpv->altitude = altitude;
+    tpv->latitude = latitude;
+    tpv->longitude = longitude;
+}
+
+static void test_aggregate_buckets(void **state)
+{
+    (void)state;
+    struct gps_aggregate aggregate;
+    struct emitted emitted;
+    struct gps_tpv tpv;
+    const struct gps_aggregate_bucket *b;
+    int i;
+
+    memset(&emitted, 0, sizeof(emitted));
+    gps_aggregate_init(&aggregate, 1000, on_bucket, &emitted);
+
+    /* Two and a half seconds at 10 Hz, speeding up by 100 mm/s each fix */
+    for (i = 0; i < 25; ++i)
+    {
+        fix(&tpv, 1000 + 100 * i, 61700 - i, 53000000 + i, -6000000 - i);
+        gps_aggregate_add(&aggregate, &tpv, 45000000 + 100 * i);
+    }
+    assert_int_equal(emitted.count, 2);
+
+    b = &emitted.buckets[0];
+    assert_int_equal(b->start, 45000000);
+    assert_int_equal(b->samples, 10);
+    assert_int_equal(b->speed.first, 1000);
+    assert_int_equal(b->speed.last, 1900);
+    assert_int_equal(b->speed.min, 1000);
+    assert_int_equal(b->speed.max, 1900);
+    assert_int_equal(b->speed.mean, 1450);
+    assert_int_equal(b->altitude.min, 61691);
+    assert_int_equal(b->altitude.max, 61700);
+    assert_int_equal(b->altitude.mean, 61696);
+    assert_int_equal(b->latitude, 53000005);
+    assert_int_equal(b->longitude, -6000005);
+    assert_int_equal(b->modes[GPS_MODE_3D_FIX], 10);
+
+    assert_int_equal(emitted.buckets[1].start, 45001000);
+    assert_int_equal(emitted.buckets[1].speed.first, 2000);
+
+    /* The last half second comes out on a flush */
+    gps_aggregate_flush(&aggregate);
+    assert_int_equal(emitted.count, 3);
+    assert_int_equal(emitted.buckets[2].samples, 5);
+    assert_int_equal(emitted.buckets[2].speed.last, 3400);
+    gps_aggregate_flush(&aggregate);
+    assert_int_equal(emitted.count, 3);
+}
+
+static void test_aggregate_invalid(void **state)
+{
+    (void)state;
+    struct gps_aggregate aggregate;
+    struct emitted emitted;
+    struct gps_tpv tpv;
+    const struct gps_aggregate_bucket *b;
+
+    memset(&emitted, 0, sizeof(emitted));
+    gps_aggregate_init(&aggregate, 60000, on_bucket, &emitted);
+
+    /* No fix, then a 2D fix without altitude */
+    gps_init_tpv(&tpv);
+    tpv.mode = GPS_MODE_NO_FIX;
+    gps_aggregate_add(&aggregate, &tpv, 1000);
+    fix(&tpv, 500, GPS_INVALID_VALUE, 10000000, 20000000);
+    tpv.mode = GPS_MODE_2D_FIX;
+    gps_aggregate_add(&aggregate, &tpv, 2000);
+    gps_aggregate_flush(&aggregate);
+
+    b = &emitted.buckets[0];
+    assert_int_equal(b->samples, 2);
+    assert_int_equal(b->positions, 1);
+    assert_int_equal(b->speed.count, 1);
+    assert_int_equal(b->speed.mean, 500);
+    assert_int_equal(b->altitude.count, 0);
+    assert_int_equal(b->altitude.first, GPS_INVALID_VALUE);
+    assert_int_equal(b->altitude.mean, GPS_INVALID_VALUE);
+    assert_int_equal(b->modes[GPS_MODE_NO_FIX], 1);
+    assert_int_equal(b->modes[GPS_MODE_2D_FIX], 1);
+
+    /* A bucket without positions */
+    gps_init_tpv(&tpv);
+    gps_aggregate_add(&aggregate, &tpv, 3000);
+    gps_aggregate_flush(&aggregate);
+    assert_int_equal(emitted.buckets[1].latitude, GPS_INVALID_VALUE);
+    assert_int_equal(emitted.buckets[1].longitude, GPS_INVALID_VALUE);
+    assert_int_equal(emitted.buckets[1].modes[GPS_MODE_UNKNOWN], 1);
+}
+
+static void test_aggregate_antimeridian(void **state)
+{
+    (void)state;
+    struct gps_aggregate aggregate;
+    struct emitted emitted;
+    struct gps_tpv tpv;
+
+    memset(&emitted, 0, sizeof(emitted));
+    gps_aggregate_init(&aggregate, 1000, on_bucket, &emitted);
+
+    /* Crossing 180 degrees eastward, the centroid is near it rather than
+     * near 0 degrees
+     */
+    fix(&tpv, 0, 0, -17000000, 179999000);
+    gps_aggregate_add(&aggregate, &tpv, 0);
+    fix(&tpv, 0, 0, -17000000, -179997000);
+    gps_aggregate_add(&aggregate, &tpv, 500);
+    gps_aggregate_flush(&aggregate);
+    assert_int_equal(emitted.buckets[0].longitude, -179999000);
+
+    fix(&tpv, 0, 0, 0, -179999000);
+    gps_aggregate_add(&aggregate, &tpv, 1000);
+    fix(&tpv, 0, 0, 0, 179997000);
+    gps_aggregate_add(&aggregate, &tpv, 1500);
+    gps_aggregate_flush(&aggregate);
+    assert_int_equal(emitted.buckets[1].longitude, 179999000);
+}
+
+static void test_aggregate_time_back(void **state)
+{
+    (void)state;
+    struct gps_aggregate aggregate;
+    struct emitted emitted;
+    struct gps_tpv tpv;
+
+    memset(&emitted, 0, sizeof(emitted));
+    gps_aggregate_init(&aggregate, 60000, on_bucket, &emitted);
+    fix(&tpv, 100, 0, 0, 0);
+
+    /* Times of day across midnight */
+    gps_aggregate_add(&aggregate, &tpv, GPS_MS_PER_DAY - 500);
+    gps_aggregate_add(&aggregate, &tpv, 500);
+    assert_int_equal(emitted.count, 1);
+    assert_int_equal(emitted.buckets[0].start, GPS_MS_PER_DAY - 60000);
+
+    /* Negative times round down */
+    gps_aggregate_add(&aggregate, &tpv, -1);
+    assert_int_equal(emitted.count, 2);
+    assert_int_equal(emitted.buckets[1].start, 0);
+    gps_aggregate_flush(&aggregate);
+    assert_int_equal(emitted.buckets[2].start, -60000);
+}
+
+int main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_aggregate_buckets),
+        cmocka_unit_test(test_aggregate_invalid),
+        cmocka_unit_test(test_aggregate_antimeridian),
+        cmocka_unit_test(test_aggregate_time_back)
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,230 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Jacob McGladdery
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include "gps_archive.h"
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <string.h>
+#include <cmocka.h>
+
+#define NUM_RECORDS (100)
+
+struct memory_sink
+{
+    uint8_t data[8192];
+    size_t size;
+    int writes;
+};
+
+static int memory_write(void *context, const void *data, size_t size)
+{
+    struct memory_sink *sink = context;
+
+    if (size > sizeof(sink->data) - sink->size) return -1;
+    memcpy(sink->data + sink->size, data, size);
+    sink->size += size;
+    sink->writes++;
+    return 0;
+}
+
+static int failing_write(void *context, const void *data, size_t size)
+{
+    (void)context;
+    (void)data;
+    (void)size;
+    return -1;
+}
+
+static void make_tpv(struct gps_tpv *tpv, int i)
+{
+    gps_init_tpv(tpv);
+    tpv->mode = GPS_MODE_3D_FIX;
+    tpv->latitude = 48117300 + i * 13;
+    tpv->longitude = 11516667 - i * 7;
+    tpv->altitude = 545400 + (i % 5);
+    tpv->speed = 11523;
+    tpv->track = (i % 3) ? 84400 : GPS_INVALID_VALUE;
+    gps_ms_to_time(tpv->time, INT64_C(764426119000) + i * 1000, 1);
+    strcpy(tpv->talker_id, (i < NUM_RECORDS / 2) ? "GP" : "GN");
+}
+
+static void assert_tpv_equal(const struct gps_tpv *a, const struct gps_tpv *b)
+{
+    assert_true(a->mode == b->mode);
+    assert_int_equal(a->altitude, b->altitude);
+    assert_int_equal(a->latitude, b->latitude);
+    assert_int_equal(a->longitude, b->longitude);
+    assert_int_equal(a->track, b->track);
+    assert_int_equal(a->speed, b->speed);
+    assert_string_equal(a->time, b->time);
+    assert_string_equal(a->talker_id, b->talker_id);
+}
+
+static void test_archive_round_trip(void **state)
+{
+    (void)state;
+    static struct memory_sink sink;
+    struct gps_archive_writer writer;
+    struct gps_archive_reader reader;
+    struct gps_archive_block block;
+    struct gps_tpv expected, actual;
+    uint8_t buffer[256];
+    int blocks = 0;
+    int i = 0;
+
+    sink.size = 0;
+    gps_archive_writer_init(&writer, buffer, sizeof(buffer), memory_write, &sink);
+    for (i = 0; i < NUM_RECORDS; ++i)
+    {
+        make_tpv(&expected, i);
+        assert_int_equal(gps_archive_write(&writer, &expected), GPS_OK);
+    }
+    assert_int_equal(gps_archive_flush(&writer), GPS_OK);
+
+    /* Smaller than a raw struct and much smaller than the NMEA */
+    assert_true(sink.size < NUM_RECORDS * 16);
+
+    assert_int_equal(gps_archive_reader_init(&reader, sink.data, sink.size), GPS_OK);
+    i = 0;
+    while (gps_archive_next_block(&reader, &block) == GPS_OK)
+    {
+        int64_t first = INT64_C(764426119000) + i * 1000;
+
+        assert_true(block.time_min == first);
+        assert_true(block.time_max == first + (int64_t)(block.count - 1) * 1000);
+        while (gps_archive_read(&reader, &actual) == GPS_OK)
+        {
+            make_tpv(&expected, i++);
+            assert_tpv_equal(&expected, &actual);
+        }
+        blocks++;
+    }
+    assert_int_equal(i, NUM_RECORDS);
+    assert_true(blocks > 1);
+}
+
+static void test_archive_invalid_values(void **state)
+{
+    (void)state;
+    static struct memory_sink sink;
+    struct gps_archive_writer writer;
+    struct gps_archive_reader reader;
+    struct gps_tpv expected, actual;
+    uint8_t buffer[128];
+
+    sink.size = 0;
+    gps_init_tpv(&expected);
+    gps_archive_writer_init(&writer, buffer, sizeof(buffer), memory_write, &sink);
+    assert_int_equal(gps_archive_write(&writer, &expected), GPS_OK);
+    assert_int_equal(gps_archive_flush(&writer), GPS_OK);
+
+    assert_int_equal(gps_archive_reader_init(&reader, sink.data, sink.size), GPS_OK);
+    assert_int_equal(gps_archive_next_block(&reader, NULL), GPS_OK);
+    assert_int_equal(gps_archive_read(&reader, &actual), GPS_OK);
+    assert_tpv_equal(&expected, &actual);
+    assert_int_equal(gps_archive_read(&reader, &actual), GPS_ERROR_END);
+    assert_int_equal(gps_archive_next_block(&reader, NULL), GPS_ERROR_END);
+}
+
+static void test_archive_seek(void **state)
+{
+    (void)state;
+    static struct memory_sink sink;
+    struct gps_archive_writer writer;
+    struct gps_archive_reader reader;
+    struct gps_archive_block first, second;
+    struct gps_tpv tpv;
+    uint8_t buffer[128];
+    int i;
+
+    sink.size = 0;
+    gps_archive_writer_init(&writer, buffer, sizeof(buffer), memory_write, &sink);
+    for (i = 0; i < NUM_RECORDS; ++i)
+    {
+        make_tpv(&tpv, i);
+        assert_int_equal(gps_archive_write(&writer, &tpv), GPS_OK);
+    }
+    assert_int_equal(gps_archive_flush(&writer), GPS_OK);
+
+    assert_int_equal(gps_archive_reader_init(&reader, sink.data, sink.size), GPS_OK);
+    assert_int_equal(gps_archive_next_block(&reader, &first), GPS_OK);
+    assert_int_equal(gps_archive_next_block(&reader, &second), GPS_OK);
+    assert_int_equal(gps_archive_seek(&reader, first.offset), GPS_OK);
+    assert_int_equal(gps_archive_next_block(&reader, &second), GPS_OK);
+    assert_int_equal(second.offset, first.offset);
+    assert_int_equal(gps_archive_read(&reader, &tpv), GPS_OK);
+    assert_true(gps_time_to_ms(tpv.time) == first.time_min);
+}
+
+static void test_archive_corrupt(void **state)
+{
+    (void)state;
+    static struct memory_sink sink;
+    struct gps_archive_writer writer;
+    struct gps_archive_reader reader;
+    struct gps_tpv tpv;
+    uint8_t buffer[128];
+
+    sink.size = 0;
+    make_tpv(&tpv, 0);
+    gps_archive_writer_init(&writer, buffer, sizeof(buffer), memory_write, &sink);
+    assert_int_equal(gps_archive_write(&writer, &tpv), GPS_OK);
+    assert_int_equal(gps_archive_flush(&writer), GPS_OK);
+
+    /* Truncated block */
+    assert_int_equal(gps_archive_reader_init(&reader, sink.data, sink.size - 1), GPS_OK);
+    assert_int_equal(gps_archive_next_block(&reader, NULL), GPS_ERROR_CORRUPT);
+
+    /* Bad magic */
+    sink.data[0] = 'X';
+    assert_int_equal(gps_archive_reader_init(&reader, sink.data, sink.size), GPS_ERROR_CORRUPT);
+}
+
+static void test_archive_write_failure(void **state)
+{
+    (void)state;
+    struct gps_archive_writer writer;
+    struct gps_tpv tpv;
+    uint8_t buffer[128];
+
+    make_tpv(&tpv, 0);
+    gps_archive_writer_init(&writer, buffer, sizeof(buffer), failing_write, NULL);
+    assert_int_equal(gps_archive_write(&writer, &tpv), GPS_OK);
+    assert_int_equal(gps_archive_flush(&writer), GPS_ERROR_IO);
+}
+
+int main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_archive_round_trip),
+        cmocka_unit_test(test_archive_invalid_values),
+        cmocka_unit_test(test_archive_seek),
+        cmocka_unit_test(test_archive_corrupt),
+        cmocka_unit_test(test_archive_write_failure)
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
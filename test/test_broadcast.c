@@ -0,0 +1,275 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Jacob McGladdery
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include "gps.h"
+#include "gps_broadcast.h"
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <cmocka.h>
+
+#define SOCKET_PATH "test_broadcast.sock"
+#define NUM_CLIENTS (2)
+#define MS          (1000000)
+
+static void decode(struct gps_tpv *tpv, const char *body)
+{
+    char nmea[128];
+
+    gps_encode(nmea, body);
+    assert_int_equal(gps_decode(tpv, nmea), GPS_OK);
+}
+
+static void open_broadcast(struct gps_broadcast *broadcast, struct gps_broadcast_client *clients,
+                           size_t capacity, int64_t hold)
+{
+    assert_int_equal(gps_broadcast_init(broadcast, clients, capacity, SOCKET_PATH, hold), GPS_OK);
+}
+
+static int connect_client(struct gps_broadcast *broadcast)
+{
+    int fd;
+
+    assert_int_equal(gps_broadcast_connect(SOCKET_PATH, &fd), GPS_OK);
+    gps_broadcast_service(broadcast, 0);
+    return fd;
+}
+
+/* Receives a message without waiting, and returns its record count or -1 */
+static int receive(int fd, uint32_t *sequence, struct gps_broadcast_record *records)
+{
+    uint8_t message[GPS_BROADCAST_MESSAGE_SIZE];
+    ssize_t size;
+    size_t count;
+
+    size = recv(fd, message, sizeof(message), MSG_DONTWAIT);
+    if (size < 0) return -1;
+    assert_int_equal(gps_broadcast_parse(message, (size_t)size, sequence, records, &count), GPS_OK);
+    return (int)count;
+}
+
+static void test_broadcast_epochs(void **state)
+{
+    (void)state;
+    struct gps_broadcast_client clients[NUM_CLIENTS];
+    struct gps_broadcast_record records[GPS_BROADCAST_BATCH_SIZE];
+    struct gps_broadcast broadcast;
+    struct gps_tpv tpv[2];
+    struct gps_tpv unpacked;
+    uint32_t sequence;
+    int fd;
+
+    open_broadcast(&broadcast, clients, NUM_CLIENTS, 500 * MS);
+    fd = connect_client(&broadcast);
+    gps_init_tpv(&tpv[0]);
+    gps_init_tpv(&tpv[1]);
+
+    /* Two sentences of one epoch from each device make one record each */
+    decode(&tpv[0], "GPGGA,092750.000,5321.6802,N,00630.3371,W,1,8,1.03,61.7,M,55.3,M,,");
+    gps_broadcast_update(&broadcast, 0, &tpv[0], 0);
+    decode(&tpv[1], "GPGGA,092750.000,4807.0380,N,01131.0000,E,1,8,0.9,545.4,M,46.9,M,,");
+    gps_broadcast_update(&broadcast, 1, &tpv[1], 0);
+    decode(&tpv[0], "GPVTG,176.90,T,,M,3.68,N,6.81,K,A");
+    gps_broadcast_update(&broadcast, 0, &tpv[0], 1 * MS);
+    assert_int_equal(broadcast.count, 2);
+    assert_int_equal(receive(fd, &sequence, records), -1);
+
+    /* The next epoch of a device sends the batch */
+    tpv[1].time[18] = '1';
+    gps_broadcast_update(&broadcast, 1, &tpv[1], 1000 * MS);
+    assert_int_equal(broadcast.count, 1);
+    assert_int_equal(receive(fd, &sequence, records), 2);
+    assert_int_equal(sequence, 0);
+    assert_int_equal(records[0].device, 0);
+    assert_int_equal(records[1].device, 1);
+
+    gps_compact_to_tpv(&unpacked, &records[0].tpv);
+    assert_memory_equal(&unpacked, &tpv[0], sizeof(unpacked));
+    assert_int_equal(unpacked.speed, 1891);
+
+    gps_broadcast_flush(&broadcast);
+    assert_int_equal(receive(fd, &sequence, records), 1);
+    assert_int_equal(sequence, 1);
+    gps_compact_to_tpv(&unpacked, &records[0].tpv);
+    assert_memory_equal(&unpacked, &tpv[1], sizeof(unpacked));
+    assert_int_equal(clients[0].sent, 2);
+
+    close(fd);
+    gps_broadcast_close(&broadcast);
+    unlink(SOCKET_PATH);
+}
+
+static void test_broadcast_hold(void **state)
+{
+    (void)state;
+    struct gps_broadcast_client clients[NUM_CLIENTS];
+    struct gps_broadcast_record records[GPS_BROADCAST_BATCH_SIZE];
+    struct gps_broadcast broadcast;
+    struct gps_tpv tpv;
+    uint32_t sequence;
+    uint16_t device;
+    int fd;
+
+    open_broadcast(&broadcast, clients, NUM_CLIENTS, 50 * MS);
+    fd = connect_client(&broadcast);
+    gps_init_tpv(&tpv);
+    decode(&tpv, "GPGGA,092750.000,5321.6802,N,00630.3371,W,1,8,1.03,61.7,M,55.3,M,,");
+
+    assert_int_equal(gps_broadcast_service(&broadcast, 0), -1);
+    gps_broadcast_update(&broadcast, 0, &tpv, 1000 * MS);
+    assert_int_equal(gps_broadcast_service(&broadcast, 1000 * MS), 50);
+    assert_int_equal(gps_broadcast_service(&broadcast, 1030 * MS + 1), 20);
+    assert_int_equal(receive(fd, &sequence, records), -1);
+    assert_int_equal(gps_broadcast_service(&broadcast, 1050 * MS), -1);
+    assert_int_equal(receive(fd, &sequence, records), 1);
+
+    /* A full batch is sent without waiting */
+    for (device = 0; device <= GPS_BROADCAST_BATCH_SIZE; ++device)
+    {
+        gps_broadcast_update(&broadcast, device, &tpv, 2000 * MS);
+    }
+    assert_int_equal(receive(fd, &sequence, records), GPS_BROADCAST_BATCH_SIZE);
+    assert_int_equal(records[GPS_BROADCAST_BATCH_SIZE - 1].device, GPS_BROADCAST_BATCH_SIZE - 1);
+    assert_int_equal(broadcast.count, 1);
+
+    close(fd);
+    gps_broadcast_close(&broadcast);
+    unlink(SOCKET_PATH);
+}
+
+static void test_broadcast_slow_client(void **state)
+{
+    (void)state;
+    struct gps_broadcast_client clients[NUM_CLIENTS];
+    struct gps_broadcast_record records[GPS_BROADCAST_BATCH_SIZE];
+    struct gps_broadcast broadcast;
+    struct gps_tpv tpv;
+    uint32_t sequence;
+    uint32_t i;
+    int fast;
+    int slow;
+    int count;
+
+    open_broadcast(&broadcast, clients, NUM_CLIENTS, 0);
+    fast = connect_client(&broadcast);
+    slow = connect_client(&broadcast);
+    gps_init_tpv(&tpv);
+    decode(&tpv, "GPGGA,092750.000,5321.6802,N,00630.3371,W,1,8,1.03,61.7,M,55.3,M,,");
+
+    /* The slow client never reads, and the flushes must not wait for it */
+    for (i = 0; (i < 100000) && (0 == clients[1].skipped); ++i)
+    {
+        gps_broadcast_update(&broadcast, 0, &tpv, 0);
+        gps_broadcast_flush(&broadcast);
+        assert_int_equal(receive(fast, &sequence, records), 1);
+        assert_int_equal(sequence, i);
+    }
+    assert_true(clients[1].skipped > 0);
+    assert_int_equal(clients[0].skipped, 0);
+    assert_int_equal(clients[0].sent, i);
+
+    /* The slow client gets the batches queued before the gap */
+    for (count = 0; receive(slow, &sequence, records) > 0; ++count)
+    {
+        assert_int_equal(sequence, (uint32_t)count);
+    }
+    assert_int_equal(count, clients[1].sent);
+
+    /* Once it catches up it receives again, after the gap */
+    gps_broadcast_update(&broadcast, 0, &tpv, 0);
+    gps_broadcast_flush(&broadcast);
+    assert_int_equal(receive(slow, &sequence, records), 1);
+    assert_int_equal(sequence, i);
+    assert_true(sequence > (uint32_t)count);
+
+    close(fast);
+    close(slow);
+    gps_broadcast_close(&broadcast);
+    unlink(SOCKET_PATH);
+}
+
+static void test_broadcast_clients(void **state)
+{
+    (void)state;
+    struct gps_broadcast_client clients[NUM_CLIENTS];
+    struct gps_broadcast_record records[GPS_BROADCAST_BATCH_SIZE];
+    struct gps_broadcast broadcast;
+    struct gps_tpv tpv;
+    uint8_t message[GPS_BROADCAST_MESSAGE_SIZE];
+    uint32_t sequence;
+    size_t count;
+    int fd[NUM_CLIENTS + 1];
+    int i;
+
+    open_broadcast(&broadcast, clients, NUM_CLIENTS, 0);
+    for (i = 0; i < NUM_CLIENTS + 1; ++i) fd[i] = connect_client(&broadcast);
+    assert_int_equal(broadcast.refused, 1);
+
+    /* A client which hung up is disconnected, freeing its slot */
+    close(fd[0]);
+    gps_init_tpv(&tpv);
+    gps_broadcast_update(&broadcast, 0, &tpv, 0);
+    gps_broadcast_flush(&broadcast);
+    assert_int_equal(broadcast.disconnected, 1);
+    assert_int_equal(clients[0].fd, -1);
+    assert_int_equal(receive(fd[1], &sequence, records), 1);
+    close(fd[2]);
+    fd[2] = connect_client(&broadcast);
+    assert_int_equal(broadcast.refused, 1);
+
+    /* Malformed messages */
+    memset(message, 0, sizeof(message));
+    assert_int_equal(gps_broadcast_parse(message, 4, &sequence, records, &count), GPS_ERROR_CORRUPT);
+    memcpy(message, "GB\x02\x00", 4);
+    assert_int_equal(gps_broadcast_parse(message, 8, &sequence, records, &count), GPS_ERROR_UNSUPPORTED);
+    memcpy(message, "GB\x01\x01", 4);
+    assert_int_equal(gps_broadcast_parse(message, 8, &sequence, records, &count), GPS_ERROR_CORRUPT);
+    assert_int_equal(gps_broadcast_parse(message, 8 + GPS_BROADCAST_RECORD_SIZE, &sequence, records, &count),
+                     GPS_OK);
+    assert_int_equal(count, 1);
+    message[3] = GPS_BROADCAST_BATCH_SIZE + 1;
+    assert_int_equal(gps_broadcast_parse(message, sizeof(message), &sequence, records, &count), GPS_ERROR_CORRUPT);
+
+    close(fd[1]);
+    close(fd[2]);
+    gps_broadcast_close(&broadcast);
+    unlink(SOCKET_PATH);
+}
+
+int main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_broadcast_epochs),
+        cmocka_unit_test(test_broadcast_hold),
+        cmocka_unit_test(test_broadcast_slow_client),
+        cmocka_unit_test(test_broadcast_clients)
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,170 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Jacob McGladdery
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include "gps_compact.h"
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <string.h>
+#include <cmocka.h>
+
+/* A day's worth of receiver output in the order a receiver might send it,
+ * crossing midnight and mixing sentences with and without a date
+ */
+static const char *sentences[] = {
+    "GPGSA,A,3,01,04,07,16,20,,,,,,,,3.6,2.2,2.7",
+    "GPGGA,235958.5,3723.46587704,N,12202.26957864,W,2,6,1.2,18.893,M,-25.669,M,2.0,0031",
+    "GPRMC,235959,A,3907.3840,N,12102.4692,W,0.0,156.1,131102,15.3,E,A",
+    "GPVTG,176.90,T,,M,3.68,N,6.81,K,A",
+    "GPGGA,000000.000,5321.6802,N,00630.3371,W,1,8,1.03,61.7,M,55.3,M,,",
+    "GNRMC,000001,A,3907.3840,N,12102.4692,W,0.0,156.1,141102,15.3,E,A",
+    "GPGLL,3704.229,N,07647.090,W,153030.311,A",
+    "GPZDA,050306,29,10,2003,,",
+    "GPGSA,A,2,01,04,07,,,,,,,,,,3.6,2.2,2.7",
+    "GPGGA,050307.000,5321.6802,N,00630.3371,W,1,8,1.03,61.7,M,55.3,M,,"
+};
+
+static void decode(struct gps_tpv *tpv, const char *body)
+{
+    char nmea[128];
+
+    gps_encode(nmea, body);
+    assert_int_equal(gps_decode(tpv, nmea), GPS_OK);
+}
+
+static void test_compact_size(void **state)
+{
+    (void)state;
+
+    assert_int_equal(sizeof(struct gps_compact_tpv), 32);
+    assert_int_equal(sizeof(struct gps_compact_tpv16), 24);
+}
+
+static void test_compact_round_trip(void **state)
+{
+    (void)state;
+    struct gps_compact_tpv compact;
+    struct gps_tpv tpv;
+    struct gps_tpv unpacked;
+    size_t i;
+
+    gps_init_tpv(&tpv);
+    gps_compact_from_tpv(&compact, &tpv);
+    gps_compact_to_tpv(&unpacked, &compact);
+    assert_memory_equal(&unpacked, &tpv, sizeof(tpv));
+
+    for (i = 0; i < sizeof(sentences) / sizeof(sentences[0]); ++i)
+    {
+        decode(&tpv, sentences[i]);
+        gps_compact_from_tpv(&compact, &tpv);
+        gps_compact_to_tpv(&unpacked, &compact);
+        assert_memory_equal(&unpacked, &tpv, sizeof(tpv));
+    }
+
+    assert_int_equal(compact.flags & GPS_COMPACT_MODE_MASK, GPS_MODE_2D_FIX);
+    assert_true(compact.flags & GPS_COMPACT_HAS_DATE);
+    assert_int_equal(compact.time, INT64_C(1067403787000));
+    assert_memory_equal(compact.talker_id, "GP", 2);
+}
+
+static void test_compact16_round_trip(void **state)
+{
+    (void)state;
+    struct gps_compact_tpv16 compact;
+    struct gps_tpv tpv;
+    struct gps_tpv unpacked;
+
+    gps_init_tpv(&tpv);
+    assert_int_equal(gps_compact16_from_tpv(&compact, &tpv, 0), GPS_OK);
+    gps_compact16_to_tpv(&unpacked, &compact, 0);
+    assert_memory_equal(&unpacked, &tpv, sizeof(tpv));
+
+    /* Altitude 61.7 m stored relative to a base of 40 m */
+    decode(&tpv, "GPGGA,092751.000,5321.6802,N,00630.3371,W,1,8,1.03,61.7,M,55.3,M,,");
+    decode(&tpv, "GNRMC,092752,A,5321.6802,N,00630.3371,W,12.5,156.1,141102,15.3,E,A");
+    assert_int_equal(gps_compact16_from_tpv(&compact, &tpv, 40000), GPS_OK);
+    assert_int_equal(compact.altitude, 217);
+    assert_int_equal(compact.track, 15610);
+    assert_int_equal(compact.speed, 6430);
+    gps_compact16_to_tpv(&unpacked, &compact, 40000);
+    assert_memory_equal(&unpacked, &tpv, sizeof(tpv));
+
+    /* Millimeter altitudes do not fit */
+    decode(&tpv, "GPGGA,172814.0,3723.46587704,N,12202.26957864,W,2,6,1.2,18.893,M,-25.669,M,2.0,0031");
+    assert_int_equal(gps_compact16_from_tpv(&compact, &tpv, 0), GPS_ERROR_OVERFLOW);
+
+    /* Nor do altitudes too far from the base */
+    decode(&tpv, "GPGGA,092751.000,5321.6802,N,00630.3371,W,1,8,1.03,61.7,M,55.3,M,,");
+    assert_int_equal(gps_compact16_from_tpv(&compact, &tpv, 61700 - 3276700), GPS_OK);
+    assert_int_equal(gps_compact16_from_tpv(&compact, &tpv, 61700 - 3276800), GPS_ERROR_OVERFLOW);
+
+    /* Speeds above 65.535 m/s */
+    decode(&tpv, "GPVTG,176.90,T,,M,3.68,N,235.0,K,A");
+    assert_int_equal(gps_compact16_from_tpv(&compact, &tpv, 0), GPS_OK);
+    decode(&tpv, "GPVTG,176.90,T,,M,3.68,N,240.0,K,A");
+    assert_int_equal(gps_compact16_from_tpv(&compact, &tpv, 0), GPS_ERROR_OVERFLOW);
+
+    /* Talker IDs other than letters */
+    decode(&tpv, "P1GGA,092751.000,5321.6802,N,00630.3371,W,1,8,1.03,61.7,M,55.3,M,,");
+    assert_int_equal(gps_compact16_from_tpv(&compact, &tpv, 0), GPS_ERROR_OVERFLOW);
+}
+
+static void test_compact_decode(void **state)
+{
+    (void)state;
+    struct gps_compact_tpv compact;
+    struct gps_compact_tpv expected;
+    struct gps_tpv tpv;
+    char nmea[128];
+    size_t i;
+
+    gps_init_tpv(&tpv);
+    gps_compact_from_tpv(&compact, &tpv);
+
+    for (i = 0; i < sizeof(sentences) / sizeof(sentences[0]); ++i)
+    {
+        gps_encode(nmea, sentences[i]);
+        assert_int_equal(gps_compact_decode(&tpv, &compact, nmea), GPS_OK);
+        gps_compact_from_tpv(&expected, &tpv);
+        assert_memory_equal(&compact, &expected, sizeof(compact));
+    }
+
+    /* Failures leave the packed TPV alone */
+    strcpy(nmea, "$GPGGA,092751.000,5321.6802,N,00630.3371,W,1,8,1.03,61.7,M,55.3,M,,*FF\r\n");
+    assert_int_equal(gps_compact_decode(&tpv, &compact, nmea), GPS_ERROR_CHECKSUM);
+    assert_memory_equal(&compact, &expected, sizeof(compact));
+}
+
+int main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_compact_size),
+        cmocka_unit_test(test_compact_round_trip),
+        cmocka_unit_test(test_compact16_round_trip),
+        cmocka_unit_test(test_compact_decode)
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
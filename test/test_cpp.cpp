@@ -0,0 +1,174 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Jacob McGladdery
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include "gps.hpp"
+#include "gps_latest.h"
+
+#include <cstdarg>
+#include <cstddef>
+#include <csetjmp>
+#include <cstring>
+#include <iterator>
+#include <string>
+#include <string_view>
+
+extern "C" {
+#include <cmocka.h>
+}
+
+namespace
+{
+
+// The C headers of the optional modules must compile as C++ too
+static_assert(sizeof(gps_latest) > sizeof(gps_tpv));
+
+std::string encode(const char *body)
+{
+    char nmea[128];
+
+    gps_encode(nmea, body);
+    return nmea;
+}
+
+const std::string GGA = encode("GPGGA,092751.000,5321.6802,N,00630.3371,W,1,8,1.03,61.7,M,55.3,M,,");
+const std::string RMC = encode("GPRMC,092751.000,A,5321.6802,N,00630.3371,W,0.02,31.66,280511,,,A");
+const std::string VTG = encode("GPVTG,176.90,T,,M,3.68,N,6.81,K,A");
+
+void test_cpp_string_view(void **state)
+{
+    (void)state;
+    const std::string copy = GGA;
+    gps::all_decoder decoder;
+    gps_tpv expected;
+    char nmea[128];
+
+    gps_init_tpv(&expected);
+    std::strcpy(nmea, GGA.c_str());
+    assert_int_equal(gps_decode(&expected, nmea), GPS_OK);
+
+    /* Decoded in place, with anything after the footer ignored */
+    assert_int_equal(decoder.decode(std::string_view(GGA + "$GPGGA")), GPS_OK);
+    assert_memory_equal(&decoder.tpv(), &expected, sizeof(expected));
+    assert_true(GGA == copy);
+
+    assert_int_equal(decoder.decode(VTG), GPS_OK);
+    assert_int_equal(decoder.tpv().speed, 1891);
+
+    decoder.reset();
+    assert_int_equal(decoder.tpv().latitude, GPS_INVALID_VALUE);
+}
+
+void test_cpp_sentence_set(void **state)
+{
+    (void)state;
+    gps::decoder<gps::gga, gps::rmc> decoder;
+    gps::all_decoder all;
+    gps_tpv before;
+
+    assert_int_equal(decoder.decode(GGA), GPS_OK);
+    assert_int_equal(decoder.decode(RMC), GPS_OK);
+    assert_string_equal(decoder.tpv().time, "2011-05-28T09:27:51.000Z");
+    assert_int_equal(decoder.tpv().altitude, 61700);
+
+    /* Other types are rejected without touching the TPV */
+    before = decoder.tpv();
+    assert_int_equal(decoder.decode(VTG), GPS_ERROR_UNSUPPORTED);
+    assert_int_equal(decoder.decode(encode("GNGSA,A,3,10,07,05,02,29,04,08,13,,,,,1.72,1.03,1.38")),
+                     GPS_ERROR_UNSUPPORTED);
+    assert_memory_equal(&decoder.tpv(), &before, sizeof(before));
+
+    for (const std::string *nmea : { &GGA, &RMC, &VTG })
+    {
+        assert_int_equal(all.decode(*nmea), GPS_OK);
+    }
+    assert_int_equal(all.tpv().speed, 1891);
+    assert_int_equal(gps::decoder<gps::vtg>().decode(VTG), GPS_OK);
+}
+
+void test_cpp_errors(void **state)
+{
+    (void)state;
+    const std::string bad = GGA.substr(0, GGA.size() - 4) + "00\r\n";
+    const std::string unterminated = GGA.substr(0, GGA.size() - 2);
+    const std::string_view inputs[] = { "", "GPGGA", "$GP", "$GPGGA,0927", bad, unterminated };
+    gps::decoder<gps::gga, gps::zda> decoder;
+
+    /* The same results as the C interface */
+    for (std::string_view nmea : inputs)
+    {
+        gps_tpv tpv;
+
+        gps_init_tpv(&tpv);
+        assert_int_not_equal(decoder.decode(nmea), GPS_OK);
+        assert_int_equal(decoder.decode(nmea), gps_decode_const(&tpv, nmea.data(), nmea.size()));
+    }
+    assert_int_equal(decoder.decode(bad), GPS_ERROR_CHECKSUM);
+    assert_true(gps::error_string(GPS_ERROR_CHECKSUM) == gps_error_string(GPS_ERROR_CHECKSUM));
+}
+
+void test_cpp_sentences(void **state)
+{
+    (void)state;
+    const std::string log = GGA + "noise\n" + RMC + VTG.substr(0, 10);
+    gps::decoder<gps::gga, gps::rmc, gps::vtg> decoder;
+    std::string_view lines[4];
+    int results[4];
+    std::size_t count = 0;
+
+    for (std::string_view nmea : gps::sentences(log))
+    {
+        assert_true(count < 4);
+        lines[count] = nmea;
+        results[count++] = decoder.decode(nmea);
+    }
+    assert_int_equal(count, 4);
+    assert_true(lines[0] == GGA);
+    assert_true(lines[1] == "noise\n");
+    assert_true(lines[2] == RMC);
+    assert_true(lines[3] == VTG.substr(0, 10));
+    assert_int_equal(results[0], GPS_OK);
+    assert_int_equal(results[1], GPS_ERROR_HEAD);
+    assert_int_equal(results[2], GPS_OK);
+    assert_int_equal(results[3], GPS_ERROR_TRUNCATED);
+
+    /* The views point into the buffer */
+    assert_ptr_equal(lines[2].data(), log.data() + GGA.size() + 6);
+
+    assert_int_equal(std::distance(gps::sentences("").begin(), gps::sentences("").end()), 0);
+    assert_int_equal(std::distance(gps::sentences("\n\n").begin(), gps::sentences("\n\n").end()), 2);
+}
+
+} // namespace
+
+int main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_cpp_string_view),
+        cmocka_unit_test(test_cpp_sentence_set),
+        cmocka_unit_test(test_cpp_errors),
+        cmocka_unit_test(test_cpp_sentences)
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
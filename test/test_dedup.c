@@ -0,0 +1,159 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Jacob McGladdery
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include "gps.h"
+#include "gps_dedup.h"
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <stdio.h>
+#include <string.h>
+#include <cmocka.h>
+
+static int check(struct gps_dedup *dedup, const char *body, uint32_t now)
+{
+    char nmea[128];
+
+    gps_encode(nmea, body);
+    return gps_dedup_check(dedup, nmea, strlen(nmea), now);
+}
+
+static void test_dedup_window(void **state)
+{
+    (void)state;
+    struct gps_dedup_entry entries[64];
+    struct gps_dedup dedup;
+    const char *gga = "GPGGA,092751.000,5321.6802,N,00630.3371,W,1,8,1.03,61.7,M,55.3,M,,";
+
+    gps_dedup_init(&dedup, entries, 64, 1000);
+
+    /* The second copy is dropped, one from another receiver is not */
+    assert_false(check(&dedup, gga, 5000));
+    assert_true(check(&dedup, gga, 5020));
+    assert_false(check(&dedup, "GNGGA,092751.000,5321.6802,N,00630.3371,W,1,8,1.03,61.7,M,55.3,M,,", 5030));
+    assert_false(check(&dedup, "GPGGA,092752.000,5321.6802,N,00630.3371,W,1,8,1.03,61.7,M,55.3,M,,", 5040));
+    assert_false(check(&dedup, "GPRMC,092751.000,A,5321.6802,N,00630.3371,W,0.06,31.66,280511,,,A", 5050));
+
+    /* Once the window has passed the same sentence is new again */
+    assert_true(check(&dedup, gga, 6000));
+    assert_false(check(&dedup, gga, 6001));
+
+    assert_int_equal(dedup.hits, 2);
+    assert_int_equal(dedup.misses, 5);
+}
+
+static void test_dedup_same_checksum(void **state)
+{
+    (void)state;
+    struct gps_dedup_entry entries[64];
+    struct gps_dedup dedup;
+    const char *order = "GNGSA,A,3,10,07,05,02,29,04,08,13,,,,,1.72,1.03,1.38";
+    const char *swapped = "GNGSA,A,3,07,10,05,02,29,04,08,13,,,,,1.72,1.03,1.38";
+    char first[128];
+    char second[128];
+
+    /* Two GSAs of one epoch which only differ in the order of their
+     * satellites, so their checksums are the same
+     */
+    gps_encode(first, order);
+    gps_encode(second, swapped);
+    assert_memory_equal(first + strlen(first) - 4, second + strlen(second) - 4, 2);
+
+    gps_dedup_init(&dedup, entries, 64, 1000);
+    assert_false(check(&dedup, order, 1000));
+    assert_false(check(&dedup, swapped, 1010));
+    assert_true(check(&dedup, swapped, 1020));
+
+    /* Nor is the same body from another talker a duplicate */
+    assert_false(check(&dedup, "GPGSA,A,3,10,07,05,02,29,04,08,13,,,,,1.72,1.03,1.38", 1030));
+    assert_int_equal(dedup.hits, 1);
+}
+
+static void test_dedup_clock_wrap(void **state)
+{
+    (void)state;
+    struct gps_dedup_entry entries[8];
+    struct gps_dedup dedup;
+    const char *zda = "GPZDA,050306,29,10,2003,,";
+
+    gps_dedup_init(&dedup, entries, 8, 100);
+    assert_false(check(&dedup, zda, UINT32_MAX - 10));
+    assert_true(check(&dedup, zda, 20));
+    assert_false(check(&dedup, zda, 200));
+}
+
+static void test_dedup_full_table(void **state)
+{
+    (void)state;
+    struct gps_dedup_entry entries[GPS_DEDUP_PROBES];
+    struct gps_dedup dedup;
+    char body[64];
+    int i;
+
+    /* With every slot live, new sentences replace the oldest ones */
+    gps_dedup_init(&dedup, entries, GPS_DEDUP_PROBES, 1000);
+    for (i = 0; i < 2 * GPS_DEDUP_PROBES; ++i)
+    {
+        sprintf(body, "GPZDA,0503%02d,29,10,2003,,", i);
+        assert_false(check(&dedup, body, (uint32_t)i));
+    }
+    for (i = GPS_DEDUP_PROBES; i < 2 * GPS_DEDUP_PROBES; ++i)
+    {
+        sprintf(body, "GPZDA,0503%02d,29,10,2003,,", i);
+        assert_true(check(&dedup, body, 100));
+    }
+    assert_int_equal(dedup.misses, 2 * GPS_DEDUP_PROBES);
+}
+
+static void test_dedup_malformed(void **state)
+{
+    (void)state;
+    struct gps_dedup_entry entries[8];
+    struct gps_dedup dedup;
+    const char *cut = "$GPGGA,092751.000,5321.6802,N,0063";
+
+    gps_dedup_init(&dedup, entries, 8, 1000);
+
+    /* Never dropped, so the decoder gets to report them */
+    assert_false(gps_dedup_check(&dedup, cut, strlen(cut), 0));
+    assert_false(gps_dedup_check(&dedup, cut, strlen(cut), 1));
+    assert_false(gps_dedup_check(&dedup, "GPGGA,1*00\r\n", 12, 2));
+    assert_false(gps_dedup_check(&dedup, "GPGGA,1*00\r\n", 12, 3));
+    assert_int_equal(dedup.hits, 0);
+    assert_int_equal(dedup.misses, 0);
+}
+
+int main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_dedup_window),
+        cmocka_unit_test(test_dedup_same_checksum),
+        cmocka_unit_test(test_dedup_clock_wrap),
+        cmocka_unit_test(test_dedup_full_table),
+        cmocka_unit_test(test_dedup_malformed)
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,170 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Jacob McGladdery
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/* Expected values were computed with a double precision haversine using a
+ * mean Earth radius of 6371008.8 m.
+ */
+
+#include "gps_geo.h"
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <string.h>
+#include <cmocka.h>
+
+#define DISTANCE_TOLERANCE (30) /* Millimeters */
+#define BEARING_TOLERANCE  (1)  /* Millidegrees */
+
+static void test_distance_short(void **state)
+{
+    (void)state;
+
+    assert_in_range(gps_geo_distance(48117300, 11516667, 48127300, 11536667),
+                    1854810 - DISTANCE_TOLERANCE, 1854810 + DISTANCE_TOLERANCE);
+    assert_in_range(gps_geo_distance(48117300, 11516667, 48117309, 11516667),
+                    1001 - DISTANCE_TOLERANCE, 1001 + DISTANCE_TOLERANCE);
+    assert_int_equal(gps_geo_distance(48117300, 11516667, 48117300, 11516667), 0);
+}
+
+static void test_distance_long(void **state)
+{
+    (void)state;
+
+    assert_in_range(gps_geo_distance(51477500, -461, 40712800, -74006000),
+                    5579644428 - DISTANCE_TOLERANCE, 5579644428 + DISTANCE_TOLERANCE);
+    assert_in_range(gps_geo_distance(-33868800, 151209300, 51507400, -127800),
+                    16993956933 - DISTANCE_TOLERANCE, 16993956933 + DISTANCE_TOLERANCE);
+}
+
+static void test_distance_antimeridian(void **state)
+{
+    (void)state;
+
+    assert_in_range(gps_geo_distance(0, 179999000, 0, -179999000),
+                    222390 - DISTANCE_TOLERANCE, 222390 + DISTANCE_TOLERANCE);
+    assert_in_range(gps_geo_distance_fast(0, 179999000, 0, -179999000),
+                    222390 - DISTANCE_TOLERANCE, 222390 + DISTANCE_TOLERANCE);
+}
+
+static void test_distance_fast(void **state)
+{
+    (void)state;
+
+    assert_in_range(gps_geo_distance_fast(48117300, 11516667, 48127300, 11536667),
+                    1854810 - DISTANCE_TOLERANCE, 1854810 + DISTANCE_TOLERANCE);
+
+    /* Within 0.01% at 200 km */
+    assert_in_range(gps_geo_distance_fast(37391097, -122037826, 39123066, -121041153),
+                    211331611 - 21133, 211331611 + 21133);
+}
+
+static void test_distance_fast_batch(void **state)
+{
+    (void)state;
+    const int32_t lat1[] = { 48117300, 37391097, 0, 48117300, -45000000 };
+    const int32_t lon1[] = { 11516667, -122037826, 179999000, 11516667, 170000000 };
+    const int32_t lat2[] = { 48127300, 39123066, 0, 48117309, -45010000 };
+    const int32_t lon2[] = { 11536667, -121041153, -179999000, 11516667, 170020000 };
+    int32_t distance[5];
+    int i;
+
+    gps_geo_distance_fast_batch(distance, lat1, lon1, lat2, lon2, 5);
+    for (i = 0; i < 5; ++i)
+    {
+        int32_t expected = gps_geo_distance_fast(lat1[i], lon1[i], lat2[i], lon2[i]);
+        int32_t tolerance = expected / 1000000 + DISTANCE_TOLERANCE;
+
+        assert_in_range(distance[i], expected - tolerance, expected + tolerance);
+    }
+}
+
+static void test_bearing(void **state)
+{
+    (void)state;
+
+    assert_in_range(gps_geo_bearing(48117300, 11516667, 48127300, 11536667),
+                    53159 - BEARING_TOLERANCE, 53159 + BEARING_TOLERANCE);
+    assert_in_range(gps_geo_bearing(51477500, -461, 40712800, -74006000),
+                    288432 - BEARING_TOLERANCE, 288432 + BEARING_TOLERANCE);
+    assert_in_range(gps_geo_bearing(-33868800, 151209300, 51507400, -127800),
+                    319171 - BEARING_TOLERANCE, 319171 + BEARING_TOLERANCE);
+    assert_int_equal(gps_geo_bearing(48117300, 11516667, 48117309, 11516667), 0);
+    assert_int_equal(gps_geo_bearing(0, 179999000, 0, -179999000), 90000);
+}
+
+static void test_bearing_fast(void **state)
+{
+    (void)state;
+
+    assert_in_range(gps_geo_bearing_fast(48117300, 11516667, 48127300, 11536667),
+                    53159 - 10, 53159 + 10);
+    assert_int_equal(gps_geo_bearing_fast(10000000, 10000000, 9000000, 10000000), 180000);
+    assert_int_equal(gps_geo_bearing_fast(0, 10000000, 0, 9000000), 270000);
+}
+
+static void test_speed(void **state)
+{
+    (void)state;
+    struct gps_tpv from, to;
+
+    gps_init_tpv(&from);
+    gps_init_tpv(&to);
+    assert_int_equal(gps_geo_speed(&from, &to), GPS_INVALID_VALUE);
+
+    from.latitude = 48117300;
+    from.longitude = 11516667;
+    to.latitude = 48117309;
+    to.longitude = 11516667;
+    strcpy(from.time, "0000-00-00T23:59:59.500Z");
+    strcpy(to.time, "0000-00-00T00:00:00.000Z");
+
+    /* 1.001 m in half a second, across midnight */
+    assert_in_range(gps_geo_speed(&from, &to), 2002 - 60, 2002 + 60);
+
+    /* A jump of about 215 km in 100 ms saturates */
+    to.latitude = 50050000;
+    strcpy(to.time, "0000-00-00T23:59:59.600Z");
+    assert_int_equal(gps_geo_speed(&from, &to), INT32_MAX - 1);
+
+    /* No time elapsed */
+    strcpy(to.time, from.time);
+    assert_int_equal(gps_geo_speed(&from, &to), GPS_INVALID_VALUE);
+}
+
+int main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_distance_short),
+        cmocka_unit_test(test_distance_long),
+        cmocka_unit_test(test_distance_antimeridian),
+        cmocka_unit_test(test_distance_fast),
+        cmocka_unit_test(test_distance_fast_batch),
+        cmocka_unit_test(test_bearing),
+        cmocka_unit_test(test_bearing_fast),
+        cmocka_unit_test(test_speed)
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,215 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Jacob McGladdery
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include "gps_geofence.h"
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+/* A 1 x 1 degree square and a U shaped polygon beside it */
+static const int32_t square_lat[] = { 10000000, 10000000, 11000000, 11000000 };
+static const int32_t square_lon[] = { 20000000, 21000000, 21000000, 20000000 };
+static const int32_t u_lat[] = { 10000000, 10000000, 11000000, 11000000, 10500000, 10500000, 11000000, 11000000 };
+static const int32_t u_lon[] = { 21000000, 24000000, 24000000, 23000000, 23000000, 22000000, 22000000, 21000000 };
+
+struct event_log
+{
+    uint32_t id[8];
+    int event[8];
+    int count;
+};
+
+static void record_event(void *context, uint32_t id, int event)
+{
+    struct event_log *log = context;
+
+    log->id[log->count] = id;
+    log->event[log->count] = event;
+    log->count++;
+}
+
+static void setup_geofence(struct gps_geofence *geofence, struct gps_geofence_polygon *polygons)
+{
+    static uint32_t cell_start[4 * 4 + 1];
+    static uint32_t cell_items[32];
+
+    gps_geofence_init(geofence, polygons, 2);
+    assert_int_equal(gps_geofence_add(geofence, 100, square_lat, square_lon, 4), GPS_OK);
+    assert_int_equal(gps_geofence_add(geofence, 200, u_lat, u_lon, 8), GPS_OK);
+    assert_int_equal(gps_geofence_build(geofence, 4, 4, cell_start, cell_items, 32), GPS_OK);
+}
+
+static void test_geofence_query(void **state)
+{
+    (void)state;
+    struct gps_geofence geofence;
+    struct gps_geofence_polygon polygons[2];
+    uint32_t found[2];
+
+    setup_geofence(&geofence, polygons);
+
+    assert_int_equal(gps_geofence_query(&geofence, 10500000, 20500000, found, 2), 1);
+    assert_int_equal(found[0], 0);
+    assert_int_equal(gps_geofence_query(&geofence, 10250000, 22500000, found, 2), 1);
+    assert_int_equal(found[0], 1);
+
+    /* Inside the notch of the U */
+    assert_int_equal(gps_geofence_query(&geofence, 10750000, 22500000, found, 2), 0);
+
+    /* Outside of the grid */
+    assert_int_equal(gps_geofence_query(&geofence, 9000000, 20500000, found, 2), 0);
+    assert_int_equal(gps_geofence_query(&geofence, 10500000, 25000000, found, 2), 0);
+}
+
+static void test_geofence_shared_edge(void **state)
+{
+    (void)state;
+    struct gps_geofence geofence;
+    struct gps_geofence_polygon polygons[2];
+    uint32_t found[2];
+
+    setup_geofence(&geofence, polygons);
+
+    /* Points on the edge shared by both polygons belong to exactly one */
+    assert_int_equal(gps_geofence_query(&geofence, 10100000, 21000000, found, 2), 1);
+    assert_int_equal(gps_geofence_query(&geofence, 10900000, 21000000, found, 2), 1);
+}
+
+static void test_geofence_brute_force_matches_index(void **state)
+{
+    (void)state;
+    struct gps_geofence indexed, brute;
+    struct gps_geofence_polygon polygons[2], brute_polygons[2];
+    uint32_t a[2], b[2];
+    int32_t lat, lon;
+
+    setup_geofence(&indexed, polygons);
+    gps_geofence_init(&brute, brute_polygons, 2);
+    gps_geofence_add(&brute, 100, square_lat, square_lon, 4);
+    gps_geofence_add(&brute, 200, u_lat, u_lon, 8);
+
+    for (lat = 9900000; lat <= 11100000; lat += 50000)
+    {
+        for (lon = 19900000; lon <= 24100000; lon += 50000)
+        {
+            size_t n = gps_geofence_query(&indexed, lat, lon, a, 2);
+
+            assert_int_equal(n, gps_geofence_query(&brute, lat, lon, b, 2));
+            if (n) assert_int_equal(a[0], b[0]);
+        }
+    }
+}
+
+static void test_geofence_transitions(void **state)
+{
+    (void)state;
+    struct gps_geofence geofence;
+    struct gps_geofence_polygon polygons[2];
+    struct gps_geofence_object object;
+    struct event_log log = { { 0 }, { 0 }, 0 };
+    struct gps_tpv tpv;
+
+    setup_geofence(&geofence, polygons);
+    gps_geofence_object_init(&object);
+    gps_init_tpv(&tpv);
+
+    /* Invalid positions are ignored */
+    assert_int_equal(gps_geofence_update(&geofence, &object, &tpv, record_event, &log), 0);
+
+    tpv.latitude = 10500000;
+    tpv.longitude = 20500000;
+    assert_int_equal(gps_geofence_update(&geofence, &object, &tpv, record_event, &log), 1);
+    assert_int_equal(log.id[0], 100);
+    assert_int_equal(log.event[0], GPS_GEOFENCE_ENTER);
+
+    /* Moving within the same polygon reports nothing */
+    tpv.longitude = 20600000;
+    assert_int_equal(gps_geofence_update(&geofence, &object, &tpv, record_event, &log), 0);
+
+    /* Crossing into the neighbour reports the exit first */
+    tpv.latitude = 10250000;
+    tpv.longitude = 22500000;
+    assert_int_equal(gps_geofence_update(&geofence, &object, &tpv, record_event, &log), 2);
+    assert_int_equal(log.id[1], 100);
+    assert_int_equal(log.event[1], GPS_GEOFENCE_EXIT);
+    assert_int_equal(log.id[2], 200);
+    assert_int_equal(log.event[2], GPS_GEOFENCE_ENTER);
+
+    tpv.latitude = 12000000;
+    assert_int_equal(gps_geofence_update(&geofence, &object, &tpv, record_event, &log), 1);
+    assert_int_equal(log.event[3], GPS_GEOFENCE_EXIT);
+}
+
+static void test_geofence_failed_rebuild(void **state)
+{
+    (void)state;
+    struct gps_geofence geofence;
+    struct gps_geofence_polygon polygons[2];
+    uint32_t cell_start[16 * 16 + 1];
+    uint32_t cell_items[4];
+    uint32_t found[2];
+
+    /* A finer grid which does not fit must not leave the coarse index behind */
+    setup_geofence(&geofence, polygons);
+    assert_int_equal(gps_geofence_build(&geofence, 16, 16, cell_start, cell_items, 4), GPS_ERROR_OVERFLOW);
+    assert_null(geofence.cell_start);
+
+    assert_int_equal(gps_geofence_query(&geofence, 10500000, 20500000, found, 2), 1);
+    assert_int_equal(found[0], 0);
+    assert_int_equal(gps_geofence_query(&geofence, 10250000, 23900000, found, 2), 1);
+    assert_int_equal(found[0], 1);
+    assert_int_equal(gps_geofence_query(&geofence, 10750000, 22500000, found, 2), 0);
+}
+
+static void test_geofence_errors(void **state)
+{
+    (void)state;
+    struct gps_geofence geofence;
+    struct gps_geofence_polygon polygons[1];
+    uint32_t cell_start[2];
+    uint32_t cell_items[1];
+
+    gps_geofence_init(&geofence, polygons, 1);
+    assert_int_equal(gps_geofence_add(&geofence, 1, square_lat, square_lon, 2), GPS_ERROR_UNSUPPORTED);
+    assert_int_equal(gps_geofence_add(&geofence, 1, square_lat, square_lon, 4), GPS_OK);
+    assert_int_equal(gps_geofence_add(&geofence, 2, u_lat, u_lon, 8), GPS_ERROR_OVERFLOW);
+    assert_int_equal(gps_geofence_build(&geofence, 1, 1, cell_start, cell_items, 0), GPS_ERROR_OVERFLOW);
+    assert_int_equal(gps_geofence_build(&geofence, 1, 1, cell_start, cell_items, 1), GPS_OK);
+}
+
+int main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_geofence_query),
+        cmocka_unit_test(test_geofence_shared_edge),
+        cmocka_unit_test(test_geofence_brute_force_matches_index),
+        cmocka_unit_test(test_geofence_transitions),
+        cmocka_unit_test(test_geofence_failed_rebuild),
+        cmocka_unit_test(test_geofence_errors)
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
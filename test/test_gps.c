@@ -33,6 +33,7 @@ THE SOFTWARE.
 #include <stdarg.h>
 #include <stddef.h>
 #include <setjmp.h>
+#include <string.h>
 #include <cmocka.h>
 
 #define SIZEOF_STRING(s)    (sizeof(s) - 1)
@@ -127,6 +128,35 @@ static void test_decode_valid_gsa_message(void **state)
     assert_true(GPS_MODE_3D_FIX == tpv.mode);
 }
 
+static void test_decode_every_body_length(void **state)
+{
+    (void)state;
+    struct gps_tpv tpv;
+    char message[64];
+    char nmea[72];
+    size_t n;
+
+    /* The body is scanned a word at a time with a tail of single characters,
+     * so move the separators and the end through every position of a word
+     */
+    for (n = 0; n < 16; ++n)
+    {
+        strcpy(message, "GPGSA,A,2,01,04");
+        memset(message + 15, ',', n);
+        strcpy(message + 15 + n, "3.6,2.2,2.7");
+        gps_encode(nmea, message);
+
+        gps_init_tpv(&tpv);
+        assert_int_equal(gps_decode(&tpv, nmea), GPS_OK);
+        assert_true(GPS_MODE_2D_FIX == tpv.mode);
+
+        /* Without the end marker the sentence is truncated */
+        nmea[0] = '$';
+        strcpy(nmea + 1, message);
+        assert_int_equal(gps_decode(&tpv, nmea), GPS_ERROR_TRUNCATED);
+    }
+}
+
 static void test_decode_valid_rmc_message(void **state)
 {
     (void)state;
@@ -174,6 +204,59 @@ static void test_decode_valid_zda_message(void **state)
     assert_string_equal(tpv.time, "2003-10-29T05:03:06.000Z");
 }
 
+static void test_decode_long_digit_runs(void **state)
+{
+    (void)state;
+    struct gps_tpv tpv;
+    char nmea[128];
+
+    /* Values too large to scale are invalid rather than wrapped */
+    gps_init_tpv(&tpv);
+    gps_encode(nmea, "GPGGA,092751.000,5321.6802,N,00630.3371,W,1,8,1.03,99999999999999999999.9,M,55.3,M,,");
+    assert_int_equal(gps_decode(&tpv, nmea), GPS_OK);
+    assert_int_equal(tpv.altitude, GPS_INVALID_VALUE);
+
+    gps_encode(nmea, "GPGGA,092751.000,5321.6802,N,00630.3371,W,1,8,1.03,2147482.999,M,55.3,M,,");
+    assert_int_equal(gps_decode(&tpv, nmea), GPS_OK);
+    assert_int_equal(tpv.altitude, 2147482999);
+
+    /* Speeds are converted without overflowing */
+    gps_encode(nmea, "GPVTG,176.90,T,,M,,N,999999.9,K,A");
+    assert_int_equal(gps_decode(&tpv, nmea), GPS_OK);
+    assert_int_equal(tpv.speed, 277777750);
+
+    gps_encode(nmea, "GPVTG,176.90,T,,M,,N,,K,A");
+    assert_int_equal(gps_decode(&tpv, nmea), GPS_OK);
+    assert_int_equal(tpv.speed, GPS_INVALID_VALUE);
+}
+
+static void test_decode_const_message(void **state)
+{
+    (void)state;
+    struct gps_tpv expected;
+    struct gps_tpv tpv;
+    char nmea[] = "$GPGGA,092751.000,5321.6802,N,00630.3371,W,1,8,1.03,61.7,M,55.3,M,,*75\r\n";
+    static const char stream[] =
+        "$GPGGA,092751.000,5321.6802,N,00630.3371,W,1,8,1.03,61.7,M,55.3,M,,*75\r\n"
+        "$GPVTG,176.90,T,,M,3.68,N,6.81,K,A*36\r\n";
+    size_t size = strlen(nmea);
+
+    gps_init_tpv(&expected);
+    assert_int_equal(gps_decode(&expected, nmea), GPS_OK);
+
+    /* The sentence is read in place, and what follows it is ignored */
+    gps_init_tpv(&tpv);
+    assert_int_equal(gps_decode_const(&tpv, stream, sizeof(stream) - 1), GPS_OK);
+    assert_memory_equal(&tpv, &expected, sizeof(tpv));
+
+    /* The size bounds the sentence, the footer must fit within it */
+    assert_int_equal(gps_decode_const(&tpv, stream, size), GPS_OK);
+    assert_int_equal(gps_decode_const(&tpv, stream, size - 1), GPS_ERROR_FOOT);
+    assert_int_equal(gps_decode_const(&tpv, stream, size - 3), GPS_ERROR_TRUNCATED);
+    assert_int_equal(gps_decode_const(&tpv, stream, 4), GPS_ERROR_TRUNCATED);
+    assert_int_equal(gps_decode_const(&tpv, stream, 0), GPS_ERROR_HEAD);
+}
+
 static void test_decode_empty_message(void **state)
 {
     (void)state;
@@ -258,6 +341,51 @@ static void test_decode_unsupported_message(void **state)
     assert_int_equal(result, GPS_ERROR_UNSUPPORTED);
 }
 
+static void test_check_const_message(void **state)
+{
+    (void)state;
+    char nmea[] = "$PGRME,15.0,M,22.5,M,15.0,M*1B\r\n";
+    size_t size = strlen(nmea);
+
+    /* Sentences without a parser are checked all the same */
+    assert_int_equal(gps_check_const(nmea, size), GPS_OK);
+    assert_int_equal(gps_check_const(nmea, size - 1), GPS_ERROR_FOOT);
+    assert_int_equal(gps_check_const(nmea, size - 3), GPS_ERROR_TRUNCATED);
+    assert_int_equal(gps_check_const(nmea, 4), GPS_ERROR_TRUNCATED);
+    assert_int_equal(gps_check_const(nmea + 1, size - 1), GPS_ERROR_HEAD);
+
+    nmea[5] = 'F';
+    assert_int_equal(gps_check_const(nmea, size), GPS_ERROR_CHECKSUM);
+}
+
+static void test_time_to_ms_with_date(void **state)
+{
+    (void)state;
+
+    assert_true(gps_time_has_date("2002-11-13T02:30:44.000Z"));
+    assert_true(gps_time_to_ms("1970-01-01T00:00:00.000Z") == 0);
+    assert_true(gps_time_to_ms("2002-11-13T02:30:44.250Z") == INT64_C(1037154644250));
+}
+
+static void test_time_to_ms_without_date(void **state)
+{
+    (void)state;
+
+    assert_false(gps_time_has_date("0000-00-00T17:28:14.000Z"));
+    assert_int_equal(gps_time_to_ms("0000-00-00T17:28:14.500Z"), 62894500);
+}
+
+static void test_ms_to_time(void **state)
+{
+    (void)state;
+    char time[GPS_TIME_STRING_SIZE];
+
+    gps_ms_to_time(time, INT64_C(1037154644250), 1);
+    assert_string_equal(time, "2002-11-13T02:30:44.250Z");
+    gps_ms_to_time(time, 62894500, 0);
+    assert_string_equal(time, "0000-00-00T17:28:14.500Z");
+}
+
 static void test_error_string_ok(void **state)
 {
     (void)state;
@@ -285,9 +413,12 @@ int main(void)
         cmocka_unit_test(test_decode_valid_gga_message),
         cmocka_unit_test(test_decode_valid_gll_message),
         cmocka_unit_test(test_decode_valid_gsa_message),
+        cmocka_unit_test(test_decode_every_body_length),
         cmocka_unit_test(test_decode_valid_rmc_message),
         cmocka_unit_test(test_decode_valid_vtg_message),
         cmocka_unit_test(test_decode_valid_zda_message),
+        cmocka_unit_test(test_decode_long_digit_runs),
+        cmocka_unit_test(test_decode_const_message),
         cmocka_unit_test(test_decode_empty_message),
         cmocka_unit_test(test_decode_invalid_header),
         cmocka_unit_test(test_decode_invalid_footer),
@@ -295,6 +426,10 @@ int main(void)
         cmocka_unit_test(test_decode_mismatch_checksum),
         cmocka_unit_test(test_decode_truncated_message),
         cmocka_unit_test(test_decode_unsupported_message),
+        cmocka_unit_test(test_check_const_message),
+        cmocka_unit_test(test_time_to_ms_with_date),
+        cmocka_unit_test(test_time_to_ms_without_date),
+        cmocka_unit_test(test_ms_to_time),
         cmocka_unit_test(test_error_string_ok),
         cmocka_unit_test(test_error_string_out_of_range)
     };
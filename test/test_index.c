@@ -0,0 +1,328 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Jacob McGladdery
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include "gps_index.h"
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <string.h>
+#include <cmocka.h>
+
+#define NUM_VEHICLES (3)
+#define NUM_RECORDS  (720) /* Two hours at one fix every ten seconds */
+#define START_TIME   INT64_C(1700000000000)
+
+#define TILE_SIZE   (10000)  /* 0.01 degrees */
+#define BUCKET_SIZE (600000) /* 10 minutes */
+
+struct memory_sink
+{
+    uint8_t data[32768];
+    size_t size;
+};
+
+struct matches
+{
+    int count;
+    int64_t time_min;
+    int64_t time_max;
+};
+
+static struct memory_sink archives[NUM_VEHICLES];
+static struct memory_sink index_data;
+static struct gps_index_entry entries[4096];
+
+static int memory_write(void *context, const void *data, size_t size)
+{
+    struct memory_sink *sink = context;
+
+    if (size > sizeof(sink->data) - sink->size) return -1;
+    memcpy(sink->data + sink->size, data, size);
+    sink->size += size;
+    return 0;
+}
+
+static void count_match(void *context, const struct gps_tpv *tpv)
+{
+    struct matches *m = context;
+    int64_t time = gps_time_to_ms(tpv->time);
+
+    if ((0 == m->count) || (time < m->time_min)) m->time_min = time;
+    if ((0 == m->count) || (time > m->time_max)) m->time_max = time;
+    m->count++;
+}
+
+/* Each vehicle drives north east from its own starting point near Munich,
+ * covering about 15 km over the two hours
+ */
+static void make_tpv(struct gps_tpv *tpv, int vehicle, int i)
+{
+    gps_init_tpv(tpv);
+    tpv->mode = GPS_MODE_3D_FIX;
+    tpv->latitude = 48100000 + vehicle * 50000 + i * 150;
+    tpv->longitude = 11500000 + vehicle * 30000 + i * 200;
+    tpv->altitude = 520000;
+    tpv->speed = 2000;
+    gps_ms_to_time(tpv->time, START_TIME + (int64_t)i * 10000, 1);
+    strcpy(tpv->talker_id, "GP");
+
+    /* A few fixes without a position */
+    if (0 == i % 97) tpv->latitude = GPS_INVALID_VALUE;
+}
+
+static int setup(void **state)
+{
+    (void)state;
+    struct gps_index_builder builder;
+    struct gps_archive_writer writer;
+    struct gps_tpv tpv;
+    uint8_t buffer[256];
+    int v, i;
+
+    for (v = 0; v < NUM_VEHICLES; ++v)
+    {
+        archives[v].size = 0;
+        gps_archive_writer_init(&writer, buffer, sizeof(buffer), memory_write, &archives[v]);
+        for (i = 0; i < NUM_RECORDS; ++i)
+        {
+            make_tpv(&tpv, v, i);
+            if (gps_archive_write(&writer, &tpv) != GPS_OK) return -1;
+        }
+        if (gps_archive_flush(&writer) != GPS_OK) return -1;
+    }
+
+    if (gps_index_builder_init(&builder, TILE_SIZE, BUCKET_SIZE, entries, 4096) != GPS_OK) return -1;
+    for (v = 0; v < NUM_VEHICLES; ++v)
+    {
+        if (gps_index_builder_add(&builder, (uint32_t)v, archives[v].data, archives[v].size) != GPS_OK) return -1;
+    }
+
+    index_data.size = 0;
+    return (gps_index_builder_write(&builder, memory_write, &index_data) == GPS_OK) ? 0 : -1;
+}
+
+/* Decodes every record of every archive, the way the index avoids */
+static int brute_force(const struct gps_index_query *query, int *blocks)
+{
+    struct gps_archive_reader reader;
+    struct gps_archive_block block;
+    struct gps_tpv tpv;
+    int count = 0;
+    int v;
+
+    *blocks = 0;
+    for (v = 0; v < NUM_VEHICLES; ++v)
+    {
+        assert_int_equal(gps_archive_reader_init(&reader, archives[v].data, archives[v].size), GPS_OK);
+        while (gps_archive_next_block(&reader, &block) == GPS_OK)
+        {
+            (*blocks)++;
+            while (gps_archive_read(&reader, &tpv) == GPS_OK)
+            {
+                if (gps_index_match(query, &tpv)) count++;
+            }
+        }
+    }
+
+    return count;
+}
+
+static void test_index_query(void **state)
+{
+    (void)state;
+    struct gps_index index;
+    struct gps_index_posting postings[64];
+    struct gps_archive_reader reader;
+    struct gps_index_query query;
+    struct matches m;
+    size_t count, i;
+    int expected, blocks, v;
+
+    assert_int_equal(gps_index_init(&index, index_data.data, index_data.size), GPS_OK);
+
+    /* A box crossed by the first two vehicles, for 20 minutes */
+    query.latitude_min = 48130000;
+    query.latitude_max = 48190000;
+    query.longitude_min = 11540000;
+    query.longitude_max = 11580000;
+    query.time_min = START_TIME + 1800000;
+    query.time_max = START_TIME + 3000000;
+
+    assert_int_equal(gps_index_query(&index, &query, postings, 64, &count), GPS_OK);
+    assert_true(count > 0);
+    for (i = 1; i < count; ++i)
+    {
+        assert_true((postings[i - 1].archive < postings[i].archive) ||
+                    ((postings[i - 1].archive == postings[i].archive) &&
+                     (postings[i - 1].offset < postings[i].offset)));
+    }
+
+    memset(&m, 0, sizeof(m));
+    for (v = 0; v < NUM_VEHICLES; ++v)
+    {
+        assert_int_equal(gps_archive_reader_init(&reader, archives[v].data, archives[v].size), GPS_OK);
+        assert_int_equal(gps_index_scan(&reader, (uint32_t)v, &query, postings, count, count_match, &m), GPS_OK);
+    }
+
+    /* Same records as decoding everything, from a fraction of the blocks */
+    expected = brute_force(&query, &blocks);
+    assert_true(expected > 0);
+    assert_int_equal(m.count, expected);
+    assert_true(m.time_min >= query.time_min);
+    assert_true(m.time_max <= query.time_max);
+    assert_true((int)count * 5 < blocks);
+}
+
+static void test_index_query_sweep(void **state)
+{
+    (void)state;
+    struct gps_index index;
+    struct gps_index_posting postings[256];
+    struct gps_archive_reader reader;
+    struct gps_index_query query;
+    struct matches m;
+    size_t count;
+    int blocks, v, step;
+
+    assert_int_equal(gps_index_init(&index, index_data.data, index_data.size), GPS_OK);
+
+    /* Boxes and time ranges that straddle tile and bucket edges */
+    for (step = 0; step < 40; ++step)
+    {
+        query.latitude_min = 48100000 + step * 5003;
+        query.latitude_max = query.latitude_min + 7919;
+        query.longitude_min = 11500000 + step * 4001;
+        query.longitude_max = query.longitude_min + 31337;
+        query.time_min = START_TIME + step * 170003;
+        query.time_max = query.time_min + 1234567;
+
+        assert_int_equal(gps_index_query(&index, &query, postings, 256, &count), GPS_OK);
+
+        memset(&m, 0, sizeof(m));
+        for (v = 0; v < NUM_VEHICLES; ++v)
+        {
+            assert_int_equal(gps_archive_reader_init(&reader, archives[v].data, archives[v].size), GPS_OK);
+            assert_int_equal(gps_index_scan(&reader, (uint32_t)v, &query, postings, count, count_match, &m), GPS_OK);
+        }
+        assert_int_equal(m.count, brute_force(&query, &blocks));
+    }
+}
+
+static void test_index_query_empty(void **state)
+{
+    (void)state;
+    struct gps_index index;
+    struct gps_index_posting postings[16];
+    struct gps_index_query query;
+    size_t count = 1;
+
+    assert_int_equal(gps_index_init(&index, index_data.data, index_data.size), GPS_OK);
+
+    /* Right place, wrong day */
+    query.latitude_min = 48100000;
+    query.latitude_max = 48300000;
+    query.longitude_min = 11500000;
+    query.longitude_max = 11700000;
+    query.time_min = START_TIME + GPS_MS_PER_DAY;
+    query.time_max = START_TIME + 2 * GPS_MS_PER_DAY;
+    assert_int_equal(gps_index_query(&index, &query, postings, 16, &count), GPS_OK);
+    assert_int_equal(count, 0);
+
+    /* Right time, wrong place */
+    query.latitude_min = -10000000;
+    query.latitude_max = -9000000;
+    query.time_min = START_TIME;
+    query.time_max = START_TIME + 60000;
+    assert_int_equal(gps_index_query(&index, &query, postings, 16, &count), GPS_OK);
+    assert_int_equal(count, 0);
+
+    /* Reversed time range */
+    query.latitude_min = 48100000;
+    query.latitude_max = 48300000;
+    query.time_min = START_TIME + 60000;
+    query.time_max = START_TIME;
+    assert_int_equal(gps_index_query(&index, &query, postings, 16, &count), GPS_OK);
+    assert_int_equal(count, 0);
+}
+
+static void test_index_overflow(void **state)
+{
+    (void)state;
+    struct gps_index index;
+    struct gps_index_builder builder;
+    struct gps_index_posting postings[1];
+    struct gps_index_query query;
+    size_t count;
+
+    assert_int_equal(gps_index_init(&index, index_data.data, index_data.size), GPS_OK);
+
+    query.latitude_min = -90000000;
+    query.latitude_max = 90000000;
+    query.longitude_min = -180000000;
+    query.longitude_max = 180000000;
+    query.time_min = 0;
+    query.time_max = INT64_MAX;
+    assert_int_equal(gps_index_query(&index, &query, postings, 1, &count), GPS_ERROR_OVERFLOW);
+
+    assert_int_equal(gps_index_builder_init(&builder, TILE_SIZE, BUCKET_SIZE, entries, 8), GPS_OK);
+    assert_int_equal(gps_index_builder_add(&builder, 0, archives[0].data, archives[0].size), GPS_ERROR_OVERFLOW);
+
+    /* Tiles and buckets too small for 32 bit keys */
+    assert_int_equal(gps_index_builder_init(&builder, 4999, BUCKET_SIZE, entries, 8), GPS_ERROR_UNSUPPORTED);
+    assert_int_equal(gps_index_builder_init(&builder, TILE_SIZE, 999, entries, 8), GPS_ERROR_UNSUPPORTED);
+}
+
+static void test_index_corrupt(void **state)
+{
+    (void)state;
+    static uint8_t copy[sizeof(index_data.data)];
+    struct gps_index index;
+
+    memcpy(copy, index_data.data, index_data.size);
+
+    assert_int_equal(gps_index_init(&index, copy, GPS_INDEX_HEADER_SIZE - 1), GPS_ERROR_CORRUPT);
+    assert_int_equal(gps_index_init(&index, copy, index_data.size - 1), GPS_ERROR_CORRUPT);
+
+    /* Posting range running past the end */
+    copy[GPS_INDEX_HEADER_SIZE + 8] = 0xFF;
+    assert_int_equal(gps_index_init(&index, copy, index_data.size), GPS_ERROR_CORRUPT);
+
+    memcpy(copy, index_data.data, index_data.size);
+    copy[0] = 'X';
+    assert_int_equal(gps_index_init(&index, copy, index_data.size), GPS_ERROR_CORRUPT);
+}
+
+int main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_index_query),
+        cmocka_unit_test(test_index_query_sweep),
+        cmocka_unit_test(test_index_query_empty),
+        cmocka_unit_test(test_index_overflow),
+        cmocka_unit_test(test_index_corrupt)
+    };
+
+    return cmocka_run_group_tests(tests, setup, NULL);
+}
@@ -0,0 +1,104 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Jacob McGladdery
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include "gps_internal.h"
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <string.h>
+#include <cmocka.h>
+
+static void test_internal_tokenize(void **state)
+{
+    (void)state;
+    const char *token[GPS_INTERNAL_MAX_FIELDS];
+    const char body[] = "GSA,A,3,04,05,,09*39";
+    uint_fast8_t count;
+    uint8_t checksum = 0;
+    const char *star;
+    char commas[80];
+
+    star = gps_internal_tokenize(body, body + sizeof(body) - 1, token, &count, &checksum);
+    assert_true(star == body + 17);
+    assert_int_equal(count, 6);
+    assert_true(token[0] == body + 4);
+    assert_true(token[4] == body + 14);
+    assert_int_equal(token[5][0], '0');
+
+    /* Missing fields read as empty, extra ones are ignored */
+    assert_int_equal(token[6][0], '\0');
+    memset(commas, ',', sizeof(commas) - 1);
+    commas[sizeof(commas) - 2] = '*';
+    commas[sizeof(commas) - 1] = '\0';
+    star = gps_internal_tokenize(commas, commas + sizeof(commas) - 1, token, &count, &checksum);
+    assert_true(star == commas + sizeof(commas) - 2);
+    assert_int_equal(count, GPS_INTERNAL_MAX_FIELDS);
+
+    /* No end marker */
+    assert_null(gps_internal_tokenize(body, body + 16, token, &count, &checksum));
+}
+
+static void test_internal_find_parser(void **state)
+{
+    (void)state;
+
+    assert_true(gps_internal_find_parser("GGA"));
+    assert_true(gps_internal_find_parser("ZDA"));
+    assert_false(gps_internal_find_parser("TXT"));
+}
+
+static void test_internal_parse_fields(void **state)
+{
+    (void)state;
+    char time[GPS_TIME_STRING_SIZE] = "0000-00-00T00:00:00.000Z";
+
+    assert_int_equal(gps_internal_parse_number("545.4"), 545400);
+    assert_int_equal(gps_internal_parse_number("-12345.678"), -12345678);
+    assert_int_equal(gps_internal_parse_number("0000000000000000000000000000001.5"), 1500);
+    assert_int_equal(gps_internal_parse_number(""), GPS_INVALID_VALUE);
+
+    assert_int_equal(gps_internal_parse_angular_distance("4807.038", 'N'), 48117300);
+    assert_int_equal(gps_internal_parse_angular_distance("17959.999999", 'W'), -179999999);
+    assert_int_equal(gps_internal_parse_angular_distance("", 'N'), GPS_INVALID_VALUE);
+
+    gps_internal_parse_time(time, "092751.999");
+    gps_internal_parse_date(time, "230394");
+    assert_string_equal(time, "2094-03-23T09:27:51.999Z");
+
+    assert_int_equal(gps_internal_parse_speed("022.4", 'N'), 11522);
+    assert_int_equal(gps_internal_parse_speed("010.2", 'K'), 2833);
+    assert_int_equal(gps_internal_parse_speed("", 'K'), GPS_INVALID_VALUE);
+}
+
+int main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_internal_tokenize),
+        cmocka_unit_test(test_internal_find_parser),
+        cmocka_unit_test(test_internal_parse_fields)
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
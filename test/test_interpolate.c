@@ -0,0 +1,188 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Jacob McGladdery
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include "gps.h"
+#include "gps_interpolate.h"
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+static void add(struct gps_interpolate *interpolate, int64_t time, int32_t latitude, int32_t longitude,
+                int32_t speed, int32_t track)
+{
+    struct gps_tpv tpv;
+
+    gps_init_tpv(&tpv);
+    tpv.latitude = latitude;
+    tpv.longitude = longitude;
+    tpv.speed = speed;
+    tpv.track = track;
+    assert_int_equal(gps_interpolate_add(interpolate, &tpv, time), GPS_OK);
+}
+
+static void test_interpolate_between(void **state)
+{
+    struct gps_interpolate_sample samples[4];
+    struct gps_interpolate interpolate;
+    struct gps_interpolate_sample fix;
+
+    (void)state;
+
+    gps_interpolate_init(&interpolate, samples, 4, 0);
+    assert_int_equal(gps_interpolate_at(&interpolate, 0, &fix), GPS_ERROR_END);
+
+    /* Across the antimeridian, with the track passing north */
+    add(&interpolate, 1000, 0, 179999000, 10000, 350000);
+    add(&interpolate, 2000, 1000, -179999000, 20000, 10000);
+
+    assert_int_equal(gps_interpolate_at(&interpolate, 1250, &fix), GPS_OK);
+    assert_int_equal(fix.time, 1250);
+    assert_int_equal(fix.latitude, 250);
+    assert_int_equal(fix.longitude, 179999500);
+    assert_int_equal(fix.speed, 12500);
+    assert_int_equal(fix.track, 355000);
+
+    assert_int_equal(gps_interpolate_at(&interpolate, 1500, &fix), GPS_OK);
+    assert_int_equal(fix.latitude, 500);
+    assert_int_equal(fix.longitude, 180000000);
+    assert_int_equal(fix.track, 0);
+
+    assert_int_equal(gps_interpolate_at(&interpolate, 1000, &fix), GPS_OK);
+    assert_int_equal(fix.longitude, 179999000);
+    assert_int_equal(gps_interpolate_at(&interpolate, 2000, &fix), GPS_OK);
+    assert_int_equal(fix.longitude, -179999000);
+    assert_int_equal(gps_interpolate_at(&interpolate, 999, &fix), GPS_ERROR_END);
+    assert_int_equal(gps_interpolate_at(&interpolate, 2001, &fix), GPS_ERROR_END);
+}
+
+static void test_interpolate_dead_reckoning(void **state)
+{
+    struct gps_interpolate_sample samples[4];
+    struct gps_interpolate interpolate;
+    struct gps_interpolate_sample fix;
+
+    (void)state;
+
+    /* 10 m/s north on the equator is 89.93 micro-degrees per second */
+    gps_interpolate_init(&interpolate, samples, 4, 2000);
+    add(&interpolate, 0, 0, 0, 10000, 0);
+    assert_int_equal(gps_interpolate_at(&interpolate, 1000, &fix), GPS_OK);
+    assert_in_range(fix.latitude, 89, 90);
+    assert_in_range(fix.longitude, -1, 1);
+    assert_int_equal(fix.speed, 10000);
+    assert_int_equal(fix.track, 0);
+    assert_int_equal(gps_interpolate_at(&interpolate, 2000, &fix), GPS_OK);
+    assert_in_range(fix.latitude, 179, 180);
+    assert_int_equal(gps_interpolate_at(&interpolate, 2001, &fix), GPS_ERROR_END);
+
+    /* Due west at 60 degrees north covers twice the longitude */
+    add(&interpolate, 1000, 60000000, 10000000, 10000, 270000);
+    assert_int_equal(gps_interpolate_at(&interpolate, 2000, &fix), GPS_OK);
+    assert_in_range(fix.latitude, 59999999, 60000001);
+    assert_in_range(fix.longitude, 10000000 - 181, 10000000 - 178);
+
+    /* Southwards the latitude stops at the pole */
+    add(&interpolate, 3000, -89999990, 0, 10000, 180000);
+    assert_int_equal(gps_interpolate_at(&interpolate, 5000, &fix), GPS_OK);
+    assert_int_equal(fix.latitude, -90000000);
+}
+
+static void test_interpolate_without_velocity(void **state)
+{
+    struct gps_interpolate_sample samples[4];
+    struct gps_interpolate interpolate;
+    struct gps_interpolate_sample fix;
+
+    (void)state;
+
+    /* A single fix without velocity is held */
+    gps_interpolate_init(&interpolate, samples, 4, 1000);
+    add(&interpolate, 0, 0, 0, GPS_INVALID_VALUE, GPS_INVALID_VALUE);
+    assert_int_equal(gps_interpolate_at(&interpolate, 500, &fix), GPS_OK);
+    assert_int_equal(fix.latitude, 0);
+    assert_int_equal(fix.longitude, 0);
+    assert_int_equal(fix.speed, GPS_INVALID_VALUE);
+
+    /* Then the last two positions give the velocity */
+    add(&interpolate, 1000, 100, -200, GPS_INVALID_VALUE, GPS_INVALID_VALUE);
+    assert_int_equal(gps_interpolate_at(&interpolate, 1500, &fix), GPS_OK);
+    assert_int_equal(fix.latitude, 150);
+    assert_int_equal(fix.longitude, -300);
+    assert_int_equal(fix.track, GPS_INVALID_VALUE);
+    assert_int_equal(gps_interpolate_at(&interpolate, 500, &fix), GPS_OK);
+    assert_int_equal(fix.latitude, 50);
+    assert_int_equal(fix.longitude, -100);
+}
+
+static void test_interpolate_ring(void **state)
+{
+    struct gps_interpolate_sample samples[4];
+    struct gps_interpolate interpolate;
+    struct gps_interpolate_sample fix;
+    struct gps_tpv tpv;
+    int64_t t;
+
+    (void)state;
+
+    /* Only the last four fixes are kept */
+    gps_interpolate_init(&interpolate, samples, 4, 0);
+    for (t = 0; t < 6; ++t) add(&interpolate, t * 1000, (int32_t)t * 1000, 0, GPS_INVALID_VALUE, 0);
+    assert_int_equal(interpolate.count, 4);
+    assert_int_equal(gps_interpolate_at(&interpolate, 1999, &fix), GPS_ERROR_END);
+    for (t = 2000; t <= 5000; t += 250)
+    {
+        assert_int_equal(gps_interpolate_at(&interpolate, t, &fix), GPS_OK);
+        assert_int_equal(fix.latitude, t);
+    }
+
+    /* A later sentence of the same epoch replaces the newest fix */
+    add(&interpolate, 5000, 6000, 0, GPS_INVALID_VALUE, 0);
+    assert_int_equal(interpolate.count, 4);
+    assert_int_equal(gps_interpolate_at(&interpolate, 4500, &fix), GPS_OK);
+    assert_int_equal(fix.latitude, 5000);
+
+    /* A fix without position is refused */
+    gps_init_tpv(&tpv);
+    assert_int_equal(gps_interpolate_add(&interpolate, &tpv, 6000), GPS_ERROR_UNSUPPORTED);
+    assert_int_equal(interpolate.count, 4);
+
+    /* Going back in time starts over */
+    add(&interpolate, 0, 0, 0, GPS_INVALID_VALUE, 0);
+    assert_int_equal(interpolate.count, 1);
+    assert_int_equal(gps_interpolate_at(&interpolate, 4000, &fix), GPS_ERROR_END);
+}
+
+int main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_interpolate_between),
+        cmocka_unit_test(test_interpolate_dead_reckoning),
+        cmocka_unit_test(test_interpolate_without_velocity),
+        cmocka_unit_test(test_interpolate_ring)
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,142 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Jacob McGladdery
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include "gps_latency.h"
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <string.h>
+#include <cmocka.h>
+
+static void test_histogram_small_values(void **state)
+{
+    (void)state;
+    struct gps_histogram histogram;
+    int64_t v;
+
+    gps_histogram_init(&histogram);
+    assert_int_equal(gps_histogram_quantile(&histogram, 500000), 0);
+
+    /* Below 64 every value has a bucket of its own */
+    for (v = 0; v < 64; ++v) gps_histogram_record(&histogram, v);
+    assert_int_equal(histogram.count, 64);
+    assert_int_equal(histogram.sum, 63 * 64 / 2);
+    assert_int_equal(histogram.min, 0);
+    assert_int_equal(histogram.max, 63);
+    assert_int_equal(gps_histogram_quantile(&histogram, 0), 0);
+    assert_int_equal(gps_histogram_quantile(&histogram, 500000), 31);
+    assert_int_equal(gps_histogram_quantile(&histogram, 1000000), 63);
+
+    /* A clock stepping back counts as 0 */
+    gps_histogram_record(&histogram, -5);
+    assert_int_equal(histogram.counts[0], 2);
+}
+
+static void test_histogram_relative_error(void **state)
+{
+    (void)state;
+    static struct gps_histogram histogram;
+    int64_t v;
+
+    /* Single values, spread over the whole range, come back within 1/32 */
+    for (v = 64; v < ((int64_t)1 << 36); v += v / 7 + 1)
+    {
+        int64_t q;
+
+        gps_histogram_init(&histogram);
+        gps_histogram_record(&histogram, v);
+        gps_histogram_record(&histogram, 0);
+        gps_histogram_record(&histogram, (int64_t)1 << 40);
+
+        q = gps_histogram_quantile(&histogram, 500000);
+        assert_true(q >= v);
+        assert_true(q - v <= v / 32);
+    }
+
+    /* Values too large to tell apart share the last bucket, yet the
+     * largest is still reported exactly
+     */
+    gps_histogram_init(&histogram);
+    gps_histogram_record(&histogram, (int64_t)1 << 40);
+    gps_histogram_record(&histogram, INT64_MAX / 2);
+    assert_int_equal(histogram.counts[GPS_HISTOGRAM_BUCKETS - 1], 2);
+    assert_true(gps_histogram_quantile(&histogram, 1000000) == INT64_MAX / 2);
+}
+
+static void test_histogram_quantiles(void **state)
+{
+    (void)state;
+    static struct gps_histogram a, b;
+    int64_t v;
+
+    /* 1 to 1000 microseconds, split over two histograms */
+    gps_histogram_init(&a);
+    gps_histogram_init(&b);
+    for (v = 1; v <= 1000; ++v) gps_histogram_record((v % 2) ? &a : &b, v * 1000);
+    gps_histogram_add(&a, &b);
+
+    assert_int_equal(a.count, 1000);
+    assert_int_equal(a.min, 1000);
+    assert_int_equal(a.max, 1000000);
+    assert_true(gps_histogram_quantile(&a, 500000) >= 500000);
+    assert_true(gps_histogram_quantile(&a, 500000) <= 500000 + 500000 / 32);
+    assert_true(gps_histogram_quantile(&a, 990000) >= 990000);
+    assert_true(gps_histogram_quantile(&a, 990000) <= 1000000);
+    assert_int_equal(gps_histogram_quantile(&a, 0), 1000);
+    assert_int_equal(gps_histogram_quantile(&a, 1000000), 1000000);
+}
+
+static void test_latency_record(void **state)
+{
+    (void)state;
+    static struct gps_latency latency;
+    struct gps_latency_stamps stamps;
+
+    gps_latency_init(&latency);
+
+    /* 1 ms on the wire, 2 us decoding, 10 us until picked up */
+    stamps.start = 5000000;
+    stamps.end = 6000000;
+    stamps.decoded = 6002000;
+    gps_latency_record(&latency, &stamps, 6012000);
+
+    assert_int_equal(latency.stages[GPS_LATENCY_RECEIVE].max, 1000000);
+    assert_int_equal(latency.stages[GPS_LATENCY_DECODE].max, 2000);
+    assert_int_equal(latency.stages[GPS_LATENCY_DISPATCH].max, 10000);
+    assert_int_equal(latency.stages[GPS_LATENCY_TOTAL].max, 1012000);
+    assert_int_equal(latency.stages[GPS_LATENCY_TOTAL].count, 1);
+}
+
+int main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_histogram_small_values),
+        cmocka_unit_test(test_histogram_relative_error),
+        cmocka_unit_test(test_histogram_quantiles),
+        cmocka_unit_test(test_latency_record)
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
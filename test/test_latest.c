@@ -0,0 +1,183 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Jacob McGladdery
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "gps_latest.h"
+
+#include <pthread.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <setjmp.h>
+#include <stdatomic.h>
+#include <string.h>
+#include <unistd.h>
+#include <cmocka.h>
+
+#define MIN_READERS   (2)
+#define MAX_READERS   (8)
+#define NUM_PUBLISHES (200000)
+
+struct reader
+{
+    pthread_t thread;
+    struct gps_latest *latest;
+    atomic_int *done;
+    unsigned reads;
+    unsigned torn;
+    unsigned backwards;
+};
+
+/* Every member of the TPV is derived from its publish number, so that a
+ * copy mixing two publishes is detected
+ */
+static void make_tpv(struct gps_tpv *tpv, uint32_t n)
+{
+    tpv->mode = (enum gps_mode)(n % 4);
+    tpv->altitude = (int32_t)(n ^ 0x55555555);
+    tpv->latitude = (int32_t)n;
+    tpv->longitude = -(int32_t)n;
+    tpv->track = (int32_t)(n * 7);
+    tpv->speed = (int32_t)~n;
+    snprintf(tpv->time, sizeof(tpv->time), "%024u", (unsigned)n);
+    snprintf(tpv->talker_id, sizeof(tpv->talker_id), "%02u", (unsigned)(n % 100));
+}
+
+static void *read_latest(void *context)
+{
+    struct reader *reader = context;
+    struct gps_tpv expected;
+    struct gps_tpv tpv;
+    uint32_t last = 0;
+
+    while (!atomic_load_explicit(reader->done, memory_order_relaxed))
+    {
+        uint32_t n = gps_latest_read(reader->latest, &tpv);
+
+        if (0 == n) continue;
+        make_tpv(&expected, n);
+        if (memcmp(&tpv, &expected, sizeof(tpv)) != 0) reader->torn++;
+        if (n < last) reader->backwards++;
+        last = n;
+        reader->reads++;
+    }
+
+    return NULL;
+}
+
+static void test_latest_init(void **state)
+{
+    (void)state;
+    struct gps_latest latest;
+    struct gps_tpv expected;
+    struct gps_tpv tpv;
+
+    gps_latest_init(&latest);
+    gps_init_tpv(&expected);
+    memset(&tpv, 0xAA, sizeof(tpv));
+    assert_int_equal(gps_latest_read(&latest, &tpv), 0);
+    assert_memory_equal(&tpv, &expected, sizeof(tpv));
+}
+
+static void test_latest_publish(void **state)
+{
+    (void)state;
+    struct gps_latest latest;
+    struct gps_tpv expected;
+    struct gps_tpv tpv;
+
+    gps_latest_init(&latest);
+    make_tpv(&expected, 1);
+    gps_latest_publish(&latest, &expected);
+    assert_int_equal(gps_latest_read(&latest, &tpv), 1);
+    assert_memory_equal(&tpv, &expected, sizeof(tpv));
+
+    make_tpv(&expected, 2);
+    gps_latest_publish(&latest, &expected);
+    assert_int_equal(gps_latest_read(&latest, &tpv), 2);
+    assert_memory_equal(&tpv, &expected, sizeof(tpv));
+
+    /* After 2^31 - 1 publishes the count wraps around to 1, never to 0 */
+    latest.storage[0] = UINT32_MAX - 1;
+    assert_int_equal(gps_latest_read(&latest, &tpv), INT32_MAX);
+    gps_latest_publish(&latest, &expected);
+    assert_int_equal(gps_latest_read(&latest, &tpv), 1);
+    assert_memory_equal(&tpv, &expected, sizeof(tpv));
+}
+
+/* One writer publishing as fast as it can against a reader on every other
+ * core. No read may return a torn TPV or go back in time.
+ */
+static void test_latest_stress(void **state)
+{
+    (void)state;
+    struct reader readers[MAX_READERS];
+    struct gps_latest latest;
+    struct gps_tpv tpv;
+    atomic_int done;
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    int count;
+    uint32_t n;
+    int i;
+
+    count = (int)((cores - 1 < MIN_READERS) ? MIN_READERS : (cores - 1 > MAX_READERS) ? MAX_READERS : cores - 1);
+
+    gps_latest_init(&latest);
+    atomic_init(&done, 0);
+    for (i = 0; i < count; ++i)
+    {
+        memset(&readers[i], 0, sizeof(readers[i]));
+        readers[i].latest = &latest;
+        readers[i].done = &done;
+        assert_int_equal(pthread_create(&readers[i].thread, NULL, read_latest, &readers[i]), 0);
+    }
+
+    for (n = 1; n <= NUM_PUBLISHES; ++n)
+    {
+        make_tpv(&tpv, n);
+        gps_latest_publish(&latest, &tpv);
+    }
+
+    atomic_store_explicit(&done, 1, memory_order_relaxed);
+    for (i = 0; i < count; ++i)
+    {
+        assert_int_equal(pthread_join(readers[i].thread, NULL), 0);
+        assert_int_equal(readers[i].torn, 0);
+        assert_int_equal(readers[i].backwards, 0);
+    }
+
+    assert_int_equal(gps_latest_read(&latest, &tpv), NUM_PUBLISHES);
+}
+
+int main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_latest_init),
+        cmocka_unit_test(test_latest_publish),
+        cmocka_unit_test(test_latest_stress)
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
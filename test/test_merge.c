@@ -0,0 +1,198 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Jacob McGladdery
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include "gps_merge.h"
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <stdio.h>
+#include <string.h>
+#include <cmocka.h>
+
+/* 2002-11-13T00:00:00.000Z */
+#define DAY_2002_11_13 (INT64_C(1037145600000))
+
+static void append(char *log, const char *body)
+{
+    char nmea[128];
+
+    gps_encode(nmea, body);
+    strcat(log, nmea);
+}
+
+static void test_merge_order(void **state)
+{
+    (void)state;
+    static char logs[3][2048];
+    struct gps_merge_source sources[3];
+    struct gps_merge merge;
+    struct gps_tpv tpv;
+    int64_t previous = 0;
+    int64_t time;
+    size_t source;
+    size_t count = 0;
+    char body[128];
+    int second;
+    int i;
+
+    /* Each receiver sends a GGA and an RMC every second, the receivers are
+     * a third of a second apart, and the second one also sends noise
+     */
+    for (i = 0; i < 3; ++i)
+    {
+        for (second = 0; second < 5; ++second)
+        {
+            sprintf(body, "GPGGA,1200%02d.%d00,5321.6802,N,00630.3371,W,1,8,1.03,%d.0,M,55.3,M,,",
+                    second, 3 * i, i);
+            append(logs[i], body);
+            if (1 == i) strcat(logs[i], "garbage\r\n$GPGGA,12*00\r\n");
+            sprintf(body, "GPRMC,1200%02d.%d00,A,5321.6802,N,00630.3371,W,%d.0,31.66,131102,,,A",
+                    second, 3 * i, i);
+            append(logs[i], body);
+        }
+        gps_merge_source_init(&sources[i], logs[i], strlen(logs[i]), 0, 0);
+    }
+
+    assert_int_equal(gps_merge_init(&merge, sources, 3), GPS_OK);
+    while (gps_merge_next(&merge, &tpv, &source, &time) == GPS_OK)
+    {
+        /* Fixes come out in time order, a receiver at a time */
+        assert_int_equal(source, count % 3);
+        assert_true(time > previous);
+        assert_int_equal(time, gps_time_to_ms(tpv.time));
+        previous = time;
+
+        /* Both sentences of a second make up one fix */
+        assert_int_equal(tpv.altitude, (int32_t)source * 1000);
+        assert_int_equal(tpv.speed, (int32_t)source * 1000 * 1000 / 1944);
+        ++count;
+    }
+
+    assert_int_equal(count, 15);
+    assert_int_equal(sources[1].errors, 5);
+    assert_int_equal(gps_merge_next(&merge, &tpv, NULL, NULL), GPS_ERROR_END);
+}
+
+static void test_merge_midnight(void **state)
+{
+    (void)state;
+    static char logs[2][1024];
+    static const int64_t expected[] = { -2000, -1000, 0, 0, 500, 1000, 1500, 1500, 2000 };
+    static const size_t from[] = { 0, 0, 0, 1, 1, 0, 1, 1, 0 };
+    struct gps_merge_source sources[2];
+    struct gps_merge merge;
+    struct gps_tpv tpv;
+    int64_t time;
+    size_t source;
+    size_t i;
+
+    /* A receiver whose GGAs keep the old date past midnight */
+    append(logs[0], "GPRMC,235958,A,3907.3840,N,12102.4692,W,0.0,156.1,121102,,,A");
+    append(logs[0], "GPGGA,235959,3907.3840,N,12102.4692,W,1,6,1.2,18.893,M,-25.669,M,,");
+    append(logs[0], "GPGGA,000000,3907.3840,N,12102.4692,W,1,6,1.2,18.893,M,-25.669,M,,");
+    append(logs[0], "GPGGA,000001,3907.3840,N,12102.4692,W,1,6,1.2,18.893,M,-25.669,M,,");
+    append(logs[0], "GPRMC,000002,A,3907.3840,N,12102.4692,W,0.0,156.1,131102,,,A");
+
+    /* A receiver which never sends a date, whose clock runs half a second
+     * behind, and whose last fix steps back in time
+     */
+    append(logs[1], "GPGGA,235959.500,3907.3840,N,12102.4692,W,1,6,1.2,18.893,M,-25.669,M,,");
+    append(logs[1], "GPGGA,000000.000,3907.3840,N,12102.4692,W,1,6,1.2,18.893,M,-25.669,M,,");
+    append(logs[1], "GPGGA,000001.000,3907.3840,N,12102.4692,W,1,6,1.2,18.893,M,-25.669,M,,");
+    append(logs[1], "GPGGA,000000.900,3907.3840,N,12102.4692,W,1,6,1.2,18.893,M,-25.669,M,,");
+
+    gps_merge_source_init(&sources[0], logs[0], strlen(logs[0]), 0, 0);
+    gps_merge_source_init(&sources[1], logs[1], strlen(logs[1]), 500, DAY_2002_11_13 - GPS_MS_PER_DAY);
+    assert_int_equal(gps_merge_init(&merge, sources, 2), GPS_OK);
+
+    for (i = 0; i < sizeof(expected) / sizeof(expected[0]); ++i)
+    {
+        assert_int_equal(gps_merge_next(&merge, &tpv, &source, &time), GPS_OK);
+        assert_int_equal(time, DAY_2002_11_13 + expected[i]);
+        assert_int_equal(source, from[i]);
+    }
+    assert_int_equal(gps_merge_next(&merge, &tpv, &source, &time), GPS_ERROR_END);
+}
+
+static void test_merge_starts_at_midnight(void **state)
+{
+    (void)state;
+    static char log[1024];
+    struct gps_merge_source sources[1];
+    struct gps_merge merge;
+    struct gps_tpv tpv;
+    int64_t time;
+    int64_t second;
+
+    /* A daily log whose first fix is at 00:00:00.000, after a sentence
+     * without a time
+     */
+    log[0] = '\0';
+    append(log, "GPGSA,A,3,10,07,05,02,29,04,08,13,,,,,1.72,1.03,1.38");
+    append(log, "GPGGA,000000.000,3907.3840,N,12102.4692,W,1,6,1.2,18.893,M,-25.669,M,,");
+    append(log, "GPGGA,000001.000,3907.3840,N,12102.4692,W,1,6,1.2,19.893,M,-25.669,M,,");
+    append(log, "GPGGA,000002.000,3907.3840,N,12102.4692,W,1,6,1.2,20.893,M,-25.669,M,,");
+    gps_merge_source_init(&sources[0], log, strlen(log), 0, DAY_2002_11_13);
+    assert_int_equal(gps_merge_init(&merge, sources, 1), GPS_OK);
+
+    for (second = 0; second < 3; ++second)
+    {
+        assert_int_equal(gps_merge_next(&merge, &tpv, NULL, &time), GPS_OK);
+        assert_int_equal(time, DAY_2002_11_13 + second * 1000);
+        assert_int_equal(tpv.altitude, 18893 + (int32_t)second * 1000);
+        assert_int_equal(tpv.mode, GPS_MODE_3D_FIX);
+    }
+    assert_int_equal(gps_merge_next(&merge, &tpv, NULL, NULL), GPS_ERROR_END);
+}
+
+static void test_merge_limits(void **state)
+{
+    (void)state;
+    static struct gps_merge_source sources[GPS_MERGE_MAX_SOURCES + 1];
+    struct gps_merge merge;
+    struct gps_tpv tpv;
+    size_t i;
+
+    for (i = 0; i < GPS_MERGE_MAX_SOURCES + 1; ++i)
+    {
+        gps_merge_source_init(&sources[i], "", 0, 0, 0);
+    }
+
+    assert_int_equal(gps_merge_init(&merge, sources, GPS_MERGE_MAX_SOURCES + 1), GPS_ERROR_OVERFLOW);
+    assert_int_equal(gps_merge_init(&merge, sources, GPS_MERGE_MAX_SOURCES), GPS_OK);
+    assert_int_equal(gps_merge_next(&merge, &tpv, NULL, NULL), GPS_ERROR_END);
+}
+
+int main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_merge_order),
+        cmocka_unit_test(test_merge_midnight),
+        cmocka_unit_test(test_merge_starts_at_midnight),
+        cmocka_unit_test(test_merge_limits)
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
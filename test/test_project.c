@@ -0,0 +1,274 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Jacob McGladdery
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/* Expected values were computed in double precision, ENU through geocentric
+ * coordinates and UTM with the sixth order Krueger series, both of which are
+ * accurate to well below a millimeter.
+ */
+
+#include "gps_project.h"
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <string.h>
+#include <cmocka.h>
+
+#define ENU_TOLERANCE       (10)     /* Millimeters */
+#define ENU_FLOAT_TOLERANCE (0.01)   /* Meters */
+#define ENU_FLOAT_PPM       (0.3e-6) /* Relative to the distance */
+#define UTM_TOLERANCE       (5)      /* Millimeters */
+
+struct enu_case
+{
+    int32_t origin[3];
+    int32_t point[3];
+    double enu[3];
+};
+
+struct utm_case
+{
+    int zone;
+    int32_t latitude;
+    int32_t longitude;
+    double easting;
+    double northing;
+};
+
+/* 1 cm, 1.5 km, 100 km and 900 km away from origins in Zurich, Sydney,
+ * Svalbard and next to the antimeridian
+ */
+static const struct enu_case enu_cases[] = {
+    { { 47376887, 8541694, 408000 }, { 47376897, 8541714, 413000 }, { 1.5105, 1.1119, 5.0000 } },
+    { { 47376887, 8541694, 408000 }, { 47386887, 8528694, 406000 }, { -981.6306, 1111.9357, -2.1724 } },
+    { { 47376887, 8541694, 408000 }, { 47976887, 9441694, 528000 }, { 67195.6011, 67103.0710, -586.7142 } },
+    { { 47376887, 8541694, 408000 }, { 40376887, 15041694, 108000 }, { 550822.4645, -752834.5904, -68923.8498 } },
+    { { -33868820, 151209296, 58000 }, { -33868810, 151209316, 63000 }, { 1.8505, 1.1092, 5.0000 } },
+    { { -33868820, 151209296, 58000 }, { -33858820, 151196296, 56000 }, { -1202.9960, 1109.1330, -2.2101 } },
+    { { -33868820, 151209296, 58000 }, { -33268820, 152109296, 178000 }, { 83850.7986, 66182.4034, -775.2756 } },
+    { { -33868820, 151209296, 58000 }, { -40868820, 157709296, -242000 }, { 546766.1806, -792235.9351, -73485.6726 } },
+    { { 78223172, 15626723, 10000 }, { 78223182, 15626727, 15000 }, { 0.0912, 1.1165, 5.0000 } },
+    { { 78223172, 15626723, 10000 }, { 78233172, 15624123, 8000 }, { -59.2137, 1116.4727, -2.0977 } },
+    { { 78223172, 15626723, 10000 }, { 78823172, 15806723, 130000 }, { 3896.6684, 66995.6985, -232.0122 } },
+    { { 78223172, 15626723, 10000 }, { 71223172, 16926723, -290000 }, { 46715.6489, -778804.9562, -48068.6655 } },
+    { { 0, 179999000, 0 }, { 10, 179999020, 5000 }, { 2.2264, 1.1057, 5.0000 } },
+    { { 0, 179999000, 0 }, { 10000, 179986000, -2000 }, { -1447.1529, 1105.7424, -2.2607 } },
+    { { 0, 179999000, 0 }, { 600000, -179101000, 120000 }, { 100179.8501, 66344.6339, -1014.2098 } },
+    { { 0, 179999000, 0 }, { -7000000, -173501000, -300000 }, { 716645.6582, -772097.6562, -88218.7835 } },
+};
+
+static const struct utm_case utm_cases[] = {
+    { 31, 48858093, 2294694, 448265.9147, 5411920.6515 },
+    { 56, -33856784, 151215297, 334900.2613, 6252290.5224 },
+    { 1, -4302181, -174000000, 833042.0450, 9523816.2456 },
+    { 32, 64000000, 12000000, 646695.2273, 7100467.0494 },
+    { 21, -79000000, -60000000, 436123.8375, 1228384.0341 },
+    { 37, 83500000, 36000000, 462101.3367, 9273261.9089 },
+    { 31, 0, 3000000, 500000.0000, 0.0000 },
+    { 1, 1000000, -177000000, 500000.0000, 110530.1588 },
+};
+
+#define CASES(x) (sizeof(x) / sizeof(x[0]))
+
+static double absolute(double x)
+{
+    return (x < 0) ? -x : x;
+}
+
+static void test_enu_origin(void **state)
+{
+    (void)state;
+
+    struct gps_project_origin origin;
+    int32_t latitude = 47376887;
+    int32_t longitude = 8541694;
+    int32_t altitude = 408000;
+    int32_t east, north, up;
+    float east_float, north_float, up_float;
+
+    gps_project_origin_init(&origin, latitude, longitude, altitude);
+    gps_project_enu(&origin, &east, &north, &up, &latitude, &longitude, &altitude, 1);
+    assert_int_equal(east, 0);
+    assert_int_equal(north, 0);
+    assert_int_equal(up, 0);
+
+    gps_project_enu_float(&origin, &east_float, &north_float, &up_float,
+                          &latitude, &longitude, &altitude, 1);
+    assert_true(absolute(east_float) < ENU_FLOAT_TOLERANCE);
+    assert_true(absolute(north_float) < ENU_FLOAT_TOLERANCE);
+    assert_true(absolute(up_float) < ENU_FLOAT_TOLERANCE);
+}
+
+static void test_enu(void **state)
+{
+    (void)state;
+
+    size_t i, j;
+
+    for (i = 0; i < CASES(enu_cases); ++i)
+    {
+        const struct enu_case *c = &enu_cases[i];
+        struct gps_project_origin origin;
+        int32_t enu[3];
+
+        gps_project_origin_init(&origin, c->origin[0], c->origin[1], c->origin[2]);
+        gps_project_enu(&origin, &enu[0], &enu[1], &enu[2],
+                        &c->point[0], &c->point[1], &c->point[2], 1);
+
+        for (j = 0; j < 3; ++j)
+        {
+            assert_true(absolute(enu[j] - c->enu[j] * 1000) <= ENU_TOLERANCE);
+        }
+    }
+}
+
+static void test_enu_float(void **state)
+{
+    (void)state;
+
+    size_t i, j;
+
+    for (i = 0; i < CASES(enu_cases); ++i)
+    {
+        const struct enu_case *c = &enu_cases[i];
+        struct gps_project_origin origin;
+        float enu[3];
+        double distance = 0;
+
+        gps_project_origin_init(&origin, c->origin[0], c->origin[1], c->origin[2]);
+        gps_project_enu_float(&origin, &enu[0], &enu[1], &enu[2],
+                              &c->point[0], &c->point[1], &c->point[2], 1);
+
+        for (j = 0; j < 3; ++j) distance += absolute(c->enu[j]);
+        for (j = 0; j < 3; ++j)
+        {
+            assert_true(absolute(enu[j] - c->enu[j]) <= ENU_FLOAT_TOLERANCE + ENU_FLOAT_PPM * distance);
+        }
+    }
+}
+
+static void test_enu_batch(void **state)
+{
+    (void)state;
+
+    struct gps_project_origin origin;
+    int32_t latitude[CASES(enu_cases)];
+    int32_t longitude[CASES(enu_cases)];
+    int32_t altitude[CASES(enu_cases)];
+    int32_t east[CASES(enu_cases)], north[CASES(enu_cases)], up[CASES(enu_cases)];
+    int32_t east_flat[CASES(enu_cases)], north_flat[CASES(enu_cases)], up_flat[CASES(enu_cases)];
+    float east_float[CASES(enu_cases)], north_float[CASES(enu_cases)], up_float[CASES(enu_cases)];
+    size_t i;
+
+    /* Every point of the first origin in a single call */
+    gps_project_origin_init(&origin, enu_cases[0].origin[0], enu_cases[0].origin[1], enu_cases[0].origin[2]);
+    for (i = 0; i < 4; ++i)
+    {
+        latitude[i] = enu_cases[i].point[0];
+        longitude[i] = enu_cases[i].point[1];
+        altitude[i] = enu_cases[i].point[2];
+    }
+
+    gps_project_enu(&origin, east, north, up, latitude, longitude, altitude, 4);
+    gps_project_enu_float(&origin, east_float, north_float, up_float, latitude, longitude, altitude, 4);
+    for (i = 0; i < 4; ++i)
+    {
+        assert_true(absolute(east[i] - enu_cases[i].enu[0] * 1000) <= ENU_TOLERANCE);
+        assert_true(absolute(north[i] - enu_cases[i].enu[1] * 1000) <= ENU_TOLERANCE);
+        assert_true(absolute(up[i] - enu_cases[i].enu[2] * 1000) <= ENU_TOLERANCE);
+        assert_true(absolute(east_float[i] - east[i] / 1000.0) <= 1.0);
+        assert_true(absolute(north_float[i] - north[i] / 1000.0) <= 1.0);
+        assert_true(absolute(up_float[i] - up[i] / 1000.0) <= 1.0);
+    }
+
+    /* Without altitudes the points are at the height of the origin */
+    for (i = 0; i < 4; ++i) altitude[i] = origin.altitude;
+    gps_project_enu(&origin, east, north, up, latitude, longitude, altitude, 4);
+    gps_project_enu(&origin, east_flat, north_flat, up_flat, latitude, longitude, NULL, 4);
+    assert_memory_equal(east, east_flat, 4 * sizeof(int32_t));
+    assert_memory_equal(north, north_flat, 4 * sizeof(int32_t));
+    assert_memory_equal(up, up_flat, 4 * sizeof(int32_t));
+
+    /* Nothing to do */
+    gps_project_enu(&origin, NULL, NULL, NULL, NULL, NULL, NULL, 0);
+    gps_project_enu_float(&origin, NULL, NULL, NULL, NULL, NULL, NULL, 0);
+}
+
+static void test_utm_zone(void **state)
+{
+    (void)state;
+
+    assert_int_equal(gps_project_utm_zone(48858093, 2294694), 31);
+    assert_int_equal(gps_project_utm_zone(-33856784, 151215297), 56);
+    assert_int_equal(gps_project_utm_zone(0, -180000000), 1);
+    assert_int_equal(gps_project_utm_zone(0, 180000000), 60);
+    assert_int_equal(gps_project_utm_zone(0, -1), 30);
+    assert_int_equal(gps_project_utm_zone(0, 0), 31);
+
+    /* Southern Norway */
+    assert_int_equal(gps_project_utm_zone(60391263, 5322054), 32);
+    assert_int_equal(gps_project_utm_zone(55000000, 5322054), 31);
+
+    /* Svalbard */
+    assert_int_equal(gps_project_utm_zone(78223172, 15626723), 33);
+    assert_int_equal(gps_project_utm_zone(78223172, 8000000), 31);
+    assert_int_equal(gps_project_utm_zone(78223172, 30000000), 35);
+    assert_int_equal(gps_project_utm_zone(78223172, 40000000), 37);
+}
+
+static void test_utm(void **state)
+{
+    (void)state;
+
+    size_t i;
+
+    for (i = 0; i < CASES(utm_cases); ++i)
+    {
+        const struct utm_case *c = &utm_cases[i];
+        int64_t easting, northing;
+        double easting_double, northing_double;
+
+        gps_project_utm(c->zone, &easting, &northing, &c->latitude, &c->longitude, 1);
+        assert_true(absolute(easting - c->easting * 1000) <= UTM_TOLERANCE);
+        assert_true(absolute(northing - c->northing * 1000) <= UTM_TOLERANCE);
+
+        gps_project_utm_double(c->zone, &easting_double, &northing_double, &c->latitude, &c->longitude, 1);
+        assert_true(absolute(easting_double - c->easting) * 1000 <= UTM_TOLERANCE);
+        assert_true(absolute(northing_double - c->northing) * 1000 <= UTM_TOLERANCE);
+    }
+}
+
+int main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_enu_origin),
+        cmocka_unit_test(test_enu),
+        cmocka_unit_test(test_enu_float),
+        cmocka_unit_test(test_enu_batch),
+        cmocka_unit_test(test_utm_zone),
+        cmocka_unit_test(test_utm)
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
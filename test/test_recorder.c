@@ -0,0 +1,207 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Jacob McGladdery
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include "gps.h"
+#include "gps_recorder.h"
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <stdio.h>
+#include <string.h>
+#include <cmocka.h>
+
+#define DUMP_PATH "test_recorder.log"
+
+static size_t encode(char *nmea, const char *body)
+{
+    gps_encode(nmea, body);
+    return strlen(nmea);
+}
+
+static void test_recorder_order(void **state)
+{
+    (void)state;
+    char arena[1024];
+    struct gps_recorder recorder;
+    struct gps_recorder_cursor cursor;
+    const char *nmea;
+    size_t size;
+    int64_t time;
+
+    gps_recorder_init(&recorder, arena, sizeof(arena));
+    gps_recorder_begin(&recorder, &cursor);
+    assert_int_equal(gps_recorder_next(&recorder, &cursor, &nmea, &size, &time), GPS_ERROR_END);
+
+    assert_int_equal(gps_recorder_store(&recorder, "$A*00\r\n", 7, 1000), GPS_OK);
+    assert_int_equal(gps_recorder_store(&recorder, "$BB*00", 6, 2000), GPS_OK);
+    assert_int_equal(recorder.count, 2);
+
+    gps_recorder_begin(&recorder, &cursor);
+    assert_int_equal(gps_recorder_next(&recorder, &cursor, &nmea, &size, &time), GPS_OK);
+    assert_int_equal(size, 7);
+    assert_memory_equal(nmea, "$A*00\r\n", 7);
+    assert_int_equal(time, 1000);
+    assert_int_equal(gps_recorder_next(&recorder, &cursor, &nmea, &size, NULL), GPS_OK);
+    assert_int_equal(size, 6);
+    assert_memory_equal(nmea, "$BB*00", 6);
+    assert_int_equal(gps_recorder_next(&recorder, &cursor, &nmea, &size, &time), GPS_ERROR_END);
+
+    /* Records larger than the arena are refused */
+    gps_recorder_init(&recorder, arena, 16);
+    assert_int_equal(gps_recorder_store(&recorder, "$A*00\r\n", 7, 0), GPS_ERROR_OVERFLOW);
+    assert_int_equal(gps_recorder_store(&recorder, "$A*00", 5, 0), GPS_OK);
+}
+
+static void test_recorder_overwrite(void **state)
+{
+    (void)state;
+    static char text[64];
+    char arena[200];
+    struct gps_recorder recorder;
+    uint32_t seed = 1;
+    int n;
+
+    memset(text, 'x', sizeof(text));
+    gps_recorder_init(&recorder, arena, sizeof(arena));
+
+    /* Sentences of random length, each tagged with its number, wrap around
+     * the arena many times. The newest ones must always be held, in order,
+     * and once the arena is full, no more space may be lost than two of the
+     * longest records take.
+     */
+    for (n = 1; n <= 2000; ++n)
+    {
+        struct gps_recorder_cursor cursor;
+        const char *nmea;
+        size_t size;
+        size_t used = 0;
+        int64_t time;
+        int64_t expected;
+        size_t length;
+
+        seed = seed * 1103515245u + 12345u;
+        length = 1 + (seed >> 16) % sizeof(text);
+        assert_int_equal(gps_recorder_store(&recorder, text, length, n), GPS_OK);
+
+        gps_recorder_begin(&recorder, &cursor);
+        expected = n - (int64_t)recorder.count + 1;
+        while (GPS_OK == gps_recorder_next(&recorder, &cursor, &nmea, &size, &time))
+        {
+            assert_int_equal(time, expected++);
+            assert_true(nmea >= arena);
+            assert_true(nmea + size <= arena + sizeof(arena));
+            used += GPS_RECORDER_HEADER_SIZE + size;
+        }
+        assert_int_equal(expected, n + 1);
+        assert_true(used <= sizeof(arena));
+        if (recorder.overwritten > 0)
+        {
+            assert_true(used + 2 * (GPS_RECORDER_HEADER_SIZE + sizeof(text)) >= sizeof(arena));
+        }
+        assert_int_equal(recorder.stored - recorder.overwritten, recorder.count);
+    }
+}
+
+static void test_recorder_decode(void **state)
+{
+    (void)state;
+    char arena[512];
+    char nmea[128];
+    struct gps_recorder recorder;
+    struct gps_recorder_cursor cursor;
+    struct gps_tpv tpv;
+    const char *stored;
+    size_t size;
+    size_t length;
+
+    gps_init_tpv(&tpv);
+    gps_recorder_init(&recorder, arena, sizeof(arena));
+
+    length = encode(nmea, "GPGGA,092751.000,5321.6802,N,00630.3371,W,1,8,1.03,61.7,M,55.3,M,,");
+    assert_int_equal(gps_recorder_decode(&recorder, &tpv, nmea, length, 7), GPS_OK);
+    assert_int_equal(tpv.altitude, 61700);
+
+    /* A bad checksum is not kept */
+    nmea[length - 3] ^= 1;
+    assert_int_equal(gps_recorder_decode(&recorder, &tpv, nmea, length, 8), GPS_ERROR_CHECKSUM);
+
+    /* An intact sentence the decoder does not support is kept, a corrupt
+     * one is not
+     */
+    length = encode(nmea, "GPGSV,3,1,11,10,63,137,17,07,61,098,15,05,59,290,20,08,54,157,30");
+    assert_int_equal(gps_recorder_decode(&recorder, &tpv, nmea, length, 9), GPS_ERROR_UNSUPPORTED);
+    nmea[10] = '2';
+    assert_int_equal(gps_recorder_decode(&recorder, &tpv, nmea, length, 10), GPS_ERROR_UNSUPPORTED);
+
+    assert_int_equal(recorder.count, 2);
+    gps_recorder_begin(&recorder, &cursor);
+    assert_int_equal(gps_recorder_next(&recorder, &cursor, &stored, &size, NULL), GPS_OK);
+    assert_memory_equal(stored, "$GPGGA,092751.000,", 18);
+    assert_int_equal(gps_recorder_next(&recorder, &cursor, &stored, &size, NULL), GPS_OK);
+    assert_memory_equal(stored, "$GPGSV,3,1,11,", 14);
+}
+
+static void test_recorder_dump(void **state)
+{
+    (void)state;
+    char arena[512];
+    char contents[256];
+    struct gps_recorder recorder;
+    FILE *file;
+    size_t size;
+
+    gps_recorder_init(&recorder, arena, sizeof(arena));
+    gps_recorder_store(&recorder, "$GPGSA,A,3,,,,,,,,,,,,,,,*6E\r\n", 30, 12500000000);
+    gps_recorder_store(&recorder, "$GPVTG,,,,,,,,,N*30", 19, 12500000001);
+
+    assert_int_equal(gps_recorder_dump(&recorder, DUMP_PATH), GPS_OK);
+
+    file = fopen(DUMP_PATH, "rb");
+    assert_non_null(file);
+    size = fread(contents, 1, sizeof(contents) - 1, file);
+    fclose(file);
+    contents[size] = '\0';
+    assert_string_equal(contents,
+                        "12.500000000 $GPGSA,A,3,,,,,,,,,,,,,,,*6E\r\n"
+                        "12.500000001 $GPVTG,,,,,,,,,N*30\r\n");
+
+    /* The temporary file is gone */
+    assert_null(fopen(DUMP_PATH ".tmp", "rb"));
+    remove(DUMP_PATH);
+
+    assert_int_equal(gps_recorder_dump(&recorder, "no/such/directory/" DUMP_PATH), GPS_ERROR_IO);
+}
+
+int main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_recorder_order),
+        cmocka_unit_test(test_recorder_overwrite),
+        cmocka_unit_test(test_recorder_decode),
+        cmocka_unit_test(test_recorder_dump)
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,198 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Jacob McGladdery
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "gps_replay.h"
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <cmocka.h>
+
+#define MAX_LINES (16)
+
+struct capture
+{
+    char text[1024];
+    size_t size;
+    int64_t at[MAX_LINES];
+    size_t lines;
+    size_t fail_at;
+};
+
+static int64_t now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static int capture_write(void *context, const void *data, size_t size)
+{
+    struct capture *capture = context;
+
+    if (capture->lines == capture->fail_at) return GPS_ERROR_IO;
+
+    memcpy(capture->text + capture->size, data, size);
+    capture->size += size;
+    capture->at[capture->lines++] = now_ns();
+
+    return GPS_OK;
+}
+
+static void append(char *log, const char *body)
+{
+    char nmea[128];
+
+    gps_encode(nmea, body);
+    strcat(log, nmea);
+}
+
+static void test_replay_fix_time(void **state)
+{
+    (void)state;
+    static struct capture capture;
+    struct gps_replay_stats stats;
+    char log[1024] = "";
+
+    /* Three fixes a second apart crossing midnight, with lines which do not
+     * carry a time, or do not decode at all, in between
+     */
+    append(log, "GPGGA,235959.000,5321.6802,N,00630.3371,W,1,8,1.03,61.7,M,55.3,M,,");
+    append(log, "GPGSA,A,3,10,07,05,02,29,04,08,13,,,,,1.72,1.03,1.38");
+    strcat(log, "$GPGSV,3,1,11,10,63,137,17,07,61,098,15,05,59,290,20,08,54,157,30*70\r\n");
+    append(log, "GPRMC,000000.000,A,5321.6802,N,00630.3371,W,0.06,31.66,131102,,,A");
+    strcat(log, "line noise\r\n");
+    append(log, "GPGGA,000001.000,5321.6802,N,00630.3371,W,1,8,1.03,61.7,M,55.3,M,,");
+
+    memset(&capture, 0, sizeof(capture));
+    capture.fail_at = MAX_LINES;
+    assert_int_equal(gps_replay(log, strlen(log), GPS_REPLAY_FIX_TIME, 50,
+                                capture_write, &capture, &stats), GPS_OK);
+
+    /* Every line goes out unchanged */
+    assert_int_equal(capture.size, strlen(log));
+    assert_memory_equal(capture.text, log, strlen(log));
+    assert_int_equal(stats.lines, 6);
+    assert_int_equal(stats.skipped, 0);
+    assert_int_equal(stats.deadlines, 2);
+    assert_true(stats.span_ns == 2000000000);
+
+    /* A second of log time is 20 ms at 50 times the speed */
+    assert_true(capture.at[3] - capture.at[0] >= 20000000);
+    assert_true(capture.at[5] - capture.at[0] >= 40000000);
+    assert_true(capture.at[2] - capture.at[0] < 20000000);
+    assert_true(stats.elapsed_ns >= 40000000);
+}
+
+static void test_replay_arrival_time(void **state)
+{
+    (void)state;
+    static struct capture capture;
+    struct gps_replay_stats stats;
+    const char *log =
+        "100.000 $GPZDA,050306,29,10,2003,,*43\r\n"
+        "$GPZDA,050307,29,10,2003,,*42\r\n"
+        "100.100\t$GPZDA,050307,29,10,2003,,*42\r\n"
+        "100.25 $GPZDA,050308,29,10,2003,,*4D\r\n";
+
+    memset(&capture, 0, sizeof(capture));
+    capture.fail_at = MAX_LINES;
+    assert_int_equal(gps_replay(log, strlen(log), GPS_REPLAY_ARRIVAL_TIME, 10,
+                                capture_write, &capture, &stats), GPS_OK);
+
+    /* The arrival times are stripped, and lines without one dropped */
+    assert_int_equal(stats.lines, 3);
+    assert_int_equal(stats.skipped, 1);
+    assert_int_equal(capture.size, 3 * strlen("$GPZDA,050306,29,10,2003,,*43\r\n"));
+    assert_memory_equal(capture.text, "$GPZDA,050306,29,10,2003,,*43\r\n$GPZDA,050307", 44);
+    assert_true(stats.span_ns == 250000000);
+    assert_true(capture.at[1] - capture.at[0] >= 10000000);
+    assert_true(capture.at[2] - capture.at[0] >= 25000000);
+}
+
+static void test_replay_pipe(void **state)
+{
+    (void)state;
+    struct gps_replay_stats stats;
+    char log[1024] = "";
+    char back[1024];
+    int fd[2];
+    int i;
+
+    for (i = 0; i < 4; ++i)
+    {
+        append(log, "GPVTG,176.90,T,,M,3.68,N,6.81,K,A");
+    }
+
+    /* As fast as possible, into a pipe */
+    assert_int_equal(pipe(fd), 0);
+    assert_int_equal(gps_replay(log, strlen(log), GPS_REPLAY_FIX_TIME, 0,
+                                gps_replay_write_fd, &fd[1], &stats), GPS_OK);
+    assert_int_equal(read(fd[0], back, sizeof(back)), (ssize_t)strlen(log));
+    assert_memory_equal(back, log, strlen(log));
+    assert_int_equal(stats.lines, 4);
+    assert_int_equal(stats.deadlines, 0);
+
+    /* Write errors stop the replay */
+    close(fd[0]);
+    close(fd[1]);
+    assert_int_equal(gps_replay(log, strlen(log), GPS_REPLAY_FIX_TIME, 0,
+                                gps_replay_write_fd, &fd[1], NULL), GPS_ERROR_IO);
+}
+
+static void test_replay_write_error(void **state)
+{
+    (void)state;
+    static struct capture capture;
+    struct gps_replay_stats stats;
+    char log[1024] = "";
+
+    append(log, "GPZDA,050306,29,10,2003,,");
+    append(log, "GPZDA,050307,29,10,2003,,");
+    append(log, "GPZDA,050308,29,10,2003,,");
+
+    memset(&capture, 0, sizeof(capture));
+    capture.fail_at = 1;
+    assert_int_equal(gps_replay(log, strlen(log), GPS_REPLAY_FIX_TIME, 1000,
+                                capture_write, &capture, &stats), GPS_ERROR_IO);
+    assert_int_equal(stats.lines, 1);
+}
+
+int main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_replay_fix_time),
+        cmocka_unit_test(test_replay_arrival_time),
+        cmocka_unit_test(test_replay_pipe),
+        cmocka_unit_test(test_replay_write_error)
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,209 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Jacob McGladdery
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include "gps_ring.h"
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <string.h>
+#include <cmocka.h>
+
+#define RING_SIZE (100)
+
+static const char *sentences[] = {
+    "GPGGA,092750.000,5321.6802,N,00630.3372,W,1,8,1.03,61.7,M,55.2,M,,",
+    "GPGSA,A,3,10,07,05,02,29,04,08,13,,,,,1.72,1.03,1.38",
+    "GPRMC,092750.000,A,5321.6802,N,00630.3372,W,0.02,31.66,280511,,,A",
+    "GPVTG,176.90,T,,M,3.68,N,6.81,K,A",
+    "GPGLL,3704.229,N,07647.090,W,153030.311,A",
+    "GPZDA,050306,29,10,2003,,",
+    "GPGGA,092751.000,5321.6802,N,00630.3371,W,1,8,1.03,61.7,M,55.3,M,,"
+};
+
+/* Plays the part of the DMA, writing characters from write onwards and
+ * wrapping around the end of the buffer
+ */
+static size_t receive(char *buffer, size_t write, const char *data, size_t n)
+{
+    while (n--)
+    {
+        buffer[write++] = *data++;
+        if (RING_SIZE == write) write = 0;
+    }
+
+    return write;
+}
+
+static void test_ring_decode(void **state)
+{
+    (void)state;
+    struct gps_tpv expected[sizeof(sentences) / sizeof(sentences[0])];
+    struct gps_tpv tpv;
+    struct gps_ring ring;
+    char stream[1024];
+    char buffer[RING_SIZE];
+    char before[RING_SIZE];
+    size_t count = sizeof(sentences) / sizeof(sentences[0]);
+    size_t length = 0;
+    size_t offset;
+    size_t write = 37;
+    size_t decoded = 0;
+    size_t i;
+    int result;
+
+    /* The sentences are sent twice, so that each one crosses the end of
+     * the buffer at a different point
+     */
+    for (i = 0; i < 2 * count; ++i)
+    {
+        char nmea[128];
+
+        gps_encode(nmea, sentences[i % count]);
+        strcpy(stream + length, nmea);
+        length += strlen(nmea);
+        gps_init_tpv(&expected[i % count]);
+        assert_int_equal(gps_decode(&expected[i % count], nmea), GPS_OK);
+    }
+
+    memset(buffer, '#', sizeof(buffer));
+    gps_ring_init(&ring, buffer, sizeof(buffer), write);
+
+    for (offset = 0; offset < length; offset += 7)
+    {
+        write = receive(buffer, write, stream + offset, (length - offset < 7) ? length - offset : 7);
+
+        memcpy(before, buffer, sizeof(buffer));
+        do
+        {
+            gps_init_tpv(&tpv);
+            result = gps_ring_decode(&ring, write, &tpv);
+            if (GPS_OK == result)
+            {
+                assert_memory_equal(&tpv, &expected[decoded % count], sizeof(tpv));
+                ++decoded;
+            }
+            else
+            {
+                assert_int_equal(result, GPS_ERROR_END);
+            }
+        }
+        while (result != GPS_ERROR_END);
+
+        /* The receive buffer is only ever read */
+        assert_memory_equal(buffer, before, sizeof(buffer));
+    }
+
+    assert_int_equal(decoded, 2 * count);
+    assert_int_equal(ring.read, write);
+}
+
+static void test_ring_partial(void **state)
+{
+    (void)state;
+    struct gps_tpv tpv;
+    struct gps_ring ring;
+    char buffer[RING_SIZE];
+    char nmea[128];
+    size_t write = 90;
+
+    gps_init_tpv(&tpv);
+    gps_encode(nmea, sentences[3]);
+    gps_ring_init(&ring, buffer, sizeof(buffer), write);
+
+    /* Nothing received yet */
+    assert_int_equal(gps_ring_decode(&ring, write, &tpv), GPS_ERROR_END);
+
+    /* Noise is dropped, the start of the sentence is kept */
+    write = receive(buffer, write, "\r\n", 2);
+    write = receive(buffer, write, nmea, 20);
+    assert_int_equal(gps_ring_decode(&ring, write, &tpv), GPS_ERROR_END);
+    assert_int_equal(ring.read, 92);
+    assert_int_equal(tpv.track, GPS_INVALID_VALUE);
+
+    /* The footer arrives */
+    write = receive(buffer, write, nmea + 20, strlen(nmea) - 20);
+    assert_int_equal(gps_ring_decode(&ring, write, &tpv), GPS_OK);
+    assert_int_equal(tpv.track, 176900);
+    assert_int_equal(gps_ring_decode(&ring, write, &tpv), GPS_ERROR_END);
+    assert_int_equal(ring.read, write);
+}
+
+static void test_ring_errors(void **state)
+{
+    (void)state;
+    struct gps_tpv tpv;
+    struct gps_ring ring;
+    char buffer[RING_SIZE];
+    char nmea[128];
+    char noise[GPS_RING_SENTENCE_SIZE];
+    char large[2 * GPS_RING_SENTENCE_SIZE];
+    size_t write = 0;
+
+    gps_init_tpv(&tpv);
+    gps_encode(nmea, sentences[3]);
+    gps_ring_init(&ring, buffer, sizeof(buffer), write);
+
+    /* A sentence cut short by the next one */
+    write = receive(buffer, write, "$GPGGA,0927", 11);
+    write = receive(buffer, write, nmea, strlen(nmea));
+    assert_int_equal(gps_ring_decode(&ring, write, &tpv), GPS_ERROR_TRUNCATED);
+    assert_int_equal(gps_ring_decode(&ring, write, &tpv), GPS_OK);
+    assert_int_equal(gps_ring_decode(&ring, write, &tpv), GPS_ERROR_END);
+
+    /* A bad checksum consumes the sentence */
+    nmea[strlen(nmea) - 3] ^= 1;
+    write = receive(buffer, write, nmea, strlen(nmea));
+    assert_int_equal(gps_ring_decode(&ring, write, &tpv), GPS_ERROR_CHECKSUM);
+    assert_int_equal(gps_ring_decode(&ring, write, &tpv), GPS_ERROR_END);
+    assert_int_equal(ring.read, write);
+
+    /* A header followed by more than a sentence of noise */
+    memset(noise, 'A', sizeof(noise));
+    noise[0] = '$';
+    gps_ring_init(&ring, noise, sizeof(noise), 0);
+    assert_int_equal(gps_ring_decode(&ring, sizeof(noise) - 1, &tpv), GPS_ERROR_END);
+
+    gps_ring_init(&ring, large, sizeof(large), sizeof(large) - 10);
+    write = sizeof(large) - 10;
+    while (write != GPS_RING_SENTENCE_SIZE - 10)
+    {
+        large[write] = noise[write == sizeof(large) - 10 ? 0 : 1];
+        write = (write + 1) % sizeof(large);
+    }
+    assert_int_equal(gps_ring_decode(&ring, write, &tpv), GPS_ERROR_OVERFLOW);
+    assert_int_equal(gps_ring_decode(&ring, write, &tpv), GPS_ERROR_END);
+    assert_int_equal(ring.read, write);
+}
+
+int main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_ring_decode),
+        cmocka_unit_test(test_ring_partial),
+        cmocka_unit_test(test_ring_errors)
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
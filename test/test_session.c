@@ -0,0 +1,360 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Jacob McGladdery
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/* Pseudo-terminals stand in for the receivers. The session reads from the
+ * slave side, like it would from a serial port, while the tests write
+ * sentences into the master side.
+ */
+
+#define _XOPEN_SOURCE 600
+
+#include "gps_session.h"
+
+#include <fcntl.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <setjmp.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+#include <cmocka.h>
+
+#define NUM_DEVICES (4)
+
+struct pty
+{
+    int master;
+    int slave;
+};
+
+struct received
+{
+    int count;
+    int removed;
+    size_t device;
+    struct gps_tpv tpv;
+    struct gps_session *remove_from;
+    struct gps_session *stamps_from;
+    struct gps_latency_stamps stamps;
+};
+
+static void open_pty(struct pty *pty)
+{
+    struct termios attributes;
+
+    pty->master = posix_openpt(O_RDWR | O_NOCTTY);
+    assert_true(pty->master >= 0);
+    assert_int_equal(grantpt(pty->master), 0);
+    assert_int_equal(unlockpt(pty->master), 0);
+    pty->slave = open(ptsname(pty->master), O_RDWR | O_NOCTTY);
+    assert_true(pty->slave >= 0);
+
+    /* Raw mode, like a serial port set up for a receiver */
+    assert_int_equal(tcgetattr(pty->slave, &attributes), 0);
+    attributes.c_iflag &= ~(tcflag_t)(IGNBRK | BRKINT | PARMRK | ISTRIP | INLCR | IGNCR | ICRNL | IXON);
+    attributes.c_oflag &= ~(tcflag_t)OPOST;
+    attributes.c_lflag &= ~(tcflag_t)(ECHO | ECHONL | ICANON | ISIG | IEXTEN);
+    attributes.c_cflag &= ~(tcflag_t)(CSIZE | PARENB);
+    attributes.c_cflag |= CS8;
+    assert_int_equal(tcsetattr(pty->slave, TCSANOW, &attributes), 0);
+}
+
+static void close_pty(struct pty *pty)
+{
+    if (pty->master >= 0) close(pty->master);
+    if (pty->slave >= 0) close(pty->slave);
+}
+
+static void send(const struct pty *pty, const char *data)
+{
+    size_t size = strlen(data);
+
+    assert_int_equal(write(pty->master, data, size), (ssize_t)size);
+}
+
+static void send_sentence(const struct pty *pty, const char *body)
+{
+    char nmea[128];
+
+    gps_encode(nmea, body);
+    send(pty, nmea);
+}
+
+static void on_tpv(void *context, size_t device, const struct gps_tpv *tpv)
+{
+    struct received *r = context;
+
+    if (NULL == tpv)
+    {
+        r->removed++;
+        return;
+    }
+
+    r->count++;
+    r->device = device;
+    r->tpv = *tpv;
+    if (r->stamps_from != NULL) r->stamps = r->stamps_from->devices[device].stamps;
+    if (r->remove_from != NULL) gps_session_remove(r->remove_from, device);
+}
+
+/* Polls until every device has seen the expected number of sentences */
+static void poll_until(struct gps_session *session, const struct received *r, size_t n, int count)
+{
+    int attempts;
+    size_t i;
+
+    for (attempts = 0; attempts < 100; ++attempts)
+    {
+        for (i = 0; i < n; ++i)
+        {
+            if (r[i].count + r[i].removed < count) break;
+        }
+        if (i == n) return;
+        assert_int_equal(gps_session_poll(session, 100), GPS_OK);
+    }
+
+    /* Timed out */
+    assert_true(attempts < 100);
+}
+
+static void test_session_decode(void **state)
+{
+    (void)state;
+    struct gps_session_device devices[NUM_DEVICES];
+    struct gps_session session;
+    struct received received[NUM_DEVICES];
+    struct pty ptys[NUM_DEVICES];
+    size_t device;
+    int i;
+
+    memset(received, 0, sizeof(received));
+    assert_int_equal(gps_session_init(&session, devices, NUM_DEVICES), GPS_OK);
+
+    for (i = 0; i < NUM_DEVICES; ++i)
+    {
+        open_pty(&ptys[i]);
+        assert_int_equal(gps_session_add(&session, ptys[i].slave, on_tpv, &received[i], &device), GPS_OK);
+        assert_int_equal(device, i);
+    }
+
+    /* Each receiver reports a different position */
+    for (i = 0; i < NUM_DEVICES; ++i)
+    {
+        char body[96];
+
+        snprintf(body, sizeof(body), "GPRMC,023044,A,390%d.3840,N,12102.4692,W,0.0,156.1,131102,15.3,E,A", i);
+        send_sentence(&ptys[i], "GPGGA,023044,3907.3840,N,12102.4692,W,1,8,1.03,61.7,M,55.3,M,,");
+        send_sentence(&ptys[i], body);
+    }
+
+    poll_until(&session, received, NUM_DEVICES, 2);
+    for (i = 0; i < NUM_DEVICES; ++i)
+    {
+        assert_int_equal(received[i].count, 2);
+        assert_int_equal(received[i].device, i);
+        assert_int_equal(received[i].tpv.altitude, 61700);
+        assert_string_equal(received[i].tpv.time, "2002-11-13T02:30:44.000Z");
+        assert_int_equal(devices[i].sentences, 2);
+        assert_int_equal(devices[i].errors, 0);
+    }
+
+    /* The GGA altitude stays while the RMC updates the position */
+    assert_int_equal(devices[0].tpv.latitude, 39006400);
+    assert_int_equal(devices[3].tpv.latitude, 39056400);
+
+    gps_session_close(&session);
+    for (i = 0; i < NUM_DEVICES; ++i) close_pty(&ptys[i]);
+}
+
+static void test_session_framing(void **state)
+{
+    (void)state;
+    struct gps_session_device devices[1];
+    struct gps_session session;
+    struct received received;
+    struct pty pty;
+    char nmea[128];
+
+    memset(&received, 0, sizeof(received));
+    assert_int_equal(gps_session_init(&session, devices, 1), GPS_OK);
+    open_pty(&pty);
+    assert_int_equal(gps_session_add(&session, pty.slave, on_tpv, &received, NULL), GPS_OK);
+
+    /* A sentence split across reads, after some line noise */
+    gps_encode(nmea, "GPGGA,092751.000,5321.6802,N,00630.3371,W,1,8,1.03,61.7,M,55.3,M,,");
+    send(&pty, "\x01\xff noise");
+    {
+        char head[64];
+
+        memcpy(head, nmea, 20);
+        head[20] = '\0';
+        send(&pty, head);
+        assert_int_equal(gps_session_poll(&session, 100), GPS_OK);
+        assert_int_equal(received.count, 0);
+        send(&pty, nmea + 20);
+    }
+    poll_until(&session, &received, 1, 1);
+    assert_int_equal(received.tpv.latitude, 53361336);
+
+    /* Bad checksum, a sentence cut short by the next one, an overlong line,
+     * and a sentence type the decoder does not handle
+     */
+    send(&pty, "$GPGGA,092751.000,5321.6802,N,00630.3371,W,1,8,1.03,61.7,M,55.3,M,,*00\r\n");
+    send(&pty, "$GPGGA,0927");
+    send(&pty, "$GPGGA,092751.000,5321.6802,N,00630.3371,W,1,8,1.03,61.7,M,55.3,M,,,,,,,,,,,,,,,,,,,,,,"
+               ",,,,,,,,,,,,,,,,,,,,,,,,,,,,,,,,,,,,,,,,,,,,,,,,,,,,,,,,,,,,,,*00\r\n");
+    send_sentence(&pty, "GPGSV,3,1,11,03,03,111,00,04,15,270,00,06,01,010,00,13,06,292,00");
+    send(&pty, nmea);
+    poll_until(&session, &received, 1, 2);
+    assert_int_equal(devices[0].sentences, 2);
+    assert_int_equal(devices[0].errors, 3);
+
+    gps_session_close(&session);
+    close_pty(&pty);
+}
+
+static void test_session_hang_up(void **state)
+{
+    (void)state;
+    struct gps_session_device devices[1];
+    struct gps_session session;
+    struct received received;
+    struct pty pty, other;
+
+    memset(&received, 0, sizeof(received));
+    assert_int_equal(gps_session_init(&session, devices, 1), GPS_OK);
+    open_pty(&pty);
+    open_pty(&other);
+    assert_int_equal(gps_session_add(&session, pty.slave, on_tpv, &received, NULL), GPS_OK);
+    assert_int_equal(gps_session_add(&session, other.slave, on_tpv, &received, NULL), GPS_ERROR_OVERFLOW);
+
+    /* The receiver goes away */
+    close(pty.master);
+    pty.master = -1;
+    poll_until(&session, &received, 1, 1);
+    assert_int_equal(received.removed, 1);
+    assert_int_equal(devices[0].fd, -1);
+
+    /* Which frees its slot */
+    assert_int_equal(gps_session_add(&session, other.slave, on_tpv, &received, NULL), GPS_OK);
+
+    gps_session_close(&session);
+    close_pty(&pty);
+    close_pty(&other);
+}
+
+static void test_session_remove(void **state)
+{
+    (void)state;
+    struct gps_session_device devices[2];
+    struct gps_session session;
+    struct received received[2];
+    struct pty ptys[2];
+    int i;
+
+    memset(received, 0, sizeof(received));
+    assert_int_equal(gps_session_init(&session, devices, 2), GPS_OK);
+    for (i = 0; i < 2; ++i)
+    {
+        open_pty(&ptys[i]);
+        assert_int_equal(gps_session_add(&session, ptys[i].slave, on_tpv, &received[i], NULL), GPS_OK);
+    }
+
+    /* The first device removes itself from its callback, with more
+     * sentences already read
+     */
+    received[0].remove_from = &session;
+    for (i = 0; i < 3; ++i)
+    {
+        send_sentence(&ptys[0], "GPGGA,092751.000,5321.6802,N,00630.3371,W,1,8,1.03,61.7,M,55.3,M,,");
+        send_sentence(&ptys[1], "GPGGA,092751.000,5321.6802,N,00630.3371,W,1,8,1.03,61.7,M,55.3,M,,");
+    }
+    poll_until(&session, &received[1], 1, 3);
+    assert_int_equal(gps_session_poll(&session, 10), GPS_OK);
+    assert_int_equal(received[0].count, 1);
+    assert_int_equal(received[0].removed, 0);
+    assert_int_equal(received[1].count, 3);
+
+    gps_session_close(&session);
+    for (i = 0; i < 2; ++i) close_pty(&ptys[i]);
+}
+
+static void test_session_timestamps(void **state)
+{
+    (void)state;
+    struct gps_session_device devices[1];
+    struct gps_session session;
+    struct received received;
+    struct gps_latency latency;
+    struct timespec pause = { 0, 20000000 };
+    struct timespec now;
+    struct pty pty;
+    int64_t dispatched;
+
+    memset(&received, 0, sizeof(received));
+    assert_int_equal(gps_session_init(&session, devices, 1), GPS_OK);
+    gps_session_set_timestamps(&session, 1);
+    open_pty(&pty);
+    assert_int_equal(gps_session_add(&session, pty.slave, on_tpv, &received, NULL), GPS_OK);
+    received.stamps_from = &session;
+
+    /* The sentence arrives in two parts 20 ms apart */
+    send(&pty, "$GPGGA,092751.000,5321.6802,N,");
+    assert_int_equal(gps_session_poll(&session, 100), GPS_OK);
+    assert_int_equal(received.count, 0);
+    nanosleep(&pause, NULL);
+    send(&pty, "00630.3371,W,1,8,1.03,61.7,M,55.3,M,,*75\r\n");
+    poll_until(&session, &received, 1, 1);
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    dispatched = (int64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+
+    assert_true(received.stamps.start > 0);
+    assert_true(received.stamps.end - received.stamps.start >= 20000000);
+    assert_true(received.stamps.decoded >= received.stamps.end);
+    assert_true(dispatched >= received.stamps.decoded);
+
+    gps_latency_init(&latency);
+    gps_latency_record(&latency, &received.stamps, dispatched);
+    assert_true(gps_histogram_quantile(&latency.stages[GPS_LATENCY_TOTAL], 1000000) >= 20000000);
+
+    gps_session_close(&session);
+    close_pty(&pty);
+}
+
+int main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_session_decode),
+        cmocka_unit_test(test_session_framing),
+        cmocka_unit_test(test_session_hang_up),
+        cmocka_unit_test(test_session_remove),
+        cmocka_unit_test(test_session_timestamps)
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,302 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Jacob McGladdery
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "gps_shm.h"
+
+#include <fcntl.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <setjmp.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <cmocka.h>
+
+#define NUM_SLOTS     (64)
+#define NUM_PUBLISHES (200000)
+
+static char name[64];
+
+/* Every member of the TPV is derived from its record number, so that a
+ * copy mixing two records is detected
+ */
+static void make_tpv(struct gps_tpv *tpv, uint32_t n)
+{
+    tpv->mode = (enum gps_mode)(n % 4);
+    tpv->altitude = (int32_t)(n ^ 0x55555555);
+    tpv->latitude = (int32_t)n;
+    tpv->longitude = -(int32_t)n;
+    tpv->track = (int32_t)(n * 7);
+    tpv->speed = (int32_t)~n;
+    snprintf(tpv->time, sizeof(tpv->time), "%024u", (unsigned)n);
+    snprintf(tpv->talker_id, sizeof(tpv->talker_id), "%02u", (unsigned)(n % 100));
+}
+
+static void test_shm_publish(void **state)
+{
+    (void)state;
+    struct gps_shm_writer writer;
+    struct gps_shm_reader reader;
+    struct gps_tpv expected;
+    struct gps_tpv tpv;
+    uint32_t number;
+    uint32_t n;
+
+    assert_int_equal(gps_shm_writer_open(&writer, name, NUM_SLOTS), GPS_OK);
+    make_tpv(&tpv, 0);
+    assert_int_equal(gps_shm_publish(&writer, &tpv), 0);
+
+    /* A reader starts with the next record */
+    assert_int_equal(gps_shm_reader_open(&reader, name), GPS_OK);
+    assert_int_equal(gps_shm_read(&reader, &tpv, &number), GPS_ERROR_END);
+
+    for (n = 1; n <= 3; ++n)
+    {
+        make_tpv(&tpv, n);
+        assert_int_equal(gps_shm_publish(&writer, &tpv), n);
+    }
+    for (n = 1; n <= 3; ++n)
+    {
+        make_tpv(&expected, n);
+        assert_int_equal(gps_shm_read(&reader, &tpv, &number), GPS_OK);
+        assert_int_equal(number, n);
+        assert_memory_equal(&tpv, &expected, sizeof(tpv));
+    }
+    assert_int_equal(gps_shm_read(&reader, &tpv, NULL), GPS_ERROR_END);
+    assert_int_equal(reader.lost, 0);
+
+    gps_shm_reader_close(&reader);
+    gps_shm_writer_close(&writer);
+    shm_unlink(name);
+}
+
+static void test_shm_overrun(void **state)
+{
+    (void)state;
+    struct gps_shm_writer writer;
+    struct gps_shm_reader reader;
+    struct gps_tpv expected;
+    struct gps_tpv tpv;
+    uint32_t number;
+    uint32_t n;
+
+    assert_int_equal(gps_shm_writer_open(&writer, name, NUM_SLOTS), GPS_OK);
+    assert_int_equal(gps_shm_reader_open(&reader, name), GPS_OK);
+
+    /* A full ring is still read in order */
+    for (n = 0; n < NUM_SLOTS; ++n)
+    {
+        make_tpv(&tpv, n);
+        gps_shm_publish(&writer, &tpv);
+    }
+    assert_int_equal(gps_shm_read(&reader, &tpv, &number), GPS_OK);
+    assert_int_equal(number, 0);
+
+    /* Falling behind skips to the oldest record left */
+    for (n = NUM_SLOTS; n < 3 * NUM_SLOTS + 10; ++n)
+    {
+        make_tpv(&tpv, n);
+        gps_shm_publish(&writer, &tpv);
+    }
+    assert_int_equal(gps_shm_read(&reader, &tpv, &number), GPS_OK);
+    assert_int_equal(number, 2 * NUM_SLOTS + 10);
+    make_tpv(&expected, number);
+    assert_memory_equal(&tpv, &expected, sizeof(tpv));
+    assert_int_equal(reader.lost, 2 * NUM_SLOTS + 9);
+
+    for (n = number + 1; n < 3 * NUM_SLOTS + 10; ++n)
+    {
+        assert_int_equal(gps_shm_read(&reader, &tpv, &number), GPS_OK);
+        assert_int_equal(number, n);
+    }
+    assert_int_equal(gps_shm_read(&reader, &tpv, &number), GPS_ERROR_END);
+
+    gps_shm_reader_close(&reader);
+    gps_shm_writer_close(&writer);
+    shm_unlink(name);
+}
+
+static void test_shm_open(void **state)
+{
+    (void)state;
+    struct gps_shm_reader reader;
+    char junk[4096];
+    int fd;
+
+    shm_unlink(name);
+    assert_int_equal(gps_shm_reader_open(&reader, name), GPS_ERROR_IO);
+
+    /* An object which is too small, one of another version, and one with
+     * a ring of the wrong size
+     */
+    fd = shm_open(name, O_RDWR | O_CREAT, 0600);
+    assert_true(fd >= 0);
+    assert_int_equal(write(fd, "GPSR", 4), 4);
+    assert_int_equal(gps_shm_reader_open(&reader, name), GPS_ERROR_CORRUPT);
+    memset(junk, 0x5A, sizeof(junk));
+    assert_int_equal(write(fd, junk, sizeof(junk)), sizeof(junk));
+    assert_int_equal(gps_shm_reader_open(&reader, name), GPS_ERROR_UNSUPPORTED);
+    assert_int_equal(pwrite(fd, "\x02\x00\x00\x00\x00\x01\x00\x00", 8, 4), 8);
+    assert_int_equal(gps_shm_reader_open(&reader, name), GPS_ERROR_CORRUPT);
+    close(fd);
+
+    shm_unlink(name);
+}
+
+static void test_shm_restart(void **state)
+{
+    (void)state;
+    struct gps_shm_writer writer;
+    struct gps_shm_reader reader;
+    struct gps_shm_reader later;
+    struct gps_tpv tpv;
+    uint32_t number;
+    uint32_t n;
+
+    shm_unlink(name);
+    assert_int_equal(gps_shm_writer_open(&writer, name, NUM_SLOTS), GPS_OK);
+    assert_int_equal(gps_shm_reader_open(&reader, name), GPS_OK);
+    assert_int_equal(reader.generation, 1);
+    for (n = 0; n < 3; ++n)
+    {
+        make_tpv(&tpv, n);
+        gps_shm_publish(&writer, &tpv);
+    }
+    gps_shm_writer_close(&writer);
+
+    /* A smaller ring replaces the old one, which its reader finishes first */
+    assert_int_equal(gps_shm_writer_open(&writer, name, NUM_SLOTS / 4), GPS_OK);
+    make_tpv(&tpv, 100);
+    gps_shm_publish(&writer, &tpv);
+    for (n = 0; n < 3; ++n)
+    {
+        assert_int_equal(gps_shm_read(&reader, &tpv, &number), GPS_OK);
+        assert_int_equal(number, n);
+    }
+    assert_int_equal(gps_shm_read(&reader, &tpv, &number), GPS_ERROR_RESTART);
+    assert_int_equal(reader.lost, 0);
+    gps_shm_reader_close(&reader);
+
+    /* Opening again follows the new ring */
+    assert_int_equal(gps_shm_reader_open(&later, name), GPS_OK);
+    assert_int_equal(later.generation, 2);
+    make_tpv(&tpv, 101);
+    gps_shm_publish(&writer, &tpv);
+    assert_int_equal(gps_shm_read(&later, &tpv, &number), GPS_OK);
+    assert_int_equal(number, 1);
+    assert_int_equal(tpv.latitude, 101);
+    assert_int_equal(gps_shm_read(&later, &tpv, &number), GPS_ERROR_END);
+
+    gps_shm_reader_close(&later);
+    gps_shm_writer_close(&writer);
+    shm_unlink(name);
+}
+
+/* A writer process publishing as fast as it can into a small ring while
+ * this process reads. No read may be torn or go back, and every record is
+ * either read or counted as lost.
+ */
+static void test_shm_processes(void **state)
+{
+    (void)state;
+    struct gps_shm_writer writer;
+    struct gps_shm_reader reader;
+    struct gps_tpv expected;
+    struct gps_tpv tpv;
+    uint32_t reads = 0;
+    uint32_t torn = 0;
+    uint32_t backwards = 0;
+    uint32_t last = 0;
+    uint32_t number;
+    int status;
+    int exited = 0;
+    pid_t child;
+
+    assert_int_equal(gps_shm_writer_open(&writer, name, NUM_SLOTS), GPS_OK);
+    assert_int_equal(gps_shm_reader_open(&reader, name), GPS_OK);
+
+    child = fork();
+    assert_true(child >= 0);
+    if (0 == child)
+    {
+        uint32_t n;
+
+        for (n = 0; n < NUM_PUBLISHES; ++n)
+        {
+            make_tpv(&tpv, n);
+            gps_shm_publish(&writer, &tpv);
+        }
+        _exit(EXIT_SUCCESS);
+    }
+
+    for (;;)
+    {
+        if (GPS_OK == gps_shm_read(&reader, &tpv, &number))
+        {
+            make_tpv(&expected, number);
+            if (memcmp(&tpv, &expected, sizeof(tpv)) != 0) torn++;
+            if ((reads > 0) && (number <= last)) backwards++;
+            last = number;
+            reads++;
+        }
+        else if (exited)
+        {
+            break;
+        }
+        else if (waitpid(child, &status, WNOHANG) == child)
+        {
+            assert_true(WIFEXITED(status));
+            assert_int_equal(WEXITSTATUS(status), EXIT_SUCCESS);
+            exited = 1;
+        }
+    }
+
+    assert_int_equal(torn, 0);
+    assert_int_equal(backwards, 0);
+    assert_int_equal(reads + reader.lost, NUM_PUBLISHES);
+    assert_int_equal(last, NUM_PUBLISHES - 1);
+
+    gps_shm_reader_close(&reader);
+    gps_shm_writer_close(&writer);
+    shm_unlink(name);
+}
+
+int main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_shm_publish),
+        cmocka_unit_test(test_shm_overrun),
+        cmocka_unit_test(test_shm_open),
+        cmocka_unit_test(test_shm_restart),
+        cmocka_unit_test(test_shm_processes)
+    };
+
+    snprintf(name, sizeof(name), "/gps-test-shm-%d", (int)getpid());
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
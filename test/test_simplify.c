@@ -0,0 +1,263 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Jacob McGladdery
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include "gps.h"
+#include "gps_simplify.h"
+
+#include <math.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <string.h>
+#include <cmocka.h>
+
+#define MAX_POINTS (2000)
+
+/* Millimeters per micro-degree of arc */
+#define MM_PER_MICRODEGREE (111.19508)
+
+struct track
+{
+    int32_t latitude[MAX_POINTS];
+    int32_t longitude[MAX_POINTS];
+    size_t count;
+};
+
+struct kept
+{
+    int64_t time[MAX_POINTS];
+    size_t count;
+};
+
+static struct track track;
+static uint8_t keep[MAX_POINTS];
+
+static void on_point(void *context, const struct gps_simplify_point *point)
+{
+    struct kept *k = context;
+
+    k->time[k->count++] = point->time;
+}
+
+/* Distance in millimeters from point p to the segment from a to b */
+static double segment_distance(size_t a, size_t b, size_t p)
+{
+    double scale = cos(track.latitude[a] * 1e-6 * M_PI / 180) * MM_PER_MICRODEGREE;
+    double bx = (track.longitude[b] - track.longitude[a]) * scale;
+    double by = (track.latitude[b] - track.latitude[a]) * MM_PER_MICRODEGREE;
+    double px = (track.longitude[p] - track.longitude[a]) * scale;
+    double py = (track.latitude[p] - track.latitude[a]) * MM_PER_MICRODEGREE;
+    double length2 = bx * bx + by * by;
+    double t = (length2 > 0) ? (px * bx + py * by) / length2 : 0;
+
+    if (t < 0) t = 0;
+    if (t > 1) t = 1;
+    return hypot(px - t * bx, py - t * by);
+}
+
+/* Checks that every point between two kept ones lies within the tolerance,
+ * allowing for the 14 mm projection unit
+ */
+static void check_within(const size_t *kept, size_t count, int32_t tolerance)
+{
+    size_t k;
+    size_t p;
+
+    assert_int_equal(kept[0], 0);
+    assert_int_equal(kept[count - 1], track.count - 1);
+    for (k = 0; k + 1 < count; ++k)
+    {
+        for (p = kept[k] + 1; p < kept[k + 1]; ++p)
+        {
+            assert_true(segment_distance(kept[k], kept[k + 1], p) <= tolerance + 30);
+        }
+    }
+}
+
+/* A drive at 15 m/s sampled at 1 Hz, turning now and then, with about a
+ * meter of noise
+ */
+static void build_track(size_t count)
+{
+    double lat = 53.36;
+    double lon = -6.5;
+    double heading = 0.3;
+    uint32_t seed = 7;
+    size_t i;
+
+    for (i = 0; i < count; ++i)
+    {
+        seed = seed * 1103515245u + 12345u;
+        if (0 == (i % 60)) heading += ((int)(seed >> 16) % 200 - 100) / 100.0;
+        lat += 15 * cos(heading) / 111195.08;
+        lon += 15 * sin(heading) / (111195.08 * cos(lat * M_PI / 180));
+        track.latitude[i] = (int32_t)lround(lat * 1e6) + (int32_t)((seed >> 8) % 20) - 10;
+        track.longitude[i] = (int32_t)lround(lon * 1e6) + (int32_t)((seed >> 20) % 20) - 10;
+    }
+    track.count = count;
+}
+
+static void test_simplify_straight(void **state)
+{
+    (void)state;
+    struct gps_simplify simplify;
+    struct kept kept;
+    struct gps_tpv tpv;
+    size_t i;
+
+    /* Due north with a third of a meter of zig-zag either side */
+    for (i = 0; i < 100; ++i)
+    {
+        track.latitude[i] = 53000000 + 100 * (int32_t)i;
+        track.longitude[i] = -6000000 + ((i % 2) ? 5 : -5);
+    }
+    track.count = 100;
+
+    assert_int_equal(gps_simplify_track(track.latitude, track.longitude, 100, 2000, keep), 2);
+    assert_int_equal(keep[0], 1);
+    assert_int_equal(keep[99], 1);
+    assert_true(gps_simplify_track(track.latitude, track.longitude, 100, 200, keep) > 50);
+
+    /* The stream keeps a point whenever its window fills */
+    memset(&kept, 0, sizeof(kept));
+    gps_simplify_init(&simplify, 2000, on_point, &kept);
+    gps_init_tpv(&tpv);
+    for (i = 0; i < 100; ++i)
+    {
+        tpv.latitude = track.latitude[i];
+        tpv.longitude = track.longitude[i];
+        gps_simplify_add(&simplify, &tpv, (int64_t)i);
+    }
+    gps_simplify_flush(&simplify);
+    assert_int_equal(kept.count, 2 + (100 - 2) / (GPS_SIMPLIFY_WINDOW - 1));
+    assert_int_equal(kept.time[1], GPS_SIMPLIFY_WINDOW - 1);
+    assert_int_equal(kept.time[kept.count - 1], 99);
+    assert_int_equal(simplify.points, 100);
+    assert_int_equal(simplify.kept, kept.count);
+}
+
+static void test_simplify_corner(void **state)
+{
+    (void)state;
+    struct gps_simplify simplify;
+    struct kept kept;
+    struct gps_tpv tpv;
+    size_t i;
+
+    /* North for 10 points, then east for 10 */
+    for (i = 0; i < 20; ++i)
+    {
+        track.latitude[i] = 53000000 + 100 * (int32_t)((i < 10) ? i : 9);
+        track.longitude[i] = -6000000 + 170 * (int32_t)((i < 10) ? 0 : i - 9);
+    }
+    track.count = 20;
+
+    assert_int_equal(gps_simplify_track(track.latitude, track.longitude, 20, 1000, keep), 3);
+    assert_int_equal(keep[9], 1);
+
+    memset(&kept, 0, sizeof(kept));
+    gps_simplify_init(&simplify, 1000, on_point, &kept);
+    gps_init_tpv(&tpv);
+    for (i = 0; i < 20; ++i)
+    {
+        tpv.latitude = track.latitude[i];
+        tpv.longitude = track.longitude[i];
+        gps_simplify_add(&simplify, &tpv, (int64_t)i);
+
+        /* Points without a fix are skipped */
+        gps_init_tpv(&tpv);
+        gps_simplify_add(&simplify, &tpv, -1);
+    }
+    gps_simplify_flush(&simplify);
+    assert_int_equal(kept.count, 3);
+    assert_int_equal(kept.time[1], 9);
+    assert_int_equal(kept.time[2], 19);
+}
+
+static void test_simplify_track_tolerance(void **state)
+{
+    (void)state;
+    static size_t kept[MAX_POINTS];
+    const int32_t tolerances[] = { 1000, 5000, 20000 };
+    size_t t;
+
+    build_track(MAX_POINTS);
+    for (t = 0; t < sizeof(tolerances) / sizeof(tolerances[0]); ++t)
+    {
+        size_t n = gps_simplify_track(track.latitude, track.longitude, track.count, tolerances[t], keep);
+        size_t count = 0;
+        size_t i;
+
+        for (i = 0; i < track.count; ++i)
+        {
+            if (keep[i]) kept[count++] = i;
+        }
+        assert_int_equal(count, n);
+        if (tolerances[t] >= 5000) assert_true(n < track.count / 4);
+        check_within(kept, count, tolerances[t]);
+    }
+}
+
+static void test_simplify_stream_tolerance(void **state)
+{
+    (void)state;
+    static struct kept kept;
+    static size_t indices[MAX_POINTS];
+    struct gps_simplify simplify;
+    struct gps_tpv tpv;
+    size_t dp;
+    size_t i;
+
+    build_track(MAX_POINTS);
+    memset(&kept, 0, sizeof(kept));
+    gps_simplify_init(&simplify, 5000, on_point, &kept);
+    gps_init_tpv(&tpv);
+    for (i = 0; i < track.count; ++i)
+    {
+        tpv.latitude = track.latitude[i];
+        tpv.longitude = track.longitude[i];
+        gps_simplify_add(&simplify, &tpv, (int64_t)i);
+    }
+    gps_simplify_flush(&simplify);
+
+    for (i = 0; i < kept.count; ++i) indices[i] = (size_t)kept.time[i];
+    check_within(indices, kept.count, 5000);
+
+    /* Douglas-Peucker needs no more points than the window */
+    dp = gps_simplify_track(track.latitude, track.longitude, track.count, 5000, keep);
+    assert_true(dp <= kept.count);
+    assert_true(kept.count < track.count / 4);
+}
+
+int main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_simplify_straight),
+        cmocka_unit_test(test_simplify_corner),
+        cmocka_unit_test(test_simplify_track_tolerance),
+        cmocka_unit_test(test_simplify_stream_tolerance)
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
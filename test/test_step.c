@@ -0,0 +1,163 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Jacob McGladdery
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include "gps_step.h"
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <string.h>
+#include <cmocka.h>
+
+static const char *sentences[] = {
+    "GPGGA,092750.000,5321.6802,N,00630.3372,W,1,8,1.03,61.7,M,55.2,M,,",
+    "GPGSA,A,3,10,07,05,02,29,04,08,13,,,,,1.72,1.03,1.38",
+    "GPRMC,092750.000,A,5321.6802,N,00630.3372,W,0.02,31.66,280511,,,A",
+    "GPVTG,176.90,T,,M,3.68,N,6.81,K,A",
+    "GPZDA,050306,29,10,2003,,"
+};
+
+static void test_step_decode(void **state)
+{
+    (void)state;
+    struct gps_tpv expected[sizeof(sentences) / sizeof(sentences[0])];
+    struct gps_tpv tpv;
+    struct gps_step step;
+    char stream[512] = "\r\nnoise";
+    size_t count = sizeof(sentences) / sizeof(sentences[0]);
+    size_t length;
+    size_t offset = 0;
+    size_t decoded = 0;
+    size_t i;
+
+    for (i = 0; i < count; ++i)
+    {
+        char nmea[128];
+
+        gps_encode(nmea, sentences[i]);
+        strcat(stream, nmea);
+        gps_init_tpv(&expected[i]);
+        assert_int_equal(gps_decode(&expected[i], nmea), GPS_OK);
+    }
+    length = strlen(stream);
+
+    /* A few characters per cycle, and one decode attempt per cycle */
+    gps_step_init(&step);
+    while (offset < length)
+    {
+        size_t used = gps_step_feed(&step, stream + offset, length - offset, 5);
+        int result;
+
+        assert_true(used <= 5);
+        offset += used;
+
+        gps_init_tpv(&tpv);
+        result = gps_step_decode(&step, &tpv);
+        if (GPS_OK == result)
+        {
+            assert_true(decoded < count);
+            assert_memory_equal(&tpv, &expected[decoded], sizeof(tpv));
+            ++decoded;
+        }
+        else
+        {
+            assert_int_equal(result, GPS_ERROR_END);
+        }
+    }
+
+    assert_int_equal(decoded, count);
+}
+
+static void test_step_pending(void **state)
+{
+    (void)state;
+    struct gps_tpv tpv;
+    struct gps_step step;
+    char nmea[128];
+    size_t length;
+
+    gps_init_tpv(&tpv);
+    gps_encode(nmea, sentences[3]);
+    strcat(nmea, "$GP");
+    length = strlen(nmea);
+
+    gps_step_init(&step);
+    assert_int_equal(gps_step_decode(&step, &tpv), GPS_ERROR_END);
+    assert_int_equal(gps_step_feed(&step, nmea, 0, 16), 0);
+
+    /* Feeding stops after the footer until the sentence is decoded */
+    assert_int_equal(gps_step_feed(&step, nmea, length, 1000), length - 3);
+    assert_int_equal(gps_step_feed(&step, nmea + length - 3, 3, 1000), 0);
+    assert_int_equal(gps_step_decode(&step, &tpv), GPS_OK);
+    assert_int_equal(tpv.track, 176900);
+    assert_int_equal(gps_step_feed(&step, nmea + length - 3, 3, 1000), 3);
+    assert_int_equal(gps_step_decode(&step, &tpv), GPS_ERROR_END);
+}
+
+static void test_step_errors(void **state)
+{
+    (void)state;
+    struct gps_tpv tpv;
+    struct gps_step step;
+    char nmea[128];
+    char noise[2 * GPS_STEP_SENTENCE_SIZE];
+    size_t used;
+
+    gps_init_tpv(&tpv);
+    gps_step_init(&step);
+
+    /* A sentence cut short by the next header, which is kept */
+    gps_encode(nmea, sentences[3]);
+    assert_int_equal(gps_step_feed(&step, "$GPGGA,0927", 11, 16), 11);
+    assert_int_equal(gps_step_feed(&step, nmea, strlen(nmea), 16), 0);
+    assert_int_equal(gps_step_decode(&step, &tpv), GPS_ERROR_TRUNCATED);
+    used = gps_step_feed(&step, nmea, strlen(nmea), 1000);
+    assert_int_equal(used, strlen(nmea));
+    assert_int_equal(gps_step_decode(&step, &tpv), GPS_OK);
+
+    /* A bad checksum */
+    nmea[strlen(nmea) - 3] ^= 1;
+    assert_int_equal(gps_step_feed(&step, nmea, strlen(nmea), 1000), strlen(nmea));
+    assert_int_equal(gps_step_decode(&step, &tpv), GPS_ERROR_CHECKSUM);
+
+    /* A header followed by more than a sentence of noise */
+    memset(noise, 'A', sizeof(noise));
+    noise[0] = '$';
+    used = gps_step_feed(&step, noise, sizeof(noise), 1000);
+    assert_int_equal(used, GPS_STEP_SENTENCE_SIZE);
+    assert_int_equal(gps_step_decode(&step, &tpv), GPS_ERROR_OVERFLOW);
+    assert_int_equal(gps_step_feed(&step, noise + used, sizeof(noise) - used, 1000), sizeof(noise) - used);
+    assert_int_equal(gps_step_decode(&step, &tpv), GPS_ERROR_END);
+}
+
+int main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_step_decode),
+        cmocka_unit_test(test_step_pending),
+        cmocka_unit_test(test_step_errors)
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
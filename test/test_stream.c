@@ -0,0 +1,270 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Jacob McGladdery
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include "gps.h"
+#include "gps_stream.h"
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <stdio.h>
+#include <string.h>
+#include <cmocka.h>
+
+#ifdef GPS_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+#ifdef GPS_HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+/* Enough epochs for the log to fill every block several times over */
+#define NUM_EPOCHS (2000)
+#define LOG_SIZE   (NUM_EPOCHS * 3 * 96)
+
+static char log_text[LOG_SIZE];
+static unsigned char compressed[LOG_SIZE];
+static struct gps_stream stream;
+
+struct received
+{
+    uint32_t count;
+    struct gps_tpv tpv;
+};
+
+static void on_tpv(void *context, const struct gps_tpv *tpv)
+{
+    struct received *r = context;
+
+    r->count++;
+    r->tpv = *tpv;
+}
+
+/* A GGA and an RMC per epoch, with an arrival time in front of the RMC,
+ * and an unsupported sentence after them
+ */
+static size_t build_log(void)
+{
+    char body[96];
+    size_t size = 0;
+    int e;
+
+    for (e = 0; e < NUM_EPOCHS; ++e)
+    {
+        int m = (e / 60) % 60;
+        int s = e % 60;
+
+        sprintf(body, "GPGGA,1%d%02d%02d.000,5321.%04d,N,00630.3371,W,1,8,1.03,61.7,M,55.3,M,,",
+                e / 3600, m, s, e);
+        gps_encode(log_text + size, body);
+        size += strlen(log_text + size);
+
+        size += (size_t)sprintf(log_text + size, "%d.250 ", e);
+        sprintf(body, "GPRMC,1%d%02d%02d.000,A,5321.%04d,N,00630.3371,W,0.02,31.66,280511,,,A",
+                e / 3600, m, s, e);
+        gps_encode(log_text + size, body);
+        size += strlen(log_text + size);
+
+        gps_encode(log_text + size, "GPTXT,01,01,02,ANTSTATUS=OK");
+        size += strlen(log_text + size);
+    }
+
+    return size;
+}
+
+static FILE *open_log(const void *data, size_t size)
+{
+    FILE *file = tmpfile();
+
+    assert_non_null(file);
+    assert_int_equal(fwrite(data, 1, size, file), size);
+    rewind(file);
+
+    return file;
+}
+
+static void check_log(const struct received *r, size_t size)
+{
+    assert_int_equal(stream.sentences, 2 * NUM_EPOCHS);
+    assert_int_equal(stream.errors, 0);
+    assert_int_equal(stream.decompressed, size);
+    assert_int_equal(r->count, 2 * NUM_EPOCHS);
+    assert_int_equal(r->tpv.latitude, 53353331);
+    assert_string_equal(r->tpv.time, "2011-05-28T10:33:19.000Z");
+}
+
+#ifdef GPS_HAVE_ZLIB
+static size_t gzip(unsigned char *out, size_t capacity, const char *data, size_t size)
+{
+    z_stream z;
+    size_t n;
+
+    memset(&z, 0, sizeof(z));
+    assert_int_equal(deflateInit2(&z, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY), Z_OK);
+    z.next_in = (Bytef *)data;
+    z.avail_in = (uInt)size;
+    z.next_out = out;
+    z.avail_out = (uInt)capacity;
+    assert_int_equal(deflate(&z, Z_FINISH), Z_STREAM_END);
+    n = z.total_out;
+    deflateEnd(&z);
+
+    return n;
+}
+#endif
+
+static void test_stream_plain(void **state)
+{
+    (void)state;
+    struct received received;
+    size_t size = build_log();
+    FILE *file = open_log(log_text, size);
+
+    memset(&received, 0, sizeof(received));
+    assert_int_equal(gps_stream_decode(&stream, file, on_tpv, &received), GPS_OK);
+    fclose(file);
+
+    assert_int_equal(stream.format, GPS_STREAM_PLAIN);
+    assert_int_equal(stream.compressed, size);
+    check_log(&received, size);
+}
+
+#ifdef GPS_HAVE_ZLIB
+static void test_stream_gzip(void **state)
+{
+    (void)state;
+    struct received received;
+    size_t size = build_log();
+    size_t half = size / 2;
+    size_t n;
+    FILE *file;
+
+    /* Two members, split in the middle of a sentence */
+    n = gzip(compressed, sizeof(compressed), log_text, half);
+    n += gzip(compressed + n, sizeof(compressed) - n, log_text + half, size - half);
+    file = open_log(compressed, n);
+
+    memset(&received, 0, sizeof(received));
+    assert_int_equal(gps_stream_decode(&stream, file, on_tpv, &received), GPS_OK);
+    fclose(file);
+
+    assert_int_equal(stream.format, GPS_STREAM_GZIP);
+    assert_int_equal(stream.compressed, n);
+    check_log(&received, size);
+}
+#endif
+
+#ifdef GPS_HAVE_ZSTD
+static void test_stream_zstd(void **state)
+{
+    (void)state;
+    struct received received;
+    size_t size = build_log();
+    size_t n;
+    FILE *file;
+
+    n = ZSTD_compress(compressed, sizeof(compressed), log_text, size, 3);
+    assert_false(ZSTD_isError(n));
+    file = open_log(compressed, n);
+
+    memset(&received, 0, sizeof(received));
+    assert_int_equal(gps_stream_decode(&stream, file, on_tpv, &received), GPS_OK);
+    fclose(file);
+
+    assert_int_equal(stream.format, GPS_STREAM_ZSTD);
+    check_log(&received, size);
+
+    /* Cut short */
+    file = open_log(compressed, n / 2);
+    memset(&received, 0, sizeof(received));
+    assert_int_equal(gps_stream_decode(&stream, file, on_tpv, &received), GPS_ERROR_TRUNCATED);
+    fclose(file);
+    assert_true(received.count > 0);
+}
+#endif
+
+static void test_stream_errors(void **state)
+{
+    (void)state;
+    struct received received;
+    size_t size;
+    FILE *file;
+
+    /* A line too long to join across blocks is dropped, and the sentence
+     * after it still decoded
+     */
+    memset(log_text, 'x', GPS_STREAM_BLOCK_SIZE + 200);
+    log_text[GPS_STREAM_BLOCK_SIZE - 150] = '\n';
+    log_text[GPS_STREAM_BLOCK_SIZE - 149] = '$';
+    log_text[GPS_STREAM_BLOCK_SIZE + 199] = '\n';
+    size = GPS_STREAM_BLOCK_SIZE + 200;
+    gps_encode(log_text + size, "GPGGA,092751.000,5321.6802,N,00630.3371,W,1,8,1.03,61.7,M,55.3,M,,");
+    size += strlen(log_text + size);
+
+    file = open_log(log_text, size);
+    memset(&received, 0, sizeof(received));
+    assert_int_equal(gps_stream_decode(&stream, file, on_tpv, &received), GPS_OK);
+    fclose(file);
+    assert_int_equal(stream.sentences, 1);
+    assert_int_equal(stream.errors, 1);
+
+#ifdef GPS_HAVE_ZLIB
+    {
+        size_t n;
+
+        /* Damaged compressed data */
+        size = build_log();
+        n = gzip(compressed, sizeof(compressed), log_text, size);
+        memset(compressed + n / 2, 0xA5, 64);
+        file = open_log(compressed, n);
+        memset(&received, 0, sizeof(received));
+        assert_int_equal(gps_stream_decode(&stream, file, on_tpv, &received), GPS_ERROR_CORRUPT);
+        fclose(file);
+
+        /* Cut short */
+        file = open_log(compressed, n / 4);
+        memset(&received, 0, sizeof(received));
+        assert_int_equal(gps_stream_decode(&stream, file, on_tpv, &received), GPS_ERROR_TRUNCATED);
+        fclose(file);
+        assert_true(received.count > 0);
+    }
+#endif
+}
+
+int main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_stream_plain),
+#ifdef GPS_HAVE_ZLIB
+        cmocka_unit_test(test_stream_gzip),
+#endif
+#ifdef GPS_HAVE_ZSTD
+        cmocka_unit_test(test_stream_zstd),
+#endif
+        cmocka_unit_test(test_stream_errors)
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,195 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Jacob McGladdery
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include "gps.h"
+#include "gps_talker.h"
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <string.h>
+#include <cmocka.h>
+
+static int decode(struct gps_talker_table *table, const char *body)
+{
+    char nmea[96];
+
+    gps_encode(nmea, body);
+    return gps_talker_decode(table, nmea, strlen(nmea));
+}
+
+static void test_talker_index(void **state)
+{
+    (void)state;
+
+    assert_int_equal(gps_talker_index("GP"), GPS_TALKER_GP);
+    assert_int_equal(gps_talker_index("GL"), GPS_TALKER_GL);
+    assert_int_equal(gps_talker_index("GA"), GPS_TALKER_GA);
+    assert_int_equal(gps_talker_index("GB"), GPS_TALKER_GB);
+    assert_int_equal(gps_talker_index("BD"), GPS_TALKER_GB);
+    assert_int_equal(gps_talker_index("GQ"), GPS_TALKER_GQ);
+    assert_int_equal(gps_talker_index("GI"), GPS_TALKER_GI);
+    assert_int_equal(gps_talker_index("GN"), GPS_TALKER_GN);
+    assert_int_equal(gps_talker_index("GZ"), GPS_TALKER_OTHER);
+    assert_int_equal(gps_talker_index("G*"), GPS_TALKER_OTHER);
+    assert_int_equal(gps_talker_index("II"), GPS_TALKER_OTHER);
+    assert_int_equal(gps_talker_index("BX"), GPS_TALKER_OTHER);
+}
+
+static void test_talker_separate(void **state)
+{
+    struct gps_talker_table table;
+
+    (void)state;
+
+    gps_talker_init(&table);
+    assert_int_equal(table.combined.mode, GPS_MODE_UNKNOWN);
+    assert_int_equal(table.source[GPS_TALKER_MODE], GPS_TALKER_NONE);
+
+    /* A GLONASS only 2D fix must not replace the 3D fix of the solution */
+    assert_int_equal(decode(&table, "GNGSA,A,3,10,07,05,02,29,04,08,13,,,,,1.72,1.03,1.38"), GPS_OK);
+    assert_int_equal(decode(&table, "GLGSA,A,2,65,66,,,,,,,,,,,2.50,1.90,1.60"), GPS_OK);
+    assert_int_equal(table.tpv[GPS_TALKER_GN].mode, GPS_MODE_3D_FIX);
+    assert_int_equal(table.tpv[GPS_TALKER_GL].mode, GPS_MODE_2D_FIX);
+    assert_int_equal(table.combined.mode, GPS_MODE_3D_FIX);
+    assert_int_equal(table.source[GPS_TALKER_MODE], GPS_TALKER_GN);
+    assert_int_equal(table.sentences[GPS_TALKER_GN], 1);
+    assert_int_equal(table.sentences[GPS_TALKER_GL], 1);
+
+    /* Each group comes from the best talker which has it */
+    assert_int_equal(decode(&table, "GPVTG,176.90,T,,M,3.68,N,6.81,K,A"), GPS_OK);
+    assert_int_equal(decode(&table, "GNGGA,092751.000,5321.6802,N,00630.3371,W,1,8,1.03,61.7,M,55.3,M,,"), GPS_OK);
+    assert_int_equal(table.combined.latitude, 53361336);
+    assert_int_equal(table.combined.longitude, -6505618);
+    assert_int_equal(table.combined.altitude, 61700);
+    assert_int_equal(table.combined.track, 176900);
+    assert_string_equal(table.combined.talker_id, "GN");
+    assert_int_equal(table.source[GPS_TALKER_POSITION], GPS_TALKER_GN);
+    assert_int_equal(table.source[GPS_TALKER_VELOCITY], GPS_TALKER_GP);
+    assert_int_equal(table.tpv[GPS_TALKER_GP].latitude, GPS_INVALID_VALUE);
+}
+
+static void test_talker_precedence(void **state)
+{
+    static const uint8_t gps_first[] = { GPS_TALKER_GP, GPS_TALKER_GN };
+    static const uint8_t glonass_only[] = { GPS_TALKER_GL };
+    struct gps_talker_table table;
+
+    (void)state;
+
+    gps_talker_init(&table);
+    assert_int_equal(decode(&table, "GNGGA,092751.000,5321.6802,N,00630.3371,W,1,8,1.03,61.7,M,55.3,M,,"), GPS_OK);
+    assert_int_equal(decode(&table, "GPGGA,092751.000,5321.6900,N,00630.3400,W,1,5,1.50,62.0,M,55.3,M,,"), GPS_OK);
+    assert_int_equal(table.combined.latitude, 53361336);
+
+    /* Changing the precedence rebuilds the combined TPV at once */
+    gps_talker_set_precedence(&table, GPS_TALKER_POSITION, gps_first, 2);
+    assert_int_equal(table.combined.latitude, 53361500);
+    assert_string_equal(table.combined.talker_id, "GP");
+    assert_int_equal(table.precedence[GPS_TALKER_POSITION][2], GPS_TALKER_NONE);
+
+    /* Talkers left out of the list are never used */
+    gps_talker_set_precedence(&table, GPS_TALKER_POSITION, glonass_only, 1);
+    assert_int_equal(table.combined.latitude, GPS_INVALID_VALUE);
+    assert_int_equal(table.source[GPS_TALKER_POSITION], GPS_TALKER_NONE);
+
+    /* The other groups keep the default */
+    assert_int_equal(table.source[GPS_TALKER_TIME], GPS_TALKER_GN);
+}
+
+static void test_talker_stale(void **state)
+{
+    struct gps_talker_table table;
+
+    (void)state;
+
+    gps_talker_init(&table);
+    assert_int_equal(decode(&table, "GNRMC,092751.000,A,5321.6802,N,00630.3371,W,0.02,31.66,280511,,,A"), GPS_OK);
+    assert_int_equal(decode(&table, "GNGGA,092751.000,5321.6802,N,00630.3371,W,1,8,1.03,61.7,M,55.3,M,,"), GPS_OK);
+    assert_int_equal(decode(&table, "GNGSA,A,3,10,07,05,02,29,04,08,13,,,,,1.72,1.03,1.38"), GPS_OK);
+    assert_int_equal(table.source[GPS_TALKER_POSITION], GPS_TALKER_GN);
+
+    /* The receiver drops to GPS only output. GN is used for one more epoch. */
+    assert_int_equal(decode(&table, "GPRMC,092752.000,A,5321.6900,N,00630.3400,W,1.50,90.00,280511,,,A"), GPS_OK);
+    assert_int_equal(decode(&table, "GPGSA,A,2,10,07,05,,,,,,,,,,2.50,1.90,1.60"), GPS_OK);
+    assert_int_equal(table.epoch, 1);
+    assert_int_equal(table.source[GPS_TALKER_POSITION], GPS_TALKER_GN);
+    assert_int_equal(table.combined.mode, GPS_MODE_3D_FIX);
+
+    /* Then GP takes over every group */
+    assert_int_equal(decode(&table, "GPRMC,092753.000,A,5321.7000,N,00630.3400,W,1.50,90.00,280511,,,A"), GPS_OK);
+    assert_int_equal(table.source[GPS_TALKER_POSITION], GPS_TALKER_GP);
+    assert_int_equal(table.source[GPS_TALKER_VELOCITY], GPS_TALKER_GP);
+    assert_int_equal(table.source[GPS_TALKER_TIME], GPS_TALKER_GP);
+    assert_int_equal(table.source[GPS_TALKER_MODE], GPS_TALKER_GP);
+    assert_int_equal(table.combined.latitude, 53361666);
+    assert_int_equal(table.combined.mode, GPS_MODE_2D_FIX);
+    assert_string_equal(table.combined.time, "2011-05-28T09:27:53.000Z");
+
+    /* GN is back as soon as it is heard again */
+    assert_int_equal(decode(&table, "GNGGA,092753.000,5321.6802,N,00630.3371,W,1,8,1.03,61.7,M,55.3,M,,"), GPS_OK);
+    assert_int_equal(table.source[GPS_TALKER_POSITION], GPS_TALKER_GN);
+
+    /* With no age allowed, only the talkers of the current epoch count */
+    assert_int_equal(decode(&table, "GPRMC,092754.000,A,5321.7100,N,00630.3400,W,1.50,90.00,280511,,,A"), GPS_OK);
+    assert_int_equal(table.source[GPS_TALKER_POSITION], GPS_TALKER_GN);
+    gps_talker_set_max_age(&table, 0);
+    assert_int_equal(table.source[GPS_TALKER_POSITION], GPS_TALKER_GP);
+}
+
+static void test_talker_errors(void **state)
+{
+    struct gps_talker_table table;
+    struct gps_talker_table before;
+    char nmea[96];
+
+    (void)state;
+
+    gps_talker_init(&table);
+    assert_int_equal(decode(&table, "GPRMC,092751.000,A,5321.6802,N,00630.3371,W,0.02,31.66,280511,,,A"), GPS_OK);
+    assert_string_equal(table.combined.time, "2011-05-28T09:27:51.000Z");
+    memcpy(&before, &table, sizeof(table));
+
+    /* Errors leave every talker as it was */
+    gps_encode(nmea, "GLGGA,092752.000,5321.6802,N,00630.3371,W,1,8,1.03,61.7,M,55.3,M,,");
+    nmea[strlen(nmea) - 3] ^= 1;
+    assert_int_equal(gps_talker_decode(&table, nmea, strlen(nmea)), GPS_ERROR_CHECKSUM);
+    assert_int_equal(decode(&table, "XXTXT,01,01,02,ANTENNA OK"), GPS_ERROR_UNSUPPORTED);
+    assert_int_equal(gps_talker_decode(&table, "GPGGA", 5), GPS_ERROR_HEAD);
+    assert_int_equal(gps_talker_decode(&table, "$G", 2), GPS_ERROR_TRUNCATED);
+    assert_memory_equal(&table, &before, sizeof(table));
+}
+
+int main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_talker_index),
+        cmocka_unit_test(test_talker_separate),
+        cmocka_unit_test(test_talker_precedence),
+        cmocka_unit_test(test_talker_stale),
+        cmocka_unit_test(test_talker_errors)
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}